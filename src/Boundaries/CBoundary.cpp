@@ -17,6 +17,7 @@
  *
  */
 #include <vector>
+#include <climits>
 #include <boost/lexical_cast.hpp>
 
 #include "CBoundaryMap.h"
@@ -25,6 +26,7 @@
 #include "../Domain/CDomain.h"
 #include "../Domain/Cartesian/CDomainCartesian.h"
 #include "../OpenCL/opencl.h"
+#include "../OpenCL/Executors/COCLKernel.h"
 
 using std::vector;
 int CBoundary::uiInstances = 0;
@@ -36,6 +38,12 @@ CBoundary::CBoundary( CDomain* pDomain )
 {
 	sName = "Boundary_" + toString( ++CBoundary::uiInstances );
 	this->pDomain = pDomain;
+
+	// Until it's prepared, a boundary could modify any cell
+	this->ulExtentX = 0;
+	this->ulExtentY = 0;
+	this->ulExtentCols = UINT_MAX;
+	this->ulExtentRows = UINT_MAX;
 }
 
 /*
@@ -46,3 +54,74 @@ CBoundary::~CBoundary()
 	// ...
 }
 
+/*
+ *  Do this boundary and another modify any of the same cells? Without
+ *  anything more specific, their extents are compared.
+ */
+bool CBoundary::overlaps( CBoundary* pOther )
+{
+	return this->ulExtentX < pOther->ulExtentX + pOther->ulExtentCols &&
+		   pOther->ulExtentX < this->ulExtentX + this->ulExtentCols &&
+		   this->ulExtentY < pOther->ulExtentY + pOther->ulExtentRows &&
+		   pOther->ulExtentY < this->ulExtentY + this->ulExtentRows;
+}
+
+/*
+ *  Take the extent as the smallest rectangle holding every enabled cell
+ *  within a window of the domain (inclusive). Cells are disabled with a
+ *  maximum FSL of -9999, as the kernels test.
+ */
+void CBoundary::findExtent( unsigned long ulMinX, unsigned long ulMinY, unsigned long ulMaxX, unsigned long ulMaxY )
+{
+	CDomainCartesian*	pDomain		= static_cast<CDomainCartesian*>( this->pDomain );
+	unsigned long		ulFirstX	= ULONG_MAX,
+						ulFirstY	= ULONG_MAX,
+						ulLastX		= 0,
+						ulLastY		= 0;
+
+	for ( unsigned long ulY = ulMinY; ulY <= ulMaxY && ulMinX <= ulMaxX; ulY++ )
+	{
+		for ( unsigned long ulX = ulMinX; ulX <= ulMaxX; ulX++ )
+		{
+			if ( pDomain->getStateValue( pDomain->getCellID( ulX, ulY ), model::domainValueIndices::kValueMaxFreeSurfaceLevel ) <= -9999.0 )
+				continue;
+
+			ulFirstX	= std::min( ulFirstX, ulX );
+			ulLastX		= std::max( ulLastX, ulX );
+			ulFirstY	= std::min( ulFirstY, ulY );
+			ulLastY		= std::max( ulLastY, ulY );
+		}
+	}
+
+	if ( ulFirstX == ULONG_MAX )
+	{
+		this->ulExtentX		= 0;
+		this->ulExtentY		= 0;
+		this->ulExtentCols	= 0;
+		this->ulExtentRows	= 0;
+		return;
+	}
+
+	this->ulExtentX		= ulFirstX;
+	this->ulExtentY		= ulFirstY;
+	this->ulExtentCols	= ulLastX - ulFirstX + 1;
+	this->ulExtentRows	= ulLastY - ulFirstY + 1;
+}
+
+/*
+ *  Launch a two-dimensional boundary kernel over the extent only. Work
+ *  items beyond the extent, from rounding up to the group size, fall on
+ *  cells the boundary doesn't modify, which the kernels skip.
+ */
+void CBoundary::setKernelExtent()
+{
+	this->oclKernel->setGroupSize( 8, 8 );
+	this->oclKernel->setGlobalOffset( this->ulExtentX, this->ulExtentY );
+	this->oclKernel->setGlobalSize( std::max( this->ulExtentCols, (cl_ulong)1 ), std::max( this->ulExtentRows, (cl_ulong)1 ) );
+
+	pManager->log->writeLine(
+		"Boundary '" + this->sName + "' applies to " + toString( this->ulExtentCols ) + " x " +
+		toString( this->ulExtentRows ) + " cells from [" + toString( this->ulExtentX ) + "," +
+		toString( this->ulExtentY ) + "]."
+	);
+}
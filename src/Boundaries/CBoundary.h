@@ -77,6 +77,7 @@ class COCLBuffer;
 class COCLDevice;
 class COCLProgram;
 class COCLKernel;
+class CBinaryTableDataset;
 
 class CBoundary
 {
@@ -87,19 +88,29 @@ public:
 	virtual bool					setupFromConfig(XMLElement*, std::string) = 0;
 	virtual void					prepareBoundary(COCLDevice*, COCLProgram*, COCLBuffer*, COCLBuffer*,
 												    COCLBuffer*, COCLBuffer*, COCLBuffer*) = 0;
-	virtual void					applyBoundary(COCLBuffer*) = 0;
+	virtual void					applyBoundary(COCLBuffer*, cl_uint = 0, const cl_event* = NULL, cl_event* = NULL) = 0;
 	virtual void					streamBoundary(double) = 0;
 	virtual void					cleanBoundary() = 0;
 	virtual void					importMap(CCSVDataset*)				{};
+	virtual void					importMap(CBinaryTableDataset*)		{};
+	virtual bool					overlaps(CBoundary*);
 	std::string						getName()							{ return sName; };
+	bool							hasCells()							{ return ulExtentCols > 0 && ulExtentRows > 0; };
 
 	static int			uiInstances;
 
 protected:	
 
+	void				findExtent(unsigned long, unsigned long, unsigned long, unsigned long);
+	void				setKernelExtent();
+
 	CDomain*			pDomain;
 	COCLKernel*			oclKernel;
 	std::string			sName;
+	cl_ulong			ulExtentX;			// First column the boundary can modify
+	cl_ulong			ulExtentY;			// First row the boundary can modify
+	cl_ulong			ulExtentCols;		// Columns spanned by the boundary
+	cl_ulong			ulExtentRows;		// Rows spanned by the boundary
 
 	/*
 	unsigned int		iType;
@@ -16,11 +16,15 @@
  * ------------------------------------------
  *
  */
+#include <algorithm>
+#include <climits>
+#include <cmath>
 #include <vector>
 #include <boost/lexical_cast.hpp>
 
 #include "CBoundaryMap.h"
 #include "CBoundaryCell.h"
+#include "../Datasets/CBinaryTableDataset.h"
 #include "../Domain/Cartesian/CDomainCartesian.h"
 #include "../OpenCL/Executors/COCLBuffer.h"
 #include "../OpenCL/Executors/COCLKernel.h"
@@ -104,31 +108,62 @@ bool CBoundaryCell::setupFromConfig(XMLElement* pElement, std::string sBoundaryS
 		);
 	}
 
-	// Timeseries file...
-	CCSVDataset* pCSVFile = new CCSVDataset(
-		sBoundarySourceDir + std::string(cBoundarySource)
-	);
-	if (pCSVFile->readFile())
+	// Timeseries file, either converted to a binary table or a CSV...
+	if (CBinaryTableDataset::isBinaryTable(std::string(cBoundarySource)))
 	{
-		if (pCSVFile->isReady())
-			this->importTimeseries(pCSVFile);
+		CBinaryTableDataset pTable(sBoundarySourceDir + std::string(cBoundarySource));
+		if (!pTable.readFile())
+		{
+			model::doError(
+				"Could not read a boundary timeseries file.",
+				model::errorCodes::kLevelWarning
+			);
+			return false;
+		}
+		this->importTimeseries(&pTable);
 	} else {
-		model::doError(
-			"Could not read a boundary timeseries file.",
-			model::errorCodes::kLevelWarning
+		CCSVDataset* pCSVFile = new CCSVDataset(
+			sBoundarySourceDir + std::string(cBoundarySource)
 		);
+		if (pCSVFile->readFile())
+		{
+			if (pCSVFile->isReady())
+				this->importTimeseries(pCSVFile);
+		} else {
+			model::doError(
+				"Could not read a boundary timeseries file.",
+				model::errorCodes::kLevelWarning
+			);
+			delete pCSVFile;
+			return false;
+		}
 		delete pCSVFile;
-		return false;
 	}
-	delete pCSVFile;
 
 	// Map file is optional -- could also have a single map file for all boundaries
 	if ( cBoundaryMap == NULL )
 		return true;
 
 	// Map file...
-	pCSVFile = new CCSVDataset(
-		sBoundarySourceDir + std::string(cBoundaryMap)
+	if (CBinaryTableDataset::isBinaryTable(std::string(cBoundaryMap)))
+	{
+		CBinaryTableDataset pTable(sBoundarySourceDir + std::string(cBoundaryMap));
+		if (!pTable.readFile())
+		{
+			model::doError(
+				"Could not read a boundary map file.",
+				model::errorCodes::kLevelWarning
+			);
+			return false;
+		}
+		this->importMap(&pTable);
+		return true;
+	}
+
+	// Names in a map are compared as written, so keep the text of every field
+	CCSVDataset* pCSVFile = new CCSVDataset(
+		sBoundarySourceDir + std::string(cBoundaryMap),
+		true
 	);
 	if (pCSVFile->readFile())
 	{
@@ -155,37 +190,24 @@ void CBoundaryCell::importTimeseries(CCSVDataset *pCSV)
 {
 	unsigned int uiIndex = 0;
 	bool bInvalidEntries = false;
-	bool bProcessedHeaders = false;
 
 	if (!pCSV->isReady())
 		return;
 
 	this->pTimeseries = new sTimeseriesCell[pCSV->getLength()];
 
-	for (vector<vector<std::string>>::const_iterator it = pCSV->begin();
-		it != pCSV->end();
-		it++)
+	for (unsigned int uiRow = 0; uiRow < pCSV->getLength(); uiRow++)
 	{
-		// TODO: Check if there are headers first... first time should be zero
-		if (uiIndex == 0 && !bProcessedHeaders)
+		if (pCSV->getFieldCount(uiRow) == 4 &&
+			pCSV->isNumber(uiRow, 0) &&
+			pCSV->isNumber(uiRow, 1) &&
+			pCSV->isNumber(uiRow, 2) &&
+			pCSV->isNumber(uiRow, 3))
 		{
-			bProcessedHeaders = true;
-			continue;
-		}
-
-		if (it->size() == 4)
-		{
-			try
-			{
-				this->pTimeseries[uiIndex].dTime				= boost::lexical_cast<cl_double>((*it)[0]);
-				this->pTimeseries[uiIndex].dDepthComponent		= boost::lexical_cast<cl_double>((*it)[1]);
-				this->pTimeseries[uiIndex].dDischargeComponentX = boost::lexical_cast<cl_double>((*it)[2]);
-				this->pTimeseries[uiIndex].dDischargeComponentY = boost::lexical_cast<cl_double>((*it)[3]);
-			}
-			catch (boost::bad_lexical_cast)
-			{
-				bInvalidEntries = true;
-			}
+			this->pTimeseries[uiIndex].dTime				= pCSV->getValue(uiRow, 0);
+			this->pTimeseries[uiIndex].dDepthComponent		= pCSV->getValue(uiRow, 1);
+			this->pTimeseries[uiIndex].dDischargeComponentX = pCSV->getValue(uiRow, 2);
+			this->pTimeseries[uiIndex].dDischargeComponentY = pCSV->getValue(uiRow, 3);
 		}
 		else {
 			bInvalidEntries = true;
@@ -212,9 +234,56 @@ void CBoundaryCell::importTimeseries(CCSVDataset *pCSV)
 		return;
 	}
 
+	this->setTimeseriesLength(uiIndex);
+}
+
+/*
+ *	Import timeseries data from a binary table, which is held in the same
+ *	layout so can be copied as it is
+ */
+void CBoundaryCell::importTimeseries(CBinaryTableDataset *pTable)
+{
+	double dInterval;
+
+	if (!pTable->isReady())
+		return;
+
+	if (pTable->getColumns() != 4)
+	{
+		model::doError(
+			"A boundary timeseries needs four columns.",
+			model::errorCodes::kLevelWarning
+		);
+		return;
+	}
+
+	// Need at least two entries
+	if (pTable->getLength() < 2)
+	{
+		model::doError(
+			"A boundary timeseries is too short.",
+			model::errorCodes::kLevelWarning
+		);
+		return;
+	}
+
+	if (!pTable->getTimeseriesInterval(&dInterval))
+		return;
+
+	this->pTimeseries = new sTimeseriesCell[pTable->getLength()];
+	std::memcpy(this->pTimeseries, pTable->getRow(0), sizeof(sTimeseriesCell) * pTable->getLength());
+
+	this->setTimeseriesLength(pTable->getLength());
+}
+
+/*
+ *	Take the interval, length and volume from the timeseries loaded
+ */
+void CBoundaryCell::setTimeseriesLength(unsigned int uiLength)
+{
 	this->dTimeseriesInterval = pTimeseries[1].dTime - pTimeseries[0].dTime;
-	this->uiTimeseriesLength = uiIndex;
-	this->dTimeseriesLength = pTimeseries[uiIndex - 1].dTime;
+	this->uiTimeseriesLength = uiLength;
+	this->dTimeseriesLength = pTimeseries[uiLength - 1].dTime;
 
 	this->dTotalVolume = 0.0;
 
@@ -234,7 +303,6 @@ void CBoundaryCell::importMap(CCSVDataset *pCSV)
 {
 	unsigned int uiIndex = 0;
 	bool bInvalidEntries = false;
-	bool bProcessedHeaders = false;
 
 	if (!pCSV->isReady())
 		return;
@@ -242,43 +310,21 @@ void CBoundaryCell::importMap(CCSVDataset *pCSV)
 	this->pRelations = new sRelationCell[pCSV->getLength()];
 	this->uiRelationCount = 0;
 
-	for (vector<vector<std::string>>::const_iterator it = pCSV->begin();
-		it != pCSV->end();
-		it++)
+	for (unsigned int uiRow = 0; uiRow < pCSV->getLength(); uiRow++)
 	{
-		// TODO: Check if there are headers first... first time should be zero
-		if (uiIndex == 0 && !bProcessedHeaders)
-		{
-			bProcessedHeaders = true;
+		unsigned int uiFields = pCSV->getFieldCount(uiRow);
+
+		// Rows with a third column only apply to the boundary named
+		if (uiFields == 3 && pCSV->getText(uiRow, 2) != this->getName())
 			continue;
-		}
 
-		if (it->size() == 2)
+		if ((uiFields == 2 || uiFields == 3) &&
+			pCSV->isIndex(uiRow, 0) &&
+			pCSV->isIndex(uiRow, 1))
 		{
-			try
-			{
-				this->pRelations[uiIndex].uiCellX = boost::lexical_cast<unsigned int>((*it)[0]);
-				this->pRelations[uiIndex].uiCellY = boost::lexical_cast<unsigned int>((*it)[1]);
-				uiIndex++;
-			}
-			catch (boost::bad_lexical_cast)
-			{
-				bInvalidEntries = true;
-			}
-		} else if (it->size() == 3) {
-			try
-			{
-				if ((*it)[2] == this->getName())
-				{
-					this->pRelations[uiIndex].uiCellX = boost::lexical_cast<unsigned int>((*it)[0]);
-					this->pRelations[uiIndex].uiCellY = boost::lexical_cast<unsigned int>((*it)[1]);
-					uiIndex++;
-				}
-			}
-			catch (boost::bad_lexical_cast)
-			{
-				bInvalidEntries = true;
-			}
+			this->pRelations[uiIndex].uiCellX = static_cast<unsigned int>(pCSV->getValue(uiRow, 0));
+			this->pRelations[uiIndex].uiCellY = static_cast<unsigned int>(pCSV->getValue(uiRow, 1));
+			uiIndex++;
 		} else {
 			bInvalidEntries = true;
 		}
@@ -295,6 +341,60 @@ void CBoundaryCell::importMap(CCSVDataset *pCSV)
 	this->uiRelationCount = uiIndex;
 }
 
+/*
+ *	Import cell map data from a binary table, taking only the rows for this
+ *	boundary if the table has names
+ */
+void CBoundaryCell::importMap(CBinaryTableDataset *pTable)
+{
+	unsigned int uiIndex = 0;
+	bool bInvalidEntries = false;
+
+	if (!pTable->isReady())
+		return;
+
+	if (pTable->getColumns() != 2)
+	{
+		model::doError(
+			"A boundary map file needs two columns besides a name.",
+			model::errorCodes::kLevelWarning
+		);
+		return;
+	}
+
+	this->pRelations = new sRelationCell[pTable->getLength()];
+	this->uiRelationCount = 0;
+
+	for (unsigned long i = 0; i < pTable->getLength(); i++)
+	{
+		if (pTable->hasLabels() && pTable->getLabel(i) != this->getName())
+			continue;
+
+		// Cell indices must be whole and not negative, as in a CSV map
+		const cl_double* dRow = pTable->getRow(i);
+		if (!(dRow[0] >= 0.0 && dRow[0] <= UINT_MAX && floor(dRow[0]) == dRow[0]) ||
+			!(dRow[1] >= 0.0 && dRow[1] <= UINT_MAX && floor(dRow[1]) == dRow[1]))
+		{
+			bInvalidEntries = true;
+			continue;
+		}
+
+		this->pRelations[uiIndex].uiCellX = static_cast<cl_uint>(dRow[0]);
+		this->pRelations[uiIndex].uiCellY = static_cast<cl_uint>(dRow[1]);
+		uiIndex++;
+	}
+
+	if (bInvalidEntries)
+	{
+		model::doError(
+			"Some table entries were not valid for a boundary map file.",
+			model::errorCodes::kLevelWarning
+		);
+	}
+
+	this->uiRelationCount = uiIndex;
+}
+
 void CBoundaryCell::prepareBoundary(
 			COCLDevice* pDevice, 
 			COCLProgram* pProgram,
@@ -307,6 +407,44 @@ void CBoundaryCell::prepareBoundary(
 {
 	// TODO: Apply scaling if discharge column is the total volume across the boundary
 
+	// Cell positions are relative to the source rasters, so if the domain is only
+	// part of them the cells outside it are dropped. Totals are still shared
+	// between every cell in the boundary.
+	CDomainCartesian* pDomainCart = static_cast<CDomainCartesian*>(this->pDomain);
+	std::vector<cl_ulong> vCells;
+	unsigned long ulWindowX = 0, ulWindowY = 0, ulWindowCols = 0, ulWindowRows = 0;
+	bool bWindow = pDomainCart->getRasterWindow( &ulWindowX, &ulWindowY, &ulWindowCols, &ulWindowRows );
+
+	for (unsigned int i = 0; i < this->uiRelationCount; ++i)
+	{
+		if ( bWindow &&
+			 ( this->pRelations[i].uiCellX < ulWindowX || this->pRelations[i].uiCellX >= ulWindowX + ulWindowCols ||
+			   this->pRelations[i].uiCellY < ulWindowY || this->pRelations[i].uiCellY >= ulWindowY + ulWindowRows ) )
+			continue;
+
+		vCells.push_back( pDomainCart->getCellID( this->pRelations[i].uiCellX - ulWindowX, this->pRelations[i].uiCellY - ulWindowY ) );
+	}
+
+	// Each relation is applied independently, so they're held in cell order
+	// to keep neighbouring work items on neighbouring cells
+	std::sort( vCells.begin(), vCells.end() );
+
+	this->ulExtentCols = 0;
+	this->ulExtentRows = 0;
+	if ( !vCells.empty() )
+	{
+		cl_ulong ulMinX = pDomainCart->getCols(), ulMaxX = 0;
+		for ( unsigned int i = 0; i < vCells.size(); ++i )
+		{
+			ulMinX = std::min( ulMinX, (cl_ulong)( vCells[i] % pDomainCart->getCols() ) );
+			ulMaxX = std::max( ulMaxX, (cl_ulong)( vCells[i] % pDomainCart->getCols() ) );
+		}
+		this->ulExtentX		= ulMinX;
+		this->ulExtentY		= vCells.front() / pDomainCart->getCols();
+		this->ulExtentCols	= ulMaxX - ulMinX + 1;
+		this->ulExtentRows	= vCells.back() / pDomainCart->getCols() - this->ulExtentY + 1;
+	}
+
 	// Configuration for the boundary and timeseries data
 	if ( pProgram->getFloatForm() == model::floatPrecision::kSingle )
 	{
@@ -317,7 +455,7 @@ void CBoundaryCell::prepareBoundary(
 		pConfiguration.TimeseriesLength   = this->dTimeseriesLength;
 		pConfiguration.DefinitionDepth	  = (cl_uint)this->ucDepthValue;
 		pConfiguration.DefinitionDischarge = (cl_uint)this->ucDischargeValue;
-		pConfiguration.RelationCount      = this->uiRelationCount;
+		pConfiguration.RelationCount      = static_cast<cl_uint>( vCells.size() );
 
 		this->pBufferConfiguration = new COCLBuffer(
 			"Bdy_" + this->sName + "_Conf",
@@ -363,7 +501,7 @@ void CBoundaryCell::prepareBoundary(
 		pConfiguration.TimeseriesLength   = this->dTimeseriesLength;
 		pConfiguration.DefinitionDepth = (cl_uint)this->ucDepthValue;
 		pConfiguration.DefinitionDischarge = (cl_uint)this->ucDischargeValue;
-		pConfiguration.RelationCount	  = this->uiRelationCount;
+		pConfiguration.RelationCount	  = static_cast<cl_uint>( vCells.size() );
 
 		this->pBufferConfiguration = new COCLBuffer(
 			"Bdy_" + this->sName + "_Conf",
@@ -414,14 +552,13 @@ void CBoundaryCell::prepareBoundary(
 		pProgram,
 		true,
 		true,
-		sizeof( cl_ulong ) * this->uiRelationCount,
+		sizeof( cl_ulong ) * std::max( vCells.size(), (size_t)1 ),
 		true
 	);
-	// This is a bit of a mess... but it works...
-	CDomainCartesian* pDomainCart = static_cast<CDomainCartesian*>(this->pDomain);
 	cl_ulong* pCells = this->pBufferRelations->getHostBlock<cl_ulong*>();
-	for (unsigned int i = 0; i < this->uiRelationCount; ++i)
-		pCells[i] = pDomainCart->getCellID( this->pRelations[i].uiCellX, this->pRelations[i].uiCellY );
+	if ( !vCells.empty() )
+		std::memcpy( pCells, &vCells[0], sizeof( cl_ulong ) * vCells.size() );
+	this->ulCellIDs = vCells;
 	this->pBufferRelations->createBuffer();
 	this->pBufferRelations->queueWriteAll();
 
@@ -440,14 +577,37 @@ void CBoundaryCell::prepareBoundary(
 
 	this->oclKernel->assignArguments(aryArgsBdy);
 	this->oclKernel->setGroupSize(8);
-	this->oclKernel->setGlobalSize( ( this->uiRelationCount / 8 + 1 ) * 8 );
+	this->oclKernel->setGlobalSize( ( vCells.size() / 8 + 1 ) * 8 );
 }
 
 // TODO: Only the cell buffer should be passed here...
-void CBoundaryCell::applyBoundary(COCLBuffer* pBufferCell)
+void CBoundaryCell::applyBoundary(COCLBuffer* pBufferCell, cl_uint uiWaitCount, const cl_event* clWaitList, cl_event* clEventOut)
 {
 	this->oclKernel->assignArgument( 6, pBufferCell );
-	this->oclKernel->scheduleExecution();
+	this->oclKernel->scheduleExecution( uiWaitCount, clWaitList, clEventOut );
+}
+
+/*
+ *  Do this boundary and another modify any of the same cells?
+ */
+bool CBoundaryCell::overlaps(CBoundary* pOther)
+{
+	CBoundaryCell* pOtherCell = dynamic_cast<CBoundaryCell*>( pOther );
+
+	// Other boundary types only have their extent to compare
+	if ( pOtherCell == NULL )
+		return CBoundary::overlaps( pOther );
+
+	std::vector<cl_ulong>::const_iterator itA = this->ulCellIDs.begin();
+	std::vector<cl_ulong>::const_iterator itB = pOtherCell->ulCellIDs.begin();
+
+	while ( itA != this->ulCellIDs.end() && itB != pOtherCell->ulCellIDs.end() )
+	{
+		if ( *itA == *itB ) return true;
+		if ( *itA < *itB ) { ++itA; } else { ++itB; }
+	}
+
+	return false;
 }
 
 void CBoundaryCell::streamBoundary(double dTime)
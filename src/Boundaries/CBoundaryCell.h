@@ -19,6 +19,7 @@
 #ifndef HIPIMS_BOUNDARIES_CBOUNDARYCELL_H_
 #define HIPIMS_BOUNDARIES_CBOUNDARYCELL_H_
 
+#include <vector>
 #include "../common.h"
 #include "CBoundary.h"
 
@@ -31,10 +32,12 @@ public:
 	virtual bool					setupFromConfig(XMLElement*, std::string);
 	virtual void					prepareBoundary(COCLDevice*, COCLProgram*, COCLBuffer*, COCLBuffer*,
 													COCLBuffer*, COCLBuffer*, COCLBuffer*);
-	virtual void					applyBoundary(COCLBuffer*);
+	virtual void					applyBoundary(COCLBuffer*, cl_uint = 0, const cl_event* = NULL, cl_event* = NULL);
 	virtual void					streamBoundary(double);
 	virtual void					cleanBoundary();
 	virtual void					importMap(CCSVDataset*);
+	virtual void					importMap(CBinaryTableDataset*);
+	virtual bool					overlaps(CBoundary*);
 
 protected:	
 
@@ -73,6 +76,8 @@ protected:
 	void							setDischargeValue( unsigned char a )		{ ucDischargeValue = a; };
 	void							setDepthValue( unsigned char a )			{ ucDepthValue = a; };
 	void							importTimeseries( CCSVDataset* );
+	void							importTimeseries( CBinaryTableDataset* );
+	void							setTimeseriesLength( unsigned int );
 
 	unsigned char					ucDischargeValue;
 	unsigned char					ucDepthValue;
@@ -85,6 +90,7 @@ protected:
 	sRelationCell*					pRelations;
 	unsigned int					uiTimeseriesLength;
 	unsigned int					uiRelationCount;
+	std::vector<cl_ulong>			ulCellIDs;					// Sorted cell IDs, for testing overlap
 
 	COCLBuffer*						pBufferTimeseries;
 	COCLBuffer*						pBufferRelations;
@@ -18,6 +18,7 @@
  */
 #include <vector>
 #include <algorithm>
+#include <climits>
 #include <boost/lexical_cast.hpp>
 
 #include "CBoundaryMap.h"
@@ -26,6 +27,7 @@
 #include "../Datasets/CRasterDataset.h"
 #include "../Domain/Cartesian/CDomainCartesian.h"
 #include "../OpenCL/Executors/COCLBuffer.h"
+#include "../OpenCL/Executors/COCLDevice.h"
 #include "../OpenCL/Executors/COCLKernel.h"
 #include "../common.h"
 
@@ -40,11 +42,14 @@ CBoundaryGridded::CBoundaryGridded(CDomain* pDomain)
 {
 	this->ucValue = model::boundaries::griddedValues::kValueRainIntensity;
 
-	this->pTimeseries = NULL;
 	this->pTransform = NULL;
+	this->pDevice = NULL;
 	this->pBufferConfiguration = NULL;
 	this->pBufferTimeseries = NULL;
 	this->uiTimeseriesLength = 0;
+	this->uiWindowSize = 0;
+	this->uiWindowStart = 0;
+	this->bTerminate = false;
 
 	this->pDomain = pDomain;
 }
@@ -54,9 +59,10 @@ CBoundaryGridded::CBoundaryGridded(CDomain* pDomain)
 */
 CBoundaryGridded::~CBoundaryGridded()
 {
-	for (unsigned int i = 0; i < this->uiTimeseriesLength; ++i)
-		delete this->pTimeseries[i];
-	delete[] this->pTimeseries;
+	this->stopPrefetching();
+
+	for (std::map<unsigned int, CBoundaryGriddedEntry*>::iterator it = mapFrames.begin(); it != mapFrames.end(); it++)
+		delete it->second;
 	delete this->pTransform;
 	delete this->pBufferConfiguration;
 	delete this->pBufferTimeseries;
@@ -105,16 +111,13 @@ bool CBoundaryGridded::setupFromConfig(XMLElement* pElement, std::string sBounda
 		);
 	}
 
-	// Allocate memory for the array of gridded inputs
-	this->uiTimeseriesLength = static_cast<unsigned int>(ceil(pManager->getSimulationLength() / dInterval)) + 1;
-	this->pTimeseries = new CBoundaryGriddedEntry*[ this->uiTimeseriesLength ];
 	SBoundaryGridTransform* pTransform = NULL;
 
 	this->dTimeseriesInterval = dInterval;
 	this->dTimeseriesLength = pManager->getSimulationLength();
 
-	// Deal with the gridded files...
-	unsigned long ulEntry = 0;
+	// Deal with the gridded files... only the first is read now, the rest
+	// are streamed in as the simulation progresses
 	for ( double dTime = 0.0; dTime <= pManager->getSimulationLength(); dTime += dInterval )
 	{
 		const char * cMaskName = Util::fromTimestamp(
@@ -132,27 +135,23 @@ bool CBoundaryGridded::setupFromConfig(XMLElement* pElement, std::string sBounda
 				model::errorCodes::kLevelWarning
 			);
 			this->dTimeseriesLength = min( this->dTimeseriesLength, dTime );
-			continue;
+			break;
 		}
 
-		// Load the raster...
-		CRasterDataset *pRaster = new CRasterDataset();
-		pRaster->openFileRead(sFilename);
-
 		// First raster? Need to come up with a transformation...
 		if ( pTransform == NULL )
+		{
+			CRasterDataset *pRaster = new CRasterDataset();
+			pRaster->openFileRead(sFilename);
 			pTransform = pRaster->createTransformationForDomain(static_cast<CDomainCartesian*>(this->pDomain));
+			delete pRaster;
+		}
 
-		// Store the data...
-		this->pTimeseries[ulEntry++] = new CBoundaryGriddedEntry(
-			dTime,
-			pRaster->createArrayForBoundary( pTransform )
-		);
-
-		delete pRaster;
+		this->vFilenames.push_back( sFilename );
 	}
 
 	this->pTransform = pTransform;
+	this->uiTimeseriesLength = this->vFilenames.size();
 
 	return true;
 }
@@ -170,12 +169,23 @@ void CBoundaryGridded::prepareBoundary(
 	if ( this->pTransform == NULL )
 		return;
 
+	// Sync points never cross an output time, so the device only needs
+	// enough frames to span one output interval at any point
+	this->uiWindowSize = min(
+		this->uiTimeseriesLength,
+		static_cast<unsigned int>( ceil( pManager->getOutputFrequency() / this->dTimeseriesInterval ) ) + 2
+	);
+	this->vRingFrames.assign( this->uiWindowSize, this->uiTimeseriesLength );
+	this->pDevice = pDevice;
+	this->ucFloatForm = pProgram->getFloatForm();
+
 	// Configuration for the boundary and timeseries data
 	if (pProgram->getFloatForm() == model::floatPrecision::kSingle)
 	{
 		sConfigurationSP pConfiguration;
 
 		pConfiguration.TimeseriesEntries = this->uiTimeseriesLength;
+		pConfiguration.TimeseriesWindow = this->uiWindowSize;
 		pConfiguration.TimeseriesInterval = this->dTimeseriesInterval;
 		pConfiguration.Definition = (cl_uint)this->ucValue;
 		pConfiguration.GridRows = this->pTransform->uiRows;
@@ -197,35 +207,12 @@ void CBoundaryGridded::prepareBoundary(
 			&pConfiguration,
 			sizeof(sConfigurationSP)
 		);
-
-		this->pBufferTimeseries = new COCLBuffer(
-			"Bdy_" + this->sName + "_Series",
-			pProgram,
-			true,
-			true,
-			sizeof(cl_float)* this->pTransform->uiColumns * this->pTransform->uiRows * this->uiTimeseriesLength,
-			true
-		);
-
-		unsigned long ulSize;
-		unsigned long ulOffset = 0;
-		for (unsigned int i = 0; i < this->uiTimeseriesLength; ++i)
-		{
-			void* pGridData = this->pTimeseries[i]->getBufferData( model::floatPrecision::kSingle, this->pTransform );
-			ulSize = sizeof( cl_float )* this->pTransform->uiColumns * this->pTransform->uiRows;
-			ulOffset += ulSize;
-			std::memcpy(
-				&( ( this->pBufferTimeseries->getHostBlock<cl_uchar*>() )[ulOffset] ),
-				pGridData,
-				ulSize
-			);
-			delete[] pGridData;
-		}
 	}
 	else {
 		sConfigurationDP pConfiguration;
 
 		pConfiguration.TimeseriesEntries = this->uiTimeseriesLength;
+		pConfiguration.TimeseriesWindow = this->uiWindowSize;
 		pConfiguration.TimeseriesInterval = this->dTimeseriesInterval;
 		pConfiguration.Definition = (cl_uint)this->ucValue;
 		pConfiguration.GridRows = this->pTransform->uiRows;
@@ -247,36 +234,27 @@ void CBoundaryGridded::prepareBoundary(
 			&pConfiguration,
 			sizeof(sConfigurationDP)
 		);
-
-		this->pBufferTimeseries = new COCLBuffer(
-			"Bdy_" + this->sName + "_Series",
-			pProgram,
-			true,
-			true,
-			sizeof( cl_double ) * this->pTransform->uiColumns * this->pTransform->uiRows * this->uiTimeseriesLength,
-			true
-		);
-
-		unsigned long ulSize;
-		unsigned long ulOffset = 0;
-		for (unsigned int i = 0; i < this->uiTimeseriesLength; ++i)
-		{
-			void* pGridData = this->pTimeseries[i]->getBufferData( model::floatPrecision::kDouble, this->pTransform );
-			ulSize = sizeof( cl_double ) * this->pTransform->uiColumns * this->pTransform->uiRows;
-			std::memcpy(
-				&((this->pBufferTimeseries->getHostBlock<cl_uchar*>())[ulOffset]),
-				pGridData,
-				ulSize
-			);
-			ulOffset += ulSize;
-			delete[] pGridData;
-		}
 	}
 
+	// Ring of frames, filled by streamBoundary() ahead of each batch
+	this->pBufferTimeseries = new COCLBuffer(
+		"Bdy_" + this->sName + "_Series",
+		pProgram,
+		true,
+		false,
+		( this->ucFloatForm == model::floatPrecision::kSingle ? sizeof( cl_float ) : sizeof( cl_double ) ) *
+			this->pTransform->uiColumns * this->pTransform->uiRows * this->uiWindowSize,
+		false
+	);
+
 	this->pBufferConfiguration->createBuffer();
 	this->pBufferConfiguration->queueWriteAll();
 	this->pBufferTimeseries->createBuffer();
-	this->pBufferTimeseries->queueWriteAll();
+
+	// Start loading the first frames in the background
+	this->bTerminate = false;
+	this->uiWindowStart = 0;
+	this->thrPrefetch = std::thread( &CBoundaryGridded::Threaded_prefetchFrames, this );
 
 	// Prepare kernel and arguments
 	this->oclKernel = pProgram->getKernel("bdy_Gridded");
@@ -292,30 +270,198 @@ void CBoundaryGridded::prepareBoundary(
 	};
 	this->oclKernel->assignArguments(aryArgsBdy);
 
-	// Dimension the kernel
-	// TODO: Need a more sensible group size!
-	CDomainCartesian* pDomain = static_cast<CDomainCartesian*>( this->pDomain );
-	this->oclKernel->setGlobalSize( ceil( pDomain->getCols() / 8 ) * 8, ceil( pDomain->getRows() / 8 ) * 8 );
-	this->oclKernel->setGroupSize( 8, 8 );
+	// Dimension the kernel over the enabled cells the grid covers, with a
+	// cell to spare either side as the kernel decides exactly
+	CDomainCartesian*	pDomain = static_cast<CDomainCartesian*>( this->pDomain );
+	double				dResolution;
+	double				dGridResolution = ( this->ucFloatForm == model::floatPrecision::kSingle ?
+											this->pTransform->dTargetResolution :
+											this->pTransform->dSourceResolution );
+	unsigned long		ulMinX = ULONG_MAX, ulMaxX = 0, ulMinY = ULONG_MAX, ulMaxY = 0;
+
+	pDomain->getCellResolution( &dResolution );
+	for ( unsigned long ulX = 1; ulX + 1 < pDomain->getCols(); ulX++ )
+	{
+		double dColumn = floor( ( ulX * dResolution - this->pTransform->dOffsetWest ) / dGridResolution );
+		if ( dColumn < -1.0 || dColumn > this->pTransform->uiColumns ) continue;
+		ulMinX = min( ulMinX, ulX );
+		ulMaxX = max( ulMaxX, ulX );
+	}
+	for ( unsigned long ulY = 1; ulY + 1 < pDomain->getRows(); ulY++ )
+	{
+		double dRow = floor( ( ulY * dResolution - this->pTransform->dOffsetSouth ) / dGridResolution );
+		if ( dRow < -1.0 || dRow > this->pTransform->uiRows ) continue;
+		ulMinY = min( ulMinY, ulY );
+		ulMaxY = max( ulMaxY, ulY );
+	}
+	if ( ulMinX == ULONG_MAX || ulMinY == ULONG_MAX )
+	{
+		this->findExtent( 1, 1, 0, 0 );
+	} else {
+		this->findExtent( ulMinX, ulMinY, ulMaxX, ulMaxY );
+	}
+	this->setKernelExtent();
 }
 
 // TODO: Only the cell buffer should be passed here...
-void CBoundaryGridded::applyBoundary(COCLBuffer* pBufferCell)
+void CBoundaryGridded::applyBoundary(COCLBuffer* pBufferCell, cl_uint uiWaitCount, const cl_event* clWaitList, cl_event* clEventOut)
 {
+	if ( !this->hasCells() )
+		return;
+
 	this->oclKernel->assignArgument(5, pBufferCell);
-	this->oclKernel->scheduleExecution();
+	this->oclKernel->scheduleExecution(uiWaitCount, clWaitList, clEventOut);
 }
 
+/*
+ *	Make sure the device ring holds every frame from the current time
+ *	forward, and release any frames which have been passed. Only called
+ *	between batches, when nothing queued can still be reading the ring.
+ */
 void CBoundaryGridded::streamBoundary(double dTime)
 {
-	// ...
-	// TODO: Should we handle all the memory buffer writing in here?...
+	if ( this->pBufferTimeseries == NULL || this->uiTimeseriesLength == 0 )
+		return;
+
+	unsigned int	uiFirst = min(
+		this->uiTimeseriesLength - 1,
+		static_cast<unsigned int>( floor( dTime / this->dTimeseriesInterval ) )
+	);
+	unsigned int	uiLast = min( this->uiTimeseriesLength, uiFirst + this->uiWindowSize );
+	unsigned long	ulFrameSize = ( this->ucFloatForm == model::floatPrecision::kSingle ? sizeof( cl_float ) : sizeof( cl_double ) ) *
+									this->pTransform->uiColumns * this->pTransform->uiRows;
+	std::vector<CBoundaryGriddedEntry*>	vUploaded;
+	std::vector<void*>					vConverted;
+
+	{
+		std::lock_guard<std::mutex> lockFrames( this->mtxFrames );
+		this->uiWindowStart = uiFirst;
+
+		// Anything before the window is no longer needed (a rollback
+		// will simply load it again)
+		while ( !this->mapFrames.empty() && this->mapFrames.begin()->first < uiFirst )
+		{
+			delete this->mapFrames.begin()->second;
+			this->mapFrames.erase( this->mapFrames.begin() );
+		}
+	}
+	this->cvFrames.notify_all();
+
+	for ( unsigned int uiFrame = uiFirst; uiFrame < uiLast; uiFrame++ )
+	{
+		unsigned int			uiSlot = uiFrame % this->uiWindowSize;
+		CBoundaryGriddedEntry*	pEntry;
+
+		{
+			std::unique_lock<std::mutex> lockFrames( this->mtxFrames );
+			if ( this->vRingFrames[ uiSlot ] == uiFrame )
+				continue;
+
+			this->cvFrames.wait( lockFrames, [this, uiFrame]{ return this->mapFrames.count( uiFrame ) > 0; } );
+
+			pEntry = this->mapFrames[ uiFrame ];
+			this->mapFrames.erase( uiFrame );
+			this->vRingFrames[ uiSlot ] = uiFrame;
+		}
+		this->cvFrames.notify_all();
+
+		void* pGridData = pEntry->getBufferData( this->ucFloatForm, this->pTransform );
+		this->pBufferTimeseries->queueWritePartial(
+			ulFrameSize * uiSlot,
+			ulFrameSize,
+			pGridData
+		);
+
+		vUploaded.push_back( pEntry );
+		if ( pGridData != static_cast<void*>( pEntry->dValues ) )
+			vConverted.push_back( pGridData );
+	}
+
+	if ( vUploaded.empty() )
+		return;
+
+	// Host copies must outlive the (non-blocking) writes
+	this->pDevice->blockUntilFinished();
+
+	for ( unsigned int i = 0; i < vConverted.size(); i++ )
+		delete[] static_cast<cl_float*>( vConverted[i] );
+	for ( unsigned int i = 0; i < vUploaded.size(); i++ )
+		delete vUploaded[i];
 }
 
 void CBoundaryGridded::cleanBoundary()
 {
-	// ...
-	// TODO: Is this needed? Most stuff is cleaned in the destructor
+	this->stopPrefetching();
+}
+
+/*
+ *	Load upcoming frames from disk ahead of the simulation, keeping no
+ *	more than two windows' worth in memory. Runs in its own thread.
+ */
+void CBoundaryGridded::Threaded_prefetchFrames()
+{
+	while ( true )
+	{
+		unsigned int	uiFrame;
+
+		{
+			std::unique_lock<std::mutex> lockFrames( this->mtxFrames );
+			this->cvFrames.wait( lockFrames, [this, &uiFrame]{ return this->bTerminate || this->getFrameToLoad( &uiFrame ); } );
+
+			if ( this->bTerminate )
+				break;
+		}
+
+		CRasterDataset *pRaster = new CRasterDataset();
+		pRaster->openFileRead( this->vFilenames[ uiFrame ] );
+		CBoundaryGriddedEntry* pEntry = new CBoundaryGriddedEntry(
+			uiFrame * this->dTimeseriesInterval,
+			pRaster->createArrayForBoundary( this->pTransform )
+		);
+		delete pRaster;
+
+		{
+			std::lock_guard<std::mutex> lockFrames( this->mtxFrames );
+			this->mapFrames[ uiFrame ] = pEntry;
+		}
+		this->cvFrames.notify_all();
+	}
+}
+
+/*
+ *	Find the earliest frame in the prefetch range which isn't yet loaded
+ *	or on the device. Must be called with the frame mutex held.
+ */
+bool CBoundaryGridded::getFrameToLoad( unsigned int* uiFrame )
+{
+	unsigned int uiEnd = min( this->uiTimeseriesLength, this->uiWindowStart + 2 * this->uiWindowSize );
+
+	for ( unsigned int i = this->uiWindowStart; i < uiEnd; i++ )
+	{
+		if ( this->vRingFrames[ i % this->uiWindowSize ] == i ||
+			 this->mapFrames.count( i ) > 0 )
+			continue;
+
+		*uiFrame = i;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ *	Stop the prefetch thread, if it's running
+ */
+void CBoundaryGridded::stopPrefetching()
+{
+	{
+		std::lock_guard<std::mutex> lockFrames( this->mtxFrames );
+		this->bTerminate = true;
+	}
+	this->cvFrames.notify_all();
+
+	if ( this->thrPrefetch.joinable() )
+		this->thrPrefetch.join();
 }
 
 /*
@@ -19,6 +19,12 @@
 #ifndef HIPIMS_BOUNDARIES_CBOUNDARYGRIDDED_H_
 #define HIPIMS_BOUNDARIES_CBOUNDARYGRIDDED_H_
 
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "../common.h"
 #include "CBoundary.h"
 
@@ -31,7 +37,7 @@ public:
 	virtual bool					setupFromConfig(XMLElement*, std::string);
 	virtual void					prepareBoundary(COCLDevice*, COCLProgram*, COCLBuffer*, COCLBuffer*,
 													COCLBuffer*, COCLBuffer*, COCLBuffer*);
-	virtual void					applyBoundary(COCLBuffer*);
+	virtual void					applyBoundary(COCLBuffer*, cl_uint = 0, const cl_event* = NULL, cl_event* = NULL);
 	virtual void					streamBoundary(double);
 	virtual void					cleanBoundary();
 
@@ -70,6 +76,7 @@ protected:
 		cl_ulong		Definition;
 		cl_ulong		GridRows;
 		cl_ulong		GridCols;
+		cl_ulong		TimeseriesWindow;
 	};
 	struct sConfigurationDP
 	{
@@ -81,6 +88,7 @@ protected:
 		cl_ulong		Definition;
 		cl_ulong		GridRows;
 		cl_ulong		GridCols;
+		cl_ulong		TimeseriesWindow;
 	};
 
 	void							setValue(unsigned char a)				{ ucValue = a; };
@@ -91,12 +99,28 @@ protected:
 	double							dTimeseriesLength;
 	double							dTimeseriesInterval;
 
-	CBoundaryGriddedEntry**			pTimeseries;
 	SBoundaryGridTransform*			pTransform;
 	unsigned int					uiTimeseriesLength;
 
+	COCLDevice*						pDevice;
 	COCLBuffer*						pBufferTimeseries;
 	COCLBuffer*						pBufferConfiguration;
+	unsigned char					ucFloatForm;
+
+	// Streaming of the timeseries through a ring of frames on the device
+	void							Threaded_prefetchFrames();
+	bool							getFrameToLoad(unsigned int*);
+	void							stopPrefetching();
+
+	std::vector<std::string>		vFilenames;					// Raster for each frame in the timeseries
+	std::vector<unsigned int>		vRingFrames;				// Frame held in each slot of the device ring
+	std::map<unsigned int, CBoundaryGriddedEntry*>	mapFrames;	// Frames loaded on the host but not yet on the device
+	unsigned int					uiWindowSize;				// Frames held on the device at once
+	unsigned int					uiWindowStart;				// First frame needed by the simulation
+	std::thread						thrPrefetch;				// Background raster loading thread
+	std::mutex						mtxFrames;					// Guards the frame map, ring and window
+	std::condition_variable			cvFrames;					// Signalled when frames are loaded or requested
+	bool							bTerminate;					// Should the prefetch thread exit?
 };
 
 #endif
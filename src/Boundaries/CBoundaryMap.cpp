@@ -27,6 +27,7 @@
 #include "CBoundaryUniform.h"
 #include "CBoundaryGridded.h"
 #include "../Datasets/CXMLDataset.h"
+#include "../Datasets/CBinaryTableDataset.h"
 #include "../Domain/CDomainManager.h"
 #include "../Domain/CDomain.h"
 #include "../Domain/Cartesian/CDomainCartesian.h"
@@ -66,17 +67,67 @@ void CBoundaryMap::prepareBoundaries(
 		COCLBuffer* pBufferTimestep
 	)
 {
+	pBoundaryOrder.clear();
+	uiBoundaryDependencies.clear();
+
 	for (mapBoundaries_t::iterator it = mapBoundaries.begin(); it != mapBoundaries.end(); it++)
+	{
 		(it->second)->prepareBoundary( pProgram->getDevice(), pProgram, pBufferBed, pBufferManning, pBufferTime, pBufferTimeHydrological, pBufferTimestep );
+		pBoundaryOrder.push_back( it->second );
+	}
+
+	// Boundaries which modify the same cells must still run one after another,
+	// but disjoint boundaries can overlap on the device
+	uiBoundaryDependencies.resize( pBoundaryOrder.size() );
+	for (unsigned int i = 0; i < pBoundaryOrder.size(); i++)
+	{
+		for (unsigned int j = 0; j < i; j++)
+		{
+			if ( pBoundaryOrder[i]->overlaps( pBoundaryOrder[j] ) )
+				uiBoundaryDependencies[i].push_back( j );
+		}
+	}
 }
 
 /*
- *	Apply the buffers (execute the relevant kernels etc.)
+ *	Apply the buffers (execute the relevant kernels etc.) once the wait
+ *	event has completed, returning the events for each boundary if requested
  */
-void CBoundaryMap::applyBoundaries(COCLBuffer* pCellBuffer)
+void CBoundaryMap::applyBoundaries(COCLBuffer* pCellBuffer, cl_event clWaitEvent, std::vector<cl_event>* pEventsOut)
 {
-	for (mapBoundaries_t::iterator it = mapBoundaries.begin(); it != mapBoundaries.end(); it++)
-		(it->second)->applyBoundary(pCellBuffer);
+	std::vector<cl_event>	clBoundaryEvents( pBoundaryOrder.size(), (cl_event)NULL );
+	std::vector<cl_event>	clWaitList;
+
+	for (unsigned int i = 0; i < pBoundaryOrder.size(); i++)
+	{
+		clWaitList.clear();
+		if ( clWaitEvent != NULL )
+			clWaitList.push_back( clWaitEvent );
+		for (unsigned int j = 0; j < uiBoundaryDependencies[i].size(); j++)
+		{
+			if ( clBoundaryEvents[ uiBoundaryDependencies[i][j] ] != NULL )
+				clWaitList.push_back( clBoundaryEvents[ uiBoundaryDependencies[i][j] ] );
+		}
+
+		pBoundaryOrder[i]->applyBoundary( 
+			pCellBuffer,
+			clWaitList.size(),
+			( clWaitList.empty() ? NULL : &clWaitList[0] ),
+			&clBoundaryEvents[i]
+		);
+	}
+
+	for (unsigned int i = 0; i < clBoundaryEvents.size(); i++)
+	{
+		if ( clBoundaryEvents[i] == NULL ) 
+			continue;
+		if ( pEventsOut != NULL )
+		{
+			pEventsOut->push_back( clBoundaryEvents[i] );
+		} else {
+			clReleaseEvent( clBoundaryEvents[i] );
+		}
+	}
 }
 
 /*
@@ -107,6 +158,7 @@ bool	CBoundaryMap::setupFromConfig( XMLElement *pConfiguration )
 								*pTimeSeriesElement,		// <timeseries .../>
 								*pDomainEdgeElement;		// <domainEdge .../>
 	CCSVDataset					*pMapFile = NULL;
+	CBinaryTableDataset			*pMapTable = NULL;
 
 	pBoundariesElement = pConfiguration->FirstChildElement("boundaryConditions");
 	if (pBoundariesElement == NULL)
@@ -127,9 +179,14 @@ bool	CBoundaryMap::setupFromConfig( XMLElement *pConfiguration )
 	// ---
 	//  Map file
 	// ---
-	if (sMapFile.length() > 0)
+	if (sMapFile.length() > 0 && CBinaryTableDataset::isBinaryTable(sMapFile))
+	{
+		pMapTable = new CBinaryTableDataset(sMapFile);
+		pMapTable->readFile();
+	}
+	else if (sMapFile.length() > 0)
 	{
-		pMapFile = new CCSVDataset(sMapFile);
+		pMapFile = new CCSVDataset(sMapFile, true);
 		pMapFile->readFile();
 	}
 
@@ -177,6 +234,8 @@ bool	CBoundaryMap::setupFromConfig( XMLElement *pConfiguration )
 			else {
 				if ( pMapFile != NULL )
 					pNewBoundary->importMap(pMapFile);
+				if ( pMapTable != NULL )
+					pNewBoundary->importMap(pMapTable);
 			}
 
 			// Store the new boundary in the unordered map
@@ -205,6 +264,7 @@ bool	CBoundaryMap::setupFromConfig( XMLElement *pConfiguration )
 	}
 
 	delete pMapFile;
+	delete pMapTable;
 
 	return true;
 }
@@ -46,7 +46,7 @@ public:
 	CBoundary*						getBoundaryByName( std::string );
 
 	void							prepareBoundaries( COCLProgram*, COCLBuffer*, COCLBuffer*, COCLBuffer*, COCLBuffer*, COCLBuffer* );
-	void							applyBoundaries( COCLBuffer* );
+	void							applyBoundaries( COCLBuffer*, cl_event = NULL, std::vector<cl_event>* = NULL );
 	void							streamBoundaries( double );
 
 	unsigned int					getBoundaryCount();
@@ -59,6 +59,8 @@ private:
 	CDomain*						pDomain;
 	unsigned char					ucBoundaryTreatment[4];
 	mapBoundaries_t					mapBoundaries;
+	std::vector<CBoundary*>			pBoundaryOrder;							// Boundaries in the order they are applied
+	std::vector< std::vector<unsigned int> >	uiBoundaryDependencies;		// Earlier boundaries each must wait on
 
 };
 
@@ -21,6 +21,7 @@
 
 #include "CBoundaryMap.h"
 #include "CBoundaryUniform.h"
+#include "../Datasets/CBinaryTableDataset.h"
 #include "../Domain/Cartesian/CDomainCartesian.h"
 #include "../OpenCL/Executors/COCLBuffer.h"
 #include "../OpenCL/Executors/COCLKernel.h"
@@ -76,7 +77,23 @@ bool CBoundaryUniform::setupFromConfig(XMLElement* pElement, std::string sBounda
 		);
 	}
 
-	// Timeseries file...
+	// Timeseries file, converted to a binary table...
+	if (CBinaryTableDataset::isBinaryTable(std::string(cBoundarySource)))
+	{
+		CBinaryTableDataset pTable(sBoundarySourceDir + std::string(cBoundarySource));
+		if (!pTable.readFile())
+		{
+			model::doError(
+				"Could not read a uniform boundary timeseries file.",
+				model::errorCodes::kLevelWarning
+				);
+			return false;
+		}
+		this->importTimeseries(&pTable);
+		return true;
+	}
+
+	// ...or a CSV
 	CCSVDataset* pCSVFile = new CCSVDataset(
 		sBoundarySourceDir + std::string(cBoundarySource)
 		);
@@ -105,7 +122,6 @@ void CBoundaryUniform::importTimeseries(CCSVDataset *pCSV)
 {
 	unsigned int uiIndex = 0;
 	bool bInvalidEntries = false;
-	bool bProcessedHeaders = false;
 
 	// Is file ready?
 	if (!pCSV->isReady())
@@ -114,29 +130,15 @@ void CBoundaryUniform::importTimeseries(CCSVDataset *pCSV)
 	// Allocate memory
 	this->pTimeseries = new sTimeseriesUniform[pCSV->getLength()];
 
-	// Iterate over the items in the list
-	for (vector<vector<std::string>>::const_iterator it = pCSV->begin();
-		it != pCSV->end();
-		it++)
+	// Iterate over the rows after the headers
+	for (unsigned int uiRow = 0; uiRow < pCSV->getLength(); uiRow++)
 	{
-		// TODO: Check if there are headers first... first time should be zero
-		if (uiIndex == 0 && !bProcessedHeaders)
-		{
-			bProcessedHeaders = true;
-			continue;
-		}
-
-		if (it->size() == 2)
+		if (pCSV->getFieldCount(uiRow) == 2 &&
+			pCSV->isNumber(uiRow, 0) &&
+			pCSV->isNumber(uiRow, 1))
 		{
-			try
-			{
-				this->pTimeseries[uiIndex].dTime = boost::lexical_cast<cl_double>((*it)[0]);
-				this->pTimeseries[uiIndex].dComponent = boost::lexical_cast<cl_double>((*it)[1]);
-			}
-			catch (boost::bad_lexical_cast)
-			{
-				bInvalidEntries = true;
-			}
+			this->pTimeseries[uiIndex].dTime = pCSV->getValue(uiRow, 0);
+			this->pTimeseries[uiIndex].dComponent = pCSV->getValue(uiRow, 1);
 		}
 		else {
 			bInvalidEntries = true;
@@ -163,12 +165,60 @@ void CBoundaryUniform::importTimeseries(CCSVDataset *pCSV)
 		return;
 	}
 
+	this->setTimeseriesLength(uiIndex);
+}
+
+/*
+*	Import timeseries data from a binary table, which is held in the same
+*	layout so can be copied as it is
+*/
+void CBoundaryUniform::importTimeseries(CBinaryTableDataset *pTable)
+{
+	double dInterval;
+
+	// Is file ready?
+	if (!pTable->isReady())
+		return;
+
+	if (pTable->getColumns() != 2)
+	{
+		model::doError(
+			"A uniform boundary timeseries needs two columns.",
+			model::errorCodes::kLevelWarning
+			);
+		return;
+	}
+
+	// Need at least two entries
+	if (pTable->getLength() < 2)
+	{
+		model::doError(
+			"A boundary timeseries is too short.",
+			model::errorCodes::kLevelWarning
+			);
+		return;
+	}
+
+	if (!pTable->getTimeseriesInterval(&dInterval))
+		return;
+
+	this->pTimeseries = new sTimeseriesUniform[pTable->getLength()];
+	std::memcpy(this->pTimeseries, pTable->getRow(0), sizeof(sTimeseriesUniform) * pTable->getLength());
+
+	this->setTimeseriesLength(pTable->getLength());
+}
+
+/*
+*	Take the interval, length and volume from the timeseries loaded
+*/
+void CBoundaryUniform::setTimeseriesLength(unsigned int uiLength)
+{
 	// Calculate the interval
 	this->dTimeseriesInterval = pTimeseries[1].dTime - pTimeseries[0].dTime;
 
 	// Store the length of the timeseries
-	this->uiTimeseriesLength = uiIndex;
-	this->dTimeseriesLength = pTimeseries[uiIndex - 1].dTime;
+	this->uiTimeseriesLength = uiLength;
+	this->dTimeseriesLength = pTimeseries[uiLength - 1].dTime;
 
 	// Calculate the amount of mass in the timeseries
 	this->dTotalVolume = 0.0;
@@ -289,16 +339,24 @@ void CBoundaryUniform::prepareBoundary(
 	};
 	this->oclKernel->assignArguments(aryArgsBdy);
 
-	// TODO: Need a more sensible group size!
+	// Only launch over the enabled cells, away from the domain edge
 	CDomainCartesian* pDomain = static_cast<CDomainCartesian*>(this->pDomain);
-	this->oclKernel->setGlobalSize(ceil(pDomain->getCols() / 8) * 8, ceil(pDomain->getRows() / 8) * 8);
-	this->oclKernel->setGroupSize(8, 8);
+	if (pDomain->getCols() > 2 && pDomain->getRows() > 2)
+	{
+		this->findExtent(1, 1, pDomain->getCols() - 2, pDomain->getRows() - 2);
+	} else {
+		this->findExtent(1, 1, 0, 0);
+	}
+	this->setKernelExtent();
 }
 
-void CBoundaryUniform::applyBoundary(COCLBuffer* pBufferCell)
+void CBoundaryUniform::applyBoundary(COCLBuffer* pBufferCell, cl_uint uiWaitCount, const cl_event* clWaitList, cl_event* clEventOut)
 {
+	if (!this->hasCells())
+		return;
+
 	this->oclKernel->assignArgument(5, pBufferCell);
-	this->oclKernel->scheduleExecution();
+	this->oclKernel->scheduleExecution(uiWaitCount, clWaitList, clEventOut);
 }
 
 void CBoundaryUniform::streamBoundary(double dTime)
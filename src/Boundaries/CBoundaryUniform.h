@@ -31,7 +31,7 @@ public:
 	virtual bool					setupFromConfig(XMLElement*, std::string);
 	virtual void					prepareBoundary(COCLDevice*, COCLProgram*, COCLBuffer*, COCLBuffer*,
 													COCLBuffer*, COCLBuffer*, COCLBuffer*);
-	virtual void					applyBoundary(COCLBuffer*);
+	virtual void					applyBoundary(COCLBuffer*, cl_uint = 0, const cl_event* = NULL, cl_event* = NULL);
 	virtual void					streamBoundary(double);
 	virtual void					cleanBoundary();
 
@@ -59,6 +59,8 @@ protected:
 
 	void							setValue(unsigned char a)			{ ucValue = a; };
 	void							importTimeseries(CCSVDataset*);
+	void							importTimeseries(CBinaryTableDataset*);
+	void							setTimeseriesLength(unsigned int);
 
 	unsigned char					ucValue;
 
@@ -46,6 +46,15 @@ inline std::string getOCLResourceFilename( std::string sID )
 	if ( strcmp( cID, "CLFriction_H" ) == 0 )
 		return sBaseDir + "Schemes/CLFriction.clh";
 
+	if ( strcmp( cID, "CLAccumulators_H" ) == 0 )
+		return sBaseDir + "Schemes/CLAccumulators.clh";
+
+	if ( strcmp( cID, "CLGauges_H" ) == 0 )
+		return sBaseDir + "Schemes/CLGauges.clh";
+
+	if ( strcmp( cID, "CLOutputFields_H" ) == 0 )
+		return sBaseDir + "Schemes/CLOutputFields.clh";
+
 	if ( strcmp( cID, "CLSchemeGodunov_H" ) == 0 )
 		return sBaseDir + "Schemes/CLSchemeGodunov.clh";
 
@@ -76,6 +85,15 @@ inline std::string getOCLResourceFilename( std::string sID )
 	if ( strcmp( cID, "CLFriction_C" ) == 0 )
 		return sBaseDir + "Schemes/CLFriction.clc";
 
+	if ( strcmp( cID, "CLAccumulators_C" ) == 0 )
+		return sBaseDir + "Schemes/CLAccumulators.clc";
+
+	if ( strcmp( cID, "CLGauges_C" ) == 0 )
+		return sBaseDir + "Schemes/CLGauges.clc";
+
+	if ( strcmp( cID, "CLOutputFields_C" ) == 0 )
+		return sBaseDir + "Schemes/CLOutputFields.clc";
+
 	if ( strcmp( cID, "CLSchemeGodunov_C" ) == 0 )
 		return sBaseDir + "Schemes/CLSchemeGodunov.clc";
 
@@ -20,6 +20,7 @@
 // Includes
 #include <cmath>
 #include <math.h>
+#include <chrono>
 #include "common.h"
 #include "main.h"
 #include "OpenCL/Executors/CExecutorControlOpenCL.h"
@@ -28,6 +29,8 @@
 #include "Schemes/CScheme.h"
 #include "Datasets/CXMLDataset.h"
 #include "Datasets/CRasterDataset.h"
+#include "Datasets/CCheckpointDataset.h"
+#include "Datasets/CZarrDataset.h"
 #include "MPI/CMPIManager.h"
 
 using std::min;
@@ -51,12 +54,19 @@ CModel::CModel(void)
 	this->dCurrentTime		= 0.0;
 	this->dSimulationTime	= 60;
 	this->dOutputFrequency	= 60;
+	this->dCheckpointFrequency = 0.0;
+	this->dLastCheckpointTime = 0.0;
+	this->dLastRebalanceTime = 0.0;
 	this->bDoublePrecision	= true;
+	this->ucCellStateLayout	= model::cellStateLayout::kArrayOfStructures;
 
 	this->pProgressCoords.sX = -1;
 	this->pProgressCoords.sY = -1;
 
 	this->ulRealTimeStart = 0;
+
+	this->ulBatchesCompleted = 0;
+	this->ulBatchesSeen		 = 0;
 }
 
 /*
@@ -103,6 +113,18 @@ void CModel::setupFromConfig( XMLElement* pXNode )
 				this->setOutputFrequency( boost::lexical_cast<double>( cParameterValue ) );
 			}
 		}
+		else if ( strcmp( cParameterName, "checkpointfrequency" ) == 0 )
+		{ 
+			if ( !CXMLDataset::isValidFloat( cParameterValue ) )
+			{
+				model::doError(
+					"Invalid checkpoint frequency given.",
+					model::errorCodes::kLevelWarning
+				);
+			} else {
+				this->setCheckpointFrequency( boost::lexical_cast<double>( cParameterValue ) );
+			}
+		}
 		else if ( strcmp( cParameterName, "floatingpointprecision" ) == 0 )
 		{ 
 			unsigned char ucFPPrecision = 255;
@@ -120,6 +142,23 @@ void CModel::setupFromConfig( XMLElement* pXNode )
 				this->setFloatPrecision( ucFPPrecision );
 			}
 		}
+		else if ( strcmp( cParameterName, "cellstatelayout" ) == 0 )
+		{ 
+			unsigned char ucLayout = 255;
+			if ( strcmp( cParameterValue, "aos" ) == 0 )
+				ucLayout = model::cellStateLayout::kArrayOfStructures;
+			if ( strcmp( cParameterValue, "soa" ) == 0 )
+				ucLayout = model::cellStateLayout::kStructureOfArrays;
+			if ( ucLayout == 255 )
+			{
+				model::doError(
+					"Invalid cell state layout given.",
+					model::errorCodes::kLevelWarning
+				);
+			} else {
+				this->setCellStateLayout( ucLayout );
+			}
+		}
 		else 
 		{
 			model::doError(
@@ -139,6 +178,10 @@ CModel::~CModel(void)
 {
 	if (this->domains != NULL)
 		delete this->domains;
+#ifdef MPI_ON
+	if ( this->mpiManager != NULL )
+		this->mpiManager->releaseLinkCommunicator();
+#endif
 	if ( this->execController != NULL )
 		delete this->execController;
 	this->log->writeLine("The model engine is completely unloaded.");
@@ -207,7 +250,9 @@ void CModel::logDetails()
 	this->log->writeLine( "  End time:           " + std::string( Util::fromTimestamp( this->ulRealTimeStart + static_cast<unsigned long>( std::ceil( this->dSimulationTime ) ), "%d-%b-%Y %H:%M:%S" ) ), true, wColour );
 	this->log->writeLine( "  Simulation length:  " + Util::secondsToTime( this->dSimulationTime ), true, wColour );
 	this->log->writeLine( "  Output frequency:   " + Util::secondsToTime( this->dOutputFrequency ), true, wColour );
+	this->log->writeLine( "  Checkpoints:        " + (std::string)( this->dCheckpointFrequency > 0.0 ? Util::secondsToTime( this->dCheckpointFrequency ) : "Disabled" ), true, wColour );
 	this->log->writeLine( "  Floating-point:     " + (std::string)( this->getFloatPrecision() == model::floatPrecision::kDouble ? "Double-precision" : "Single-precision" ), true, wColour );
+	this->log->writeLine( "  Cell state layout:  " + (std::string)( this->getCellStateLayout() == model::cellStateLayout::kStructureOfArrays ? "Structure of arrays" : "Array of structures" ), true, wColour );
 	this->log->writeDivide();
 }
 
@@ -286,6 +331,22 @@ void	CModel::setOutputFrequency( double dFrequency )
 	this->dOutputFrequency = dFrequency;
 }
 
+/*
+ *  Set the frequency of checkpoints
+ */
+void	CModel::setCheckpointFrequency( double dFrequency )
+{
+	this->dCheckpointFrequency = dFrequency;
+}
+
+/*
+ *  Get the frequency of checkpoints
+ */
+double	CModel::getCheckpointFrequency()
+{
+	return this->dCheckpointFrequency;
+}
+
 /*
  *  Sets the real world start time
  */
@@ -337,6 +398,22 @@ unsigned char	CModel::getFloatPrecision()
 	return ( this->bDoublePrecision ? model::floatPrecision::kDouble : model::floatPrecision::kSingle );
 }
 
+/*
+ *  Set the cell state memory layout
+ */
+void	CModel::setCellStateLayout( unsigned char ucLayout )
+{
+	this->ucCellStateLayout = ucLayout;
+}
+
+/*
+ *  Get the cell state memory layout
+ */
+unsigned char	CModel::getCellStateLayout()
+{
+	return this->ucCellStateLayout;
+}
+
 /*
  *  Write details of where model execution is currently at
  */
@@ -513,6 +590,12 @@ void	CModel::runModelPrepare()
 	dTargetTime			= 0.0;
 	dLastSyncTime		= -1.0;
 	dLastOutputTime		= 0.0;
+	dLastCheckpointTime	= 0.0;
+	dLastRebalanceTime	= 0.0;
+
+	// Pick up where a previous run left off if requested
+	if ( model::resumeDir != NULL && !this->runModelResume() )
+		model::forceAbort = true;
 
 	// Global block until all domains are ready
 	// Don't use the global block function here as that's for async blocking during 
@@ -748,6 +831,13 @@ void	CModel::runModelUpdateTarget( double dTimeBase )
 		dEarliestSyncProposal = (floor(dLastSyncTime / dOutputFrequency) + 1) * dOutputFrequency;
 	}
 
+	// Stop before the device runs out of room for gauge samples
+	double dGaugeInterval = domains->getGaugeReadbackInterval();
+	if (dGaugeInterval > 0.0 && dEarliestSyncProposal > dLastSyncTime + dGaugeInterval)
+	{
+		dEarliestSyncProposal = dLastSyncTime + dGaugeInterval;
+	}
+
 	// Reduce across all MPI nodes if required
 #ifdef MPI_ON
 	if ( this->getDomainSet()->getSyncMethod() == model::syncMethod::kSyncForecast )
@@ -790,6 +880,15 @@ void	CModel::runModelSync()
 
 	// Write outputs if possible
 	this->runModelOutputs();
+
+	// Time series samples are gathered on the device between syncs
+	domains->writeGauges();
+
+	// Take a checkpoint alongside the outputs if one is due
+	this->runModelCheckpoint();
+
+	// Even out the work between split domains if it's time to
+	this->runModelRebalance();
 		
 	// Calculate a new target time to aim for
 	this->runModelUpdateTarget( dCurrentTime );
@@ -864,6 +963,63 @@ void	CModel::runModelBlockGlobal()
 #endif
 }
 
+/*
+ *  Sleep until a batch completes, rather than spinning on the domain states,
+ *  but wake in time for the next progress update
+ */
+void	CModel::runModelWait( CBenchmark::sPerformanceMetrics * sTotalMetrics )
+{
+	bool bAnyRunning = false;
+
+	for (unsigned int i = 0; i < domains->getDomainCount(); ++i)
+	{
+		if (!domains->isDomainLocal(i))
+			continue;
+
+		if (domains->getDomain(i)->getScheme()->isRunning())
+		{
+			bAnyRunning = true;
+		} 
+		else if (domains->getDomain(i)->getDevice()->isBusy()) 
+		{
+			// Work queued outside a batch (e.g. link data) must finish before
+			// the domain is idle, and the worker thread is asleep
+			domains->getDomain(i)->getDevice()->blockUntilFinished();
+		}
+	}
+
+	// Idle domains may be scheduled straight away, and MPI traffic still
+	// needs polling, so only sleep while a batch is in progress
+	if (!bAnyRunning || model::forceAbort)
+		return;
+#ifdef MPI_ON
+	return;
+#endif
+
+	double dWait = 0.85 - ( sTotalMetrics->dSeconds - dLastProgressUpdate );
+	if (dWait < 0.01) 
+		dWait = 0.01;
+
+	std::unique_lock<std::mutex> lockBatch( this->mtxBatchComplete );
+	this->cvBatchComplete.wait_for(
+		lockBatch,
+		std::chrono::milliseconds( static_cast<long long>( dWait * 1000.0 ) ),
+		[this]{ return this->ulBatchesCompleted != this->ulBatchesSeen; }
+	);
+}
+
+/*
+ *  Called by the worker threads when a batch has been completed
+ */
+void	CModel::notifyBatchComplete()
+{
+	{
+		std::lock_guard<std::mutex> lockBatch( this->mtxBatchComplete );
+		this->ulBatchesCompleted++;
+	}
+	this->cvBatchComplete.notify_all();
+}
+
 /*
  *  Write output files if required.
  */
@@ -890,6 +1046,95 @@ void	CModel::runModelOutputs()
 	this->runModelBlockGlobal();
 }
 
+/*
+ *  Write checkpoints if required. These are only taken at output times so
+ *  a resumed run follows exactly the same sequence of sync points.
+ */
+void	CModel::runModelCheckpoint()
+{
+	if ( this->dCheckpointFrequency <= 0.0 ||
+		 bRollbackRequired ||
+		 !bSynchronised ||
+		 !bAllIdle ||
+		 fabs( this->dCurrentTime - dLastOutputTime ) > 1E-5 ||
+		 this->dCurrentTime - dLastCheckpointTime < this->dCheckpointFrequency - 1E-5 ||
+		 this->dCurrentTime >= dSimulationTime - 1E-5 )
+		return;
+
+	pManager->log->writeLine( "Writing checkpoint at " + Util::secondsToTime( this->dCurrentTime ) + "..." );
+
+	for (unsigned int i = 0; i < domains->getDomainCount(); ++i)
+	{
+		if (domains->isDomainLocal(i))
+			domains->getDomain(i)->writeCheckpoint( dLastOutputTime );
+	}
+	dLastCheckpointTime = this->dCurrentTime;
+}
+
+/*
+ *  Move cells between the pieces of a domain split across devices, so
+ *  each finishes its batches in roughly the same time.
+ */
+void	CModel::runModelRebalance()
+{
+	if ( domains->getRebalanceFrequency() <= 0.0 ||
+		 bRollbackRequired ||
+		 !bSynchronised ||
+		 !bAllIdle ||
+		 this->dCurrentTime - dLastRebalanceTime < domains->getRebalanceFrequency() - 1E-5 ||
+		 this->dCurrentTime >= dSimulationTime - 1E-5 )
+		return;
+
+	domains->rebalanceDomains( this->dCurrentTime );
+	dLastRebalanceTime = this->dCurrentTime;
+}
+
+/*
+ *  Load each domain's state from its checkpoint and move the model
+ *  time forward to match
+ */
+bool	CModel::runModelResume()
+{
+	sCheckpointHeader	pHeader;
+	bool				bFirst = true;
+
+	for (unsigned int i = 0; i < domains->getDomainCount(); ++i)
+	{
+		if (!domains->isDomainLocal(i))
+			continue;
+
+		if ( !domains->getDomain(i)->loadCheckpoint( std::string( model::resumeDir ), &pHeader ) )
+			return false;
+
+		if ( !bFirst && fabs( pHeader.dTime - dCurrentTime ) > 1E-5 )
+		{
+			model::doError(
+				"Checkpoints for each domain were taken at different times.",
+				model::errorCodes::kLevelModelStop
+			);
+			return false;
+		}
+
+		dCurrentTime	= pHeader.dTime;
+		dLastOutputTime	= pHeader.dLastOutputTime;
+		bFirst			= false;
+
+		domains->getDomain(i)->resumeGauges( dCurrentTime );
+	}
+
+	dEarliestTime		= dCurrentTime;
+	dTargetTime			= dCurrentTime;
+	dLastCheckpointTime	= dCurrentTime;
+	dLastRebalanceTime	= dCurrentTime;
+
+	// Output stores carry on from the same point
+	CZarrDataset::setResumeTime( dCurrentTime );
+
+	pManager->log->writeLine( "Simulation resumed at " + Util::secondsToTime( dCurrentTime ) + "." );
+
+	return true;
+}
+
 /*
 *  Process incoming and pending MPI messages etc.
 */
@@ -1031,7 +1276,10 @@ void	CModel::runModelCleanup()
 	for (unsigned int i = 0; i < domains->getDomainCount(); ++i)
 	{
 		if (domains->isDomainLocal(i))
+		{
 			domains->getDomain(i)->getScheme()->cleanupSimulation();
+			domains->getDomain(i)->waitForOutputs();
+		}
 	}
 }
 
@@ -1064,6 +1312,12 @@ void	CModel::runModelMain()
 	// Even if user has forced abort, still wait until all idle state is reached
 	while ( ( this->dCurrentTime < dSimulationTime - 1E-5 && !model::forceAbort ) || !bAllIdle )
 	{
+		// Any batch completing after this point will cut short the wait below
+		{
+			std::lock_guard<std::mutex> lockBatch( this->mtxBatchComplete );
+			this->ulBatchesSeen = this->ulBatchesCompleted;
+		}
+
 		// Assess the overall state of the simulation at present
 		this->runModelDomainAssess(
 			bSyncReady,
@@ -1097,6 +1351,11 @@ void	CModel::runModelMain()
 		this->runModelUI(
 			sTotalMetrics
 		);
+
+		// Nothing more to do until a domain finishes its batch
+		this->runModelWait(
+			sTotalMetrics
+		);
 	}
 
 	// Update to 100% progress bar
@@ -1113,6 +1372,9 @@ void	CModel::runModelMain()
 			"Simulation has been aborted",
 			model::errorCodes::kLevelModelStop
 		);
+	} else {
+		// Maxima, arrival times and durations cover the whole run
+		this->getDomainSet()->writeFinalOutputs();
 	}
 
 	// Get the total number of cells calculated
@@ -1133,6 +1395,9 @@ void	CModel::runModelMain()
 	//pManager->log->writeLine( "Final volume:        " + toString( static_cast<int>( dVolume ) ) + "m3" );
 	pManager->log->writeDivide();
 
+	// Kernel timings, if profiling was requested
+	this->execController->writeProfilingReport();
+
 	delete   pBenchmarkAll;
 	delete[] bSyncReady;
 	delete[] bIdle;
@@ -22,6 +22,8 @@
 #include "OpenCL/opencl.h"
 #include "General/CBenchmark.h"
 #include "Datasets/TinyXML/tinyxml2.h"
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 
 // Some classes we need to know about...
@@ -63,12 +65,17 @@ class CModel
 		void					runModelUpdateTarget(double);					// Calculate a new target time
 		void					runModelSync(void);								// Synchronise domain and timestep data
 		void					runModelOutputs(void);							// Process outputs
+		void					runModelCheckpoint(void);						// Write checkpoints if required
+		void					runModelRebalance(void);						// Rebalance split domains if required
+		bool					runModelResume(void);							// Resume domain states from checkpoints
 		void					runModelMPI(void);								// Process MPI queue etc.
 		void					runModelSchedule( CBenchmark::sPerformanceMetrics *, bool * );	// Schedule work
 		void					runModelUI( CBenchmark::sPerformanceMetrics * );// Update progress data etc.
 		void					runModelRollback(void);							// Rollback simulation
 		void					runModelBlockGlobal(void);						// Block all domains until all are done
 		void					runModelBlockNode(void);						// Block further processing on this node only
+		void					runModelWait( CBenchmark::sPerformanceMetrics * );	// Sleep until a batch completes or the UI is due
+		void					notifyBatchComplete(void);						// Wake the main loop when a batch completes
 		void					runModelCleanup(void);							// Clean up after a simulation completes/aborts
 
 		void					logDetails();									// Spit some info out to the log
@@ -78,8 +85,12 @@ class CModel
 		void					setRealStart( char*, char* = NULL );			// Set the real world start time
 		double					getOutputFrequency();							// Get the output frequency
 		void					setOutputFrequency( double );					// Set the output frequency
+		double					getCheckpointFrequency();						// Get the checkpoint frequency
+		void					setCheckpointFrequency( double );				// Set the checkpoint frequency
 		void					setFloatPrecision( unsigned char );				// Set floating point precision
 		unsigned char			getFloatPrecision();							// Get floating point precision
+		void					setCellStateLayout( unsigned char );			// Set cell state memory layout
+		unsigned char			getCellStateLayout();							// Get cell state memory layout
 		void					setName( std::string );							// Sets the name
 		void					setDescription( std::string );					// Sets the description
 		void					writeOutputs();									// Produce output files
@@ -101,11 +112,15 @@ class CModel
 		std::string				sModelName;										// Short name for the model
 		std::string				sModelDescription;								// Short description of the model
 		bool					bDoublePrecision;								// Double precision enabled?
+		unsigned char			ucCellStateLayout;								// Cell state memory layout
 		double					dSimulationTime;								// Total length of simulations
 		double					dCurrentTime;									// Current simulation time
 		double					dVisualisationTime;								// Current visualisation time
 		double					dProcessingTime;								// Total processing time
 		double					dOutputFrequency;								// Frequency of outputs
+		double					dCheckpointFrequency;							// Frequency of checkpoints (zero if disabled)
+		double					dLastCheckpointTime;							// Time the last checkpoint was taken
+		double					dLastRebalanceTime;								// Time split domains were last rebalanced
 		double					dLastSyncTime;									//
 		double					dLastOutputTime;								//
 		double					dLastProgressUpdate;							//
@@ -117,6 +132,10 @@ class CModel
 		bool					bAllIdle;										//
 		bool					bWaitOnLinks;									//
 		bool					bSynchronised;									//
+		unsigned long			ulBatchesCompleted;								// Number of batches completed by worker threads
+		unsigned long			ulBatchesSeen;									// Batches completed as of the start of this loop
+		std::mutex				mtxBatchComplete;								// Guards the batch completion count
+		std::condition_variable	cvBatchComplete;								// Signalled when a batch completes
 		unsigned char			ucFloatSize;									// Size of single/double precision floats used
 		cursorCoords			pProgressCoords;								// Buffer coords of the progress output
 
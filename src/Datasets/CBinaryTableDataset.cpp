@@ -0,0 +1,313 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ *
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Binary table handling class
+ * ------------------------------------------
+ *
+ */
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <boost/lexical_cast.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "../common.h"
+#include "CBinaryTableDataset.h"
+#include "CCSVDataset.h"
+
+/*
+ *  Constructor
+ */
+CBinaryTableDataset::CBinaryTableDataset( std::string sTableFilename )
+{
+	this->sFilename			= sTableFilename;
+	this->pMapping			= NULL;
+	this->pRegion			= NULL;
+	this->pHeader			= NULL;
+	this->dValues			= NULL;
+	this->uiLabelIndices	= NULL;
+	this->bReadFile			= false;
+}
+
+/*
+ *  Destructor
+ */
+CBinaryTableDataset::~CBinaryTableDataset()
+{
+	delete this->pRegion;
+	delete this->pMapping;
+}
+
+/*
+ *  Binary tables are identified by their extension
+ */
+bool CBinaryTableDataset::isBinaryTable( std::string sFilename )
+{
+	return boost::algorithm::iends_with( sFilename, ".hbt" );
+}
+
+/*
+ *  Map the table into memory and check it's complete. Only the row names
+ *  are copied, the values are used where they lie.
+ */
+bool CBinaryTableDataset::readFile()
+{
+	try {
+		this->pMapping	= new boost::interprocess::file_mapping( this->sFilename.c_str(), boost::interprocess::read_only );
+		this->pRegion	= new boost::interprocess::mapped_region( *this->pMapping, boost::interprocess::read_only );
+	}
+	catch ( boost::interprocess::interprocess_exception )
+	{
+		model::doError(
+			"Could not open a binary table: " + this->sFilename,
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	char*				cData	= static_cast<char*>( this->pRegion->get_address() );
+	unsigned long long	ulSize	= this->pRegion->get_size();
+	this->pHeader	= reinterpret_cast<sBinaryTableHeader*>( cData );
+
+	bool bValid = ulSize >= sizeof( sBinaryTableHeader ) &&
+				  std::memcmp( this->pHeader->cMagic, "HIPIMSBT", 8 ) == 0 &&
+				  this->pHeader->uiVersion == uiFormatVersion &&
+				  this->pHeader->uiColumns > 0;
+
+	// Row count is checked by division first so the value block size can't overflow
+	if ( bValid &&
+		 this->pHeader->ulRows > ( ulSize - sizeof( sBinaryTableHeader ) ) / ( this->pHeader->uiColumns * sizeof( cl_double ) ) )
+		bValid = false;
+
+	// Names must sit after the values, hold an index for every row, and end with a terminator
+	if ( bValid && this->pHeader->ulLabelOffset > 0 )
+	{
+		unsigned long long ulValuesEnd = sizeof( sBinaryTableHeader ) + this->pHeader->ulRows * this->pHeader->uiColumns * sizeof( cl_double );
+
+		if ( this->pHeader->ulLabelOffset < ulValuesEnd ||
+			 this->pHeader->ulLabelOffset > ulSize ||
+			 this->pHeader->ulLabelLength > ulSize - this->pHeader->ulLabelOffset ||
+			 this->pHeader->ulRows * sizeof( cl_uint ) > this->pHeader->ulLabelLength ||
+			 ( this->pHeader->ulLabelLength > this->pHeader->ulRows * sizeof( cl_uint ) &&
+			   cData[ this->pHeader->ulLabelOffset + this->pHeader->ulLabelLength - 1 ] != '\0' ) )
+			bValid = false;
+	}
+
+	if ( !bValid )
+	{
+		model::doError(
+			"Binary table is not valid: " + this->sFilename,
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	this->dValues = reinterpret_cast<const cl_double*>( cData + sizeof( sBinaryTableHeader ) );
+
+	// Names follow an index into them for every row
+	if ( this->pHeader->ulLabelOffset > 0 )
+	{
+		this->uiLabelIndices = reinterpret_cast<const cl_uint*>( cData + this->pHeader->ulLabelOffset );
+
+		const char*	cLabel		= cData + this->pHeader->ulLabelOffset + this->pHeader->ulRows * sizeof( cl_uint );
+		const char*	cLabelEnd	= cData + this->pHeader->ulLabelOffset + this->pHeader->ulLabelLength;
+		while ( cLabel < cLabelEnd )
+		{
+			this->vLabels.push_back( std::string( cLabel ) );
+			cLabel += this->vLabels.back().length() + 1;
+		}
+
+		for ( unsigned long i = 0; i < this->pHeader->ulRows; i++ )
+		{
+			if ( this->uiLabelIndices[ i ] >= this->vLabels.size() )
+			{
+				model::doError(
+					"Binary table has invalid row names: " + this->sFilename,
+					model::errorCodes::kLevelWarning
+				);
+				return false;
+			}
+		}
+	}
+
+	this->bReadFile = true;
+
+	return true;
+}
+
+/*
+ *  Check the times in the first column increase from one row to the next,
+ *  and take the interval from the first two rows as for a CSV timeseries
+ */
+bool CBinaryTableDataset::getTimeseriesInterval( double* dInterval )
+{
+	if ( !this->bReadFile || this->pHeader->ulRows < 2 )
+		return false;
+
+	for ( unsigned long i = 1; i < this->pHeader->ulRows; i++ )
+	{
+		if ( this->getRow( i )[0] <= this->getRow( i - 1 )[0] )
+		{
+			model::doError(
+				"Times must increase through a boundary timeseries: " + this->sFilename,
+				model::errorCodes::kLevelWarning
+			);
+			return false;
+		}
+	}
+
+	*dInterval = this->getRow( 1 )[0] - this->getRow( 0 )[0];
+
+	return true;
+}
+
+/*
+ *  Convert a CSV file to a binary table. The first row is taken as headers,
+ *  as when boundaries read a CSV. The last column is held as names if it
+ *  isn't a number on any row, or if there are three columns as only a
+ *  relation map with boundary names has. Names are kept as written, so the
+ *  file is read again keeping its text when there are any.
+ *  This runs before a model is loaded, so reports straight to the console.
+ */
+bool CBinaryTableDataset::convertCSV( std::string sCSVFilename, std::string sTableFilename )
+{
+	if ( !Util::fileExists( sCSVFilename.c_str() ) )
+	{
+		std::cout << "Could not open the CSV file " << sCSVFilename << "." << std::endl;
+		return false;
+	}
+
+	CCSVDataset*	pCSV		= new CCSVDataset( sCSVFilename );
+	if ( !pCSV->readFile() || pCSV->getLength() < 1 )
+	{
+		std::cout << "The CSV file " << sCSVFilename << " has no rows to convert." << std::endl;
+		delete pCSV;
+		return false;
+	}
+
+	bool			bLabels		= pCSV->getFieldCount( 0 ) == 3;
+	for ( unsigned long ulCheck = 0; ulCheck < pCSV->getLength() && !bLabels; ulCheck++ )
+	{
+		unsigned int uiFields = pCSV->getFieldCount( ulCheck );
+		bLabels = uiFields > 1 && !pCSV->isNumber( ulCheck, uiFields - 1 );
+	}
+
+	if ( bLabels )
+	{
+		delete pCSV;
+		pCSV = new CCSVDataset( sCSVFilename, true );
+		if ( !pCSV->readFile() )
+		{
+			std::cout << "The CSV file " << sCSVFilename << " could not be read again for its names." << std::endl;
+			delete pCSV;
+			return false;
+		}
+	}
+
+	unsigned int	uiColumns	= pCSV->getFieldCount( 0 ) - ( bLabels ? 1 : 0 );
+	unsigned long	ulRow		= 0;
+	if ( uiColumns == 0 )
+	{
+		std::cout << "The CSV file " << sCSVFilename << " has no values to convert." << std::endl;
+		delete pCSV;
+		return false;
+	}
+
+	std::vector<cl_double>				vValues;
+	std::vector<cl_uint>				vLabelIndices;
+	std::vector<std::string>			vLabels;
+	std::map<std::string, cl_uint>		mapLabels;
+
+	vValues.reserve( static_cast<unsigned long long>( pCSV->getLength() ) * uiColumns );
+
+	for ( ; ulRow < pCSV->getLength(); ulRow++ )
+	{
+		if ( pCSV->getFieldCount( ulRow ) != uiColumns + ( bLabels ? 1 : 0 ) )
+		{
+			std::cout << "Row " << ulRow + 2 << " of " << sCSVFilename << " has the wrong number of columns." << std::endl;
+			delete pCSV;
+			return false;
+		}
+
+		for ( unsigned int i = 0; i < uiColumns; i++ )
+		{
+			if ( !pCSV->isNumber( ulRow, i ) )
+			{
+				std::cout << "Row " << ulRow + 2 << " of " << sCSVFilename << " has a value which is not a number." << std::endl;
+				delete pCSV;
+				return false;
+			}
+			vValues.push_back( pCSV->getValue( ulRow, i ) );
+		}
+
+		if ( bLabels )
+		{
+			std::string sLabel = pCSV->getText( ulRow, uiColumns );
+			std::map<std::string, cl_uint>::iterator itLabel = mapLabels.find( sLabel );
+			if ( itLabel == mapLabels.end() )
+			{
+				itLabel = mapLabels.insert( std::make_pair( sLabel, static_cast<cl_uint>( vLabels.size() ) ) ).first;
+				vLabels.push_back( sLabel );
+			}
+			vLabelIndices.push_back( itLabel->second );
+		}
+	}
+	delete pCSV;
+
+	sBinaryTableHeader	pHeader;
+	std::memset( &pHeader, 0, sizeof( sBinaryTableHeader ) );
+	std::memcpy( pHeader.cMagic, "HIPIMSBT", 8 );
+	pHeader.uiVersion	= uiFormatVersion;
+	pHeader.uiColumns	= uiColumns;
+	pHeader.ulRows		= ulRow;
+
+	if ( bLabels )
+	{
+		pHeader.ulLabelOffset	= sizeof( sBinaryTableHeader ) + vValues.size() * sizeof( cl_double );
+		pHeader.ulLabelLength	= vLabelIndices.size() * sizeof( cl_uint );
+		for ( unsigned int i = 0; i < vLabels.size(); i++ )
+			pHeader.ulLabelLength += vLabels[ i ].length() + 1;
+	}
+
+	std::string		sTemporary = sTableFilename + ".tmp";
+	std::ofstream	ofsTable( sTemporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+
+	ofsTable.write( reinterpret_cast<char*>( &pHeader ), sizeof( sBinaryTableHeader ) );
+	if ( !vValues.empty() )
+		ofsTable.write( reinterpret_cast<char*>( &vValues[0] ), vValues.size() * sizeof( cl_double ) );
+	if ( bLabels )
+	{
+		ofsTable.write( reinterpret_cast<char*>( &vLabelIndices[0] ), vLabelIndices.size() * sizeof( cl_uint ) );
+		for ( unsigned int i = 0; i < vLabels.size(); i++ )
+			ofsTable.write( vLabels[ i ].c_str(), vLabels[ i ].length() + 1 );
+	}
+	ofsTable.close();
+
+	boost::system::error_code ecRename;
+	if ( !ofsTable.fail() )
+		boost::filesystem::rename( sTemporary, sTableFilename, ecRename );
+
+	if ( ofsTable.fail() || ecRename )
+	{
+		std::cout << "Could not write the binary table " << sTableFilename << "." << std::endl;
+		return false;
+	}
+
+	std::cout << "Converted " << ulRow << " rows of " << sCSVFilename << " to " << sTableFilename << "." << std::endl;
+
+	return true;
+}
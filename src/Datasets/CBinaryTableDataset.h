@@ -0,0 +1,87 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ *
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Binary table handling class
+ * ------------------------------------------
+ *
+ */
+
+#ifndef HIPIMS_DATASETS_CBINARYTABLEDATASET_H_
+#define HIPIMS_DATASETS_CBINARYTABLEDATASET_H_
+
+#include <string>
+#include <vector>
+
+#include "../OpenCL/opencl.h"
+
+namespace boost { namespace interprocess {
+	class file_mapping;
+	class mapped_region;
+} }
+
+/*
+ *  Fixed header at the start of each binary table, followed by
+ *  the values as doubles a row at a time. Tables converted from
+ *  a CSV with a name in the last column then hold an index into
+ *  a list of names for each row, and the names themselves.
+ */
+struct sBinaryTableHeader
+{
+	char			cMagic[8];				// File identifier
+	cl_uint			uiVersion;				// File format version
+	cl_uint			uiColumns;				// Number of value columns
+	cl_ulong		ulRows;					// Number of rows
+	cl_ulong		ulLabelOffset;			// Position of the row names (0 if none)
+	cl_ulong		ulLabelLength;			// Bytes taken by the row names
+};
+
+/*
+ *  BINARY TABLE DATASET CLASS
+ *  CBinaryTableDataset
+ *
+ *  Maps a table converted from a CSV file into memory, so
+ *  boundary time series and relation maps can be loaded
+ *  without parsing every value.
+ */
+class CBinaryTableDataset
+{
+public:
+	CBinaryTableDataset( std::string );
+	~CBinaryTableDataset();
+
+	static bool				isBinaryTable( std::string );											// Is the file a binary table, from its extension?
+	static bool				convertCSV( std::string, std::string );									// Convert a CSV file to a binary table
+	bool					readFile();																// Map the file into memory
+	bool					isReady()			{ return bReadFile; }
+	unsigned int			getColumns()		{ return pHeader->uiColumns; }
+	unsigned long			getLength()			{ return static_cast<unsigned long>( pHeader->ulRows ); }
+	const cl_double*		getRow( unsigned long ulRow )	{ return dValues + ulRow * pHeader->uiColumns; }
+	bool					hasLabels()			{ return !vLabels.empty(); }
+	const std::string&		getLabel( unsigned long ulRow )	{ return vLabels[ uiLabelIndices[ ulRow ] ]; }
+	bool					getTimeseriesInterval( double* );										// Check the times increase and find the interval
+
+private:
+	static const cl_uint	uiFormatVersion = 1;													// Current file format version
+
+	std::string								sFilename;
+	boost::interprocess::file_mapping*		pMapping;
+	boost::interprocess::mapped_region*		pRegion;
+	sBinaryTableHeader*						pHeader;
+	const cl_double*						dValues;
+	const cl_uint*							uiLabelIndices;
+	std::vector<std::string>				vLabels;
+	bool									bReadFile;
+};
+
+#endif
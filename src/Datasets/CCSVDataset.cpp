@@ -16,7 +16,13 @@
  * ------------------------------------------
  *
  */
-#include <boost/tokenizer.hpp>
+#include <cctype>
+#include <cmath>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include "../common.h"
@@ -26,10 +32,12 @@
  *  Constructor
  */
 CCSVDataset::CCSVDataset(
-		std::string		sCSVFilename
+		std::string		sCSVFilename,
+		bool			bKeepFieldText
 	)
 {
 	sFilename	= sCSVFilename;
+	bKeepText	= bKeepFieldText;
 	bReadFile	= false;
 }
 
@@ -42,14 +50,12 @@ CCSVDataset::~CCSVDataset()
 }
 
 /*
- *  Read the CSV file using Boost's tokenizer stuff
+ *  Read the CSV file a chunk at a time, sharing the lines in each chunk
+ *  between threads which convert the fields as they go
  */
 bool CCSVDataset::readFile()
 {
-	typedef boost::tokenizer<boost::escaped_list_separator<char>>	Tokenizer;
-
-	std::string sRow;
-	std::ifstream ifsCSV( this->sFilename, std::ios::in );
+	std::ifstream ifsCSV( this->sFilename.c_str(), std::ios::in | std::ios::binary );
 
 	if ( !ifsCSV.is_open() )
 	{
@@ -60,22 +66,82 @@ bool CCSVDataset::readFile()
 		return false;
 	}
 
-	vContents.clear();
+	this->vHeaders.clear();
+	this->sContents		= sParsedRows();
+	this->bReadFile		= false;
+
+	std::vector<char>	vBuffer;
+	unsigned long long	ulCarried		= 0;
+	unsigned int		uiFields		= 0;
+	unsigned int		uiMaxThreads	= std::max( 1U, std::thread::hardware_concurrency() );
 
-	while ( ifsCSV.good() )
+	while ( true )
 	{
-		getline( ifsCSV, sRow );
+		vBuffer.resize( ulCarried + ulChunkSize );
+		ifsCSV.read( &vBuffer[ ulCarried ], ulChunkSize );
+
+		unsigned long long	ulLength	= ulCarried + ifsCSV.gcount();
+		bool				bLastChunk	= !ifsCSV.good();
+		const char*			cStart		= &vBuffer[0];
+		const char*			cEnd		= cStart + ulLength;
+
+		// Only whole lines are converted until the end of the file
+		if ( !bLastChunk )
+		{
+			while ( cEnd > cStart && *( cEnd - 1 ) != '\n' )
+				cEnd--;
+		}
+
+		// The first line with anything in it holds the headers
+		while ( this->vHeaders.empty() && cStart < cEnd )
+		{
+			const char* cLineEnd = std::find( cStart, cEnd, '\n' );
+			CCSVDataset::splitRow( cStart, cLineEnd, &this->vHeaders, &uiFields );
+			this->vHeaders.resize( uiFields );
+			cStart = ( cLineEnd == cEnd ) ? cEnd : cLineEnd + 1;
+		}
+
+		// Split the remaining lines between threads
+		unsigned int				uiThreads	= static_cast<unsigned int>( std::min<unsigned long long>( uiMaxThreads, ( cEnd - cStart ) / ulThreadSize + 1 ) );
+		std::vector<sParsedRows>	vParts( uiThreads );
+		std::vector<std::thread>	vThreads;
+		const char*					cPartStart	= cStart;
 
-		Tokenizer				tRow(sRow);
-		std::vector<std::string>		vTokens;
+		for ( unsigned int i = 0; i < uiThreads; i++ )
+		{
+			const char* cPartEnd = cEnd;
+			if ( i < uiThreads - 1 )
+			{
+				cPartEnd = std::find( std::max( cPartStart, cStart + ( cEnd - cStart ) * ( i + 1 ) / uiThreads ), cEnd, '\n' );
+				if ( cPartEnd < cEnd )
+					cPartEnd++;
+			}
 
-		vTokens.assign( tRow.begin(), tRow.end() );
+			vThreads.push_back( std::thread( &CCSVDataset::parseRows, cPartStart, cPartEnd, &vParts[i], this->bKeepText ) );
+			cPartStart = cPartEnd;
+		}
 
-		for( unsigned int i = 0; i < vTokens.size(); i++ )
-			vTokens[i] = boost::algorithm::trim_copy( vTokens[i] );
+		for ( unsigned int i = 0; i < uiThreads; i++ )
+		{
+			vThreads[i].join();
+			this->mergeRows( &vParts[i] );
+		}
 
-		if ( strcmp( sRow.c_str(), "" ) != 0 )
-			vContents.push_back( vTokens );
+		if ( bLastChunk )
+			break;
+
+		// Keep any partial line for the next chunk
+		ulCarried = ( &vBuffer[0] + ulLength ) - cEnd;
+		std::memmove( &vBuffer[0], cEnd, ulCarried );
+	}
+
+	if ( ifsCSV.bad() )
+	{
+		model::doError(
+			"Could not read a CSV file.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
 	}
 
 	ifsCSV.close();
@@ -83,3 +149,190 @@ bool CCSVDataset::readFile()
 
 	return true;
 }
+
+/*
+ *  Split a line into trimmed fields, allowing for quotes and escaped
+ *  characters as Boost's escaped list separator would. The vector of fields
+ *  is reused between lines, so the number found is returned separately, and
+ *  is zero for a line which is blank.
+ */
+void CCSVDataset::splitRow( const char* cStart, const char* cEnd, std::vector<std::string>* vFields, unsigned int* uiFields )
+{
+	bool			bQuoted		= false;
+	std::string*	sField;
+
+	*uiFields = 0;
+
+	if ( std::find_if( cStart, cEnd, []( char c ) { return !std::isspace( static_cast<unsigned char>( c ) ); } ) == cEnd )
+		return;
+
+	*uiFields = 1;
+	if ( vFields->empty() )
+		vFields->resize( 1 );
+	sField = &vFields->front();
+	sField->clear();
+
+	for ( const char* c = cStart; c < cEnd; c++ )
+	{
+		if ( *c == '\\' && c + 1 < cEnd )
+		{
+			c++;
+			sField->push_back( *c == 'n' ? '\n' : *c );
+		}
+		else if ( *c == '"' )
+		{
+			bQuoted = !bQuoted;
+		}
+		else if ( *c == ',' && !bQuoted )
+		{
+			( *uiFields )++;
+			if ( vFields->size() < *uiFields )
+				vFields->resize( *uiFields );
+			sField = &( *vFields )[ *uiFields - 1 ];
+			sField->clear();
+		}
+		else {
+			sField->push_back( *c );
+		}
+	}
+
+	for ( unsigned int i = 0; i < *uiFields; i++ )
+		boost::algorithm::trim( ( *vFields )[i] );
+}
+
+/*
+ *  Convert every line in part of a chunk, skipping blank lines. The text
+ *  of numbers is only kept if asked for, as names might look like numbers.
+ */
+void CCSVDataset::parseRows( const char* cStart, const char* cEnd, sParsedRows* pRows, bool bKeepText )
+{
+	std::vector<std::string>	vFields;
+	unsigned int				uiFields;
+	char*						cNumberEnd;
+
+	while ( cStart < cEnd )
+	{
+		const char* cLineEnd = std::find( cStart, cEnd, '\n' );
+		CCSVDataset::splitRow( cStart, cLineEnd, &vFields, &uiFields );
+		cStart = ( cLineEnd == cEnd ) ? cEnd : cLineEnd + 1;
+
+		if ( uiFields == 0 )
+			continue;
+
+		for ( unsigned int i = 0; i < uiFields; i++ )
+		{
+			double	dValue		= vFields[i].empty() ? 0.0 : std::strtod( vFields[i].c_str(), &cNumberEnd );
+			bool	bNumber		= !vFields[i].empty() && *cNumberEnd == '\0';
+
+			if ( bNumber && !bKeepText )
+			{
+				pRows->vValues.push_back( dValue );
+				pRows->vFlags.push_back( 1 );
+				continue;
+			}
+
+			std::unordered_map<std::string, unsigned int>::iterator itText = pRows->mapText.find( vFields[i] );
+			if ( itText == pRows->mapText.end() )
+			{
+				itText = pRows->mapText.insert( std::make_pair( vFields[i], static_cast<unsigned int>( pRows->vText.size() ) ) ).first;
+				pRows->vText.push_back( vFields[i] );
+			}
+
+			if ( bKeepText )
+				pRows->vTextIndices.push_back( itText->second );
+
+			pRows->vValues.push_back( bNumber ? dValue : static_cast<double>( itText->second ) );
+			pRows->vFlags.push_back( bNumber ? 1 : 0 );
+		}
+
+		pRows->vRowEnds.push_back( pRows->vValues.size() );
+	}
+}
+
+/*
+ *  Append the rows converted by a thread, moving their text into the
+ *  list for the whole file
+ */
+void CCSVDataset::mergeRows( sParsedRows* pPart )
+{
+	unsigned long long			ulBase = this->sContents.vValues.size();
+	std::vector<unsigned int>	vTextMap( pPart->vText.size() );
+
+	for ( unsigned int i = 0; i < pPart->vText.size(); i++ )
+	{
+		std::unordered_map<std::string, unsigned int>::iterator itText = this->sContents.mapText.find( pPart->vText[i] );
+		if ( itText == this->sContents.mapText.end() )
+		{
+			itText = this->sContents.mapText.insert( std::make_pair( pPart->vText[i], static_cast<unsigned int>( this->sContents.vText.size() ) ) ).first;
+			this->sContents.vText.push_back( pPart->vText[i] );
+		}
+		vTextMap[i] = itText->second;
+	}
+
+	for ( unsigned long long i = 0; i < pPart->vValues.size(); i++ )
+	{
+		if ( pPart->vFlags[i] == 0 )
+			pPart->vValues[i] = static_cast<double>( vTextMap[ static_cast<unsigned int>( pPart->vValues[i] ) ] );
+	}
+	for ( unsigned long long i = 0; i < pPart->vTextIndices.size(); i++ )
+		pPart->vTextIndices[i] = vTextMap[ pPart->vTextIndices[i] ];
+
+	this->sContents.vValues.insert( this->sContents.vValues.end(), pPart->vValues.begin(), pPart->vValues.end() );
+	this->sContents.vFlags.insert( this->sContents.vFlags.end(), pPart->vFlags.begin(), pPart->vFlags.end() );
+	this->sContents.vTextIndices.insert( this->sContents.vTextIndices.end(), pPart->vTextIndices.begin(), pPart->vTextIndices.end() );
+	for ( unsigned long long i = 0; i < pPart->vRowEnds.size(); i++ )
+		this->sContents.vRowEnds.push_back( ulBase + pPart->vRowEnds[i] );
+
+	*pPart = sParsedRows();
+}
+
+/*
+ *  Number of fields in a row
+ */
+unsigned int CCSVDataset::getFieldCount( unsigned int uiRow )
+{
+	return static_cast<unsigned int>( this->sContents.vRowEnds[ uiRow ] - this->getRowStart( uiRow ) );
+}
+
+/*
+ *  Is a field a number?
+ */
+bool CCSVDataset::isNumber( unsigned int uiRow, unsigned int uiField )
+{
+	return this->sContents.vFlags[ this->getRowStart( uiRow ) + uiField ] != 0;
+}
+
+/*
+ *  Is a field a whole number which can be used as a cell index?
+ */
+bool CCSVDataset::isIndex( unsigned int uiRow, unsigned int uiField )
+{
+	if ( !this->isNumber( uiRow, uiField ) )
+		return false;
+
+	double dValue = this->getValue( uiRow, uiField );
+	return dValue >= 0.0 && dValue <= UINT_MAX && std::floor( dValue ) == dValue;
+}
+
+/*
+ *  Value of a numeric field
+ */
+double CCSVDataset::getValue( unsigned int uiRow, unsigned int uiField )
+{
+	return this->sContents.vValues[ this->getRowStart( uiRow ) + uiField ];
+}
+
+/*
+ *  Text of a field, as it was in the file if kept, otherwise with numbers
+ *  written back out
+ */
+std::string CCSVDataset::getText( unsigned int uiRow, unsigned int uiField )
+{
+	if ( this->bKeepText )
+		return this->sContents.vText[ this->sContents.vTextIndices[ this->getRowStart( uiRow ) + uiField ] ];
+
+	if ( this->isNumber( uiRow, uiField ) )
+		return toString( this->getValue( uiRow, uiField ) );
+
+	return this->sContents.vText[ static_cast<unsigned int>( this->getValue( uiRow, uiField ) ) ];
+}
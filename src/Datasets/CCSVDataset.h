@@ -22,33 +22,66 @@
 
 #include <iostream>
 #include <fstream>
+#include <string>
 #include <vector>
 #include <algorithm>
 #include <iterator>
+#include <unordered_map>
 
 /*
  *  CSV DATASET CLASS
  *  CCSVDataset
  *
- *  Provides access for reading CSV files.
+ *  Provides access for reading CSV files. The first row is
+ *  held as headers, and the fields of every other row are
+ *  converted as they're read, with numbers held as doubles
+ *  and anything else as an index into a list of text.
+ *  Where fields are names which might look like numbers,
+ *  the original text of every field can be kept too.
  */
 class CCSVDataset
 {
 public:
-	CCSVDataset( std::string sCSVFilename );
+	CCSVDataset( std::string sCSVFilename, bool bKeepText = false );
 	~CCSVDataset();
 
-	bool													readFile();
-	std::vector<std::vector<std::string>>::const_iterator	begin()				{ return vContents.begin(); }
-	std::vector<std::vector<std::string>>::const_iterator	end()				{ return vContents.end(); }
-	unsigned int											getLength()			{ return vContents.size() - 1; }
-	bool													isReady()			{ return bReadFile; }
+	bool							readFile();
+	unsigned int					getLength()			{ return sContents.vRowEnds.size(); }	// Number of rows after the headers
+	bool							isReady()			{ return bReadFile; }
+	const std::vector<std::string>&	getHeaders()		{ return vHeaders; }
+	unsigned int					getFieldCount( unsigned int );								// Number of fields in a row
+	bool							isNumber( unsigned int, unsigned int );						// Is a field a number?
+	bool							isIndex( unsigned int, unsigned int );						// Is a field a whole number, not negative?
+	double							getValue( unsigned int, unsigned int );						// Value of a numeric field
+	std::string						getText( unsigned int, unsigned int );						// Text of a field
 
 private:
-	std::string												sFilename;
-	std::ifstream											ifsFile;
-	std::vector<std::vector<std::string>>					vContents;
-	bool													bReadFile;
+	/*
+	 *  Fields parsed from part of the file
+	 */
+	struct sParsedRows
+	{
+		std::vector<double>								vValues;		// Value, or text index, of each field
+		std::vector<unsigned char>						vFlags;			// Whether each field is a number
+		std::vector<unsigned long long>					vRowEnds;		// Position after the last field of each row
+		std::vector<unsigned int>						vTextIndices;	// Original text of each field, if kept
+		std::vector<std::string>						vText;			// Distinct text which isn't a number
+		std::unordered_map<std::string, unsigned int>	mapText;		// Position of each in the text list
+	};
+
+	static const unsigned long long	ulChunkSize = 64 * 1024 * 1024;								// Bytes read from the file at a time
+	static const unsigned long long	ulThreadSize = 1024 * 1024;									// Smallest part of a chunk worth a thread
+
+	static void						splitRow( const char*, const char*, std::vector<std::string>*, unsigned int* );	// Split a line into trimmed fields
+	static void						parseRows( const char*, const char*, sParsedRows*, bool );	// Convert the lines in part of a chunk
+	void							mergeRows( sParsedRows* );									// Append the rows converted from part of a chunk
+	unsigned long long				getRowStart( unsigned int uiRow )	{ return uiRow == 0 ? 0 : sContents.vRowEnds[ uiRow - 1 ]; }
+
+	std::string						sFilename;
+	std::vector<std::string>		vHeaders;
+	sParsedRows						sContents;
+	bool							bKeepText;
+	bool							bReadFile;
 };
 
 #endif
@@ -0,0 +1,164 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ * 
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Simulation checkpoint handling class
+ * ------------------------------------------
+ *
+ */
+#include <fstream>
+#include <boost/lexical_cast.hpp>
+#include <boost/filesystem.hpp>
+
+#include "../common.h"
+#include "CCheckpointDataset.h"
+
+/*
+ *  Checkpoint filename for a domain within a directory
+ */
+std::string CCheckpointDataset::getFilename( std::string sDirectory, unsigned int uiDomainID )
+{
+	if ( !sDirectory.empty() && 
+		 sDirectory[ sDirectory.length() - 1 ] != '/' &&
+		 sDirectory[ sDirectory.length() - 1 ] != '\\' )
+		sDirectory += "/";
+
+	return sDirectory + "checkpoint_" + toString( uiDomainID + 1 ) + ".chk";
+}
+
+/*
+ *  Fill in the fields which identify what a checkpoint belongs to
+ */
+void CCheckpointDataset::prepareHeader( sCheckpointHeader* pHeader, unsigned int uiDomainID, unsigned long ulCellCount, unsigned char ucFloatSize, unsigned char ucCellStateLayout )
+{
+	std::memset( pHeader, 0, sizeof( sCheckpointHeader ) );
+	std::memcpy( pHeader->cMagic, "HIPIMSCK", 8 );
+	pHeader->uiVersion			= uiFormatVersion;
+	pHeader->uiDomainID			= uiDomainID;
+	pHeader->ulCellCount		= ulCellCount;
+	pHeader->uiFloatSize		= ucFloatSize;
+	pHeader->uiCellStateLayout	= ucCellStateLayout;
+}
+
+/*
+ *  Write a checkpoint to disk. The file is written under a temporary
+ *  name and moved into place, so a crash mid-write never leaves a
+ *  broken checkpoint behind. Accumulators are the same size as the cell
+ *  states, and are written after them if given.
+ */
+bool CCheckpointDataset::writeFile( std::string sFilename, sCheckpointHeader* pHeader, void* pCellStates, unsigned long long ulSize, void* pAccumulators )
+{
+	pHeader->uiAccumulators = ( pAccumulators != NULL ? 1 : 0 );
+
+	std::string		sTemporary = sFilename + ".tmp";
+	std::ofstream	ofsFile( sTemporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+
+	if ( !ofsFile.is_open() )
+	{
+		model::doError(
+			"Could not open checkpoint file for writing: " + sTemporary,
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	ofsFile.write( reinterpret_cast<char*>( pHeader ), sizeof( sCheckpointHeader ) );
+	ofsFile.write( static_cast<char*>( pCellStates ), ulSize );
+	if ( pAccumulators != NULL )
+		ofsFile.write( static_cast<char*>( pAccumulators ), ulSize );
+	ofsFile.close();
+
+	if ( ofsFile.fail() )
+	{
+		model::doError(
+			"Failed to write checkpoint file: " + sTemporary,
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	boost::system::error_code ecRename;
+	boost::filesystem::rename( sTemporary, sFilename, ecRename );
+	if ( ecRename )
+	{
+		model::doError(
+			"Could not replace checkpoint file: " + sFilename,
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ *  Read a checkpoint from disk, verifying it matches the expected domain
+ *  (the identifying fields of the header must already be populated). The
+ *  accumulators are read too if asked for and the checkpoint holds them,
+ *  which is shown by the header returned.
+ */
+bool CCheckpointDataset::readFile( std::string sFilename, sCheckpointHeader* pHeader, void* pCellStates, unsigned long long ulSize, void* pAccumulators )
+{
+	sCheckpointHeader	pFileHeader;
+	std::ifstream		ifsFile( sFilename.c_str(), std::ios::in | std::ios::binary );
+
+	if ( !ifsFile.is_open() )
+	{
+		model::doError(
+			"Could not open checkpoint file: " + sFilename,
+			model::errorCodes::kLevelModelStop
+		);
+		return false;
+	}
+
+	ifsFile.read( reinterpret_cast<char*>( &pFileHeader ), sizeof( sCheckpointHeader ) );
+
+	if ( ifsFile.fail() ||
+		 std::memcmp( pFileHeader.cMagic, pHeader->cMagic, 8 ) != 0 ||
+		 pFileHeader.uiVersion != pHeader->uiVersion )
+	{
+		model::doError(
+			"Checkpoint file is not valid: " + sFilename,
+			model::errorCodes::kLevelModelStop
+		);
+		return false;
+	}
+
+	if ( pFileHeader.uiDomainID != pHeader->uiDomainID ||
+		 pFileHeader.ulCellCount != pHeader->ulCellCount ||
+		 pFileHeader.uiFloatSize != pHeader->uiFloatSize ||
+		 pFileHeader.uiCellStateLayout != pHeader->uiCellStateLayout )
+	{
+		model::doError(
+			"Checkpoint does not match the domain configuration: " + sFilename,
+			model::errorCodes::kLevelModelStop
+		);
+		return false;
+	}
+
+	ifsFile.read( static_cast<char*>( pCellStates ), ulSize );
+	if ( !ifsFile.fail() && pAccumulators != NULL && pFileHeader.uiAccumulators != 0 )
+		ifsFile.read( static_cast<char*>( pAccumulators ), ulSize );
+	if ( ifsFile.fail() )
+	{
+		model::doError(
+			"Checkpoint file is truncated: " + sFilename,
+			model::errorCodes::kLevelModelStop
+		);
+		return false;
+	}
+
+	*pHeader = pFileHeader;
+
+	return true;
+}
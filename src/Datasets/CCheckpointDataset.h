@@ -0,0 +1,68 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ * 
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Simulation checkpoint handling class
+ * ------------------------------------------
+ *
+ */
+
+#ifndef HIPIMS_DATASETS_CCHECKPOINTDATASET_H_
+#define HIPIMS_DATASETS_CCHECKPOINTDATASET_H_
+
+#include <string>
+
+#include "../OpenCL/opencl.h"
+
+/*
+ *  Fixed header at the start of each checkpoint file, followed
+ *  by the raw cell states for the domain, then the accumulators
+ *  if they were in use
+ */
+struct sCheckpointHeader
+{
+	char			cMagic[8];				// File identifier
+	cl_uint			uiVersion;				// File format version
+	cl_uint			uiDomainID;				// Domain the states belong to
+	cl_ulong		ulCellCount;			// Number of cells in the domain
+	cl_uint			uiFloatSize;			// Bytes per floating-point value
+	cl_uint			uiCellStateLayout;		// Cell state memory layout
+	cl_double		dTime;					// Simulation time
+	cl_double		dTimestep;				// Current timestep
+	cl_double		dTimeHydrological;		// Time since hydrological processes were applied
+	cl_double		dBatchTimesteps;		// Cumulative timesteps in the last batch
+	cl_uint			uiBatchSuccessful;		// Successful iterations in the last batch
+	cl_uint			uiAccumulators;			// Whether the accumulators follow the cell states
+	cl_double		dLastOutputTime;		// Time outputs were last written
+};
+
+/*
+ *  CHECKPOINT DATASET CLASS
+ *  CCheckpointDataset
+ *
+ *  Reads and writes binary checkpoints of a domain's
+ *  full state, so a simulation can be resumed.
+ */
+class CCheckpointDataset
+{
+public:
+	static std::string		getFilename( std::string, unsigned int );							// Checkpoint filename for a domain in a directory
+	static void				prepareHeader( sCheckpointHeader*, unsigned int, unsigned long, unsigned char, unsigned char );	// Fill in the identifying fields of a header
+	static bool				writeFile( std::string, sCheckpointHeader*, void*, unsigned long long, void* = NULL );	// Write a checkpoint to disk
+	static bool				readFile( std::string, sCheckpointHeader*, void*, unsigned long long, void* = NULL );	// Read a checkpoint back from disk
+
+private:
+	static const cl_uint	uiFormatVersion = 1;												// Current file format version
+};
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ *
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Prepared domain cache handling class
+ * ------------------------------------------
+ *
+ */
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <boost/lexical_cast.hpp>
+#include <boost/filesystem.hpp>
+
+#include "../common.h"
+#include "CDomainCacheDataset.h"
+
+/*
+ *  Cache filename for a set of inputs within a directory
+ */
+std::string CDomainCacheDataset::getFilename( std::string sDirectory, cl_ulong ulInputKey )
+{
+	std::ostringstream	ossKey;
+	ossKey << std::hex << std::setw( 16 ) << std::setfill( '0' ) << ulInputKey;
+
+	if ( !sDirectory.empty() &&
+		 sDirectory[ sDirectory.length() - 1 ] != '/' &&
+		 sDirectory[ sDirectory.length() - 1 ] != '\\' )
+		sDirectory += "/";
+
+	return sDirectory + "domain_" + ossKey.str() + ".cache";
+}
+
+/*
+ *  Fill in the fields which identify what a cache file belongs to
+ */
+void CDomainCacheDataset::prepareHeader( sDomainCacheHeader* pHeader, cl_ulong ulInputKey, unsigned long ulCellCount, unsigned char ucFloatSize, unsigned char ucCellStateLayout )
+{
+	std::memset( pHeader, 0, sizeof( sDomainCacheHeader ) );
+	std::memcpy( pHeader->cMagic, "HIPIMSDC", 8 );
+	pHeader->uiVersion			= uiFormatVersion;
+	pHeader->uiFloatSize		= ucFloatSize;
+	pHeader->ulCellCount		= ulCellCount;
+	pHeader->uiCellStateLayout	= ucCellStateLayout;
+	pHeader->ulInputKey			= ulInputKey;
+}
+
+/*
+ *  Extend a 64-bit hash with some data. Each word is mixed as in xxHash64,
+ *  so a change to any bit reaches every bit of the hash, and the result is
+ *  mixed again so calls can be chained.
+ */
+cl_ulong CDomainCacheDataset::hashData( const void* pData, unsigned long long ulSize, cl_ulong ulHash )
+{
+	const unsigned char*	ucData	= static_cast<const unsigned char*>( pData );
+	unsigned long long		ulWords	= ulSize / sizeof( cl_ulong );
+
+	for ( unsigned long long i = 0; i < ulWords; i++ )
+	{
+		cl_ulong	ulWord;
+		std::memcpy( &ulWord, ucData + i * sizeof( cl_ulong ), sizeof( cl_ulong ) );
+		ulHash ^= CDomainCacheDataset::rotateLeft( ulWord * ulHashPrime2, 31 ) * ulHashPrime1;
+		ulHash  = CDomainCacheDataset::rotateLeft( ulHash, 27 ) * ulHashPrime1 + ulHashPrime4;
+	}
+
+	for ( unsigned long long i = ulWords * sizeof( cl_ulong ); i < ulSize; i++ )
+	{
+		ulHash ^= ucData[ i ] * ulHashPrime5;
+		ulHash  = CDomainCacheDataset::rotateLeft( ulHash, 11 ) * ulHashPrime1;
+	}
+
+	ulHash ^= ulSize;
+	ulHash ^= ulHash >> 33;
+	ulHash *= ulHashPrime2;
+	ulHash ^= ulHash >> 29;
+	ulHash *= ulHashPrime3;
+	ulHash ^= ulHash >> 32;
+
+	return ulHash;
+}
+
+/*
+ *  Extend a hash with the contents of a file
+ */
+bool CDomainCacheDataset::hashFile( std::string sFilename, cl_ulong* ulHash )
+{
+	std::ifstream		ifsFile( sFilename.c_str(), std::ios::in | std::ios::binary );
+	std::vector<char>	vBuffer( 4 * 1024 * 1024 );
+
+	if ( !ifsFile.is_open() )
+		return false;
+
+	while ( ifsFile )
+	{
+		ifsFile.read( &vBuffer[0], vBuffer.size() );
+		*ulHash = CDomainCacheDataset::hashData( &vBuffer[0], ifsFile.gcount(), *ulHash );
+	}
+
+	return ifsFile.eof();
+}
+
+/*
+ *  Write a cache file to disk. The file is written under a temporary
+ *  name and moved into place, as for checkpoints.
+ */
+bool CDomainCacheDataset::writeFile( std::string sFilename, sDomainCacheHeader* pHeader, void* pCellStates, void* pBedElevations, void* pManningValues )
+{
+	void*				pSections[3] = { pCellStates, pBedElevations, pManningValues };
+	std::string			sTemporary = sFilename + ".tmp";
+	std::vector<char>	vPadding( ulPageSize, 0 );
+
+	pHeader->ulChecksum = ulHashBasis;
+	for ( unsigned char i = 0; i < 3; i++ )
+		pHeader->ulChecksum = CDomainCacheDataset::hashData( pSections[i], CDomainCacheDataset::getSectionSize( pHeader, i ), pHeader->ulChecksum );
+
+	boost::system::error_code ecDirectory;
+	boost::filesystem::create_directories( boost::filesystem::path( sFilename ).parent_path(), ecDirectory );
+
+	std::ofstream	ofsFile( sTemporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+	if ( !ofsFile.is_open() )
+	{
+		model::doError(
+			"Could not open domain cache file for writing: " + sTemporary,
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	unsigned long long ulPosition = sizeof( sDomainCacheHeader );
+	ofsFile.write( reinterpret_cast<char*>( pHeader ), sizeof( sDomainCacheHeader ) );
+	for ( unsigned char i = 0; i < 3; i++ )
+	{
+		ofsFile.write( &vPadding[0], CDomainCacheDataset::getSectionOffset( pHeader, i ) - ulPosition );
+		ofsFile.write( static_cast<char*>( pSections[i] ), CDomainCacheDataset::getSectionSize( pHeader, i ) );
+		ulPosition = CDomainCacheDataset::getSectionOffset( pHeader, i ) + CDomainCacheDataset::getSectionSize( pHeader, i );
+	}
+	ofsFile.close();
+
+	if ( ofsFile.fail() )
+	{
+		model::doError(
+			"Failed to write domain cache file: " + sTemporary,
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	boost::system::error_code ecRename;
+	boost::filesystem::rename( sTemporary, sFilename, ecRename );
+	if ( ecRename )
+	{
+		model::doError(
+			"Could not replace domain cache file: " + sFilename,
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ *  Read a cache file straight into the domain's arrays, verifying it
+ *  matches the inputs (the identifying fields of the header must already
+ *  be populated). A missing, stale or damaged file just means the domain
+ *  has to be prepared from the inputs again.
+ */
+bool CDomainCacheDataset::readFile( std::string sFilename, sDomainCacheHeader* pHeader, void* pCellStates, void* pBedElevations, void* pManningValues )
+{
+	void*				pSections[3] = { pCellStates, pBedElevations, pManningValues };
+	sDomainCacheHeader	pFileHeader;
+	std::ifstream		ifsFile( sFilename.c_str(), std::ios::in | std::ios::binary );
+
+	if ( !ifsFile.is_open() )
+		return false;
+
+	ifsFile.read( reinterpret_cast<char*>( &pFileHeader ), sizeof( sDomainCacheHeader ) );
+
+	if ( ifsFile.fail() ||
+		 std::memcmp( pFileHeader.cMagic, pHeader->cMagic, 8 ) != 0 ||
+		 pFileHeader.uiVersion != pHeader->uiVersion ||
+		 pFileHeader.uiFloatSize != pHeader->uiFloatSize ||
+		 pFileHeader.ulCellCount != pHeader->ulCellCount ||
+		 pFileHeader.uiCellStateLayout != pHeader->uiCellStateLayout ||
+		 pFileHeader.ulInputKey != pHeader->ulInputKey )
+	{
+		pManager->log->writeLine( "Domain cache does not match the inputs: " + sFilename );
+		return false;
+	}
+
+	cl_ulong ulChecksum = ulHashBasis;
+	for ( unsigned char i = 0; i < 3; i++ )
+	{
+		ifsFile.seekg( CDomainCacheDataset::getSectionOffset( &pFileHeader, i ) );
+		ifsFile.read( static_cast<char*>( pSections[i] ), CDomainCacheDataset::getSectionSize( &pFileHeader, i ) );
+		if ( ifsFile.fail() )
+			break;
+		ulChecksum = CDomainCacheDataset::hashData( pSections[i], CDomainCacheDataset::getSectionSize( &pFileHeader, i ), ulChecksum );
+	}
+
+	if ( ifsFile.fail() || ulChecksum != pFileHeader.ulChecksum )
+	{
+		model::doError(
+			"Domain cache file is damaged and will be rebuilt: " + sFilename,
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	*pHeader = pFileHeader;
+
+	return true;
+}
+
+/*
+ *  Position of a section (cell states, bed elevations, Manning coefficients)
+ *  in the file, each rounded up to a page boundary
+ */
+unsigned long long CDomainCacheDataset::getSectionOffset( sDomainCacheHeader* pHeader, unsigned char ucSection )
+{
+	unsigned long long ulOffset = sizeof( sDomainCacheHeader );
+
+	for ( unsigned char i = 0; i <= ucSection; i++ )
+	{
+		ulOffset = ( ( ulOffset + ulPageSize - 1 ) / ulPageSize ) * ulPageSize;
+		if ( i < ucSection )
+			ulOffset += CDomainCacheDataset::getSectionSize( pHeader, i );
+	}
+
+	return ulOffset;
+}
+
+/*
+ *  Size of a section in bytes
+ */
+unsigned long long CDomainCacheDataset::getSectionSize( sDomainCacheHeader* pHeader, unsigned char ucSection )
+{
+	return pHeader->ulCellCount * pHeader->uiFloatSize * ( ucSection == 0 ? 4 : 1 );
+}
@@ -0,0 +1,83 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ *
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Prepared domain cache handling class
+ * ------------------------------------------
+ *
+ */
+
+#ifndef HIPIMS_DATASETS_CDOMAINCACHEDATASET_H_
+#define HIPIMS_DATASETS_CDOMAINCACHEDATASET_H_
+
+#include <string>
+
+#include "../OpenCL/opencl.h"
+
+/*
+ *  Fixed header at the start of each cache file. The cell states,
+ *  bed elevations and Manning coefficients follow, each starting
+ *  on a page boundary so the file can be mapped.
+ */
+struct sDomainCacheHeader
+{
+	char			cMagic[8];				// File identifier
+	cl_uint			uiVersion;				// File format version
+	cl_uint			uiFloatSize;			// Bytes per floating-point value
+	cl_ulong		ulCellCount;			// Number of cells in the domain
+	cl_uint			uiCellStateLayout;		// Cell state memory layout
+	cl_uint			uiReserved;				// Padding
+	cl_ulong		ulInputKey;				// Hash of the input files and configuration
+	cl_ulong		ulChecksum;				// Hash of the cached data
+	cl_double		dMinFSL;				// Range of the input values
+	cl_double		dMaxFSL;
+	cl_double		dMinTopo;
+	cl_double		dMaxTopo;
+	cl_double		dMinDepth;
+	cl_double		dMaxDepth;
+};
+
+/*
+ *  DOMAIN CACHE DATASET CLASS
+ *  CDomainCacheDataset
+ *
+ *  Reads and writes binary copies of a domain's prepared
+ *  initial conditions, keyed on a hash of the inputs, so
+ *  later runs don't need to decode the rasters again.
+ */
+class CDomainCacheDataset
+{
+public:
+	static std::string		getFilename( std::string, cl_ulong );								// Cache filename for a set of inputs in a directory
+	static void				prepareHeader( sDomainCacheHeader*, cl_ulong, unsigned long, unsigned char, unsigned char );	// Fill in the identifying fields of a header
+	static cl_ulong			hashData( const void*, unsigned long long, cl_ulong = ulHashBasis );	// Extend a hash with some data
+	static bool				hashFile( std::string, cl_ulong* );									// Extend a hash with the contents of a file
+	static bool				writeFile( std::string, sDomainCacheHeader*, void*, void*, void* );	// Write a cache file to disk
+	static bool				readFile( std::string, sDomainCacheHeader*, void*, void*, void* );	// Read a cache file back, if it matches
+
+private:
+	static const cl_uint	uiFormatVersion = 2;												// Current file format version
+	static const cl_ulong	ulHashBasis		= 0x27D4EB2F165667C5ULL;							// Hash seed
+	static const cl_ulong	ulHashPrime1	= 0x9E3779B185EBCA87ULL;							// xxHash64 primes
+	static const cl_ulong	ulHashPrime2	= 0xC2B2AE3D27D4EB4FULL;
+	static const cl_ulong	ulHashPrime3	= 0x165667B19E3779F9ULL;
+	static const cl_ulong	ulHashPrime4	= 0x85EBCA77C2B2AE63ULL;
+	static const cl_ulong	ulHashPrime5	= 0x27D4EB2F165667C5ULL;
+	static const unsigned long long	ulPageSize = 4096;											// Alignment of each section
+
+	static unsigned long long	getSectionOffset( sDomainCacheHeader*, unsigned char );		// Position of a section in the file
+	static unsigned long long	getSectionSize( sDomainCacheHeader*, unsigned char );			// Size of a section in bytes
+	static cl_ulong				rotateLeft( cl_ulong ulValue, unsigned int uiBits )	{ return ( ulValue << uiBits ) | ( ulValue >> ( 64 - uiBits ) ); }
+};
+
+#endif
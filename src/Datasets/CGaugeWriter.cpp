@@ -0,0 +1,354 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ *
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Gauge time series writing class
+ * ------------------------------------------
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <boost/filesystem.hpp>
+
+#include "../common.h"
+#include "../main.h"
+#include "CGaugeWriter.h"
+#include "CRasterDataset.h"
+#include "../Domain/Cartesian/CDomainCartesian.h"
+#include "../Schemes/CScheme.h"
+#include "../OpenCL/Executors/COCLDevice.h"
+
+std::set<std::string>	CGaugeWriter::sFilesOpened;
+
+/*
+ *  Constructor
+ */
+CGaugeWriter::CGaugeWriter( CDomainCartesian* pDomain )
+{
+	this->pDomain		= pDomain;
+	this->dInterval		= 0.0;
+	this->uiSamples		= 0;
+	this->ulLastSample	= 0;
+	this->bStarted		= false;
+	this->cSamples		= NULL;
+}
+
+/*
+ *  Destructor
+ */
+CGaugeWriter::~CGaugeWriter()
+{
+	for ( unsigned int i = 0; i < this->vTargets.size(); i++ )
+	{
+		if ( this->vTargets[i].pFile != NULL )
+		{
+			this->vTargets[i].pFile->close();
+			delete this->vTargets[i].pFile;
+		}
+	}
+
+	if ( this->cSamples != NULL )
+		delete [] this->cSamples;
+}
+
+/*
+ *  Add a CSV file holding one value at each of a list of cells, written
+ *  at the given frequency
+ */
+bool	CGaugeWriter::addTarget(
+			std::string					sFilename,
+			unsigned char				ucValue,
+			double						dFrequency,
+			std::vector<unsigned long>*	vGaugeCells,
+			std::vector<std::string>*	vGaugeNames
+		)
+{
+	if ( ucValue != model::rasterDatasets::dataValues::kDepth &&
+		 ucValue != model::rasterDatasets::dataValues::kFreeSurfaceLevel &&
+		 ucValue != model::rasterDatasets::dataValues::kVelocityX &&
+		 ucValue != model::rasterDatasets::dataValues::kVelocityY &&
+		 ucValue != model::rasterDatasets::dataValues::kDischargeX &&
+		 ucValue != model::rasterDatasets::dataValues::kDischargeY )
+	{
+		model::doError(
+			"Time series outputs can only record depth, FSL, velocity or discharge.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	if ( dFrequency <= 0.0 )
+	{
+		model::doError(
+			"Time series outputs need a positive frequency.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	// Gauges might all be held by another part of a split domain
+	if ( vGaugeCells->empty() )
+		return true;
+
+	sGaugeTarget pTarget;
+	pTarget.sFilename		= sFilename;
+	pTarget.ucValue			= ucValue;
+	pTarget.dFrequency		= dFrequency;
+	pTarget.uiFirstGauge	= this->vCells.size();
+	pTarget.uiGaugeCount	= vGaugeCells->size();
+	pTarget.llLastRow		= -1;
+
+	pTarget.sHeader = "time";
+	for ( unsigned int i = 0; i < vGaugeNames->size(); i++ )
+		pTarget.sHeader += "," + ( *vGaugeNames )[ i ];
+
+	// The first domain to write a file this run starts it afresh, unless the
+	// run resumes from a checkpoint, when the file is cut back once the time
+	// is known
+	bool	bAppend = ( sFilesOpened.count( sFilename ) > 0 );
+	pTarget.bResuming = ( !bAppend && model::resumeDir != NULL && boost::filesystem::exists( sFilename ) );
+	pTarget.pFile = new std::ofstream( sFilename.c_str(), std::ios::out | ( bAppend || pTarget.bResuming ? std::ios::app : std::ios::trunc ) );
+
+	if ( !pTarget.pFile->is_open() )
+	{
+		delete pTarget.pFile;
+		model::doError(
+			"Could not open time series output file " + sFilename + ".",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+	sFilesOpened.insert( sFilename );
+
+	if ( !bAppend && !pTarget.bResuming )
+		*pTarget.pFile << pTarget.sHeader << std::endl;
+	*pTarget.pFile << std::setprecision( 10 );
+
+	this->vCells.insert( this->vCells.end(), vGaugeCells->begin(), vGaugeCells->end() );
+	this->vTargets.push_back( pTarget );
+
+	return true;
+}
+
+/*
+ *  Size the ring buffer so it covers at least one output interval, which is
+ *  the longest the model runs between synchronisations anyway, and have the
+ *  scheme start sampling
+ */
+void	CGaugeWriter::prepare()
+{
+	if ( this->vTargets.empty() )
+		return;
+
+	this->dInterval = this->vTargets[0].dFrequency;
+	for ( unsigned int i = 1; i < this->vTargets.size(); i++ )
+		this->dInterval = std::min( this->dInterval, this->vTargets[i].dFrequency );
+
+	this->uiSamples = static_cast<unsigned int>( std::min(
+		ceil( pManager->getOutputFrequency() / this->dInterval ) + 2.0,
+		static_cast<double>( uiMaxSamples )
+	) );
+	this->uiSamples = std::max( this->uiSamples, 3U );
+
+	this->cSamples = new char[ this->vCells.size() * 4 * this->uiSamples * ( pDomain->isDoublePrecision() ? sizeof( cl_double ) : sizeof( cl_float ) ) ];
+
+	pDomain->getScheme()->enableGauges( &this->vCells, this->dInterval, this->uiSamples );
+}
+
+/*
+ *  Keep the rows written by an earlier run up to the time this run resumed
+ *  from, and carry on after them. A file whose gauges don't match the
+ *  header is started afresh.
+ */
+void	CGaugeWriter::resumeAt( double dTime )
+{
+	for ( unsigned int i = 0; i < this->vTargets.size(); i++ )
+	{
+		sGaugeTarget*		pTarget		= &this->vTargets[i];
+
+		if ( !pTarget->bResuming )
+			continue;
+		pTarget->bResuming = false;
+
+		std::ifstream		ifsFile( pTarget->sFilename.c_str(), std::ios::in );
+		std::ostringstream	ossKept;
+		std::string			sLine;
+		unsigned long		ulRows		= 0;
+
+		if ( std::getline( ifsFile, sLine ) && sLine == pTarget->sHeader )
+		{
+			while ( std::getline( ifsFile, sLine ) )
+			{
+				char*	cEnd	= NULL;
+				double	dRow	= std::strtod( sLine.c_str(), &cEnd );
+				// A row cut short when the earlier run stopped is dropped too
+				if ( cEnd == sLine.c_str() || *cEnd != ',' || dRow > dTime + 1E-6 ||
+					 static_cast<unsigned int>( std::count( sLine.begin(), sLine.end(), ',' ) ) != pTarget->uiGaugeCount )
+					break;
+
+				ossKept << sLine << "\n";
+				pTarget->llLastRow = static_cast<long long>( floor( dRow / pTarget->dFrequency + 1E-6 ) );
+				ulRows++;
+			}
+		} else {
+			model::doError(
+				"Time series output " + pTarget->sFilename + " has different gauges, so it will be started afresh.",
+				model::errorCodes::kLevelWarning
+			);
+		}
+		ifsFile.close();
+
+		pTarget->pFile->close();
+		pTarget->pFile->open( pTarget->sFilename.c_str(), std::ios::out | std::ios::trunc );
+		*pTarget->pFile << pTarget->sHeader << "\n" << ossKept.str();
+		pTarget->pFile->flush();
+
+		if ( pTarget->pFile->fail() )
+		{
+			model::doError(
+				"Could not rewrite time series output " + pTarget->sFilename + ".",
+				model::errorCodes::kLevelWarning
+			);
+			continue;
+		}
+
+		pManager->log->writeLine( "Resuming time series output " + pTarget->sFilename + " with " + toString( ulRows ) + " earlier rows." );
+	}
+}
+
+/*
+ *  Longest the simulation can run between readbacks without the device
+ *  overwriting samples which haven't been read
+ */
+double	CGaugeWriter::getReadbackInterval()
+{
+	if ( this->vTargets.empty() )
+		return 0.0;
+
+	return ( this->uiSamples - 2 ) * this->dInterval;
+}
+
+/*
+ *  Fetch the ring buffer slots filled since the last call and append a row
+ *  to each file for every sample which falls on its frequency. Must be
+ *  called when the domain is idle at a sync point.
+ */
+void	CGaugeWriter::writeSamples()
+{
+	if ( this->vTargets.empty() || !pDomain->getScheme()->getGaugesEnabled() )
+		return;
+
+	unsigned long long	ulNow	= static_cast<unsigned long long>( floor( pDomain->getScheme()->getCurrentTime() / this->dInterval + 1E-6 ) );
+	unsigned long long	ulFirst	= ( this->bStarted ? this->ulLastSample + 1 : 0 );
+
+	if ( ulNow + 1 <= ulFirst )
+		return;
+
+	if ( ulNow + 1 - ulFirst > this->uiSamples )
+	{
+		if ( this->bStarted )
+			model::doError(
+				"Gauge samples were overwritten before they could be read back.",
+				model::errorCodes::kLevelWarning
+			);
+		ulFirst = ulNow + 1 - this->uiSamples;
+	}
+
+	// Read back in at most two pieces, where the ring wraps around
+	unsigned int uiStart	= static_cast<unsigned int>( ulFirst % this->uiSamples );
+	unsigned int uiCount	= static_cast<unsigned int>( ulNow + 1 - ulFirst );
+	unsigned int uiFirstPart = std::min( uiCount, this->uiSamples - uiStart );
+
+	pDomain->getScheme()->readGauges( uiStart, uiFirstPart, this->cSamples );
+	pDomain->getScheme()->readGauges( 0, uiCount - uiFirstPart, this->cSamples );
+	pDomain->getDevice()->blockUntilFinished();
+
+	for ( unsigned long long ulSample = ulFirst; ulSample <= ulNow; ulSample++ )
+	{
+		unsigned int uiSlotStart = static_cast<unsigned int>( ( ulSample % this->uiSamples ) * this->vCells.size() );
+
+		for ( unsigned int i = 0; i < this->vTargets.size(); i++ )
+		{
+			sGaugeTarget* pTarget = &this->vTargets[i];
+
+			// Slots which were never filled, or hold an older sample, are skipped
+			double dTime = this->getGaugeValue( uiSlotStart + pTarget->uiFirstGauge, 255 );
+			if ( dTime < 0.0 ||
+				 static_cast<unsigned long long>( floor( dTime / this->dInterval + 1E-6 ) ) != ulSample )
+				continue;
+
+			long long llRow = static_cast<long long>( floor( dTime / pTarget->dFrequency + 1E-6 ) );
+			if ( llRow <= pTarget->llLastRow )
+				continue;
+			pTarget->llLastRow = llRow;
+
+			*pTarget->pFile << dTime;
+			for ( unsigned int j = 0; j < pTarget->uiGaugeCount; j++ )
+				*pTarget->pFile << "," << this->getGaugeValue( uiSlotStart + pTarget->uiFirstGauge + j, pTarget->ucValue );
+			*pTarget->pFile << "\n";
+		}
+	}
+
+	for ( unsigned int i = 0; i < this->vTargets.size(); i++ )
+		this->vTargets[i].pFile->flush();
+
+	this->ulLastSample	= ulNow;
+	this->bStarted		= true;
+}
+
+/*
+ *  Convert a sample held as (FSL, time, discharge X, discharge Y) into the
+ *  value for a file, or the time of the sample if no value is given
+ */
+double	CGaugeWriter::getGaugeValue( unsigned int uiEntry, unsigned char ucValue )
+{
+	double	dSample[4];
+	for ( unsigned char ucIndex = 0; ucIndex < 4; ucIndex++ )
+	{
+		if ( pDomain->isDoublePrecision() )
+		{
+			dSample[ ucIndex ] = reinterpret_cast<cl_double*>( this->cSamples )[ uiEntry * 4 + ucIndex ];
+		} else {
+			dSample[ ucIndex ] = static_cast<double>( reinterpret_cast<cl_float*>( this->cSamples )[ uiEntry * 4 + ucIndex ] );
+		}
+	}
+
+	if ( ucValue == 255 )
+		return dSample[1];
+
+	double	dResolution;
+	double	dDepth = std::max( 0.0, dSample[0] - pDomain->getBedElevation( this->vCells[ uiEntry % this->vCells.size() ] ) );
+	pDomain->getCellResolution( &dResolution );
+
+	switch( ucValue )
+	{
+	case model::rasterDatasets::dataValues::kDepth:
+		return dDepth;
+	case model::rasterDatasets::dataValues::kFreeSurfaceLevel:
+		return dSample[0];
+	case model::rasterDatasets::dataValues::kVelocityX:
+		return ( dDepth > 1E-8 ? dSample[2] / dDepth : 0.0 );
+	case model::rasterDatasets::dataValues::kVelocityY:
+		return ( dDepth > 1E-8 ? dSample[3] / dDepth : 0.0 );
+	case model::rasterDatasets::dataValues::kDischargeX:
+		return dSample[2] * dResolution;
+	case model::rasterDatasets::dataValues::kDischargeY:
+		return dSample[3] * dResolution;
+	}
+
+	return -9999.0;
+}
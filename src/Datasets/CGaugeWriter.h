@@ -0,0 +1,83 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ *
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Gauge time series writing class
+ * ------------------------------------------
+ *
+ */
+
+#ifndef HIPIMS_DATASETS_CGAUGEWRITER_H_
+#define HIPIMS_DATASETS_CGAUGEWRITER_H_
+
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+class CDomainCartesian;
+
+/*
+ *  GAUGE WRITER CLASS
+ *  CGaugeWriter
+ *
+ *  Collects the gauge cells for a domain's time series
+ *  outputs, has the scheme sample them on the device,
+ *  and appends the samples read back to CSV files.
+ */
+class CGaugeWriter
+{
+public:
+	CGaugeWriter( CDomainCartesian* );
+	~CGaugeWriter();
+
+	bool							addTarget( std::string, unsigned char, double,			// Add a CSV file for a value at a list of cells
+											   std::vector<unsigned long>*,
+											   std::vector<std::string>* );
+	void							prepare();												// Have the scheme start sampling the gauges
+	void							resumeAt( double );										// Keep the rows up to a resume time in each file
+	void							writeSamples();											// Read back new samples and append them to the files
+	double							getReadbackInterval();									// Longest the simulation can run before samples are lost
+	unsigned int					getTargetCount()		{ return vTargets.size(); }		// Number of time series files
+
+private:
+	static const unsigned int		uiMaxSamples = 4096;									// Most samples held on the device at once
+
+	struct sGaugeTarget
+	{
+		std::string					sFilename;
+		unsigned char				ucValue;
+		double						dFrequency;
+		unsigned int				uiFirstGauge;
+		unsigned int				uiGaugeCount;
+		long long					llLastRow;
+		std::string					sHeader;
+		bool						bResuming;
+		std::ofstream*				pFile;
+	};
+
+	double							getGaugeValue( unsigned int, unsigned char );			// Convert a gauge sample to an output value
+
+	CDomainCartesian*				pDomain;												// Domain the gauges are in
+	std::vector<sGaugeTarget>		vTargets;												// Time series files
+	std::vector<unsigned long>		vCells;													// Cell for each gauge, across every file
+	double							dInterval;												// Time between samples on the device
+	unsigned int					uiSamples;												// Samples held in the device ring buffer
+	unsigned long long				ulLastSample;											// Last sample read back
+	bool							bStarted;												// Have any samples been read back yet?
+	char*							cSamples;												// Host copy of the ring buffer
+
+	static std::set<std::string>	sFilesOpened;											// Files already started by this process
+};
+
+#endif
@@ -0,0 +1,296 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ *
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Asynchronous output writing class
+ * ------------------------------------------
+ *
+ */
+
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+
+#include "../common.h"
+#include "COutputWriter.h"
+#include "CRasterDataset.h"
+#include "CZarrDataset.h"
+#include "../Domain/Cartesian/CDomainCartesian.h"
+#include "../Schemes/CScheme.h"
+#include "../OpenCL/Executors/COCLBuffer.h"
+#include "../OpenCL/Executors/COCLDevice.h"
+
+/*
+ *  Constructor
+ */
+COutputWriter::COutputWriter( CDomainCartesian* pDomain )
+{
+	this->pDomain		= pDomain;
+	this->bTerminate	= false;
+
+	for ( unsigned int i = 0; i < uiStagingCount; i++ )
+	{
+		this->pStaging[ i ]				= NULL;
+		this->pAccumulatorStaging[ i ]	= NULL;
+		this->pFieldStaging[ i ]		= NULL;
+		this->bStagingBusy[ i ]			= false;
+	}
+
+	this->thrWriter = std::thread( &COutputWriter::Threaded_writeOutputs, this );
+}
+
+/*
+ *  Destructor
+ */
+COutputWriter::~COutputWriter()
+{
+	// The thread drains any outstanding jobs before it exits
+	{
+		std::lock_guard<std::mutex> lockJobs( this->mtxJobs );
+		this->bTerminate = true;
+	}
+	this->cvJobs.notify_all();
+
+	if ( this->thrWriter.joinable() )
+		this->thrWriter.join();
+
+	for ( unsigned int i = 0; i < uiStagingCount; i++ )
+	{
+		if ( this->pStaging[ i ] != NULL )
+			delete this->pStaging[ i ];
+		if ( this->pAccumulatorStaging[ i ] != NULL )
+			delete this->pAccumulatorStaging[ i ];
+		if ( this->pFieldStaging[ i ] != NULL )
+			delete this->pFieldStaging[ i ];
+	}
+}
+
+/*
+ *  Take a copy of the values needed for the outputs from the device and
+ *  hand it to the writer thread. Blocks only if every staging buffer is
+ *  still waiting to be written, which bounds the memory used.
+ */
+void	COutputWriter::queueOutputs( std::vector<sOutputTarget> vTargets )
+{
+	if ( vTargets.empty() )
+		return;
+
+	// Only read back what the outputs need: a single-precision plane for
+	// each distinct field, including the accumulators. Anything else, like
+	// the bed elevations, is already held on the host.
+	sOutputJob	pJob;
+	pJob.bCellStates	= false;
+	pJob.bAccumulators	= false;
+	for ( unsigned int i = 0; i < vTargets.size(); i++ )
+	{
+		if ( ( CRasterDataset::isDeviceFieldValue( vTargets[i].ucValue ) ||
+			   CRasterDataset::isAccumulatorValue( vTargets[i].ucValue ) ) &&
+			 std::find( pJob.vFields.begin(), pJob.vFields.end(), vTargets[i].ucValue ) == pJob.vFields.end() )
+			pJob.vFields.push_back( vTargets[i].ucValue );
+	}
+
+	pJob.uiStaging		= this->takeSnapshot( pJob.bCellStates, pJob.bAccumulators, &pJob.vFields );
+	pJob.vTargets		= vTargets;
+	pJob.dTime			= pDomain->getScheme()->getCurrentTime();
+
+	this->queueJob( pJob );
+}
+
+/*
+ *  Take a copy of the current cell states, and the accumulators if in
+ *  use, and have the writer thread save them alongside the header as
+ *  a checkpoint
+ */
+void	COutputWriter::queueCheckpoint( std::string sFilename, sCheckpointHeader pHeader )
+{
+	sOutputJob	pJob;
+	pJob.bCellStates		= true;
+	pJob.bAccumulators		= pDomain->getScheme()->getAccumulatorsEnabled();
+	pJob.dTime				= pHeader.dTime;
+	pJob.uiStaging			= this->takeSnapshot( true, pJob.bAccumulators, NULL );
+	pJob.sCheckpoint		= sFilename;
+	pJob.pCheckpointHeader	= pHeader;
+
+	this->queueJob( pJob );
+}
+
+/*
+ *  Wait for a free staging buffer and copy the cell states, accumulators
+ *  and output fields into it as required
+ */
+unsigned int	COutputWriter::takeSnapshot( bool bCellStates, bool bAccumulators, std::vector<unsigned char>* vFields )
+{
+	cl_ulong		ulStateSize = pDomain->getCellCount() * 4 * ( pDomain->isDoublePrecision() ? sizeof( cl_double ) : sizeof( cl_float ) );
+	cl_ulong		ulFieldSize = ( vFields == NULL ? 0 : pDomain->getCellCount() * sizeof( cl_float ) * vFields->size() );
+	unsigned int	uiStaging = 0;
+
+	{
+		std::unique_lock<std::mutex> lockJobs( this->mtxJobs );
+		this->cvJobs.wait( lockJobs, [this]{
+			for ( unsigned int i = 0; i < uiStagingCount; i++ )
+				if ( !this->bStagingBusy[ i ] ) return true;
+			return false;
+		} );
+
+		while ( this->bStagingBusy[ uiStaging ] )
+			uiStaging++;
+		this->bStagingBusy[ uiStaging ] = true;
+	}
+
+	if ( bCellStates && this->pStaging[ uiStaging ] == NULL )
+		this->pStaging[ uiStaging ] = this->createStaging( "Output staging " + toString( uiStaging + 1 ), ulStateSize );
+	if ( bAccumulators && this->pAccumulatorStaging[ uiStaging ] == NULL )
+		this->pAccumulatorStaging[ uiStaging ] = this->createStaging( "Accumulator staging " + toString( uiStaging + 1 ), ulStateSize );
+	if ( ulFieldSize > 0 && ( this->pFieldStaging[ uiStaging ] == NULL || this->pFieldStaging[ uiStaging ]->getSize() < ulFieldSize ) )
+	{
+		if ( this->pFieldStaging[ uiStaging ] != NULL )
+			delete this->pFieldStaging[ uiStaging ];
+		this->pFieldStaging[ uiStaging ] = this->createStaging( "Field staging " + toString( uiStaging + 1 ), ulFieldSize );
+	}
+
+	// Cell states must be consistent before they're copied
+	pDomain->getDevice()->blockUntilFinished();
+	if ( bCellStates )
+		pDomain->getScheme()->readDomainAll( this->pStaging[ uiStaging ]->getHostBlock<void*>() );
+	if ( bAccumulators )
+		pDomain->getScheme()->readAccumulators( this->pAccumulatorStaging[ uiStaging ]->getHostBlock<void*>() );
+	if ( ulFieldSize > 0 )
+		pDomain->getScheme()->readOutputFields( vFields, this->pFieldStaging[ uiStaging ]->getHostBlock<void*>() );
+	pDomain->getDevice()->blockUntilFinished();
+
+	return uiStaging;
+}
+
+/*
+ *  Create a staging buffer of the given size, pinned where possible
+ */
+COCLBuffer*	COutputWriter::createStaging( std::string sName, cl_ulong ulSize )
+{
+	COCLBuffer* pBuffer = new COCLBuffer(
+		sName,
+		pDomain->getScheme()->getProgram(),
+		false,
+		false,
+		ulSize,
+		false
+	);
+
+	// Fall back on pageable memory if the device can't map a pinned buffer
+	if ( !pBuffer->createPinnedBuffer() ||
+		 pBuffer->getHostBlock<void*>() == NULL )
+		pBuffer->allocateHostBlock( ulSize );
+
+	return pBuffer;
+}
+
+/*
+ *  Pass a job over to the writer thread
+ */
+void	COutputWriter::queueJob( sOutputJob pJob )
+{
+	{
+		std::lock_guard<std::mutex> lockJobs( this->mtxJobs );
+		this->dqJobs.push_back( pJob );
+	}
+	this->cvJobs.notify_all();
+}
+
+/*
+ *  Block until every queued output has been written to disk
+ */
+void	COutputWriter::waitForCompletion()
+{
+	std::unique_lock<std::mutex> lockJobs( this->mtxJobs );
+	this->cvJobs.wait( lockJobs, [this]{
+		if ( !this->dqJobs.empty() ) return false;
+		for ( unsigned int i = 0; i < uiStagingCount; i++ )
+			if ( this->bStagingBusy[ i ] ) return false;
+		return true;
+	} );
+}
+
+/*
+ *  Write each snapshot's rasters in turn, releasing its staging buffer
+ *  once complete. Runs in its own thread.
+ */
+void	COutputWriter::Threaded_writeOutputs()
+{
+	while ( true )
+	{
+		sOutputJob	pJob;
+
+		{
+			std::unique_lock<std::mutex> lockJobs( this->mtxJobs );
+			this->cvJobs.wait( lockJobs, [this]{ return this->bTerminate || !this->dqJobs.empty(); } );
+
+			if ( this->dqJobs.empty() )
+				break;
+
+			pJob = this->dqJobs.front();
+			this->dqJobs.pop_front();
+		}
+
+		if ( !pJob.sCheckpoint.empty() )
+		{
+			// Stores should hold every output time the checkpoint has passed
+			CZarrDataset::flushStores( this->pDomain, false );
+			CCheckpointDataset::writeFile(
+				pJob.sCheckpoint,
+				&pJob.pCheckpointHeader,
+				this->pStaging[ pJob.uiStaging ]->getHostBlock<void*>(),
+				pDomain->getCellCount() * 4 * ( pDomain->isDoublePrecision() ? sizeof( cl_double ) : sizeof( cl_float ) ),
+				( pJob.bAccumulators ? this->pAccumulatorStaging[ pJob.uiStaging ]->getHostBlock<void*>() : NULL )
+			);
+		}
+
+		for ( unsigned int i = 0; i < pJob.vTargets.size(); i++ )
+		{
+			// Fields are held as consecutive planes, in the order they were requested
+			cl_float* fField = NULL;
+			std::vector<unsigned char>::iterator itField = std::find( pJob.vFields.begin(), pJob.vFields.end(), pJob.vTargets[i].ucValue );
+			if ( itField != pJob.vFields.end() )
+				fField = this->pFieldStaging[ pJob.uiStaging ]->getHostBlock<cl_float*>() + pDomain->getCellCount() * ( itField - pJob.vFields.begin() );
+
+			// Multi-timestep stores take one slice per output time
+			if ( boost::iequals( pJob.vTargets[i].sFormat, "zarr" ) )
+			{
+				CZarrDataset::appendSlice(
+					pJob.vTargets[i].sFilename,
+					this->pDomain,
+					pJob.vTargets[i].ucValue,
+					pJob.dTime,
+					fField,
+					pJob.vTargets[i].sCompression
+				);
+				continue;
+			}
+
+			CRasterDataset::domainToRaster(
+				pJob.vTargets[i].sFormat.c_str(),
+				pJob.vTargets[i].sFilename,
+				this->pDomain,
+				pJob.vTargets[i].ucValue,
+				fField,
+				pJob.vTargets[i].sCompression
+			);
+		}
+
+		{
+			std::lock_guard<std::mutex> lockJobs( this->mtxJobs );
+			this->bStagingBusy[ pJob.uiStaging ] = false;
+		}
+		this->cvJobs.notify_all();
+	}
+
+	// No more output times will follow
+	CZarrDataset::flushStores( this->pDomain, true );
+}
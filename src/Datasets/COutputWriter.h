@@ -0,0 +1,95 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ *
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Asynchronous output writing class
+ * ------------------------------------------
+ *
+ */
+
+#ifndef HIPIMS_DATASETS_COUTPUTWRITER_H_
+#define HIPIMS_DATASETS_COUTPUTWRITER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CCheckpointDataset.h"
+
+class CDomainCartesian;
+class COCLBuffer;
+
+/*
+ *  OUTPUT WRITER CLASS
+ *  COutputWriter
+ *
+ *  Snapshots the output fields for a domain, derived on
+ *  the device, into pinned staging memory and writes the
+ *  output rasters from a background thread, so the
+ *  simulation can continue. Checkpoints are written the
+ *  same way from a snapshot of the cell states.
+ */
+class COutputWriter
+{
+public:
+	COutputWriter( CDomainCartesian* );
+	~COutputWriter();
+
+	struct sOutputTarget
+	{
+		std::string		sFormat;
+		std::string		sFilename;
+		unsigned char	ucValue;
+		std::string		sCompression;
+	};
+
+	void							queueOutputs( std::vector<sOutputTarget> );		// Snapshot the domain and queue the outputs for writing
+	void							queueCheckpoint( std::string, sCheckpointHeader );	// Snapshot the domain and queue a checkpoint for writing
+	void							waitForCompletion();							// Block until every queued output has been written
+
+private:
+	static const unsigned int		uiStagingCount = 2;								// Snapshots which can be held at once
+
+	struct sOutputJob
+	{
+		unsigned int				uiStaging;
+		double						dTime;
+		std::vector<sOutputTarget>	vTargets;
+		std::vector<unsigned char>	vFields;
+		bool						bCellStates;
+		bool						bAccumulators;
+		std::string					sCheckpoint;
+		sCheckpointHeader			pCheckpointHeader;
+	};
+
+	unsigned int					takeSnapshot( bool, bool, std::vector<unsigned char>* );	// Copy the cell states, accumulators and fields into a free staging buffer
+	COCLBuffer*						createStaging( std::string, cl_ulong );			// Create a pinned staging buffer
+	void							queueJob( sOutputJob );							// Hand a snapshot to the writer thread
+	void							Threaded_writeOutputs();						// Worker thread loop
+
+	CDomainCartesian*				pDomain;										// Domain the outputs are taken from
+	COCLBuffer*						pStaging[ uiStagingCount ];						// Pinned staging buffers for cell state snapshots
+	COCLBuffer*						pAccumulatorStaging[ uiStagingCount ];			// Pinned staging buffers for accumulator snapshots
+	COCLBuffer*						pFieldStaging[ uiStagingCount ];				// Pinned staging buffers for output field snapshots
+	bool							bStagingBusy[ uiStagingCount ];					// Is a staging buffer waiting to be written?
+	std::deque<sOutputJob>			dqJobs;											// Snapshots waiting to be written
+	std::thread						thrWriter;										// Background writer thread
+	std::mutex						mtxJobs;										// Guards the job queue and staging state
+	std::condition_variable			cvJobs;											// Signalled when jobs are queued or completed
+	bool							bTerminate;										// Should the writer thread exit?
+};
+
+#endif
@@ -18,6 +18,8 @@
  */
 #include <boost/lexical_cast.hpp>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 
 #include "../common.h"
 #include "CRasterDataset.h"
@@ -102,26 +104,31 @@ bool	CRasterDataset::domainToRaster(
 			const char*			cDriver, 
 			std::string			sFilename,
 			CDomainCartesian*	pDomain,
-			unsigned char		ucValue
+			unsigned char		ucValue,
+			cl_float*			fField,
+			std::string			sCompression
 		)
 {
 	// Get the driver and check it's capable of writing
 	GDALDriver*		pDriver;
+	GDALDriver*		pCreateDriver;
 	GDALDataset*	pDataset;
 	GDALRasterBand*	pBand;
+	GDALDataType	gdType;
 	char**			czDriverMetadata;
 	char**			czOptions;
 	double			adfGeoTransform[6]		= { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 	double			dResolution;
 	double*			dRow;
-	double			dDepth;
-	double			dVelocityX, dVelocityY;
 	unsigned long	ulCellID;
+	bool			bCreateCopy				= false;
 	std::string		sValueName;
 
 	CRasterDataset::getValueDetails( ucValue, &sValueName );
 	pManager->log->writeLine( "Writing " + sValueName + " to output raster file..." );
 
+	std::chrono::high_resolution_clock::time_point tStart = std::chrono::high_resolution_clock::now();
+
 	pDriver = GetGDALDriverManager()->GetDriverByName( cDriver );
 
 	if ( pDriver == NULL )
@@ -133,27 +140,47 @@ bool	CRasterDataset::domainToRaster(
 		return false;
 	}
 
+	// Formats like COG can only be copied from an existing dataset, so the
+	// raster is assembled in memory first
 	czDriverMetadata = pDriver->GetMetadata();
 	if ( CSLFetchBoolean( czDriverMetadata, GDAL_DCAP_CREATE, false ) == 0 )
+	{
+		if ( CSLFetchBoolean( czDriverMetadata, GDAL_DCAP_CREATECOPY, false ) == 0 )
+		{
+			model::doError(
+				"GDAL format driver does not support file creation.",
+				model::errorCodes::kLevelWarning
+			);
+			return false;
+		}
+		bCreateCopy = true;
+	}
+
+	pCreateDriver = ( bCreateCopy ? GetGDALDriverManager()->GetDriverByName( "MEM" ) : pDriver );
+	if ( pCreateDriver == NULL )
 	{
 		model::doError(
-			"GDAL format driver does not support file creation.",
+			"Unable to obtain the in-memory driver for output.",
 			model::errorCodes::kLevelWarning
 		);
 		return false;
 	}
 
+	// Fields from the device are only single-precision anyway
+	gdType		= ( fField != NULL ? GDT_Float32 : GDT_Float64 );
+	czOptions	= CRasterDataset::getCreationOptions( pDriver, sCompression, gdType );
+
 	// Create and set metadata
-	czOptions = NULL;
-	pDataset = pDriver->Create(  sFilename.c_str(),			// Filename
-								 pDomain->getCols(),		// X size
-								 pDomain->getRows(),		// Y size
-								 1,							// Bands
-								 GDT_Float64,				// Data format
-								 czOptions );				// Options
+	pDataset = pCreateDriver->Create(  ( bCreateCopy ? "" : sFilename.c_str() ),	// Filename
+									   pDomain->getCols(),		// X size
+									   pDomain->getRows(),		// Y size
+									   1,						// Bands
+									   gdType,					// Data format
+									   ( bCreateCopy ? NULL : czOptions ) );	// Options
 								 
 	if ( pDataset == NULL )
 	{
+		CSLDestroy( czOptions );
 		model::doError(
 			"Could not create output raster file.",
 			model::errorCodes::kLevelWarning
@@ -174,6 +201,47 @@ bool	CRasterDataset::domainToRaster(
 	pBand	= pDataset->GetRasterBand( 1 );
 	pBand->SetNoDataValue( -9999.0 );
 
+	// Fields derived on the device already hold the final values, so they
+	// are written a whole strip of blocks at a time
+	if ( fField != NULL )
+	{
+		int				iBlockX, iBlockY;
+		pBand->GetBlockSize( &iBlockX, &iBlockY );
+
+		unsigned long	ulStripRows	= static_cast<unsigned long>( iBlockY ) * max( 1, 64 / max( 1, iBlockY ) );
+		cl_float*		fStrip		= new cl_float[ pDomain->getCols() * min( ulStripRows, pDomain->getRows() ) ];
+
+		for( unsigned long ulTop = 0; ulTop < pDomain->getRows(); ulTop += ulStripRows )
+		{
+			unsigned long ulRows = min( ulStripRows, pDomain->getRows() - ulTop );
+
+			// Rasters start in the top left, cells in the bottom left
+			for( unsigned long iRow = 0; iRow < ulRows; ++iRow )
+				memcpy( 
+					fStrip + iRow * pDomain->getCols(), 
+					fField + pDomain->getCellID( 0, pDomain->getRows() - ulTop - iRow - 1 ), 
+					sizeof( cl_float ) * pDomain->getCols() 
+				);
+
+			pBand->RasterIO( GF_Write,							// Flag
+							 0,									// X offset
+							 ulTop,								// Y offset
+							 pDomain->getCols(),				// X size
+							 ulRows,							// Y size
+							 fStrip,							// Memory
+							 pDomain->getCols(),				// X buffer size
+							 ulRows,							// Y buffer size
+							 GDT_Float32,						// Data type
+							 0,									// Pixel space
+							 0 );								// Line space
+		}
+		delete [] fStrip;
+
+		return CRasterDataset::closeOutput( pDataset, pDriver, bCreateCopy, sFilename, czOptions, tStart );
+	}
+
+	// Everything the simulation changes is derived on the device, which
+	// leaves the values held on the host from when the domain was loaded
 	dRow	= new double[ pDomain->getCols() ];
 	for( unsigned long iRow = 0; iRow < pDomain->getRows(); ++iRow )
 	{
@@ -184,85 +252,12 @@ bool	CRasterDataset::domainToRaster(
 
 			switch( ucValue )
 			{
-			case model::rasterDatasets::dataValues::kMaxFSL:
-				dRow[ iCol ] = pDomain->getStateValue( 
-					ulCellID,
-					model::domainValueIndices::kValueMaxFreeSurfaceLevel
-				);
-				if ( dRow[ iCol ] < pDomain->getBedElevation( ulCellID ) + 1E-8 ) 
-					dRow[ iCol ] = pBand->GetNoDataValue();
-				if (pDomain->getBedElevation(ulCellID) > 9999.0)
-					dRow[iCol] = pBand->GetNoDataValue();
-				break;
-			case model::rasterDatasets::dataValues::kFreeSurfaceLevel:
-				dRow[ iCol ] = pDomain->getStateValue( 
-					ulCellID,
-					model::domainValueIndices::kValueFreeSurfaceLevel
-				);
-				if ( dRow[ iCol ] < pDomain->getBedElevation( ulCellID ) + 1E-8 ) 
-					dRow[ iCol ] = pBand->GetNoDataValue();
-				if (pDomain->getBedElevation(ulCellID) > 9999.0)
-					dRow[iCol] = pBand->GetNoDataValue();
-				break;
-			case model::rasterDatasets::dataValues::kMaxDepth:
-				dRow[ iCol ] = max( 0.0, pDomain->getStateValue( ulCellID, 
-									model::domainValueIndices::kValueMaxFreeSurfaceLevel ) - 
-									pDomain->getBedElevation( ulCellID ) );
-				if ( dRow[ iCol ] < 1E-8 || dRow[iCol] <= -9990.0 || dRow[iCol] >= 9999.0 ) 
-					dRow[ iCol ] = pBand->GetNoDataValue();
-				break;
-			case model::rasterDatasets::dataValues::kDepth:
-				dRow[ iCol ] = max( 0.0, pDomain->getStateValue( ulCellID, 
-									model::domainValueIndices::kValueFreeSurfaceLevel ) - 
-									pDomain->getBedElevation( ulCellID ) );
-				if ( dRow[ iCol ] < 1E-8 ) 
-					dRow[ iCol ] = pBand->GetNoDataValue();
-				break;
-			case model::rasterDatasets::dataValues::kDischargeX:
-				dRow[ iCol ] = pDomain->getStateValue( 
-					ulCellID,
-					model::domainValueIndices::kValueDischargeX
-				) * dResolution;
-				break;
-			case model::rasterDatasets::dataValues::kDischargeY:
-				dRow[ iCol ] = pDomain->getStateValue( 
-					ulCellID,
-					model::domainValueIndices::kValueDischargeY
-				) * dResolution;
-				break;
-			case model::rasterDatasets::dataValues::kVelocityX:
-				dDepth		 = pDomain->getStateValue( ulCellID,
-									model::domainValueIndices::kValueFreeSurfaceLevel ) - 
-							   pDomain->getBedElevation( ulCellID );
-				dRow[ iCol ] = ( dDepth > 1E-8 ?
-							   ( pDomain->getStateValue( ulCellID,
-									model::domainValueIndices::kValueDischargeX ) / 
-									dDepth ) :
-							   ( pBand->GetNoDataValue() ) );
-				break;
-			case model::rasterDatasets::dataValues::kVelocityY:
-				dDepth		 = pDomain->getStateValue( ulCellID,
-									model::domainValueIndices::kValueFreeSurfaceLevel ) - 
-							   pDomain->getBedElevation( ulCellID );
-				dRow[ iCol ] = ( dDepth > 1E-8 ?
-							   ( pDomain->getStateValue( ulCellID,
-									model::domainValueIndices::kValueDischargeY ) / 
-									dDepth ) :
-							   ( pBand->GetNoDataValue() ) );
+			case model::rasterDatasets::dataValues::kBedElevation:
+				dRow[ iCol ] = pDomain->getBedElevation( ulCellID );
 				break;
-			case model::rasterDatasets::dataValues::kFroudeNumber:
-				dDepth		 = pDomain->getStateValue( ulCellID,
-									model::domainValueIndices::kValueFreeSurfaceLevel ) - 
-							   pDomain->getBedElevation( ulCellID );
-				dVelocityY	 = pDomain->getStateValue( ulCellID,
-									model::domainValueIndices::kValueDischargeY ) / 
-									dDepth;
-				dVelocityX	 = pDomain->getStateValue( ulCellID,
-									model::domainValueIndices::kValueDischargeX ) / 
-									dDepth;
-				dRow[ iCol ] = ( dDepth > 1E-8 ?
-							   ( sqrt( dVelocityX*dVelocityX + dVelocityY*dVelocityY ) / sqrt( 9.81 * dDepth ) ) :
-							   ( pBand->GetNoDataValue() ) );
+			case model::rasterDatasets::dataValues::kManningCoefficient:
+				if ( pDomain->getBedElevation( ulCellID ) > -9999.0 )
+					dRow[ iCol ] = pDomain->getManningCoefficient( ulCellID );
 				break;
 			}
 		}
@@ -281,9 +276,96 @@ bool	CRasterDataset::domainToRaster(
 	}
 	delete [] dRow;
 	
+	return CRasterDataset::closeOutput( pDataset, pDriver, bCreateCopy, sFilename, czOptions, tStart );
+}
+
+/*
+ *  Creation options for tiled, compressed GeoTIFF and COG outputs, using
+ *  DEFLATE unless another compression is named
+ */
+char**	CRasterDataset::getCreationOptions( GDALDriver* pDriver, std::string sCompression, GDALDataType gdType )
+{
+	char**		czOptions	= NULL;
+	std::string	sDriver		= std::string( pDriver->GetDescription() );
+
+	if ( sDriver != "GTiff" && sDriver != "COG" )
+	{
+		if ( !sCompression.empty() )
+			model::doError(
+				"Compression is only supported for GTiff and COG outputs.",
+				model::errorCodes::kLevelWarning
+			);
+		return NULL;
+	}
+
+	std::transform( sCompression.begin(), sCompression.end(), sCompression.begin(), ::toupper );
+	if ( sCompression.empty() )
+		sCompression = "DEFLATE";
+	if ( sCompression != "NONE" && sCompression != "DEFLATE" && sCompression != "LZW" && sCompression != "ZSTD" )
+	{
+		model::doError(
+			"Unrecognised output compression " + sCompression + ", using DEFLATE instead.",
+			model::errorCodes::kLevelWarning
+		);
+		sCompression = "DEFLATE";
+	}
+
+	czOptions = CSLSetNameValue( czOptions, "COMPRESS", sCompression.c_str() );
+	czOptions = CSLSetNameValue( czOptions, "BIGTIFF", "IF_SAFER" );
+
+	if ( sDriver == "GTiff" )
+	{
+		czOptions = CSLSetNameValue( czOptions, "TILED", "YES" );
+		czOptions = CSLSetNameValue( czOptions, "BLOCKXSIZE", "256" );
+		czOptions = CSLSetNameValue( czOptions, "BLOCKYSIZE", "256" );
+		if ( sCompression != "NONE" )
+			czOptions = CSLSetNameValue( czOptions, "PREDICTOR", ( gdType == GDT_Float32 || gdType == GDT_Float64 ) ? "3" : "2" );
+	} else {
+		czOptions = CSLSetNameValue( czOptions, "BLOCKSIZE", "256" );
+		if ( sCompression != "NONE" )
+			czOptions = CSLSetNameValue( czOptions, "PREDICTOR", "YES" );
+	}
+
+	return czOptions;
+}
+
+/*
+ *  Finish an output raster, copying it to its final format if it was built
+ *  in memory, and log how long it took and how large it is
+ */
+bool	CRasterDataset::closeOutput( GDALDataset* pDataset, GDALDriver* pDriver, bool bCreateCopy, std::string sFilename, char** czOptions, std::chrono::high_resolution_clock::time_point tStart )
+{
+	bool	bSuccess = true;
+
+	if ( bCreateCopy )
+	{
+		GDALDataset* pCopy = pDriver->CreateCopy( sFilename.c_str(), pDataset, FALSE, czOptions, NULL, NULL );
+		if ( pCopy == NULL )
+		{
+			model::doError(
+				"Could not create output raster file.",
+				model::errorCodes::kLevelWarning
+			);
+			bSuccess = false;
+		} else {
+			GDALClose( (GDALDatasetH)pCopy );
+		}
+	}
+
 	GDALClose( (GDALDatasetH)pDataset );
-	
-	return true;
+	CSLDestroy( czOptions );
+
+	VSIStatBufL	sStat;
+	if ( bSuccess && VSIStatL( sFilename.c_str(), &sStat ) == 0 )
+	{
+		double dSeconds = std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - tStart ).count();
+		pManager->log->writeLine( 
+			"Output raster written in " + toString( floor( dSeconds * 1000.0 ) / 1000.0 ) + "s, " + 
+			toString( floor( sStat.st_size / 1048576.0 * 100.0 ) / 100.0 ) + "MB." 
+		);
+	}
+
+	return bSuccess;
 }
 
 /*
@@ -352,32 +434,57 @@ void	CRasterDataset::logDetails()
  */
 bool	CRasterDataset::applyDimensionsToDomain( CDomainCartesian*	pDomain )
 {
+	unsigned long	ulWindowX		= 0,
+					ulWindowY		= 0,
+					ulWindowCols	= this->ulColumns,
+					ulWindowRows	= this->ulRows;
+
 	if ( !this->bAvailable ) return false;
 
 	pManager->log->writeLine( "Dimensioning domain from raster dataset." );
 
+	// The domain may only be part of the raster
+	if ( pDomain->getRasterWindow( &ulWindowX, &ulWindowY, &ulWindowCols, &ulWindowRows ) )
+	{
+		if ( ulWindowX + ulWindowCols > this->ulColumns ||
+			 ulWindowY + ulWindowRows > this->ulRows )
+		{
+			model::doError(
+				"The domain lies outside of the raster dataset.",
+				model::errorCodes::kLevelWarning
+			);
+			return false;
+		}
+
+		pManager->log->writeLine( "Using a window of " + toString( ulWindowCols ) + " x " + toString( ulWindowRows ) + 
+			" cells from [" + toString( ulWindowX ) + ", " + toString( ulWindowY ) + "]." );
+	}
+
+	double			dOffsetX		= this->dOffsetX + this->dResolutionX * ulWindowX;
+	double			dOffsetY		= this->dOffsetY + this->dResolutionY * ulWindowY;
+
 	pDomain->setProjectionCode( 0 );					// Unknown
 	pDomain->setUnits( "m" );							
 	pDomain->setCellResolution( this->dResolutionX );	
-	pDomain->setRealDimensions( this->dResolutionX * this->ulColumns, this->dResolutionY * this->ulRows );	
-	pDomain->setRealOffset( this->dOffsetX, this->dOffsetY );			
-	pDomain->setRealExtent( this->dOffsetY + this->dResolutionY * this->ulRows,
-						    this->dOffsetX + this->dResolutionX * this->ulColumns,
-							this->dOffsetY,
-							this->dOffsetX );
+	pDomain->setRealDimensions( this->dResolutionX * ulWindowCols, this->dResolutionY * ulWindowRows );	
+	pDomain->setRealOffset( dOffsetX, dOffsetY );			
+	pDomain->setRealExtent( dOffsetY + this->dResolutionY * ulWindowRows,
+						    dOffsetX + this->dResolutionX * ulWindowCols,
+							dOffsetY,
+							dOffsetX );
 
 	return true;
 }
 
 /*
- *  Apply some data to the domain from this raster's first band
+ *  Apply some data to the domain from this raster's first band, using values
+ *  already read for the domain if given
  */
-bool	CRasterDataset::applyDataToDomain( unsigned char ucValue, CDomainCartesian* pDomain )
+bool	CRasterDataset::applyDataToDomain( unsigned char ucValue, CDomainCartesian* pDomain, std::vector<double>* vValues )
 {
-	GDALRasterBand*	pBand;
 	std::string		sValueName	= "unknown";
-	unsigned char	ucDataIndex	= 0;
 	unsigned char	ucRounding	= 4;			// decimal places
+	std::vector<double>	vRead;
 
 	if ( !this->bAvailable ) return false;
 	if ( !this->isDomainCompatible( pDomain ) ) return false;
@@ -385,14 +492,115 @@ bool	CRasterDataset::applyDataToDomain( unsigned char ucValue, CDomainCartesian*
 	CRasterDataset::getValueDetails( ucValue, &sValueName );
 	pManager->log->writeLine( "Loading " + sValueName + " from raster dataset." );
 
+	std::chrono::high_resolution_clock::time_point tStart = std::chrono::high_resolution_clock::now();
+
+	if ( vValues == NULL || vValues->empty() )
+	{
+		vValues = &vRead;
+		if ( !this->readDataForDomain( pDomain, vValues ) )
+		{
+			model::doError(
+				"Could not read " + sValueName + " from raster dataset.",
+				model::errorCodes::kLevelWarning
+			);
+			return false;
+		}
+	}
+
+	pDomain->handleInputData( &( *vValues )[0], ucValue, ucRounding );
+
+	double dSeconds = std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - tStart ).count();
+	pManager->log->writeLine( "Applied " + sValueName + " to the domain in " + toString( floor( dSeconds * 1000.0 ) / 1000.0 ) + "s." );
+
+	return true;
+}
+
+/*
+ *  Read the first band over the domain's window into an array indexed by
+ *  cell ID. Whole strips of blocks are read at once, so each block is only
+ *  decoded once, rather than a scan line at a time. Nothing is logged, so
+ *  several rasters can be read on their own threads.
+ */
+bool	CRasterDataset::readDataForDomain( CDomainCartesian* pDomain, std::vector<double>* vValues )
+{
+	GDALRasterBand*	pBand;
+	int				iBlockX, iBlockY;
+	unsigned long	ulWindowX		= 0,
+					ulWindowY		= 0,
+					ulWindowCols	= this->ulColumns,
+					ulWindowRows	= this->ulRows;
+
+	if ( !this->bAvailable ) return false;
+	if ( !this->isDomainCompatible( pDomain ) ) return false;
+
+	pDomain->getRasterWindow( &ulWindowX, &ulWindowY, &ulWindowCols, &ulWindowRows );
+
 	pBand = this->gdDataset->GetRasterBand( 1 );
+	pBand->GetBlockSize( &iBlockX, &iBlockY );
 
-	double*			dScanLine;
-	double			dValue;
-	unsigned long	ulCellID;
+	unsigned long	ulStripRows	= static_cast<unsigned long>( iBlockY * std::max( 1, 64 / std::max( 1, iBlockY ) ) );
+	unsigned long	ulRowTop	= this->ulRows - ulWindowY - ulWindowRows;
+	unsigned long	ulRowEnd	= ulRowTop + ulWindowRows;
+	std::vector<double>	vStrip;
+
+	try {
+		vValues->resize( ulWindowCols * ulWindowRows );
+		vStrip.resize( ulWindowCols * std::min( ulStripRows, ulWindowRows ) );
+	}
+	catch( std::bad_alloc )
+	{
+		return false;
+	}
+
+	unsigned long	ulRow = ulRowTop;
+	while ( ulRow < ulRowEnd )
+	{
+		// Strips after the first start on a block boundary
+		unsigned long ulRows = std::min( ( ulRow / ulStripRows + 1 ) * ulStripRows, ulRowEnd ) - ulRow;
+
+		if ( pBand->RasterIO( GF_Read,				// Flag
+							  ulWindowX,			// X offset
+							  ulRow,				// Y offset
+							  ulWindowCols,			// X read size
+							  ulRows,				// Y read size
+							  &vStrip[0],			// Target heap
+							  ulWindowCols,			// X buffer size
+							  ulRows,				// Y buffer size
+							  GDT_Float64,			// Data type
+							  0,					// Pixel space
+							  0 ) != CE_None )		// Line space
+			return false;
+
+		// Scan lines start in the top left
+		for( unsigned long iRow = 0; iRow < ulRows; iRow++ )
+			memcpy(
+				&( *vValues )[ pDomain->getCellID( 0, ulRowEnd - ( ulRow + iRow ) - 1 ) ],
+				&vStrip[ iRow * ulWindowCols ],
+				sizeof( double ) * ulWindowCols
+			);
+
+		ulRow += ulRows;
+	}
+
+	return true;
+}
+
+/*
+ *  Count the enabled (i.e. not -9999) cells in each row and column of the
+ *  raster. Rows are counted from the bottom, to match a domain.
+ */
+bool	CRasterDataset::countEnabledCells( std::vector<unsigned long>* vRowCounts, std::vector<unsigned long>* vColCounts )
+{
+	if ( !this->bAvailable ) return false;
+
+	GDALRasterBand*	pBand = this->gdDataset->GetRasterBand( 1 );
+
+	vRowCounts->assign( this->ulRows, 0 );
+	vColCounts->assign( this->ulColumns, 0 );
+
+	double*			dScanLine = (double*) CPLMalloc( sizeof( double ) * this->ulColumns );
 	for( unsigned long iRow = 0; iRow < this->ulRows; iRow++ )
 	{
-		dScanLine = (double*) CPLMalloc(sizeof( double ) * this->ulColumns );
 		pBand->RasterIO( GF_Read,				// Flag
 						 0,						// X offset
 						 iRow,					// Y offset
@@ -407,19 +615,14 @@ bool	CRasterDataset::applyDataToDomain( unsigned char ucValue, CDomainCartesian*
 
 		for( unsigned long iCol = 0; iCol < this->ulColumns; iCol++ )
 		{
-			dValue		= dScanLine[ iCol ];
-			ulCellID	= pDomain->getCellID( iCol, this->ulRows - iRow - 1 );		// Scan lines start in the top left
-
-			pDomain->handleInputData(
-				ulCellID,
-				dValue,
-				ucValue,
-				ucRounding
-			);
-		}
+			if ( dScanLine[ iCol ] == -9999.0 )
+				continue;
 
-		CPLFree( dScanLine );
+			(*vRowCounts)[ this->ulRows - iRow - 1 ]++;
+			(*vColCounts)[ iCol ]++;
+		}
 	}
+	CPLFree( dScanLine );
 
 	return true;
 }
@@ -429,8 +632,17 @@ bool	CRasterDataset::applyDataToDomain( unsigned char ucValue, CDomainCartesian*
  */
 bool	CRasterDataset::isDomainCompatible( CDomainCartesian* pDomain )
 {
-	if ( pDomain->getCols() != this->ulColumns ) return false;
-	if ( pDomain->getRows() != this->ulRows) return false;
+	unsigned long	ulWindowX		= 0,
+					ulWindowY		= 0,
+					ulWindowCols	= this->ulColumns,
+					ulWindowRows	= this->ulRows;
+
+	pDomain->getRasterWindow( &ulWindowX, &ulWindowY, &ulWindowCols, &ulWindowRows );
+
+	if ( ulWindowX + ulWindowCols > this->ulColumns ) return false;
+	if ( ulWindowY + ulWindowRows > this->ulRows ) return false;
+	if ( pDomain->getCols() != ulWindowCols ) return false;
+	if ( pDomain->getRows() != ulWindowRows ) return false;
 	
 	// Assume yes for now
 	// TODO: Add extra checks
@@ -548,8 +760,57 @@ void	CRasterDataset::getValueDetails( unsigned char ucValue, std::string* sValue
 	case model::rasterDatasets::dataValues::kFroudeNumber:
 		*sValueName  = "froude number";
 		break;
+	case model::rasterDatasets::dataValues::kMaxVelocity:
+		*sValueName  = "maximum velocity";
+		break;
+	case model::rasterDatasets::dataValues::kMaxHazard:
+		*sValueName  = "maximum depth-velocity product";
+		break;
+	case model::rasterDatasets::dataValues::kArrivalTime:
+		*sValueName  = "inundation arrival time";
+		break;
+	case model::rasterDatasets::dataValues::kDuration:
+		*sValueName  = "inundation duration";
+		break;
+	case model::rasterDatasets::dataValues::kSpeed:
+		*sValueName  = "speed";
+		break;
+	case model::rasterDatasets::dataValues::kUnitDischarge:
+		*sValueName  = "unit discharge";
+		break;
 	default:
 		*sValueName  = "unknown value";
 		break;
 	}
+}
+
+/*
+ *  Is the value only available from the accumulators the scheme updates
+ *  on the device, rather than the cell states?
+ */
+bool	CRasterDataset::isAccumulatorValue( unsigned char ucValue )
+{
+	return ( ucValue == model::rasterDatasets::dataValues::kMaxVelocity ||
+			 ucValue == model::rasterDatasets::dataValues::kMaxHazard ||
+			 ucValue == model::rasterDatasets::dataValues::kArrivalTime ||
+			 ucValue == model::rasterDatasets::dataValues::kDuration );
+}
+
+/*
+ *  Is the value one the scheme can derive from the cell states on the
+ *  device, so only a single-precision plane needs to be read back?
+ */
+bool	CRasterDataset::isDeviceFieldValue( unsigned char ucValue )
+{
+	return ( ucValue == model::rasterDatasets::dataValues::kDepth ||
+			 ucValue == model::rasterDatasets::dataValues::kFreeSurfaceLevel ||
+			 ucValue == model::rasterDatasets::dataValues::kMaxDepth ||
+			 ucValue == model::rasterDatasets::dataValues::kMaxFSL ||
+			 ucValue == model::rasterDatasets::dataValues::kVelocityX ||
+			 ucValue == model::rasterDatasets::dataValues::kVelocityY ||
+			 ucValue == model::rasterDatasets::dataValues::kDischargeX ||
+			 ucValue == model::rasterDatasets::dataValues::kDischargeY ||
+			 ucValue == model::rasterDatasets::dataValues::kFroudeNumber ||
+			 ucValue == model::rasterDatasets::dataValues::kSpeed ||
+			 ucValue == model::rasterDatasets::dataValues::kUnitDischarge );
 }
\ No newline at end of file
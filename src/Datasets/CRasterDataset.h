@@ -22,6 +22,8 @@
 
 #include <gdal_priv.h>
 #include <cpl_conv.h>
+#include <chrono>
+#include <vector>
 #include "../Domain/CDomain.h"
 #include "../Domain/Cartesian/CDomainCartesian.h"
 #include "../Boundaries/CBoundaryGridded.h"
@@ -42,7 +44,13 @@ namespace dataValues { enum dataValues {
 	kDisabledCells		= 8,		// Disabled cells
 	kMaxDepth			= 9,		// Max depth
 	kMaxFSL				= 10,		// Max FSL
-	kFroudeNumber		= 11		// Froude number
+	kFroudeNumber		= 11,		// Froude number
+	kMaxVelocity		= 12,		// Max velocity (accumulator)
+	kMaxHazard			= 13,		// Max depth x velocity (accumulator)
+	kArrivalTime		= 14,		// Inundation arrival time (accumulator)
+	kDuration			= 15,		// Inundation duration (accumulator)
+	kSpeed				= 16,		// Velocity magnitude
+	kUnitDischarge		= 17		// Discharge per unit width magnitude
 }; };
 };
 };
@@ -68,12 +76,16 @@ class CRasterDataset
 		// Public functions
 		static void		registerAll();																		// Register types for use, must be called first
 		static void		cleanupAll();																		// Cleanup memory after use. Not perfect... 
-		static bool		domainToRaster( const char*, std::string, CDomainCartesian*, unsigned char );		// Open a file as the dataset for writing
+		static bool		domainToRaster( const char*, std::string, CDomainCartesian*, unsigned char, cl_float* = NULL, std::string = "" );	// Open a file as the dataset for writing
+		static bool		isAccumulatorValue( unsigned char );												// Is the value taken from the device-side accumulators?
+		static bool		isDeviceFieldValue( unsigned char );												// Can the value be derived from the cell states on the device?
 		bool			openFileRead( std::string );														// Open a file as the dataset for reading
 		void			readMetadata();																		// Read metadata for the dataset
 		void			logDetails();																		// Write details (mainly metdata) to the log
 		bool			applyDimensionsToDomain( CDomainCartesian* );										// Applies the dimensions, offset and scaling to a domain
-		bool			applyDataToDomain( unsigned char, CDomainCartesian* );								// Applies first band of data in the raster to a domain variable
+		bool			applyDataToDomain( unsigned char, CDomainCartesian*, std::vector<double>* = NULL );	// Applies first band of data in the raster to a domain variable
+		bool			readDataForDomain( CDomainCartesian*, std::vector<double>* );						// Read the first band over the domain, indexed by cell ID
+		bool			countEnabledCells( std::vector<unsigned long>*, std::vector<unsigned long>* );		// Count the enabled cells in each row and column
 		CBoundaryGridded::SBoundaryGridTransform* createTransformationForDomain(CDomainCartesian*);			// Create a transformation to match the domain
 		double*			createArrayForBoundary(CBoundaryGridded::SBoundaryGridTransform*);					// Create an array for a boundary condition
 
@@ -81,6 +93,8 @@ class CRasterDataset
 
 		// Private functions
 		static void		getValueDetails( unsigned char, std::string* );										// Fetch some data on a value, like its index in the CDomain array
+		static char**	getCreationOptions( GDALDriver*, std::string, GDALDataType );						// Tiling and compression options for an output driver
+		static bool		closeOutput( GDALDataset*, GDALDriver*, bool, std::string, char**, std::chrono::high_resolution_clock::time_point );	// Finish writing an output raster
 		bool			isDomainCompatible( CDomainCartesian* );											// Is the domain compatible (i.e. row/column count, etc.) with this raster?
 
 		// Private variables
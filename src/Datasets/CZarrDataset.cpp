@@ -0,0 +1,678 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ *
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Zarr output store handling class
+ * ------------------------------------------
+ *
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <cpl_conv.h>
+
+#include "../common.h"
+#include "CZarrDataset.h"
+#include "CRasterDataset.h"
+#include "../Domain/Cartesian/CDomainCartesian.h"
+
+std::map<std::string, CZarrDataset::sStoreInfo>	CZarrDataset::mapStores;
+std::mutex										CZarrDataset::mtxStores;
+double											CZarrDataset::dResumeTime = -1.0;
+
+/*
+ *  Add the values for one output time to an array in the store, creating
+ *  the store the first time it is written by this process and the array
+ *  the first time the value is written. Each chunk spans several output
+ *  times, so the values are held until the chunk is complete. Time slices
+ *  not yet written for an array read as the fill value.
+ */
+bool	CZarrDataset::appendSlice(
+			std::string			sStore,
+			CDomainCartesian*	pDomain,
+			unsigned char		ucValue,
+			double				dTime,
+			cl_float*			fField,
+			std::string			sCompression
+		)
+{
+	std::lock_guard<std::mutex>	lockStores( mtxStores );
+
+	std::string	sArray	= CZarrDataset::getArrayName( ucValue );
+	if ( sArray.empty() || fField == NULL )
+	{
+		model::doError(
+			"Zarr outputs can only hold values derived on the device.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	// The first write this run starts the store afresh, unless the run has
+	// resumed and can carry on from an existing store
+	if ( mapStores.find( sStore ) == mapStores.end() )
+	{
+		sStoreInfo pInfo;
+		if ( dResumeTime >= 0.0 && boost::filesystem::exists( sStore + "/.zgroup" ) )
+		{
+			if ( !CZarrDataset::reopenStore( sStore, pDomain, &pInfo ) )
+				return false;
+		}
+		else if ( !CZarrDataset::createStore( sStore, pDomain, &pInfo ) )
+		{
+			return false;
+		}
+		mapStores[ sStore ] = pInfo;
+	}
+	sStoreInfo* pInfo = &mapStores[ sStore ];
+	pInfo->pDomain = pDomain;
+
+	if ( pInfo->ulCols != pDomain->getCols() || pInfo->ulRows != pDomain->getRows() )
+	{
+		model::doError(
+			"Domain extent has changed, so the output cannot be added to " + sStore + ".",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	// Find or add the time slice, growing every array to match
+	unsigned long ulSlice = 0;
+	while ( ulSlice < pInfo->vTimes.size() && fabs( pInfo->vTimes[ ulSlice ] - dTime ) > 1E-6 )
+		ulSlice++;
+
+	std::vector<unsigned long>	vShape, vChunks;
+	vShape.push_back( pInfo->vTimes.size() + ( ulSlice == pInfo->vTimes.size() ? 1 : 0 ) );
+	vShape.push_back( pInfo->ulRows );
+	vShape.push_back( pInfo->ulCols );
+	vChunks.push_back( 1 );
+	vChunks.push_back( uiChunkSize );
+	vChunks.push_back( uiChunkSize );
+
+	if ( ulSlice == pInfo->vTimes.size() )
+	{
+		pInfo->vTimes.push_back( dTime );
+		if ( !CZarrDataset::writeTimes( sStore, pInfo ) )
+			return false;
+
+		for ( std::map<std::string, sArrayInfo>::iterator itArray = pInfo->mapArrays.begin(); itArray != pInfo->mapArrays.end(); itArray++ )
+		{
+			vChunks[0] = itArray->second.ulTimeChunk;
+			CZarrDataset::writeArrayMetadata( sStore, itArray->first, vShape, vChunks, "<f4", "", itArray->second.iLevel );
+		}
+	}
+
+	if ( pInfo->mapArrays.find( sArray ) == pInfo->mapArrays.end() )
+	{
+		sArrayInfo	pArray;
+		std::string	sMethod = boost::algorithm::to_lower_copy( sCompression );
+
+		pArray.iLevel = 6;
+		if ( sMethod == "none" )
+		{
+			pArray.iLevel = -1;
+		}
+		else if ( !sMethod.empty() && sMethod != "deflate" && sMethod != "zlib" )
+		{
+			model::doError(
+				"Zarr outputs only support zlib compression, using it for " + sArray + ".",
+				model::errorCodes::kLevelWarning
+			);
+		}
+
+		// As many output times per chunk as can be held back for a domain this size
+		pArray.ulTimeChunk	= static_cast<unsigned long>( std::max( 1ULL, std::min( static_cast<unsigned long long>( uiMaxTimeChunk ),
+								ulPendingSize / ( static_cast<unsigned long long>( pInfo->ulRows ) * pInfo->ulCols * sizeof( cl_float ) ) ) ) );
+		pArray.ulFirstSlice	= 0;
+
+		pInfo->mapArrays[ sArray ] = pArray;
+		vChunks[0] = pArray.ulTimeChunk;
+		if ( !CZarrDataset::writeArrayMetadata( sStore, sArray, vShape, vChunks, "<f4", "", pArray.iLevel ) )
+			return false;
+	}
+
+	// Output times are held back until every one in their chunk is here
+	sArrayInfo*		pArray		= &pInfo->mapArrays[ sArray ];
+	unsigned long	ulCells		= pInfo->ulRows * pInfo->ulCols;
+
+	if ( !pArray->vPending.empty() && ulSlice / pArray->ulTimeChunk != pArray->ulFirstSlice / pArray->ulTimeChunk )
+	{
+		if ( !CZarrDataset::flushArray( sStore, pInfo, sArray, true ) )
+			return false;
+	}
+
+	if ( pArray->vPending.empty() )
+	{
+		pArray->ulFirstSlice = ( ulSlice / pArray->ulTimeChunk ) * pArray->ulTimeChunk;
+		pArray->vPending.assign( pArray->ulTimeChunk * ulCells, -9999.0f );
+		pArray->vHeld.assign( pArray->ulTimeChunk, false );
+	}
+
+	// Rows run from the top, unlike the cells
+	unsigned long ulHeld = ulSlice - pArray->ulFirstSlice;
+	for ( unsigned long iRow = 0; iRow < pInfo->ulRows; iRow++ )
+		memcpy(
+			&pArray->vPending[ ulHeld * ulCells + iRow * pInfo->ulCols ],
+			fField + pDomain->getCellID( 0, pInfo->ulRows - iRow - 1 ),
+			sizeof( cl_float ) * pInfo->ulCols
+		);
+	pArray->vHeld[ ulHeld ] = true;
+
+	if ( std::find( pArray->vHeld.begin(), pArray->vHeld.end(), false ) == pArray->vHeld.end() )
+		return CZarrDataset::flushArray( sStore, pInfo, sArray, true );
+
+	return true;
+}
+
+/*
+ *  Write the output times held back for each store a domain writes to,
+ *  such as before a checkpoint, so the stores match it. Memory is only
+ *  released if no more output times will follow.
+ */
+bool	CZarrDataset::flushStores( CDomainCartesian* pDomain, bool bRelease )
+{
+	std::lock_guard<std::mutex>	lockStores( mtxStores );
+	bool						bSuccess = true;
+
+	for ( std::map<std::string, sStoreInfo>::iterator itStore = mapStores.begin(); itStore != mapStores.end(); itStore++ )
+	{
+		if ( itStore->second.pDomain != pDomain )
+			continue;
+
+		for ( std::map<std::string, sArrayInfo>::iterator itArray = itStore->second.mapArrays.begin(); itArray != itStore->second.mapArrays.end(); itArray++ )
+			bSuccess = CZarrDataset::flushArray( itStore->first, &itStore->second, itArray->first, bRelease ) && bSuccess;
+	}
+
+	return bSuccess;
+}
+
+/*
+ *  Write every chunk for the output times held back for an array. Chunks
+ *  are full-sized even at the edges, padded with the fill value. Output
+ *  times in the chunk which aren't held are taken from the chunk already
+ *  on disk, if there is one, as after a resume.
+ */
+bool	CZarrDataset::flushArray( std::string sStore, sStoreInfo* pInfo, std::string sArray, bool bRelease )
+{
+	sArrayInfo*		pArray		= &pInfo->mapArrays[ sArray ];
+	unsigned long	ulCells		= pInfo->ulRows * pInfo->ulCols;
+	unsigned long	ulChunkT	= pArray->ulFirstSlice / pArray->ulTimeChunk;
+	bool			bComplete	= std::find( pArray->vHeld.begin(), pArray->vHeld.end(), false ) == pArray->vHeld.end();
+
+	if ( pArray->vPending.empty() )
+		return true;
+
+	std::vector<cl_float>	vChunk( pArray->ulTimeChunk * uiChunkSize * uiChunkSize );
+	for ( unsigned long ulChunkY = 0; ulChunkY * uiChunkSize < pInfo->ulRows; ulChunkY++ )
+	{
+		for ( unsigned long ulChunkX = 0; ulChunkX * uiChunkSize < pInfo->ulCols; ulChunkX++ )
+		{
+			std::string sChunk = sStore + "/" + sArray + "/" + toString( ulChunkT ) + "." + toString( ulChunkY ) + "." + toString( ulChunkX );
+
+			if ( bComplete || !CZarrDataset::readChunk( sChunk, &vChunk[0], sizeof( cl_float ) * vChunk.size(), pArray->iLevel ) )
+				std::fill( vChunk.begin(), vChunk.end(), -9999.0f );
+
+			unsigned long ulRows = std::min( static_cast<unsigned long>( uiChunkSize ), pInfo->ulRows - ulChunkY * uiChunkSize );
+			unsigned long ulCols = std::min( static_cast<unsigned long>( uiChunkSize ), pInfo->ulCols - ulChunkX * uiChunkSize );
+
+			for ( unsigned long ulHeld = 0; ulHeld < pArray->ulTimeChunk; ulHeld++ )
+			{
+				if ( !pArray->vHeld[ ulHeld ] )
+					continue;
+
+				for ( unsigned long iRow = 0; iRow < ulRows; iRow++ )
+					memcpy(
+						&vChunk[ ( ulHeld * uiChunkSize + iRow ) * uiChunkSize ],
+						&pArray->vPending[ ulHeld * ulCells + ( ulChunkY * uiChunkSize + iRow ) * pInfo->ulCols + ulChunkX * uiChunkSize ],
+						sizeof( cl_float ) * ulCols
+					);
+			}
+
+			if ( !CZarrDataset::writeChunk( sChunk, &vChunk[0], sizeof( cl_float ) * vChunk.size(), pArray->iLevel ) )
+				return false;
+		}
+	}
+
+	if ( bRelease )
+	{
+		std::vector<cl_float>().swap( pArray->vPending );
+		pArray->vHeld.clear();
+	}
+
+	return true;
+}
+
+/*
+ *  Set the time a run resumed from, so stores it finds are carried on
+ *  rather than replaced
+ */
+void	CZarrDataset::setResumeTime( double dTime )
+{
+	std::lock_guard<std::mutex>	lockStores( mtxStores );
+
+	dResumeTime = dTime;
+}
+
+/*
+ *  Name of the array in the store holding a value, matching the value
+ *  given in the configuration
+ */
+std::string	CZarrDataset::getArrayName( unsigned char ucValue )
+{
+	switch( ucValue )
+	{
+	case model::rasterDatasets::dataValues::kDepth:				return "depth";
+	case model::rasterDatasets::dataValues::kFreeSurfaceLevel:	return "fsl";
+	case model::rasterDatasets::dataValues::kMaxDepth:			return "maxdepth";
+	case model::rasterDatasets::dataValues::kMaxFSL:			return "maxfsl";
+	case model::rasterDatasets::dataValues::kVelocityX:			return "velocityx";
+	case model::rasterDatasets::dataValues::kVelocityY:			return "velocityy";
+	case model::rasterDatasets::dataValues::kDischargeX:		return "dischargex";
+	case model::rasterDatasets::dataValues::kDischargeY:		return "dischargey";
+	case model::rasterDatasets::dataValues::kFroudeNumber:		return "froude";
+	case model::rasterDatasets::dataValues::kSpeed:				return "speed";
+	case model::rasterDatasets::dataValues::kUnitDischarge:		return "unitdischarge";
+	}
+
+	return "";
+}
+
+/*
+ *  Replace any existing store with an empty group holding the cell centre
+ *  coordinates, so it can be opened as a dataset by xarray or GDAL. Only a
+ *  Zarr group or an empty directory is replaced, never anything else.
+ */
+bool	CZarrDataset::createStore( std::string sStore, CDomainCartesian* pDomain, sStoreInfo* pInfo )
+{
+	boost::system::error_code ecStore;
+	if ( boost::filesystem::exists( sStore + "/.zgroup", ecStore ) )
+	{
+		boost::filesystem::remove_all( sStore, ecStore );
+	}
+	else if ( boost::filesystem::exists( sStore, ecStore ) &&
+			  ( !boost::filesystem::is_directory( sStore, ecStore ) || !boost::filesystem::is_empty( sStore, ecStore ) ) )
+	{
+		model::doError(
+			"Zarr output target " + sStore + " already exists and is not a Zarr store, so it won't be replaced.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+	boost::filesystem::create_directories( sStore, ecStore );
+	if ( ecStore )
+	{
+		model::doError(
+			"Could not create Zarr output store " + sStore + ".",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	pInfo->ulCols					= pDomain->getCols();
+	pInfo->ulRows					= pDomain->getRows();
+	pInfo->ulTimeCoordinateChunk	= uiTimeCoordinateChunk;
+
+	double	dResolution, dOffsetX, dOffsetY;
+	pDomain->getCellResolution( &dResolution );
+	pDomain->getRealOffset( &dOffsetX, &dOffsetY );
+
+	std::vector<double>	vX( pInfo->ulCols ), vY( pInfo->ulRows );
+	for ( unsigned long i = 0; i < pInfo->ulCols; i++ )
+		vX[ i ] = dOffsetX + ( i + 0.5 ) * dResolution;
+	for ( unsigned long i = 0; i < pInfo->ulRows; i++ )
+		vY[ i ] = dOffsetY + ( pInfo->ulRows - i - 0.5 ) * dResolution;
+
+	std::vector<unsigned long> vXShape( 1, pInfo->ulCols ), vYShape( 1, pInfo->ulRows ), vTimeShape( 1, 0 ), vTimeChunks( 1, uiTimeCoordinateChunk );
+
+	return CZarrDataset::writeText( sStore + "/.zgroup", "{\n    \"zarr_format\": 2\n}\n" ) &&
+		   CZarrDataset::writeArrayMetadata( sStore, "x", vXShape, vXShape, "<f8", "x", -1 ) &&
+		   CZarrDataset::writeArrayMetadata( sStore, "y", vYShape, vYShape, "<f8", "y", -1 ) &&
+		   CZarrDataset::writeArrayMetadata( sStore, "time", vTimeShape, vTimeChunks, "<f8", "time", -1 ) &&
+		   CZarrDataset::writeChunk( sStore + "/x/0", &vX[0], sizeof( double ) * vX.size(), -1 ) &&
+		   CZarrDataset::writeChunk( sStore + "/y/0", &vY[0], sizeof( double ) * vY.size(), -1 );
+}
+
+/*
+ *  Open a store written by an earlier run, keeping the slices up to the
+ *  time this run resumed from. Later slices are dropped from the shape of
+ *  each array and their chunks removed, so they're written again.
+ */
+bool	CZarrDataset::reopenStore( std::string sStore, CDomainCartesian* pDomain, sStoreInfo* pInfo )
+{
+	std::vector<unsigned long>	vXShape, vYShape, vTimeShape, vTimeChunks, vChunks;
+	int							iLevel;
+
+	if ( !CZarrDataset::readArrayMetadata( sStore, "x", &vXShape, &vChunks, &iLevel ) ||
+		 !CZarrDataset::readArrayMetadata( sStore, "y", &vYShape, &vChunks, &iLevel ) ||
+		 !CZarrDataset::readArrayMetadata( sStore, "time", &vTimeShape, &vTimeChunks, &iLevel ) ||
+		 vXShape.size() != 1 || vYShape.size() != 1 || vTimeShape.size() != 1 ||
+		 vTimeChunks.size() != 1 || vTimeChunks[0] == 0 )
+	{
+		model::doError(
+			"Could not read the existing Zarr output store " + sStore + ".",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	if ( vXShape[0] != pDomain->getCols() || vYShape[0] != pDomain->getRows() )
+	{
+		model::doError(
+			"Existing Zarr output store " + sStore + " doesn't match the domain extent.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	pInfo->ulCols					= pDomain->getCols();
+	pInfo->ulRows					= pDomain->getRows();
+	pInfo->ulTimeCoordinateChunk	= vTimeChunks[0];
+
+	// Keep the times up to the resume time
+	for ( unsigned long i = 0; i < vTimeShape[0]; i++ )
+	{
+		double			dTime;
+		std::ifstream	ifsTime( ( sStore + "/time/" + toString( i / vTimeChunks[0] ) ).c_str(), std::ios::in | std::ios::binary );
+		ifsTime.seekg( ( i % vTimeChunks[0] ) * sizeof( double ) );
+		ifsTime.read( reinterpret_cast<char*>( &dTime ), sizeof( double ) );
+		if ( ifsTime.fail() || dTime > dResumeTime + 1E-6 )
+			break;
+		pInfo->vTimes.push_back( dTime );
+	}
+
+	unsigned long				ulSlices = pInfo->vTimes.size();
+	boost::system::error_code	ecRemove;
+
+	for ( unsigned long i = ( ulSlices + vTimeChunks[0] - 1 ) / vTimeChunks[0]; i * vTimeChunks[0] < vTimeShape[0]; i++ )
+		boost::filesystem::remove( sStore + "/time/" + toString( i ), ecRemove );
+	vTimeShape[0] = ulSlices;
+	if ( !CZarrDataset::writeArrayMetadata( sStore, "time", vTimeShape, vTimeChunks, "<f8", "time", -1 ) )
+		return false;
+
+	// Cut each value array back to match
+	for ( unsigned char ucValue = 0; ucValue < 255; ucValue++ )
+	{
+		std::string					sArray = CZarrDataset::getArrayName( ucValue );
+		std::vector<unsigned long>	vShape;
+
+		if ( sArray.empty() ||
+			 pInfo->mapArrays.find( sArray ) != pInfo->mapArrays.end() ||
+			 !boost::filesystem::exists( sStore + "/" + sArray + "/.zarray" ) )
+			continue;
+
+		if ( !CZarrDataset::readArrayMetadata( sStore, sArray, &vShape, &vChunks, &iLevel ) ||
+			 vShape.size() != 3 || vChunks.size() != 3 )
+		{
+			model::doError(
+				"Could not read the " + sArray + " array in Zarr output store " + sStore + ".",
+				model::errorCodes::kLevelWarning
+			);
+			return false;
+		}
+
+		// Chunk names start with the index of the chunk along the time axis
+		std::vector<boost::filesystem::path> vRemove;
+		for ( boost::filesystem::directory_iterator itChunk( sStore + "/" + sArray ); itChunk != boost::filesystem::directory_iterator(); itChunk++ )
+		{
+			std::string sChunk = itChunk->path().filename().string();
+			if ( !sChunk.empty() &&
+				 std::isdigit( static_cast<unsigned char>( sChunk[0] ) ) &&
+				 std::strtoul( sChunk.c_str(), NULL, 10 ) * vChunks[0] >= ulSlices )
+				vRemove.push_back( itChunk->path() );
+		}
+		for ( unsigned int i = 0; i < vRemove.size(); i++ )
+			boost::filesystem::remove( vRemove[ i ], ecRemove );
+
+		sArrayInfo pArray;
+		pArray.iLevel		= iLevel;
+		pArray.ulTimeChunk	= std::max( vChunks[0], 1UL );
+		pArray.ulFirstSlice	= 0;
+
+		vShape[0] = ulSlices;
+		pInfo->mapArrays[ sArray ] = pArray;
+		if ( !CZarrDataset::writeArrayMetadata( sStore, sArray, vShape, vChunks, "<f4", "", iLevel ) )
+			return false;
+	}
+
+	pManager->log->writeLine( "Resuming Zarr output store " + sStore + " with " + toString( ulSlices ) + " earlier output times." );
+
+	return true;
+}
+
+/*
+ *  Read back the shape, chunks and compression level (-1 for none) from
+ *  the metadata of an array written by this class
+ */
+bool	CZarrDataset::readArrayMetadata(
+			std::string					sStore,
+			std::string					sArray,
+			std::vector<unsigned long>*	vShape,
+			std::vector<unsigned long>*	vChunks,
+			int*						iLevel
+		)
+{
+	std::ifstream		ifsArray( ( sStore + "/" + sArray + "/.zarray" ).c_str(), std::ios::in );
+	std::ostringstream	ossArray;
+
+	if ( !ifsArray.is_open() )
+		return false;
+	ossArray << ifsArray.rdbuf();
+
+	std::string		sArrayText	= ossArray.str();
+	const char*		cKeys[]		= { "\"shape\": [", "\"chunks\": [" };
+	std::vector<unsigned long>*	vLists[]	= { vShape, vChunks };
+
+	for ( unsigned int i = 0; i < 2; i++ )
+	{
+		size_t szStart = sArrayText.find( cKeys[i] );
+		if ( szStart == std::string::npos )
+			return false;
+
+		const char*	cValue	= sArrayText.c_str() + szStart + std::strlen( cKeys[i] );
+		char*		cEnd	= NULL;
+		vLists[i]->clear();
+		while ( *cValue != ']' && *cValue != '\0' )
+		{
+			vLists[i]->push_back( std::strtoul( cValue, &cEnd, 10 ) );
+			if ( cEnd == cValue )
+				return false;
+			cValue = cEnd;
+			while ( *cValue == ',' || *cValue == ' ' )
+				cValue++;
+		}
+	}
+
+	size_t szLevel = sArrayText.find( "\"level\": " );
+	*iLevel = ( sArrayText.find( "\"compressor\": null" ) != std::string::npos || szLevel == std::string::npos ) ?
+			  -1 : std::atoi( sArrayText.c_str() + szLevel + 9 );
+
+	return true;
+}
+
+/*
+ *  Write the metadata for an array. Coordinate arrays are named by their
+ *  own dimension, while values use (time, y, x).
+ */
+bool	CZarrDataset::writeArrayMetadata(
+			std::string					sStore,
+			std::string					sArray,
+			std::vector<unsigned long>	vShape,
+			std::vector<unsigned long>	vChunks,
+			std::string					sType,
+			std::string					sDimension,
+			int							iLevel
+		)
+{
+	std::ostringstream	ossArray, ossAttributes;
+
+	boost::system::error_code ecArray;
+	boost::filesystem::create_directories( sStore + "/" + sArray, ecArray );
+
+	ossArray << "{\n    \"zarr_format\": 2,\n    \"shape\": [";
+	for ( unsigned int i = 0; i < vShape.size(); i++ )
+		ossArray << ( i > 0 ? ", " : "" ) << vShape[ i ];
+	ossArray << "],\n    \"chunks\": [";
+	for ( unsigned int i = 0; i < vChunks.size(); i++ )
+		ossArray << ( i > 0 ? ", " : "" ) << std::max( vChunks[ i ], 1UL );
+	ossArray << "],\n    \"dtype\": \"" << sType << "\",\n";
+	if ( iLevel < 0 )
+	{
+		ossArray << "    \"compressor\": null,\n";
+	} else {
+		ossArray << "    \"compressor\": { \"id\": \"zlib\", \"level\": " << iLevel << " },\n";
+	}
+	ossArray << "    \"fill_value\": " << ( sDimension.empty() ? "-9999.0" : "\"NaN\"" ) << ",\n";
+	ossArray << "    \"order\": \"C\",\n    \"filters\": null\n}\n";
+
+	ossAttributes << "{\n    \"_ARRAY_DIMENSIONS\": [";
+	if ( sDimension.empty() )
+	{
+		ossAttributes << "\"time\", \"y\", \"x\"";
+	} else {
+		ossAttributes << "\"" << sDimension << "\"";
+	}
+	ossAttributes << "]";
+	if ( sDimension == "time" )
+		ossAttributes << ",\n    \"units\": \"seconds\"";
+	ossAttributes << "\n}\n";
+
+	return CZarrDataset::writeText( sStore + "/" + sArray + "/.zarray", ossArray.str() ) &&
+		   CZarrDataset::writeText( sStore + "/" + sArray + "/.zattrs", ossAttributes.str() );
+}
+
+/*
+ *  Write the time coordinate chunk holding the latest output time, with
+ *  the rest of the chunk left as NaN, and the shape to match
+ */
+bool	CZarrDataset::writeTimes( std::string sStore, sStoreInfo* pInfo )
+{
+	unsigned long		ulChunk = ( pInfo->vTimes.size() - 1 ) / pInfo->ulTimeCoordinateChunk;
+	std::vector<double>	vChunk( pInfo->ulTimeCoordinateChunk, std::numeric_limits<double>::quiet_NaN() );
+
+	for ( unsigned long i = ulChunk * pInfo->ulTimeCoordinateChunk; i < pInfo->vTimes.size(); i++ )
+		vChunk[ i - ulChunk * pInfo->ulTimeCoordinateChunk ] = pInfo->vTimes[ i ];
+
+	std::vector<unsigned long> vTimeShape( 1, pInfo->vTimes.size() ), vTimeChunks( 1, pInfo->ulTimeCoordinateChunk );
+
+	return CZarrDataset::writeChunk( sStore + "/time/" + toString( ulChunk ), &vChunk[0], sizeof( double ) * vChunk.size(), -1 ) &&
+		   CZarrDataset::writeArrayMetadata( sStore, "time", vTimeShape, vTimeChunks, "<f8", "time", -1 );
+}
+
+/*
+ *  Read a chunk back from its file, which must hold exactly the size
+ *  given once decompressed
+ */
+bool	CZarrDataset::readChunk( std::string sFilename, void* pData, size_t szData, int iLevel )
+{
+	std::ifstream		ifsChunk( sFilename.c_str(), std::ios::in | std::ios::binary );
+	std::ostringstream	ossChunk;
+
+	if ( !ifsChunk.is_open() )
+		return false;
+	ossChunk << ifsChunk.rdbuf();
+
+	std::string sChunk = ossChunk.str();
+	if ( iLevel < 0 )
+	{
+		if ( sChunk.size() != szData )
+			return false;
+		memcpy( pData, sChunk.data(), szData );
+		return true;
+	}
+
+	size_t szInflated = 0;
+	return !sChunk.empty() &&
+		   CPLZLibInflate( &sChunk[0], sChunk.size(), pData, szData, &szInflated ) != NULL &&
+		   szInflated == szData;
+}
+
+/*
+ *  Write a chunk to its own file, compressed as a zlib stream unless the
+ *  level is negative
+ */
+bool	CZarrDataset::writeChunk( std::string sFilename, void* pData, size_t szData, int iLevel )
+{
+	void*	pCompressed		= NULL;
+	size_t	szCompressed	= 0;
+
+	if ( iLevel >= 0 )
+	{
+		pCompressed = CPLZLibDeflate( pData, szData, iLevel, NULL, 0, &szCompressed );
+		if ( pCompressed == NULL )
+		{
+			model::doError(
+				"Could not compress Zarr chunk " + sFilename + ".",
+				model::errorCodes::kLevelWarning
+			);
+			return false;
+		}
+	}
+
+	std::ofstream	ofsChunk( sFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+	if ( pCompressed != NULL )
+	{
+		ofsChunk.write( static_cast<char*>( pCompressed ), szCompressed );
+		VSIFree( pCompressed );
+	} else {
+		ofsChunk.write( static_cast<char*>( pData ), szData );
+	}
+	ofsChunk.close();
+
+	if ( ofsChunk.fail() )
+	{
+		model::doError(
+			"Failed to write Zarr chunk " + sFilename + ".",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ *  Replace a metadata file, via a temporary file so readers never see it
+ *  half-written
+ */
+bool	CZarrDataset::writeText( std::string sFilename, std::string sText )
+{
+	std::string		sTemporary = sFilename + ".tmp";
+	std::ofstream	ofsFile( sTemporary.c_str(), std::ios::out | std::ios::trunc );
+
+	ofsFile << sText;
+	ofsFile.close();
+
+	boost::system::error_code ecRename;
+	if ( !ofsFile.fail() )
+		boost::filesystem::rename( sTemporary, sFilename, ecRename );
+
+	if ( ofsFile.fail() || ecRename )
+	{
+		model::doError(
+			"Failed to write Zarr metadata " + sFilename + ".",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	return true;
+}
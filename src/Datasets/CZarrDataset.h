@@ -0,0 +1,91 @@
+/*
+ * ------------------------------------------
+ *
+ *  HIGH-PERFORMANCE INTEGRATED MODELLING SYSTEM (HiPIMS)
+ *  Luke S. Smith and Qiuhua Liang
+ *  luke@smith.ac
+ *
+ *  School of Civil Engineering & Geosciences
+ *  Newcastle University
+ *
+ * ------------------------------------------
+ *  This code is licensed under GPLv3. See LICENCE
+ *  for more information.
+ * ------------------------------------------
+ *  Zarr output store handling class
+ * ------------------------------------------
+ *
+ */
+
+#ifndef HIPIMS_DATASETS_CZARRDATASET_H_
+#define HIPIMS_DATASETS_CZARRDATASET_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../OpenCL/opencl.h"
+
+class CDomainCartesian;
+
+/*
+ *  ZARR DATASET CLASS
+ *  CZarrDataset
+ *
+ *  Appends each output time to a single Zarr (v2) store,
+ *  holding one (time, y, x) array per value in compressed
+ *  chunks, rather than writing a raster per output time.
+ *  Each chunk spans several output times, which are held
+ *  in memory until the chunk is complete. A resumed run
+ *  carries on from the checkpoint's slice.
+ */
+class CZarrDataset
+{
+public:
+	static bool				appendSlice( std::string, CDomainCartesian*, unsigned char, double, cl_float*, std::string );	// Add an output time for a value to a store
+	static bool				flushStores( CDomainCartesian*, bool );							// Write the output times held back for a domain's stores
+	static void				setResumeTime( double );											// Keep the slices up to this time in existing stores
+
+private:
+	static const unsigned int		uiChunkSize = 256;											// Chunk rows and columns
+	static const unsigned int		uiMaxTimeChunk = 32;										// Most output times in a chunk
+	static const unsigned long long	ulPendingSize = 256 * 1024 * 1024;							// Bytes of output times held back for an array
+	static const unsigned int		uiTimeCoordinateChunk = 1024;								// Output times in each chunk of the time coordinate
+
+	struct sArrayInfo
+	{
+		int							iLevel;														// Compression level (-1 for none)
+		unsigned long				ulTimeChunk;												// Output times in each chunk
+		unsigned long				ulFirstSlice;												// First output time held back
+		std::vector<cl_float>		vPending;													// Output times held back, each with rows from the top
+		std::vector<bool>			vHeld;														// Which output times have been given
+	};
+
+	struct sStoreInfo
+	{
+		CDomainCartesian*					pDomain;											// Domain writing to the store
+		unsigned long						ulCols;
+		unsigned long						ulRows;
+		unsigned long						ulTimeCoordinateChunk;
+		std::vector<double>					vTimes;
+		std::map<std::string, sArrayInfo>	mapArrays;
+	};
+
+	static std::string		getArrayName( unsigned char );										// Name of the array holding a value
+	static bool				createStore( std::string, CDomainCartesian*, sStoreInfo* );			// Write the group and coordinate arrays
+	static bool				reopenStore( std::string, CDomainCartesian*, sStoreInfo* );			// Open an existing store, dropping slices after the resume time
+	static bool				readArrayMetadata( std::string, std::string, std::vector<unsigned long>*, std::vector<unsigned long>*, int* );	// Read the shape, chunks and compression of an array
+	static bool				writeArrayMetadata( std::string, std::string, std::vector<unsigned long>, std::vector<unsigned long>, std::string, std::string, int );	// Write the .zarray and .zattrs for an array
+	static bool				writeTimes( std::string, sStoreInfo* );							// Write the chunk of the time coordinate holding the latest time
+	static bool				flushArray( std::string, sStoreInfo*, std::string, bool );			// Write the chunks for the output times held back for an array
+	static bool				readChunk( std::string, void*, size_t, int );						// Read a chunk back, decompressing it if required
+	static bool				writeChunk( std::string, void*, size_t, int );						// Write a chunk, compressing it if required
+	static bool				writeText( std::string, std::string );								// Replace a small text file
+
+	static std::map<std::string, sStoreInfo>	mapStores;										// Stores started by this process
+	static std::mutex							mtxStores;										// Guards the stores between writer threads
+	static double								dResumeTime;									// Time the run resumed from, or negative
+};
+
+#endif
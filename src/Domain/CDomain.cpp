@@ -16,6 +16,9 @@
  * ------------------------------------------
  *
  */
+#include <algorithm>
+#include <thread>
+#include <vector>
 #include <boost/lexical_cast.hpp>
 
 #include "../common.h"
@@ -23,6 +26,8 @@
 #include "Cartesian/CDomainCartesian.h"
 #include "../Datasets/CXMLDataset.h"
 #include "../Datasets/CRasterDataset.h"
+#include "../Datasets/CCheckpointDataset.h"
+#include "../Datasets/CDomainCacheDataset.h"
 #include "../Boundaries/CBoundaryMap.h"
 #include "../Schemes/CScheme.h"
 #include "../OpenCL/Executors/COCLDevice.h"
@@ -36,6 +41,7 @@ CDomain::CDomain(void)
 	this->pDevice			= NULL;
 	this->bPrepared			= false;
 	this->ucFloatSize		= 0;
+	this->bStructureOfArrays = false;
 	this->dMinFSL			= 9999.0;
 	this->dMaxFSL			= -9999.0;
 	this->dMinTopo			= 9999.0;
@@ -46,6 +52,7 @@ CDomain::CDomain(void)
 
 	this->cTargetDir				= NULL;
 	this->cSourceDir				= NULL;
+	this->cCacheDir					= NULL;
 
 	this->pBoundaries = new CBoundaryMap( this );
 }
@@ -71,6 +78,7 @@ CDomain::~CDomain(void)
 
 	delete [] this->cSourceDir;
 	delete [] this->cTargetDir;
+	delete [] this->cCacheDir;
 
 	pManager->log->writeLine("All domain memory has been released.");
 }
@@ -122,6 +130,7 @@ bool CDomain::configureDomain( XMLElement* pXDomain )
 	pXData = pXDomain->FirstChildElement( "data" );
 	const char*	cDataSourceDir = pXData->Attribute( "sourceDir" );
 	const char*	cDataTargetDir = pXData->Attribute( "targetDir" );
+	const char*	cDataCacheDir = pXData->Attribute( "cacheDir" );
 
 	if ( cDataSourceDir != NULL )
 	{
@@ -133,6 +142,11 @@ bool CDomain::configureDomain( XMLElement* pXDomain )
 		this->cTargetDir = new char[ std::strlen( cDataTargetDir ) + 1 ];
 		std::strcpy( this->cTargetDir, cDataTargetDir );
 	}
+	if ( cDataCacheDir != NULL )
+	{
+		this->cCacheDir = new char[ std::strlen( cDataCacheDir ) + 1 ];
+		std::strcpy( this->cCacheDir, cDataCacheDir );
+	}
 
 	return true;
 }
@@ -151,6 +165,7 @@ void	CDomain::createStoreBuffers(
 		prepareDomain();
 
 	this->ucFloatSize = ucFloatSize;
+	this->bStructureOfArrays = ( pManager->getCellStateLayout() == model::cellStateLayout::kStructureOfArrays );
 
 	try {
 		if ( ucFloatSize == sizeof( cl_float ) )
@@ -200,19 +215,16 @@ void	CDomain::initialiseMemory()
 
 	for( unsigned long i = 0; i < this->ulCellCount; i++ )
 	{
+		this->setStateValue( i, 0, 0 );			// Free-surface level
+		this->setStateValue( i, 1, 0 );			// Maximum free-surface level
+		this->setStateValue( i, 2, 0 );			// Discharge X
+		this->setStateValue( i, 3, 0 );			// Discharge Y
+
 		if ( this->ucFloatSize == 4 )
 		{
-			this->fCellStates[ i ].s[0]	= 0;	// Free-surface level
-			this->fCellStates[ i ].s[1]	= 0;	// Maximum free-surface level
-			this->fCellStates[ i ].s[2]	= 0;	// Discharge X
-			this->fCellStates[ i ].s[3]	= 0;	// Discharge Y
 			this->fBedElevations[ i ]   = 1;	// Bed elevation
 			this->fManningValues[ i ]	= 0;	// Manning coefficient
 		} else {
-			this->dCellStates[ i ].s[0]	= 0;	// Free-surface level
-			this->dCellStates[ i ].s[1]	= 0;	// Maximum free-surface level
-			this->dCellStates[ i ].s[2]	= 0;	// Discharge X
-			this->dCellStates[ i ].s[3]	= 0;	// Discharge Y
 			this->dBedElevations[ i ]   = 1;	// Bed elevation
 			this->dManningValues[ i ]	= 0;	// Manning coefficient
 		}
@@ -252,9 +264,9 @@ void	CDomain::setStateValue( unsigned long ulCellID, unsigned char ucIndex, doub
 {
 	if ( this->ucFloatSize == 4 )
 	{
-		this->fCellStates[ ulCellID ].s[ ucIndex ] = static_cast<float>( dValue );
+		reinterpret_cast<cl_float*>( this->fCellStates )[ this->getStateOffset( ulCellID, ucIndex ) ] = static_cast<float>( dValue );
 	} else {
-		this->dCellStates[ ulCellID ].s[ ucIndex ] = dValue;
+		reinterpret_cast<cl_double*>( this->dCellStates )[ this->getStateOffset( ulCellID, ucIndex ) ] = dValue;
 	}
 }
 
@@ -284,12 +296,49 @@ double	CDomain::getManningCoefficient( unsigned long ulCellID )
 double	CDomain::getStateValue( unsigned long ulCellID, unsigned char ucIndex )
 {
 	if ( this->ucFloatSize == 4 ) 
-		return static_cast<double>( this->fCellStates[ ulCellID ].s[ ucIndex ] );
-	return this->dCellStates[ ulCellID ].s[ ucIndex ];
+		return static_cast<double>( reinterpret_cast<cl_float*>( this->fCellStates )[ this->getStateOffset( ulCellID, ucIndex ) ] );
+	return reinterpret_cast<cl_double*>( this->dCellStates )[ this->getStateOffset( ulCellID, ucIndex ) ];
 }
 
 /*
- *  Handle initial conditions input data for a cell (usually from a raster dataset)
+ *  Gets a state variable for a given cell from a copy of the cell state
+ *  heap, such as a snapshot taken for writing outputs
+ */
+double	CDomain::getStateValue( unsigned long ulCellID, unsigned char ucIndex, void* vCellStates )
+{
+	if ( vCellStates == NULL )
+		return this->getStateValue( ulCellID, ucIndex );
+	if ( this->ucFloatSize == 4 ) 
+		return static_cast<double>( static_cast<cl_float*>( vCellStates )[ this->getStateOffset( ulCellID, ucIndex ) ] );
+	return static_cast<cl_double*>( vCellStates )[ this->getStateOffset( ulCellID, ucIndex ) ];
+}
+
+/*
+ *  Gets an accumulator for a given cell from a copy of the accumulator
+ *  data, which is always interleaved
+ */
+double	CDomain::getAccumulatorValue( unsigned long ulCellID, unsigned char ucIndex, void* vAccumulators )
+{
+	if ( vAccumulators == NULL )
+		return -9999.0;
+	if ( this->ucFloatSize == 4 ) 
+		return static_cast<double>( static_cast<cl_float*>( vAccumulators )[ ulCellID * 4 + ucIndex ] );
+	return static_cast<cl_double*>( vAccumulators )[ ulCellID * 4 + ucIndex ];
+}
+
+/*
+ *  Position of a state variable in the cell state heap, which is either
+ *  interleaved or holds each variable in its own plane
+ */
+unsigned long	CDomain::getStateOffset( unsigned long ulCellID, unsigned char ucIndex )
+{
+	if ( this->bStructureOfArrays )
+		return ucIndex * this->ulCellCount + ulCellID;
+	return ulCellID * 4 + ucIndex;
+}
+
+/*
+ *  Handle initial conditions input data for a cell (usually from a constant)
  */
 void	CDomain::handleInputData( 
 			unsigned long	ulCellID, 
@@ -301,52 +350,117 @@ void	CDomain::handleInputData(
 	if ( !bPrepared )
 		prepareDomain();
 
+	sInputStatistics	sStatistics = this->getInputStatistics();
+
+	this->applyInputValue(
+		ulCellID,
+		dValue,
+		ucValue,
+		static_cast<double>( (unsigned int)std::pow( 10.0, ucRounding ) ),
+		&sStatistics
+	);
+
+	this->mergeInputStatistics( &sStatistics );
+}
+
+/*
+ *  Handle initial conditions input data for every cell at once (usually
+ *  from a raster dataset), indexed by cell ID. The cells are shared between
+ *  several threads, as a large DEM would otherwise take longer to load than
+ *  the first part of the simulation takes to run.
+ */
+void	CDomain::handleInputData( 
+			double*			dValues,
+			unsigned char	ucValue,
+			unsigned char	ucRounding
+		)
+{
+	if ( !bPrepared )
+		prepareDomain();
+
+	unsigned int	uiThreads	= std::max( 1U, std::min( std::thread::hardware_concurrency(), static_cast<unsigned int>( this->ulCellCount / 65536 + 1 ) ) );
+	unsigned long	ulPerThread	= ( this->ulCellCount + uiThreads - 1 ) / uiThreads;
+	double			dMultiplier	= static_cast<double>( (unsigned int)std::pow( 10.0, ucRounding ) );
+
+	std::vector<sInputStatistics>	vStatistics( uiThreads, this->getInputStatistics() );
+	std::vector<std::thread>		vThreads;
+
+	for ( unsigned int i = 0; i < uiThreads; i++ )
+	{
+		unsigned long ulFirst	= std::min( this->ulCellCount, ulPerThread * i );
+		unsigned long ulLast	= std::min( this->ulCellCount, ulFirst + ulPerThread );
+
+		vThreads.push_back( std::thread( [=, &vStatistics]() {
+			for ( unsigned long ulCellID = ulFirst; ulCellID < ulLast; ulCellID++ )
+				this->applyInputValue( ulCellID, dValues[ ulCellID ], ucValue, dMultiplier, &vStatistics[ i ] );
+		} ) );
+	}
+
+	for ( unsigned int i = 0; i < uiThreads; i++ )
+	{
+		vThreads[ i ].join();
+		this->mergeInputStatistics( &vStatistics[ i ] );
+	}
+}
+
+/*
+ *  Apply an input value to a cell, rounded using the multiplier given, and
+ *  extend the range of values seen
+ */
+void	CDomain::applyInputValue( 
+			unsigned long		ulCellID, 
+			double				dValue,
+			unsigned char		ucValue,
+			double				dMultiplier,
+			sInputStatistics*	pStatistics
+		)
+{
 	switch( ucValue )
 	{
 	case model::rasterDatasets::dataValues::kBedElevation:
 		this->setBedElevation( 
 			ulCellID, 
-			Util::round( dValue, ucRounding ) 
+			Util::roundScaled( dValue, dMultiplier ) 
 		);
 		this->setStateValue( 
 			ulCellID, 
 			model::domainValueIndices::kValueFreeSurfaceLevel, 
-			Util::round( dValue, ucRounding ) 
+			Util::roundScaled( dValue, dMultiplier ) 
 		);
-		if ( dValue < dMinTopo && dValue != -9999.0 ) dMinTopo = dValue;
-		if ( dValue > dMaxTopo && dValue != -9999.0 ) dMaxTopo = dValue;
+		if ( dValue < pStatistics->dMinTopo && dValue != -9999.0 ) pStatistics->dMinTopo = dValue;
+		if ( dValue > pStatistics->dMaxTopo && dValue != -9999.0 ) pStatistics->dMaxTopo = dValue;
 		break;
 	case model::rasterDatasets::dataValues::kFreeSurfaceLevel:
 		this->setStateValue( 
 			ulCellID,
 			model::domainValueIndices::kValueFreeSurfaceLevel, 
-			Util::round( dValue, ucRounding ) 
+			Util::roundScaled( dValue, dMultiplier ) 
 		);
 		this->setStateValue( 
 			ulCellID, 
 			model::domainValueIndices::kValueMaxFreeSurfaceLevel, 
-			Util::round( dValue, ucRounding ) 
+			Util::roundScaled( dValue, dMultiplier ) 
 		);
-		if ( dValue - this->getBedElevation( ulCellID ) < dMinDepth && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) dMinDepth = dValue;
-		if ( dValue - this->getBedElevation( ulCellID ) > dMaxDepth && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) dMaxDepth = dValue;
-		if ( dValue < dMinFSL && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) dMinFSL = dValue;
-		if ( dValue > dMaxFSL && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) dMaxFSL = dValue;
+		if ( dValue - this->getBedElevation( ulCellID ) < pStatistics->dMinDepth && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) pStatistics->dMinDepth = dValue - this->getBedElevation( ulCellID );
+		if ( dValue - this->getBedElevation( ulCellID ) > pStatistics->dMaxDepth && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) pStatistics->dMaxDepth = dValue - this->getBedElevation( ulCellID );
+		if ( dValue < pStatistics->dMinFSL && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) pStatistics->dMinFSL = dValue;
+		if ( dValue > pStatistics->dMaxFSL && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) pStatistics->dMaxFSL = dValue;
 		break;
 	case model::rasterDatasets::dataValues::kDepth:
 		this->setStateValue( 
 			ulCellID, 
 			model::domainValueIndices::kValueFreeSurfaceLevel, 
-			Util::round( ( this->getBedElevation( ulCellID ) + dValue ), ucRounding ) 
+			Util::roundScaled( ( this->getBedElevation( ulCellID ) + dValue ), dMultiplier ) 
 		);
 		this->setStateValue( 
 			ulCellID, 
 			model::domainValueIndices::kValueMaxFreeSurfaceLevel, 
-			Util::round( ( this->getBedElevation( ulCellID ) + dValue ), ucRounding ) 
+			Util::roundScaled( ( this->getBedElevation( ulCellID ) + dValue ), dMultiplier ) 
 		);
-		if ( dValue + this->getBedElevation( ulCellID ) < dMinFSL && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) dMinFSL = dValue;
-		if ( dValue + this->getBedElevation( ulCellID ) > dMaxFSL && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) dMaxFSL = dValue;
-		if ( dValue < dMinDepth && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) dMinDepth = dValue;
-		if ( dValue > dMaxDepth && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) dMaxDepth = dValue;
+		if ( dValue + this->getBedElevation( ulCellID ) < pStatistics->dMinFSL && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) pStatistics->dMinFSL = dValue + this->getBedElevation( ulCellID );
+		if ( dValue + this->getBedElevation( ulCellID ) > pStatistics->dMaxFSL && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) pStatistics->dMaxFSL = dValue + this->getBedElevation( ulCellID );
+		if ( dValue < pStatistics->dMinDepth && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) pStatistics->dMinDepth = dValue;
+		if ( dValue > pStatistics->dMaxDepth && this->getBedElevation( ulCellID ) > -9999.0 && dValue > -9999.0 ) pStatistics->dMaxDepth = dValue;
 		break;
 	case model::rasterDatasets::dataValues::kDisabledCells:
 		// Cells are disabled using a free-surface level of -9999
@@ -355,7 +469,7 @@ void	CDomain::handleInputData(
 			this->setStateValue( 
 				ulCellID, 
 				model::domainValueIndices::kValueMaxFreeSurfaceLevel, 
-				Util::round( ( -9999.0 ), ucRounding ) 
+				Util::roundScaled( ( -9999.0 ), dMultiplier ) 
 			);
 		}
 		break;
@@ -363,39 +477,69 @@ void	CDomain::handleInputData(
 		this->setStateValue( 
 			ulCellID,
 			model::domainValueIndices::kValueDischargeX, 
-			Util::round( dValue, ucRounding ) 
+			Util::roundScaled( dValue, dMultiplier ) 
 		);
 		break;
 	case model::rasterDatasets::dataValues::kDischargeY:
 		this->setStateValue( 
 			ulCellID, 
 			model::domainValueIndices::kValueDischargeY, 
-			Util::round( dValue, ucRounding ) 
+			Util::roundScaled( dValue, dMultiplier ) 
 		);
 		break;
 	case model::rasterDatasets::dataValues::kVelocityX:
 		this->setStateValue( 
 			ulCellID, 
 			model::domainValueIndices::kValueDischargeX, 
-			Util::round( dValue * ( this->getStateValue( ulCellID, model::domainValueIndices::kValueFreeSurfaceLevel ) - this->getBedElevation( ulCellID ) ), ucRounding )
+			Util::roundScaled( dValue * ( this->getStateValue( ulCellID, model::domainValueIndices::kValueFreeSurfaceLevel ) - this->getBedElevation( ulCellID ) ), dMultiplier )
 		);
 		break;
 	case model::rasterDatasets::dataValues::kVelocityY:
 		this->setStateValue( 
 			ulCellID, 
 			model::domainValueIndices::kValueDischargeY, 
-			Util::round( dValue * ( this->getStateValue( ulCellID, model::domainValueIndices::kValueFreeSurfaceLevel ) - this->getBedElevation( ulCellID ) ), ucRounding ) 
+			Util::roundScaled( dValue * ( this->getStateValue( ulCellID, model::domainValueIndices::kValueFreeSurfaceLevel ) - this->getBedElevation( ulCellID ) ), dMultiplier ) 
 		);
 		break;
 	case model::rasterDatasets::dataValues::kManningCoefficient:
 		this->setManningCoefficient( 
 			ulCellID, 
-			Util::round( dValue, ucRounding ) 
+			Util::roundScaled( dValue, dMultiplier ) 
 		);
 		break;
 	}
 }
 
+/*
+ *  Fetch the range of values seen in the inputs so far
+ */
+CDomain::sInputStatistics	CDomain::getInputStatistics()
+{
+	sInputStatistics	sStatistics;
+
+	sStatistics.dMinFSL		= this->dMinFSL;
+	sStatistics.dMaxFSL		= this->dMaxFSL;
+	sStatistics.dMinTopo	= this->dMinTopo;
+	sStatistics.dMaxTopo	= this->dMaxTopo;
+	sStatistics.dMinDepth	= this->dMinDepth;
+	sStatistics.dMaxDepth	= this->dMaxDepth;
+
+	return sStatistics;
+}
+
+/*
+ *  Extend the range of values seen in the inputs
+ */
+void	CDomain::mergeInputStatistics( sInputStatistics* pStatistics )
+{
+	this->dMinFSL	= std::min( this->dMinFSL,		pStatistics->dMinFSL );
+	this->dMaxFSL	= std::max( this->dMaxFSL,		pStatistics->dMaxFSL );
+	this->dMinTopo	= std::min( this->dMinTopo,		pStatistics->dMinTopo );
+	this->dMaxTopo	= std::max( this->dMaxTopo,		pStatistics->dMaxTopo );
+	this->dMinDepth	= std::min( this->dMinDepth,	pStatistics->dMinDepth );
+	this->dMaxDepth	= std::max( this->dMaxDepth,	pStatistics->dMaxDepth );
+}
+
 /*
  *  Calculate the total volume present in all of the cells
  */
@@ -407,6 +551,135 @@ double	CDomain::getVolume()
 	return dVolume;
 }
 
+/*
+ *  Load the prepared initial conditions from the cache directory, if a
+ *  cache file exists for the same inputs
+ */
+bool	CDomain::loadDomainCache( cl_ulong ulInputKey )
+{
+	sDomainCacheHeader	pHeader;
+	std::string			sFilename = CDomainCacheDataset::getFilename( std::string( this->cCacheDir ), ulInputKey );
+
+	if ( !bPrepared )
+		prepareDomain();
+
+	CDomainCacheDataset::prepareHeader(
+		&pHeader,
+		ulInputKey,
+		this->ulCellCount,
+		this->ucFloatSize,
+		( this->bStructureOfArrays ? model::cellStateLayout::kStructureOfArrays : model::cellStateLayout::kArrayOfStructures )
+	);
+
+	if ( !CDomainCacheDataset::readFile(
+			sFilename,
+			&pHeader,
+			( this->isDoublePrecision() ? static_cast<void*>( this->dCellStates ) : static_cast<void*>( this->fCellStates ) ),
+			( this->isDoublePrecision() ? static_cast<void*>( this->dBedElevations ) : static_cast<void*>( this->fBedElevations ) ),
+			( this->isDoublePrecision() ? static_cast<void*>( this->dManningValues ) : static_cast<void*>( this->fManningValues ) )
+		) )
+		return false;
+
+	this->dMinFSL	= pHeader.dMinFSL;
+	this->dMaxFSL	= pHeader.dMaxFSL;
+	this->dMinTopo	= pHeader.dMinTopo;
+	this->dMaxTopo	= pHeader.dMaxTopo;
+	this->dMinDepth	= pHeader.dMinDepth;
+	this->dMaxDepth	= pHeader.dMaxDepth;
+
+	pManager->log->writeLine( "Loaded prepared domain from " + sFilename + "." );
+
+	return true;
+}
+
+/*
+ *  Save the prepared initial conditions to the cache directory, so later
+ *  runs with the same inputs can skip loading them
+ */
+void	CDomain::writeDomainCache( cl_ulong ulInputKey )
+{
+	sDomainCacheHeader	pHeader;
+	std::string			sFilename = CDomainCacheDataset::getFilename( std::string( this->cCacheDir ), ulInputKey );
+
+	CDomainCacheDataset::prepareHeader(
+		&pHeader,
+		ulInputKey,
+		this->ulCellCount,
+		this->ucFloatSize,
+		( this->bStructureOfArrays ? model::cellStateLayout::kStructureOfArrays : model::cellStateLayout::kArrayOfStructures )
+	);
+	pHeader.dMinFSL		= this->dMinFSL;
+	pHeader.dMaxFSL		= this->dMaxFSL;
+	pHeader.dMinTopo	= this->dMinTopo;
+	pHeader.dMaxTopo	= this->dMaxTopo;
+	pHeader.dMinDepth	= this->dMinDepth;
+	pHeader.dMaxDepth	= this->dMaxDepth;
+
+	if ( CDomainCacheDataset::writeFile(
+			sFilename,
+			&pHeader,
+			( this->isDoublePrecision() ? static_cast<void*>( this->dCellStates ) : static_cast<void*>( this->fCellStates ) ),
+			( this->isDoublePrecision() ? static_cast<void*>( this->dBedElevations ) : static_cast<void*>( this->fBedElevations ) ),
+			( this->isDoublePrecision() ? static_cast<void*>( this->dManningValues ) : static_cast<void*>( this->fManningValues ) )
+		) )
+		pManager->log->writeLine( "Saved prepared domain to " + sFilename + "." );
+}
+
+/*
+ *  Load the cell states, timing data and any accumulators from a checkpoint
+ *  in the given directory (or the output directory if none is given) and
+ *  send them to the device
+ */
+bool	CDomain::loadCheckpoint( std::string sDirectory, sCheckpointHeader* pHeader )
+{
+	if ( sDirectory.empty() && this->cTargetDir != NULL )
+		sDirectory = std::string( this->cTargetDir );
+
+	std::string sFilename = CCheckpointDataset::getFilename( sDirectory, this->uiID );
+
+	CCheckpointDataset::prepareHeader(
+		pHeader,
+		this->uiID,
+		this->ulCellCount,
+		this->ucFloatSize,
+		( this->bStructureOfArrays ? model::cellStateLayout::kStructureOfArrays : model::cellStateLayout::kArrayOfStructures )
+	);
+
+	unsigned long long	ulStateSize		= static_cast<unsigned long long>( this->ulCellCount ) * 4 * this->ucFloatSize;
+	char*				cAccumulators	= ( this->pScheme->getAccumulatorsEnabled() ? new char[ ulStateSize ] : NULL );
+
+	if ( !CCheckpointDataset::readFile(
+			sFilename,
+			pHeader,
+			( this->isDoublePrecision() ? static_cast<void*>( this->dCellStates ) : static_cast<void*>( this->fCellStates ) ),
+			ulStateSize,
+			cAccumulators
+		) )
+	{
+		delete [] cAccumulators;
+		return false;
+	}
+
+	this->pScheme->restoreCheckpointState( pHeader );
+
+	if ( cAccumulators != NULL && pHeader->uiAccumulators != 0 )
+	{
+		this->pScheme->writeAccumulators( cAccumulators );
+	}
+	else if ( cAccumulators != NULL )
+	{
+		model::doError(
+			"Checkpoint has no accumulators, so maxima and durations only cover the run from " + Util::secondsToTime( pHeader->dTime ) + ".",
+			model::errorCodes::kLevelWarning
+		);
+	}
+	delete [] cAccumulators;
+
+	pManager->log->writeLine( "Domain #" + toString( this->uiID + 1 ) + " resumed from " + sFilename + " at " + Util::secondsToTime( pHeader->dTime ) + "." );
+
+	return true;
+}
+
 /*
  *  Sets the scheme we're running on this domain
  */
@@ -463,6 +736,14 @@ CDomainBase::mpiSignalDataProgress	CDomain::getDataProgress()
  */
 unsigned char	CDomain::getDataValueCode( char* cSourceValue )
 {
+	if ( strstr( cSourceValue, "maxvelocity" ) != NULL )
+		return model::rasterDatasets::dataValues::kMaxVelocity;
+	if ( strstr( cSourceValue, "maxhazard" ) != NULL )
+		return model::rasterDatasets::dataValues::kMaxHazard;
+	if ( strstr( cSourceValue, "arrivaltime" ) != NULL )
+		return model::rasterDatasets::dataValues::kArrivalTime;
+	if ( strstr( cSourceValue, "duration" ) != NULL )
+		return model::rasterDatasets::dataValues::kDuration;
 	if ( strstr( cSourceValue, "dem" ) != NULL )		
 		return model::rasterDatasets::dataValues::kBedElevation;
 	if ( strstr( cSourceValue, "maxdepth" ) != NULL )		
@@ -495,6 +776,10 @@ unsigned char	CDomain::getDataValueCode( char* cSourceValue )
 		return model::rasterDatasets::dataValues::kVelocityY;
 	if ( strstr( cSourceValue, "froude" ) != NULL )		
 		return model::rasterDatasets::dataValues::kFroudeNumber;
+	if ( strstr( cSourceValue, "speed" ) != NULL )
+		return model::rasterDatasets::dataValues::kSpeed;
+	if ( strstr( cSourceValue, "unitdischarge" ) != NULL )
+		return model::rasterDatasets::dataValues::kUnitDischarge;
 
 	return 255;
 }
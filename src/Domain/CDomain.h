@@ -32,6 +32,14 @@ namespace domainValueIndices{ enum domainValueIndices {
 	kValueDischargeY						= 3		// Discharge Y
 }; }
 
+// Device-side accumulator structure
+namespace accumulatorIndices{ enum accumulatorIndices {
+	kAccumulatorMaxVelocity					= 0,	// Max velocity
+	kAccumulatorMaxHazard					= 1,	// Max depth x velocity
+	kAccumulatorArrivalTime					= 2,	// Time the inundation threshold was first reached
+	kAccumulatorDuration					= 3		// Time spent above the inundation threshold
+}; }
+
 }
 
 // TODO: Make a CLocation class
@@ -40,6 +48,7 @@ class CBoundaryMap;
 class COCLDevice;
 class COCLBuffer;
 class CScheme;
+struct sCheckpointHeader;
 
 /*
  *  DOMAIN CLASS
@@ -67,16 +76,29 @@ class CDomain : public CDomainBase
 		virtual		void			logDetails() = 0;												// Log details about the domain
 		virtual		void			updateCellStatistics() = 0;										// Update the total number of cells calculation
 		virtual		void			writeOutputs() = 0;												// Write output files to disk
+		virtual		void			writeFinalOutputs()		{};										// Write the output files only taken at the end of a simulation
+		virtual		void			waitForOutputs()		{};										// Wait for output files still being written
+		virtual		void			writeCheckpoint( double ) {};									// Write a checkpoint of the domain state to disk
+		virtual		void			writeGauges()			{};										// Append new gauge samples to the time series files
+		virtual		double			getGaugeReadbackInterval()	{ return 0.0; };						// Longest time between syncs before gauge samples are lost
+		virtual		void			resumeGauges( double )	{};										// Keep the time series rows up to a resume time
+		bool						loadCheckpoint( std::string, sCheckpointHeader* );				// Resume the domain state from a checkpoint
+		bool						loadDomainCache( cl_ulong );									// Load the prepared initial conditions from the cache
+		void						writeDomainCache( cl_ulong );									// Save the prepared initial conditions to the cache
 		void						createStoreBuffers( void**, void**, void**, unsigned char );	// Allocates memory and returns pointers to the three arrays
 		void						initialiseMemory();												// Populate cells with default values
 		void						handleInputData( unsigned long, double, unsigned char, unsigned char );	// Handle input data for varying state/static cell variables 
+		void						handleInputData( double*, unsigned char, unsigned char );		// Handle input data for every cell at once, across several threads
 		void						setBedElevation( unsigned long, double );						// Sets the bed elevation for a cell
 		void						setManningCoefficient( unsigned long, double );					// Sets the manning coefficient for a cell
 		void						setStateValue( unsigned long, unsigned char, double );			// Sets a state variable
 		bool						isDoublePrecision() { return ( ucFloatSize == 8 ); };				// Are we using double-precision?
+		bool						isStructureOfArrays() { return bStructureOfArrays; };			// Are cell states stored as separate planes?
 		double						getBedElevation( unsigned long );								// Gets the bed elevation for a cell
 		double						getManningCoefficient( unsigned long );							// Gets the manning coefficient for a cell
 		double						getStateValue( unsigned long, unsigned char );					// Gets a state variable
+		double						getStateValue( unsigned long, unsigned char, void* );			// Gets a state variable from a copy of the cell states
+		double						getAccumulatorValue( unsigned long, unsigned char, void* );	// Gets an accumulator from a copy of the accumulator data
 		double						getMaxFSL()				{ return dMaxFSL; }						// Fetch the maximum FSL in the domain
 		double						getMinFSL()				{ return dMinFSL; }						// Fetch the minimum FSL in the domain
 		virtual double				getVolume();													// Calculate the total volume in all the cells
@@ -98,8 +120,10 @@ class CDomain : public CDomainBase
 
 		// Private variables
 		unsigned char		ucFloatSize;															// Size of floats used for cell data (bytes)
+		bool				bStructureOfArrays;														// Cell states stored as separate planes?
 		char*				cSourceDir;																// Data source dir
 		char*				cTargetDir;																// Output target dir
+		char*				cCacheDir;																// Prepared domain cache dir (NULL if disabled)
 		cl_double4*			dCellStates;															// Heap for cell state data
 		cl_double*			dBedElevations;															// Heap for bed elevations
 		cl_double*			dManningValues;															// Heap for manning values
@@ -118,8 +142,23 @@ class CDomain : public CDomainBase
 		CScheme*			pScheme;																// Scheme we are running for this particular domain
 		COCLDevice*			pDevice;																// Device responsible for running this domain
 
+		// Private structures
+		struct sInputStatistics
+		{
+			cl_double		dMinFSL;
+			cl_double		dMaxFSL;
+			cl_double		dMinTopo;
+			cl_double		dMaxTopo;
+			cl_double		dMinDepth;
+			cl_double		dMaxDepth;
+		};
+
 		// Private functions
 		unsigned char		getDataValueCode( char* );												// Get a raster dataset code from text description
+		void				applyInputValue( unsigned long, double, unsigned char, double, sInputStatistics* );	// Apply an input value to a cell
+		sInputStatistics	getInputStatistics();													// Fetch the range of input values seen so far
+		void				mergeInputStatistics( sInputStatistics* );								// Extend the range of input values seen
+		unsigned long		getStateOffset( unsigned long, unsigned char );							// Position of a state variable in the cell state heap
 };
 
 #endif
@@ -48,7 +48,7 @@ class CDomainBase
 	public:
 
 		CDomainBase(void);																			// Constructor
-		~CDomainBase(void);																			// Destructor
+		virtual ~CDomainBase(void);																	// Destructor
 
 		// Public structures
 		struct DomainSummary
@@ -16,6 +16,9 @@
  * ------------------------------------------
  *
  */
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+
 #include "../common.h"
 #include "CDomainManager.h"
 #include "CDomainBase.h"
@@ -25,6 +28,7 @@
 #include "../Schemes/CScheme.h"
 #include "../Datasets/CXMLDataset.h"
 #include "../Datasets/CRasterDataset.h"
+#include "../Datasets/CCheckpointDataset.h"
 #include "../Boundaries/CBoundaryMap.h"
 #include "../OpenCL/Executors/COCLDevice.h"
 #include "../MPI/CMPIManager.h"
@@ -37,6 +41,12 @@ CDomainManager::CDomainManager(void)
 {
 	this->ucSyncMethod = model::syncMethod::kSyncForecast;
 	this->uiSyncSpareIterations = 3;
+	this->dRebalanceFrequency = 0.0;
+	this->bRebalancing = false;
+	this->pXPartition = NULL;
+	this->uiPartitionDevice = 0;
+	this->bPartitionRows = true;
+	this->ulPartitionBreadth = 0;
 }
 
 /*
@@ -60,6 +70,7 @@ bool CDomainManager::setupFromConfig( XMLElement* pXNode )
 	char			*cParameterValue	= NULL;
 	char			*cSyncMethodName    = NULL;
 	char			*cSyncSpareIterations = NULL;
+	char			*cRebalanceFrequency = NULL;
 
 	// Have we defined a synchronisation method for multi-domains?
 	Util::toLowercase(&cSyncMethodName, pXNode->Attribute("syncMethod"));
@@ -99,6 +110,35 @@ bool CDomainManager::setupFromConfig( XMLElement* pXNode )
 		}
 	}
 
+	// How often should domains split across devices be rebalanced?
+	Util::toLowercase(&cRebalanceFrequency, pXNode->Attribute("rebalanceFrequency"));
+	if (cRebalanceFrequency != NULL)
+	{
+		if ( CXMLDataset::isValidFloat(cRebalanceFrequency) )
+		{
+			this->setRebalanceFrequency(boost::lexical_cast<double>(cRebalanceFrequency));
+		}
+		else
+		{
+			model::doError(
+				"Invalid rebalancing frequency given.",
+				model::errorCodes::kLevelWarning
+			);
+		}
+	}
+
+	// Under forecast sync each piece's timesteps depend on its extent, so moving
+	// the cuts would change the results
+	if (this->getRebalanceFrequency() > 0.0 &&
+		this->getSyncMethod() != model::syncMethod::kSyncTimestep)
+	{
+		model::doError(
+			"Rebalancing requires timestep synchronisation, so it has been disabled.",
+			model::errorCodes::kLevelWarning
+		);
+		this->setRebalanceFrequency(0.0);
+	}
+
 	// TODO: Ditch <parameter> for the domainSet?
 	/*
 	while ( pParameter != NULL )
@@ -170,15 +210,17 @@ bool CDomainManager::setupFromConfig( XMLElement* pXNode )
 	XMLElement*		pXDomain			= pXNode->FirstChildElement( "domain" );
 	char			*cDomainType		= NULL;
 	char			*cDomainDevice		= NULL;
+	char			*cDomainDeviceCount	= NULL;
 
 	while ( pXDomain != NULL )
 	{
 		Util::toLowercase( &cDomainType,   pXDomain->Attribute( "type" ) );
 		Util::toLowercase( &cDomainDevice, pXDomain->Attribute( "deviceNumber" ) );
+		Util::toLowercase( &cDomainDeviceCount, pXDomain->Attribute( "deviceCount" ) );
 
 		if (strcmp(cDomainType, "cartesian") == 0)
 		{
-			CDomainBase* pDomainNew;
+			unsigned int uiDeviceCount = 1;
 
 			// Do we have a valid device number?
 			if (cDomainDevice == NULL)
@@ -197,36 +239,38 @@ bool CDomainManager::setupFromConfig( XMLElement* pXNode )
 						"The domain device specified is invalid.",
 						model::errorCodes::kLevelWarning
 						);
+					return false;
 				}
 			}
 
-			// Is the domain located on this node?
-			unsigned int uiDeviceAdjust = 1;
-#ifdef MPI_ON
-			if ( !pManager->getMPIManager()->getNode()->isDeviceOnNode(boost::lexical_cast<unsigned int>(cDomainDevice)) )
+			// Should the domain be split across a number of devices?
+			if (cDomainDeviceCount != NULL)
 			{
-				// Domain lives somewhere else, so we only need a skeleton data structure
-				pManager->log->writeLine("Creating a new skeleton domain for a remote node.");
-				pDomainNew = CDomainBase::createDomain(model::domainStructureTypes::kStructureRemote);
-			} else {
-				// Adjust device number to be a local ID rather than across the whole MPI COMM
-				uiDeviceAdjust = pManager->getMPIManager()->getNode()->getDeviceBaseID();
-#endif
-				// Domain resides on this node
-				pManager->log->writeLine("Creating a new Cartesian-structured domain.");
-				pDomainNew = CDomainBase::createDomain(model::domainStructureTypes::kStructureCartesian);
-				pManager->log->writeLine("Local device IDs are relative to #" + toString(uiDeviceAdjust) + "." );
-				pManager->log->writeLine("Assigning domain to device #" + toString(boost::lexical_cast<unsigned int>(cDomainDevice) - uiDeviceAdjust + 1) + "."  );
-				static_cast<CDomain*>(pDomainNew)->setDevice(pManager->getExecutor()->getDevice(boost::lexical_cast<unsigned int>(cDomainDevice) - uiDeviceAdjust + 1));
-#ifdef MPI_ON
+				if (!CXMLDataset::isValidUnsignedInt(std::string(cDomainDeviceCount)) ||
+					boost::lexical_cast<unsigned int>(cDomainDeviceCount) < 1)
+				{
+					model::doError(
+						"The domain device count specified is invalid.",
+						model::errorCodes::kLevelWarning
+						);
+					return false;
+				}
+				uiDeviceCount = boost::lexical_cast<unsigned int>(cDomainDeviceCount);
 			}
-#endif
 
-			if (!pDomainNew->configureDomain(pXDomain))
-				return false;
+			if (uiDeviceCount > 1)
+			{
+				if (!this->partitionDomain(pXDomain, boost::lexical_cast<unsigned int>(cDomainDevice), uiDeviceCount))
+					return false;
+			} else {
+				CDomainBase* pDomainNew = this->createDomainOnDevice(boost::lexical_cast<unsigned int>(cDomainDevice));
 
-			pDomainNew->setID( getDomainCount() );	// Should not be needed, but somehow is?
-			domains.push_back( pDomainNew );
+				if (!pDomainNew->configureDomain(pXDomain))
+					return false;
+
+				pDomainNew->setID( getDomainCount() );	// Should not be needed, but somehow is?
+				domains.push_back( pDomainNew );
+			}
 		}
 		else 
 		{
@@ -281,6 +325,521 @@ bool CDomainManager::setupFromConfig( XMLElement* pXNode )
 	return true;
 }
 
+/*
+ *  Create a Cartesian domain for a device, or a skeleton if the
+ *  device belongs to another node
+ */
+CDomainBase*	CDomainManager::createDomainOnDevice( unsigned int uiDevice )
+{
+	CDomainBase* pDomainNew;
+
+	// Is the domain located on this node?
+	unsigned int uiDeviceAdjust = 1;
+#ifdef MPI_ON
+	if ( !pManager->getMPIManager()->getNode()->isDeviceOnNode(uiDevice) )
+	{
+		// Domain lives somewhere else, so we only need a skeleton data structure
+		pManager->log->writeLine("Creating a new skeleton domain for a remote node.");
+		pDomainNew = CDomainBase::createDomain(model::domainStructureTypes::kStructureRemote);
+	} else {
+		// Adjust device number to be a local ID rather than across the whole MPI COMM
+		uiDeviceAdjust = pManager->getMPIManager()->getNode()->getDeviceBaseID();
+#endif
+		// Domain resides on this node
+		pManager->log->writeLine("Creating a new Cartesian-structured domain.");
+		pDomainNew = CDomainBase::createDomain(model::domainStructureTypes::kStructureCartesian);
+		pManager->log->writeLine("Local device IDs are relative to #" + toString(uiDeviceAdjust) + "." );
+		pManager->log->writeLine("Assigning domain to device #" + toString(uiDevice - uiDeviceAdjust + 1) + "."  );
+		static_cast<CDomain*>(pDomainNew)->setDevice(pManager->getExecutor()->getDevice(uiDevice - uiDeviceAdjust + 1));
+#ifdef MPI_ON
+	}
+#endif
+
+	return pDomainNew;
+}
+
+/*
+ *  Split a single domain across a number of consecutive devices. The cuts are
+ *  made along the longer axis, weighted by the number of enabled cells in the
+ *  DEM so each device has a similar workload, and neighbours overlap by
+ *  enough cells for the synchronisation method in use.
+ */
+bool	CDomainManager::partitionDomain( XMLElement* pXDomain, unsigned int uiFirstDevice, unsigned int uiDeviceCount )
+{
+	XMLElement*		pXData			= pXDomain->FirstChildElement( "data" );
+	XMLElement*		pXDataSource	= NULL;
+	char			*cSourceType	= NULL,
+					*cSourceValue	= NULL;
+	std::string		sStructure, sDEM, sSourceDir;
+
+	if ( pXData != NULL )
+	{
+		if ( pXData->Attribute( "sourceDir" ) != NULL )
+			sSourceDir = pXData->Attribute( "sourceDir" );
+		pXDataSource = pXData->FirstChildElement( "dataSource" );
+	}
+
+	while ( pXDataSource != NULL )
+	{
+		Util::toLowercase( &cSourceType,  pXDataSource->Attribute( "type" ) );
+		Util::toLowercase( &cSourceValue, pXDataSource->Attribute( "value" ) );
+
+		if ( cSourceType != NULL && cSourceValue != NULL && pXDataSource->Attribute( "source" ) != NULL &&
+			 strcmp( cSourceType, "raster" ) == 0 )
+		{
+			if ( strstr( cSourceValue, "structure" ) != NULL )
+				sStructure = pXDataSource->Attribute( "source" );
+			if ( strstr( cSourceValue, "dem" ) != NULL )
+				sDEM = pXDataSource->Attribute( "source" );
+		}
+
+		pXDataSource = pXDataSource->NextSiblingElement( "dataSource" );
+	}
+
+	if ( sStructure.empty() )
+	{
+		model::doError(
+			"A domain can only be split across devices if its structure is from a raster.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+	if ( sDEM.empty() )
+		sDEM = sStructure;
+
+	// Each piece appends to its own Zarr store or time series file, which can't
+	// follow its window or gauges when the pieces are resized
+	if ( this->getRebalanceFrequency() > 0.0 && pXData != NULL )
+	{
+		for ( XMLElement* pXTarget = pXData->FirstChildElement( "dataTarget" ); pXTarget != NULL; pXTarget = pXTarget->NextSiblingElement( "dataTarget" ) )
+		{
+			if ( pXTarget->Attribute( "format" ) != NULL && boost::iequals( pXTarget->Attribute( "format" ), "zarr" ) )
+			{
+				model::doError(
+					"Zarr outputs can't be used with a rebalancing frequency, as the split domains change size.",
+					model::errorCodes::kLevelWarning
+				);
+				return false;
+			}
+			if ( pXTarget->Attribute( "type" ) != NULL && boost::iequals( pXTarget->Attribute( "type" ), "timeseries" ) )
+			{
+				model::doError(
+					"Time series outputs can't be used with a rebalancing frequency, as the gauges in each split domain change.",
+					model::errorCodes::kLevelWarning
+				);
+				return false;
+			}
+		}
+	}
+
+	// Find the workload in each row and column
+	CRasterDataset					pDataset;
+	std::vector<unsigned long>		vRowCounts, vColCounts;
+
+	pManager->log->writeLine( "Splitting domain across " + toString( uiDeviceCount ) + " devices." );
+	if ( !pDataset.openFileRead( sSourceDir + sDEM ) ||
+		 !pDataset.countEnabledCells( &vRowCounts, &vColCounts ) )
+	{
+		model::doError(
+			"Could not read the DEM to split the domain.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	// Cut across the longer axis, so the overlaps are as small as possible
+	this->pXPartition		= pXDomain;
+	this->uiPartitionDevice	= uiFirstDevice;
+	this->bPartitionRows	= ( vRowCounts.size() >= vColCounts.size() );
+	this->vPartitionEnabled	= ( this->bPartitionRows ? vRowCounts : vColCounts );
+	this->ulPartitionBreadth	= ( this->bPartitionRows ? vColCounts.size() : vRowCounts.size() );
+
+	unsigned long					ulLength	= this->vPartitionEnabled.size();
+	unsigned long					ulOverlap	= this->getPartitionOverlap();
+
+	if ( ulLength < uiDeviceCount * ( ulOverlap + 1 ) )
+	{
+		model::doError(
+			"The domain is too small to split across " + toString( uiDeviceCount ) + " devices with an overlap of " + toString( ulOverlap ) + " cells.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	// Running total of enabled cells, falling back on area if there are none
+	std::vector<double>				vCumulative( ulLength + 1, 0.0 );
+	std::vector<double>				vTargets;
+	for ( unsigned long i = 0; i < ulLength; i++ )
+		vCumulative[ i + 1 ] = vCumulative[ i ] + this->vPartitionEnabled[ i ];
+	if ( vCumulative[ ulLength ] <= 0.0 )
+		for ( unsigned long i = 0; i < ulLength; i++ )
+			vCumulative[ i + 1 ] = static_cast<double>( i + 1 );
+
+	// Each device takes an equal share
+	for ( unsigned int i = 1; i < uiDeviceCount; i++ )
+		vTargets.push_back( vCumulative[ ulLength ] * i / uiDeviceCount );
+	this->vPartitionCuts = this->getPartitionCuts( &vCumulative, &vTargets );
+
+	// Create each of the domains
+	for ( unsigned int i = 0; i < uiDeviceCount; i++ )
+	{
+		CDomainBase* pDomainNew = this->createPartition( i );
+		if ( pDomainNew == NULL )
+			return false;
+
+		domains.push_back( pDomainNew );
+	}
+
+	return true;
+}
+
+/*
+ *  Place the cuts for a split domain where the running total of the workload
+ *  passes each target, but keep every domain wider than the overlap. The
+ *  cuts returned include both ends.
+ */
+std::vector<unsigned long>	CDomainManager::getPartitionCuts( std::vector<double>* vCumulative, std::vector<double>* vTargets )
+{
+	std::vector<unsigned long>		vCuts;
+	unsigned long					ulLength	= vCumulative->size() - 1;
+	unsigned long					ulOverlap	= this->getPartitionOverlap();
+	unsigned int					uiCount		= vTargets->size() + 1;
+
+	vCuts.push_back( 0 );
+	for ( unsigned int i = 1; i < uiCount; i++ )
+	{
+		unsigned long ulCut = static_cast<unsigned long>( 
+			std::lower_bound( vCumulative->begin(), vCumulative->end(), (*vTargets)[ i - 1 ] ) - vCumulative->begin() 
+		);
+
+		ulCut = std::max( ulCut, vCuts.back() + ulOverlap + 1 );
+		ulCut = std::min( ulCut, ulLength - ( uiCount - i ) * ( ulOverlap + 1 ) );
+		vCuts.push_back( ulCut );
+	}
+	vCuts.push_back( ulLength );
+
+	return vCuts;
+}
+
+/*
+ *  Create and configure one piece of a split domain, extending it past the
+ *  cuts either side to form the overlaps. Pieces are numbered after the
+ *  domains already created, as they must be added in order.
+ */
+CDomainBase*	CDomainManager::createPartition( unsigned int uiPartition )
+{
+	unsigned long	ulLength		= this->vPartitionEnabled.size();
+	unsigned long	ulOverlap		= this->getPartitionOverlap();
+	unsigned int	uiCount			= this->vPartitionCuts.size() - 1;
+	unsigned long	ulStart			= ( uiPartition == 0 ? 0 : this->vPartitionCuts[ uiPartition ] - ulOverlap / 2 );
+	unsigned long	ulEnd			= ( uiPartition == uiCount - 1 ? ulLength : this->vPartitionCuts[ uiPartition + 1 ] + ulOverlap - ulOverlap / 2 );
+	unsigned long	ulOwnedStart	= this->vPartitionCuts[ uiPartition ];
+	unsigned long	ulOwnedEnd		= this->vPartitionCuts[ uiPartition + 1 ];
+	unsigned long	ulEnabled		= 0;
+
+	for ( unsigned long i = this->vPartitionCuts[ uiPartition ]; i < this->vPartitionCuts[ uiPartition + 1 ]; i++ )
+		ulEnabled += this->vPartitionEnabled[ i ];
+
+	pManager->log->writeLine( "Domain #" + toString( getDomainCount() + 1 ) + " takes " + ( this->bPartitionRows ? "rows " : "columns " ) +
+		toString( ulStart + 1 ) + " to " + toString( ulEnd ) + " with " + toString( ulEnabled ) + " enabled cells." );
+
+	CDomainBase* pDomainNew = this->createDomainOnDevice( this->uiPartitionDevice + uiPartition );
+	pDomainNew->setID( getDomainCount() );
+
+	if ( !pDomainNew->isRemote() )
+	{
+		if ( this->bPartitionRows )
+		{
+			static_cast<CDomainCartesian*>( pDomainNew )->setRasterWindow( 0, ulStart, this->ulPartitionBreadth, ulEnd - ulStart );
+			static_cast<CDomainCartesian*>( pDomainNew )->setOwnedWindow( 0, ulOwnedStart, this->ulPartitionBreadth, ulOwnedEnd - ulOwnedStart );
+		} else {
+			static_cast<CDomainCartesian*>( pDomainNew )->setRasterWindow( ulStart, 0, ulEnd - ulStart, this->ulPartitionBreadth );
+			static_cast<CDomainCartesian*>( pDomainNew )->setOwnedWindow( ulOwnedStart, 0, ulOwnedEnd - ulOwnedStart, this->ulPartitionBreadth );
+		}
+	}
+
+	if ( !pDomainNew->configureDomain( this->pXPartition ) )
+	{
+		delete pDomainNew;
+		return NULL;
+	}
+
+	return pDomainNew;
+}
+
+/*
+ *  Move rows or columns between the pieces of a split domain so the time each
+ *  device spends on a batch is evened out. The workload is estimated from the
+ *  wet cells and the time each domain has spent running batches since the last
+ *  call. Cell states are carried across by recreating every domain from the
+ *  configuration, much like resuming from a checkpoint, which re-reads the
+ *  rasters and rebuilds the programs. Only used with timestep sync, where
+ *  every piece shares the same timesteps, so the results match a static
+ *  partition. Must be called when every domain is idle and synchronised.
+ */
+bool	CDomainManager::rebalanceDomains( double dTime )
+{
+	// Only a single domain split automatically, and held on this node, can be rebalanced
+	if ( this->pXPartition == NULL || 
+		 domains.size() < 2 || 
+		 domains.size() != this->vPartitionCuts.size() - 1 )
+		return false;
+
+	for ( unsigned int i = 0; i < domains.size(); i++ )
+	{
+		if ( !this->isDomainLocal( i ) )
+			return false;
+	}
+
+	unsigned int				uiCount		= domains.size();
+	unsigned long				ulLength	= this->vPartitionEnabled.size();
+	std::vector<double>			vWork( ulLength, 0.0 );
+	std::vector<double>			vSeconds( uiCount, 0.0 );
+	std::vector<void*>			vStates( uiCount, (void*)NULL );
+	std::vector<void*>			vAccumulators( uiCount, (void*)NULL );
+	bool						bAccumulators = this->getDomain( 0 )->getScheme()->getAccumulatorsEnabled();
+	sCheckpointHeader			pHeader;
+
+	// Fetch the cell states from every domain, alongside the time data
+	// which is the same for each at a sync point
+	for ( unsigned int i = 0; i < uiCount; i++ )
+	{
+		CDomain* pDomain = this->getDomain( i );
+		unsigned long long ulBytes = static_cast<unsigned long long>( pDomain->getCellCount() ) * 4 * ( pDomain->isDoublePrecision() ? sizeof( cl_double ) : sizeof( cl_float ) );
+
+		pDomain->getDevice()->blockUntilFinished();
+		vStates[ i ] = new char[ ulBytes ];
+		pDomain->getScheme()->readDomainAll( vStates[ i ] );
+		if ( bAccumulators )
+		{
+			vAccumulators[ i ] = new char[ ulBytes ];
+			pDomain->getScheme()->readAccumulators( vAccumulators[ i ] );
+		}
+		pDomain->getDevice()->blockUntilFinished();
+
+		if ( i == 0 )
+			pDomain->getScheme()->readCheckpointState( &pHeader );
+
+		vSeconds[ i ] = pDomain->getScheme()->getComputeSeconds();
+		pDomain->getScheme()->resetComputeSeconds();
+	}
+
+	// Estimate the work in each row or column from the domain which owns it. Dry
+	// cells still cost something, but much less than wet ones.
+	for ( unsigned int i = 0; i < uiCount; i++ )
+	{
+		CDomainCartesian* pDomain = static_cast<CDomainCartesian*>( this->getDomain( i ) );
+		unsigned long ulWindowX, ulWindowY, ulWindowCols, ulWindowRows;
+		pDomain->getRasterWindow( &ulWindowX, &ulWindowY, &ulWindowCols, &ulWindowRows );
+		unsigned long ulWindowStart = ( this->bPartitionRows ? ulWindowY : ulWindowX );
+
+		for ( unsigned long ulLine = this->vPartitionCuts[ i ]; ulLine < this->vPartitionCuts[ i + 1 ]; ulLine++ )
+		{
+			unsigned long ulWet = 0;
+
+			for ( unsigned long ulAcross = 0; ulAcross < this->ulPartitionBreadth; ulAcross++ )
+			{
+				unsigned long ulCellID = ( this->bPartitionRows ?
+					pDomain->getCellID( ulAcross, ulLine - ulWindowStart ) :
+					pDomain->getCellID( ulLine - ulWindowStart, ulAcross ) );
+				double dBed = pDomain->getBedElevation( ulCellID );
+
+				if ( dBed > -9999.0 && 
+					 pDomain->getStateValue( ulCellID, model::domainValueIndices::kValueFreeSurfaceLevel, vStates[ i ] ) - dBed > 1E-10 )
+					ulWet++;
+			}
+
+			vWork[ ulLine ] = ulWet + 0.1 * this->vPartitionEnabled[ ulLine ];
+		}
+	}
+
+	std::vector<double>			vCumulative( ulLength + 1, 0.0 );
+	for ( unsigned long i = 0; i < ulLength; i++ )
+		vCumulative[ i + 1 ] = vCumulative[ i ] + vWork[ i ];
+
+	// Devices may differ in speed, so find the time each takes per unit of work
+	std::vector<double>			vRate( uiCount, 0.0 );
+	double						dRateTotal	= 0.0;
+	unsigned int				uiRates		= 0;
+	for ( unsigned int i = 0; i < uiCount; i++ )
+	{
+		double dWork = vCumulative[ this->vPartitionCuts[ i + 1 ] ] - vCumulative[ this->vPartitionCuts[ i ] ];
+		if ( vSeconds[ i ] > 0.0 && dWork > 0.0 )
+		{
+			vRate[ i ] = vSeconds[ i ] / dWork;
+			dRateTotal += vRate[ i ];
+			uiRates++;
+		}
+	}
+	for ( unsigned int i = 0; i < uiCount; i++ )
+	{
+		if ( vRate[ i ] <= 0.0 )
+			vRate[ i ] = ( uiRates > 0 ? dRateTotal / uiRates : 1.0 );
+	}
+
+	// Give each device the share of the work it can finish in the same time
+	double						dInverseTotal = 0.0;
+	std::vector<double>			vTargets;
+	for ( unsigned int i = 0; i < uiCount; i++ )
+		dInverseTotal += 1.0 / vRate[ i ];
+	for ( unsigned int i = 1; i < uiCount; i++ )
+		vTargets.push_back( ( i == 1 ? 0.0 : vTargets.back() ) + vCumulative[ ulLength ] / dInverseTotal / vRate[ i - 1 ] );
+
+	std::vector<unsigned long>	vCuts = this->getPartitionCuts( &vCumulative, &vTargets );
+
+	// Only worth moving the cells if the slowest device gains noticeably
+	double dSlowestBefore = 0.0, dSlowestAfter = 0.0;
+	for ( unsigned int i = 0; i < uiCount; i++ )
+	{
+		dSlowestBefore	= std::max( dSlowestBefore, vRate[ i ] * ( vCumulative[ this->vPartitionCuts[ i + 1 ] ] - vCumulative[ this->vPartitionCuts[ i ] ] ) );
+		dSlowestAfter	= std::max( dSlowestAfter, vRate[ i ] * ( vCumulative[ vCuts[ i + 1 ] ] - vCumulative[ vCuts[ i ] ] ) );
+	}
+
+	if ( vCuts == this->vPartitionCuts || dSlowestAfter > 0.9 * dSlowestBefore )
+	{
+		for ( unsigned int i = 0; i < uiCount; i++ )
+		{
+			delete [] static_cast<char*>( vStates[ i ] );
+			delete [] static_cast<char*>( vAccumulators[ i ] );
+		}
+		return false;
+	}
+
+	pManager->log->writeLine( "Rebalancing domains at " + Util::secondsToTime( dTime ) + "..." );
+
+	// Gather the state of every line from the domain which owns it
+	unsigned long				ulCells		= ulLength * this->ulPartitionBreadth;
+	std::vector<cl_double4>		vGlobal( ulCells );
+	std::vector<cl_double4>		vGlobalAccumulators( bAccumulators ? ulCells : 0 );
+	for ( unsigned int i = 0; i < uiCount; i++ )
+	{
+		CDomainCartesian* pDomain = static_cast<CDomainCartesian*>( this->getDomain( i ) );
+		unsigned long ulWindowX, ulWindowY, ulWindowCols, ulWindowRows;
+		pDomain->getRasterWindow( &ulWindowX, &ulWindowY, &ulWindowCols, &ulWindowRows );
+		unsigned long ulWindowStart = ( this->bPartitionRows ? ulWindowY : ulWindowX );
+
+		for ( unsigned long ulLine = this->vPartitionCuts[ i ]; ulLine < this->vPartitionCuts[ i + 1 ]; ulLine++ )
+		{
+			for ( unsigned long ulAcross = 0; ulAcross < this->ulPartitionBreadth; ulAcross++ )
+			{
+				unsigned long ulCellID = ( this->bPartitionRows ?
+					pDomain->getCellID( ulAcross, ulLine - ulWindowStart ) :
+					pDomain->getCellID( ulLine - ulWindowStart, ulAcross ) );
+
+				for ( unsigned char ucValue = 0; ucValue < 4; ucValue++ )
+					vGlobal[ ulLine * this->ulPartitionBreadth + ulAcross ].s[ ucValue ] = pDomain->getStateValue( ulCellID, ucValue, vStates[ i ] );
+				for ( unsigned char ucValue = 0; bAccumulators && ucValue < 4; ucValue++ )
+					vGlobalAccumulators[ ulLine * this->ulPartitionBreadth + ulAcross ].s[ ucValue ] = pDomain->getAccumulatorValue( ulCellID, ucValue, vAccumulators[ i ] );
+			}
+		}
+
+		delete [] static_cast<char*>( vStates[ i ] );
+		delete [] static_cast<char*>( vAccumulators[ i ] );
+	}
+
+	// Replace every domain with one covering its new cells
+	for ( unsigned int i = 0; i < uiCount; i++ )
+	{
+		this->getDomain( i )->getScheme()->cleanupSimulation();
+		delete domains[ i ];
+	}
+	domains.clear();
+
+	this->vPartitionCuts = vCuts;
+
+	// The new pieces don't use the prepared domain cache, as their states
+	// are replaced and their windows are unlikely to be seen again
+	this->bRebalancing = true;
+	for ( unsigned int i = 0; i < uiCount; i++ )
+	{
+		CDomainBase* pDomainNew = this->createPartition( i );
+		if ( pDomainNew == NULL )
+		{
+			this->bRebalancing = false;
+			model::doError(
+				"Could not recreate a domain while rebalancing.",
+				model::errorCodes::kLevelModelStop
+			);
+			return false;
+		}
+		domains.push_back( pDomainNew );
+	}
+	this->bRebalancing = false;
+
+	this->generateLinks();
+
+	for ( unsigned int i = 0; i < uiCount; i++ )
+	{
+		CDomainCartesian* pDomain = static_cast<CDomainCartesian*>( this->getDomain( i ) );
+		unsigned long ulWindowX, ulWindowY, ulWindowCols, ulWindowRows;
+		pDomain->getRasterWindow( &ulWindowX, &ulWindowY, &ulWindowCols, &ulWindowRows );
+		unsigned long ulWindowStart = ( this->bPartitionRows ? ulWindowY : ulWindowX );
+		unsigned long ulWindowLength = ( this->bPartitionRows ? ulWindowRows : ulWindowCols );
+		bool bDoublePrecision = pDomain->isDoublePrecision();
+		char* cAccumulators = ( bAccumulators ? new char[ pDomain->getCellCount() * 4 * ( bDoublePrecision ? sizeof( cl_double ) : sizeof( cl_float ) ) ] : NULL );
+
+		for ( unsigned long ulLine = ulWindowStart; ulLine < ulWindowStart + ulWindowLength; ulLine++ )
+		{
+			for ( unsigned long ulAcross = 0; ulAcross < this->ulPartitionBreadth; ulAcross++ )
+			{
+				unsigned long ulCellID = ( this->bPartitionRows ?
+					pDomain->getCellID( ulAcross, ulLine - ulWindowStart ) :
+					pDomain->getCellID( ulLine - ulWindowStart, ulAcross ) );
+
+				for ( unsigned char ucValue = 0; ucValue < 4; ucValue++ )
+					pDomain->setStateValue( ulCellID, ucValue, vGlobal[ ulLine * this->ulPartitionBreadth + ulAcross ].s[ ucValue ] );
+
+				// Accumulators are always interleaved
+				for ( unsigned char ucValue = 0; bAccumulators && ucValue < 4; ucValue++ )
+				{
+					double dValue = vGlobalAccumulators[ ulLine * this->ulPartitionBreadth + ulAcross ].s[ ucValue ];
+					if ( bDoublePrecision )
+					{
+						reinterpret_cast<cl_double*>( cAccumulators )[ ulCellID * 4 + ucValue ] = dValue;
+					} else {
+						reinterpret_cast<cl_float*>( cAccumulators )[ ulCellID * 4 + ucValue ] = static_cast<cl_float>( dValue );
+					}
+				}
+			}
+		}
+
+		pDomain->getScheme()->prepareSimulation();
+		pDomain->getScheme()->restoreCheckpointState( &pHeader );
+		if ( bAccumulators )
+		{
+			pDomain->getScheme()->writeAccumulators( cAccumulators );
+			delete [] cAccumulators;
+		}
+		pDomain->setRollbackLimit();
+	}
+
+	// Links start from the time the cell states were taken
+	for ( unsigned int i = 0; i < uiCount; i++ )
+	{
+		CDomain* pDomain = this->getDomain( i );
+		for ( unsigned int j = 0; j < pDomain->getDependentLinkCount(); j++ )
+			pDomain->getDependentLink( j )->pullFromBuffer( dTime, pDomain->getScheme()->getNextCellSourceBuffer() );
+		pDomain->getDevice()->blockUntilFinished();
+		for ( unsigned int j = 0; j < pDomain->getDependentLinkCount(); j++ )
+			pDomain->getDependentLink( j )->stageOnTarget();
+	}
+
+	return true;
+}
+
+/*
+ *  Overlap in cells to leave between domains split automatically. A domain can
+ *  run half the overlap less two iterations before it must synchronise, which
+ *  should cover the spare iterations and, if forecasting, a useful batch beyond.
+ */
+unsigned int	CDomainManager::getPartitionOverlap()
+{
+	unsigned int uiIterations = this->uiSyncSpareIterations + 
+		( this->ucSyncMethod == model::syncMethod::kSyncForecast ? 10 : 1 );
+
+	return ( uiIterations + 2 ) * 2 + 1;
+}
+
 /*
  *  Add a new domain to the set
  */
@@ -365,6 +924,55 @@ void	CDomainManager::writeOutputs()
 	}
 }
 
+/*
+ *  Write the outputs each domain only produces once the simulation is over
+ */
+void	CDomainManager::writeFinalOutputs()
+{
+	for( unsigned int i = 0; i < domains.size(); i++ )
+	{
+		if (!domains[i]->isRemote())
+		{
+			getDomain(i)->writeFinalOutputs();
+		}
+	}
+}
+
+/*
+ *  Read back and write the gauge samples for each domain
+ */
+void	CDomainManager::writeGauges()
+{
+	for( unsigned int i = 0; i < domains.size(); i++ )
+	{
+		if (!domains[i]->isRemote())
+		{
+			getDomain(i)->writeGauges();
+		}
+	}
+}
+
+/*
+ *  Shortest time any local domain can run before its gauge samples must be
+ *  read back, or zero if none have gauges
+ */
+double	CDomainManager::getGaugeReadbackInterval()
+{
+	double dInterval = 0.0;
+
+	for( unsigned int i = 0; i < domains.size(); i++ )
+	{
+		if (!domains[i]->isRemote())
+		{
+			double dDomainInterval = getDomain(i)->getGaugeReadbackInterval();
+			if ( dDomainInterval > 0.0 && ( dInterval <= 0.0 || dDomainInterval < dInterval ) )
+				dInterval = dDomainInterval;
+		}
+	}
+
+	return dInterval;
+}
+
 /*
 *	Fetch the current sync method being employed
 */
@@ -381,6 +989,22 @@ void CDomainManager::setSyncMethod(unsigned char ucMethod)
 	this->ucSyncMethod = ucMethod;
 }
 
+/*
+*	Set how often domains split across devices should be rebalanced
+*/
+void CDomainManager::setRebalanceFrequency(double dFrequency)
+{
+	this->dRebalanceFrequency = dFrequency;
+}
+
+/*
+*	Fetch how often domains split across devices should be rebalanced
+*/
+double CDomainManager::getRebalanceFrequency()
+{
+	return this->dRebalanceFrequency;
+}
+
 /*
 *	Fetch the number of spare batch iterations to aim for when forecast syncing
 */
@@ -439,10 +1063,20 @@ void	CDomainManager::generateLinks()
 		for (unsigned int j = 0; j < domains.size(); j++)
 		{
 			// Must overlap and meet our various constraints
+			// Neighbours may be offset on either or both axes, so diagonal
+			// neighbours are linked to supply the corner cells they own
 			if (i != j && CDomainLink::canLink(domains[i], domains[j]))
 			{
 				// Make a new link...
 				CDomainLink* pNewLink = new CDomainLink(domains[i], domains[j]);
+
+				// ...unless a neighbour owns none of the overlapping cells
+				if (!pNewLink->hasDefinitions())
+				{
+					delete pNewLink;
+					continue;
+				}
+
 				domains[i]->addLink(pNewLink);
 				domains[j]->addDependentLink(pNewLink);
 			}
@@ -55,6 +55,9 @@ class CDomainManager
 		// Public functions
 		bool					setupFromConfig( XMLElement* );										// Set up the domain set
 		void					writeOutputs();														// Output each domain to disk if required
+		void					writeFinalOutputs();												// Output what each domain only writes at the end
+		void					writeGauges();														// Append new gauge samples for each domain
+		double					getGaugeReadbackInterval();											// Longest time between syncs before gauge samples are lost
 		bool					isDomainLocal(unsigned int);										// Is this domain local to this node?
 		CDomainBase*			getDomainBase(unsigned int);										// Fetch a domain base by ID
 		CDomain*				getDomain( unsigned int );											// Fetch a domain by ID
@@ -71,6 +74,10 @@ class CDomainManager
 		bool					isSetReady();														// Is the set of domains ready?
 		void					logDetails();														// Spit out some information
 		void					generateLinks();													// Generate domain link records
+		void					setRebalanceFrequency(double);										// Set how often split domains are rebalanced
+		double					getRebalanceFrequency();											// Fetch how often split domains are rebalanced
+		bool					rebalanceDomains(double);											// Move cells between split domains to even out the work
+		bool					isRebalancing()				{ return bRebalancing; }				// Are the domains being recreated to rebalance them?
 
 	protected:
 
@@ -78,10 +85,23 @@ class CDomainManager
 		std::vector<CDomainBase*> domains;															// Vector of all the domains we hold
 		unsigned char			ucSyncMethod;														// Method of domain synchronisation
 		unsigned int			uiSyncSpareIterations;												// Aim for # spare iterations when synchronising
+		double					dRebalanceFrequency;												// Seconds of simulation between rebalancing split domains
+		bool					bRebalancing;														// Are the domains being recreated to rebalance them?
+		XMLElement*				pXPartition;														// Configuration of the domain split across devices
+		unsigned int			uiPartitionDevice;													// First device the split domain uses
+		bool					bPartitionRows;														// Is the split domain cut into bands of rows?
+		unsigned long			ulPartitionBreadth;													// Cells across each band
+		std::vector<unsigned long>	vPartitionCuts;													// Where the split domain is cut, including both ends
+		std::vector<unsigned long>	vPartitionEnabled;												// Enabled cells in each row or column of the split domain
 
 		// Private functions
 		CDomainBase*			createNewDomain( unsigned char );									// Add a new domain
 		CDomainBase*			createNewDomain( unsigned char, XMLElement* );						// Add a new domain and configure it
+		CDomainBase*			createDomainOnDevice( unsigned int );								// Create a domain for a device, local or remote
+		bool					partitionDomain( XMLElement*, unsigned int, unsigned int );			// Split a domain across a number of devices
+		unsigned int			getPartitionOverlap();												// Overlap to leave between split domains
+		std::vector<unsigned long>	getPartitionCuts(std::vector<double>*, std::vector<double>*);	// Place the cuts for a split domain
+		CDomainBase*			createPartition(unsigned int);										// Create one piece of a split domain
 
 };
 
@@ -18,7 +18,10 @@
  */
 #include <limits>
 #include <stdio.h>
+#include <chrono>
 #include <cstring>
+#include <sstream>
+#include <thread>
 #include <boost/lexical_cast.hpp>
 
 #include "../../common.h"
@@ -29,6 +32,9 @@
 #include "../../Schemes/CScheme.h"
 #include "../../Datasets/CXMLDataset.h"
 #include "../../Datasets/CRasterDataset.h"
+#include "../../Datasets/CDomainCacheDataset.h"
+#include "../../Datasets/COutputWriter.h"
+#include "../../Datasets/CGaugeWriter.h"
 #include "../../OpenCL/Executors/CExecutorControlOpenCL.h"
 #include "../../Boundaries/CBoundaryMap.h"
 #include "../../MPI/CMPIManager.h"
@@ -53,6 +59,17 @@ CDomainCartesian::CDomainCartesian(void)
 	this->ulProjectionCode			= 0;
 	this->cTargetDir				= NULL;
 	this->cSourceDir				= NULL;
+	this->pOutputWriter				= NULL;
+	this->pGaugeWriter				= NULL;
+	this->bRasterWindow				= false;
+	this->ulRasterWindow[0]			= 0;
+	this->ulRasterWindow[1]			= 0;
+	this->ulRasterWindow[2]			= 0;
+	this->ulRasterWindow[3]			= 0;
+	this->ulOwnedWindow[0]			= 0;
+	this->ulOwnedWindow[1]			= 0;
+	this->ulOwnedWindow[2]			= 0;
+	this->ulOwnedWindow[3]			= 0;
 }
 
 /*
@@ -60,7 +77,11 @@ CDomainCartesian::CDomainCartesian(void)
  */
 CDomainCartesian::~CDomainCartesian(void)
 {
-	// ...
+	// Finishes writing any outputs still queued
+	if ( this->pOutputWriter != NULL )
+		delete this->pOutputWriter;
+	if ( this->pGaugeWriter != NULL )
+		delete this->pGaugeWriter;
 }
 
 /*
@@ -251,35 +272,111 @@ bool	CDomainCartesian::loadInitialConditions( XMLElement* pXData )
 	// 1. DEM
 	// 2. Depth/FSL
 	// 3. All others
-	if ( !this->loadInitialConditionSource( pDataDEM,	cSourceDir ) )
+	// Rasters are all read at once, each on its own thread, but are still
+	// applied in this order as the later values depend on the earlier ones
+	std::vector<sDataSourceInfo>		vSources;
+	vSources.push_back( pDataDEM );
+	vSources.push_back( pDataDepth );
+	vSources.insert( vSources.end(), pDataOther.begin(), pDataOther.end() );
+
+	// A prepared copy of the domain can be used instead, if the inputs
+	// haven't changed since it was saved (but not when rebalancing)
+	cl_ulong	ulInputKey = 0;
+	if ( this->cCacheDir != NULL && !pManager->getDomainSet()->isRebalancing() )
 	{
-		model::doError(
-			"Could not load DEM data.",
-			model::errorCodes::kLevelWarning
-		);
-		return false;
+		ulInputKey = this->getInputKey( &vSources, cSourceDir );
+		if ( ulInputKey != 0 && this->loadDomainCache( ulInputKey ) )
+			return true;
 	}
-	if ( !this->loadInitialConditionSource( pDataDepth,	cSourceDir ) )
+
+	std::vector<CRasterDataset*>		vRasters( vSources.size(), NULL );
+	std::vector<std::vector<double> >	vValues( vSources.size() );
+	std::vector<std::thread>			vReaders( vSources.size() );
+	std::chrono::high_resolution_clock::time_point tStart = std::chrono::high_resolution_clock::now();
+
+	for ( unsigned int i = 0; i < vSources.size(); ++i )
 	{
-		model::doError(
-			"Could not load depth/FSL data.",
-			model::errorCodes::kLevelWarning
-		);
-		return false;
+		if ( vSources[i].ucValue == 255 || strcmp( vSources[i].cSourceType, "raster" ) != 0 )
+			continue;
+
+		vRasters[i] = new CRasterDataset();
+		if ( !vRasters[i]->openFileRead( std::string( cSourceDir ) + std::string( vSources[i].cFileValue ) ) )
+			continue;
+
+		CRasterDataset*			pRaster = vRasters[i];
+		std::vector<double>*	vRaster	= &vValues[i];
+		vReaders[i] = std::thread( [this, pRaster, vRaster]() {
+			// Failures are reported when the values are applied
+			if ( !pRaster->readDataForDomain( this, vRaster ) )
+				vRaster->clear();
+		} );
 	}
-	for ( unsigned int i = 0; i < pDataOther.size(); ++i )
+
+	bool	bLoaded = true;
+	for ( unsigned int i = 0; i < vSources.size(); ++i )
 	{
-		if ( !this->loadInitialConditionSource( pDataOther[i], cSourceDir ) ) 
+		if ( vReaders[i].joinable() )
+			vReaders[i].join();
+
+		if ( bLoaded && !this->loadInitialConditionSource( vSources[i], cSourceDir, vRasters[i], &vValues[i] ) )
 		{
 			model::doError(
-				"Could not load initial conditions.",
+				( i == 0 ? "Could not load DEM data." : ( i == 1 ? "Could not load depth/FSL data." : "Could not load initial conditions." ) ),
 				model::errorCodes::kLevelWarning
 			);
-			return false;
+			bLoaded = false;
 		}
+
+		delete vRasters[i];
+		std::vector<double>().swap( vValues[i] );
 	}
 
-	return true;
+	if ( bLoaded && ulInputKey != 0 )
+		this->writeDomainCache( ulInputKey );
+
+	if ( bLoaded )
+		pManager->log->writeLine( "Initial conditions loaded in " + toString( floor( std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - tStart ).count() * 1000.0 ) / 1000.0 ) + "s." );
+
+	return bLoaded;
+}
+
+/*
+ *  Hash the configuration of the initial conditions and the contents of
+ *  every raster they're loaded from, to identify a prepared copy of the
+ *  domain. Zero is returned if a raster can't be read.
+ */
+cl_ulong	CDomainCartesian::getInputKey( std::vector<sDataSourceInfo>* vSources, char* cDataDir )
+{
+	std::ostringstream	ossConfiguration;
+	unsigned long		ulWindowX		= 0,
+						ulWindowY		= 0,
+						ulWindowCols	= this->ulCols,
+						ulWindowRows	= this->ulRows;
+
+	this->getRasterWindow( &ulWindowX, &ulWindowY, &ulWindowCols, &ulWindowRows );
+
+	ossConfiguration << this->ulCellCount << ":" << static_cast<unsigned int>( this->ucFloatSize ) << ":" << this->bStructureOfArrays << ":"
+					 << ulWindowX << ":" << ulWindowY << ":" << ulWindowCols << ":" << ulWindowRows;
+
+	for ( unsigned int i = 0; i < vSources->size(); ++i )
+	{
+		if ( ( *vSources )[i].ucValue == 255 )
+			continue;
+		ossConfiguration << "|" << ( *vSources )[i].cSourceType << ":" << static_cast<unsigned int>( ( *vSources )[i].ucValue ) << ":" << ( *vSources )[i].cFileValue;
+	}
+
+	std::string	sConfiguration	= ossConfiguration.str();
+	cl_ulong	ulKey			= CDomainCacheDataset::hashData( sConfiguration.c_str(), sConfiguration.length() );
+
+	for ( unsigned int i = 0; i < vSources->size(); ++i )
+	{
+		if ( ( *vSources )[i].ucValue == 255 || strcmp( ( *vSources )[i].cSourceType, "raster" ) != 0 )
+			continue;
+		if ( !CDomainCacheDataset::hashFile( std::string( cDataDir ) + std::string( ( *vSources )[i].cFileValue ), &ulKey ) )
+			return 0;
+	}
+
+	return ( ulKey == 0 ? 1 : ulKey );
 }
 
 /*
@@ -300,9 +397,10 @@ bool	CDomainCartesian::loadOutputDefinitions( XMLElement* pXData )
 		Util::toNewString( &cOutputFormat, pDataTarget->Attribute( "format" ) );
 		Util::toNewString( &cOutputFile,   pDataTarget->Attribute( "target" ) );
 
+		// Time series are always written as CSV
 		if ( cOutputType   == NULL || 
 			 cOutputValue  == NULL || 
-			 cOutputFormat == NULL || 
+			 ( cOutputFormat == NULL && strcmp( cOutputType, "timeseries" ) != 0 ) || 
 			 cOutputFile   == NULL )
 		{
 			model::doError(
@@ -312,18 +410,46 @@ bool	CDomainCartesian::loadOutputDefinitions( XMLElement* pXData )
 			return false;
 		}
 
+		std::string sTarget = std::string( cTargetDir ) + std::string( cOutputFile );
+
+		// Domains cut from a larger raster would otherwise overwrite each other
+		if ( this->bRasterWindow )
+		{
+			std::string sSuffix = "_" + toString( this->getID() + 1 );
+			size_t szExtension = sTarget.find_last_of( '.' );
+			size_t szDirectory = sTarget.find_last_of( "/\\" );
+			if ( szExtension == std::string::npos || ( szDirectory != std::string::npos && szExtension < szDirectory ) )
+			{
+				sTarget += sSuffix;
+			} else {
+				sTarget.insert( szExtension, sSuffix );
+			}
+		}
+
 		if ( strcmp( cOutputType, "raster" ) == 0 )
 		{
 			sDataTargetInfo	pOutput;
 
 			pOutput.cFormat	= cOutputFormat;
 			pOutput.cType   = cOutputType;
-			pOutput.sTarget = std::string( cTargetDir ) + std::string( cOutputFile );
+			pOutput.sTarget = sTarget;
 			pOutput.ucValue = this->getDataValueCode( cOutputValue );
 
+			// Tiled GeoTIFF and COG outputs are compressed unless told otherwise
+			if ( pDataTarget->Attribute( "compression" ) != NULL )
+				pOutput.sCompression = std::string( pDataTarget->Attribute( "compression" ) );
+
+			// Maxima, arrival times and durations are tracked on the device
+			if ( CRasterDataset::isAccumulatorValue( pOutput.ucValue ) )
+				this->pScheme->enableAccumulators();
+
 			addOutput( pOutput );
+		} 
+		else if ( strcmp( cOutputType, "timeseries" ) == 0 )
+		{
+			if ( !this->loadGaugeDefinitions( pDataTarget, sTarget, this->getDataValueCode( cOutputValue ) ) )
+				return false;
 		} else {
-			// TODO: Allow for timeseries outputs in specific cells etc.
 			model::doError(
 				"An invalid output format type was given.",
 				model::errorCodes::kLevelWarning
@@ -335,16 +461,156 @@ bool	CDomainCartesian::loadOutputDefinitions( XMLElement* pXData )
 
 	pManager->log->writeLine( "Identified " + toString( this->pOutputs.size() ) + " output file definition(s)." );
 
+	if ( this->pGaugeWriter != NULL )
+	{
+		pManager->log->writeLine( "Identified " + toString( this->pGaugeWriter->getTargetCount() ) + " time series output definition(s)." );
+		this->pGaugeWriter->prepare();
+	}
+
 	return true;
 }
 
+/*
+ *  Load the gauges for a time series output, given either as real coordinates
+ *  or as column and row indices from the lower-left of the source rasters
+ */
+bool	CDomainCartesian::loadGaugeDefinitions( XMLElement* pDataTarget, std::string sTarget, unsigned char ucValue )
+{
+	XMLElement*					pGauge			= pDataTarget->FirstChildElement( "gauge" );
+	std::vector<unsigned long>	vGaugeCells;
+	std::vector<std::string>	vGaugeNames;
+	char						*cFrequency		= NULL;
+	double						dFrequency;
+
+	Util::toNewString( &cFrequency, pDataTarget->Attribute( "frequency" ) );
+
+	if ( cFrequency == NULL || !CXMLDataset::isValidFloat( cFrequency ) )
+	{
+		model::doError(
+			"Time series output has no valid frequency.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+	dFrequency = boost::lexical_cast<double>( cFrequency );
+	delete [] cFrequency;
+
+	while ( pGauge != NULL )
+	{
+		char		*cName = NULL, *cX = NULL, *cY = NULL, *cCol = NULL, *cRow = NULL;
+		long		lCol, lRow;
+		bool		bValid = true;
+
+		Util::toNewString( &cName,	pGauge->Attribute( "name" ) );
+		Util::toNewString( &cX,		pGauge->Attribute( "x" ) );
+		Util::toNewString( &cY,		pGauge->Attribute( "y" ) );
+		Util::toNewString( &cCol,	pGauge->Attribute( "col" ) );
+		Util::toNewString( &cRow,	pGauge->Attribute( "row" ) );
+
+		std::string sName = ( cName != NULL ? std::string( cName ) : "gauge " + toString( vGaugeNames.size() + 1 ) );
+
+		if ( cX != NULL && cY != NULL && CXMLDataset::isValidFloat( cX ) && CXMLDataset::isValidFloat( cY ) )
+		{
+			lCol	= static_cast<long>( floor( ( boost::lexical_cast<double>( cX ) - this->dRealOffset[ kAxisX ] ) / this->dCellResolution ) );
+			lRow	= static_cast<long>( floor( ( boost::lexical_cast<double>( cY ) - this->dRealOffset[ kAxisY ] ) / this->dCellResolution ) );
+		}
+		else if ( cCol != NULL && cRow != NULL && CXMLDataset::isValidUnsignedInt( cCol ) && CXMLDataset::isValidUnsignedInt( cRow ) )
+		{
+			// Indices are for the source rasters, not a window cut from them
+			lCol	= boost::lexical_cast<long>( cCol ) - static_cast<long>( this->ulRasterWindow[0] );
+			lRow	= boost::lexical_cast<long>( cRow ) - static_cast<long>( this->ulRasterWindow[1] );
+		} else {
+			bValid	= false;
+		}
+
+		delete [] cName;
+		delete [] cX;
+		delete [] cY;
+		delete [] cCol;
+		delete [] cRow;
+
+		if ( !bValid )
+		{
+			model::doError(
+				"Gauge " + sName + " needs either x and y, or col and row.",
+				model::errorCodes::kLevelWarning
+			);
+			return false;
+		}
+
+		// Other parts of a split domain will pick up the gauge, including
+		// where it lies in the overlap with a neighbour
+		if ( lCol >= 0 && lRow >= 0 && 
+			 static_cast<unsigned long>( lCol ) < this->ulCols && 
+			 static_cast<unsigned long>( lRow ) < this->ulRows &&
+			 ( !this->bRasterWindow ||
+			   ( lCol + this->ulRasterWindow[0] >= this->ulOwnedWindow[0] &&
+				 lCol + this->ulRasterWindow[0] < this->ulOwnedWindow[0] + this->ulOwnedWindow[2] &&
+				 lRow + this->ulRasterWindow[1] >= this->ulOwnedWindow[1] &&
+				 lRow + this->ulRasterWindow[1] < this->ulOwnedWindow[1] + this->ulOwnedWindow[3] ) ) )
+		{
+			vGaugeCells.push_back( this->getCellID( lCol, lRow ) );
+			vGaugeNames.push_back( sName );
+		} 
+		else if ( !this->bRasterWindow )
+		{
+			model::doError(
+				"Gauge " + sName + " lies outside the domain.",
+				model::errorCodes::kLevelWarning
+			);
+		}
+
+		pGauge = pGauge->NextSiblingElement( "gauge" );
+	}
+
+	if ( this->pGaugeWriter == NULL )
+		this->pGaugeWriter = new CGaugeWriter( this );
+
+	return this->pGaugeWriter->addTarget( sTarget, ucValue, dFrequency, &vGaugeCells, &vGaugeNames );
+}
+
+/*
+ *  Read back the gauge samples gathered on the device and append them to the
+ *  time series files
+ */
+void	CDomainCartesian::writeGauges()
+{
+	if ( this->pGaugeWriter != NULL )
+		this->pGaugeWriter->writeSamples();
+}
+
+/*
+ *  Cut the time series files back to the time the run resumed from, so
+ *  new samples carry on after them
+ */
+void	CDomainCartesian::resumeGauges( double dTime )
+{
+	if ( this->pGaugeWriter != NULL )
+		this->pGaugeWriter->resumeAt( dTime );
+}
+
+/*
+ *  Longest the domain can run between syncs without losing gauge samples
+ */
+double	CDomainCartesian::getGaugeReadbackInterval()
+{
+	if ( this->pGaugeWriter == NULL )
+		return 0.0;
+
+	return this->pGaugeWriter->getReadbackInterval();
+}
+
 /*
  *  Read a data source raster or constant using the pre-parsed data held in the structure
  */
-bool	CDomainCartesian::loadInitialConditionSource( sDataSourceInfo pDataSource, char* cDataDir )
+bool	CDomainCartesian::loadInitialConditionSource( sDataSourceInfo pDataSource, char* cDataDir, CRasterDataset* pRaster, std::vector<double>* vValues )
 {
 	if ( strcmp( pDataSource.cSourceType, "raster" ) == 0 )
 	{
+		// Use the raster opened and read already if given
+		if ( pRaster != NULL )
+			return pRaster->applyDataToDomain( pDataSource.ucValue, this, vValues );
+
 		CRasterDataset	pDataset;
 		pDataset.openFileRead( 
 			std::string( cDataDir ) + std::string( pDataSource.cFileValue ) 
@@ -692,10 +958,49 @@ unsigned long	CDomainCartesian::getCellID( unsigned long ulX, unsigned long ulY
 unsigned long	CDomainCartesian::getCellFromCoordinates( double dX, double dY )
 {
 	unsigned long ulX	= floor( ( dX - dRealOffset[ 0 ] ) / dCellResolution );
-	unsigned long ulY	= floor( ( dY - dRealOffset[ 2 ] ) / dCellResolution );
+	unsigned long ulY	= floor( ( dY - dRealOffset[ 1 ] ) / dCellResolution );
 	return getCellID( ulX, ulY );
 }
 
+/*
+ *  Restrict the source rasters to a window of cells, measured from the
+ *  lower-left corner, so the domain covers only part of them
+ */
+void	CDomainCartesian::setRasterWindow( unsigned long ulX, unsigned long ulY, unsigned long ulCols, unsigned long ulRows )
+{
+	this->bRasterWindow		= true;
+	this->ulRasterWindow[0]	= ulX;
+	this->ulRasterWindow[1]	= ulY;
+	this->ulRasterWindow[2]	= ulCols;
+	this->ulRasterWindow[3]	= ulRows;
+	this->setOwnedWindow( ulX, ulY, ulCols, ulRows );
+}
+
+/*
+ *  Set the part of the window which isn't overlapped by the other pieces
+ *  of a split domain, in the same terms as the window itself
+ */
+void	CDomainCartesian::setOwnedWindow( unsigned long ulX, unsigned long ulY, unsigned long ulCols, unsigned long ulRows )
+{
+	this->ulOwnedWindow[0]	= ulX;
+	this->ulOwnedWindow[1]	= ulY;
+	this->ulOwnedWindow[2]	= ulCols;
+	this->ulOwnedWindow[3]	= ulRows;
+}
+
+/*
+ *  Fetch the window within the source rasters, if the domain has one
+ */
+bool	CDomainCartesian::getRasterWindow( unsigned long* ulX, unsigned long* ulY, unsigned long* ulCols, unsigned long* ulRows )
+{
+	*ulX	= this->ulRasterWindow[0];
+	*ulY	= this->ulRasterWindow[1];
+	*ulCols	= this->ulRasterWindow[2];
+	*ulRows	= this->ulRasterWindow[3];
+
+	return this->bRasterWindow;
+}
+
 #ifdef _WINDLL
 /*
  *  Send the topography to the renderer for visualisation purposes
@@ -710,7 +1015,8 @@ void	CDomainCartesian::sendAllToRenderer()
 		 ( this->ucFloatSize == 8 && this->dBedElevations == NULL ) ||
 		 ( this->ucFloatSize == 4 && this->fBedElevations == NULL ) ||
 		 ( this->ucFloatSize == 8 && this->dCellStates == NULL ) ||
-		 ( this->ucFloatSize == 4 && this->fCellStates == NULL ) ) 
+		 ( this->ucFloatSize == 4 && this->fCellStates == NULL ) ||
+		 this->bStructureOfArrays )			// Renderer expects interleaved cell states
 		return;
 
 #ifdef _WINDLL
@@ -746,14 +1052,8 @@ double	CDomainCartesian::getVolume()
 
 	for( unsigned int i = 0; i < this->ulCellCount; ++i )
 	{
-		if ( this->isDoublePrecision() )
-		{
-			dVolume += ( this->dCellStates[i].s[0] - this->dBedElevations[i] ) *
-					   this->dCellResolution * this->dCellResolution;
-		} else {
-			dVolume += ( this->fCellStates[i].s[0] - this->fBedElevations[i] ) *
-					   this->dCellResolution * this->dCellResolution;
-		}
+		dVolume += ( this->getStateValue( i, model::domainValueIndices::kValueFreeSurfaceLevel ) - this->getBedElevation( i ) ) *
+				   this->dCellResolution * this->dCellResolution;
 	}
 
 	return dVolume;
@@ -803,14 +1103,31 @@ void	CDomainCartesian::imposeBoundaryModification(unsigned char ucDirection, uns
  */
 void	CDomainCartesian::writeOutputs()
 {
-	// Read the data back first...
-	// TODO: Review whether this is necessary, isn't it a sync point anyway?
-	pDevice->blockUntilFinished();
-	pScheme->readDomainAll();
-	pDevice->blockUntilFinished();
+	this->queueOutputs( false );
+}
+
+/*
+ *  Write the accumulator outputs, which cover the whole simulation so are
+ *  only written once it has finished
+ */
+void	CDomainCartesian::writeFinalOutputs()
+{
+	this->queueOutputs( true );
+}
+
+/*
+ *  Pass the outputs for the current time to the background writer, either
+ *  the periodic outputs or those of the accumulators
+ */
+void	CDomainCartesian::queueOutputs( bool bAccumulators )
+{
+	std::vector<COutputWriter::sOutputTarget>	vTargets;
 
 	for( unsigned int i = 0; i < this->pOutputs.size(); ++i )
 	{
+		if ( CRasterDataset::isAccumulatorValue( this->pOutputs[i].ucValue ) != bAccumulators )
+			continue;
+
 		// Replaces %t with the time in the filename, if required
 		// TODO: Allow for decimal output filenames
 		std::string sFilename		= this->pOutputs[i].sTarget;
@@ -819,13 +1136,58 @@ void	CDomainCartesian::writeOutputs()
 		if ( uiTimeLocation != std::string::npos )
 			sFilename.replace( uiTimeLocation, 2, sTime );
 
-		CRasterDataset::domainToRaster(
-			this->pOutputs[i].cFormat,
-			sFilename,
-			this,
-			this->pOutputs[i].ucValue
-		);
+		COutputWriter::sOutputTarget pTarget;
+		pTarget.sFormat		= this->pOutputs[i].cFormat;
+		pTarget.sFilename	= sFilename;
+		pTarget.ucValue		= this->pOutputs[i].ucValue;
+		pTarget.sCompression	= this->pOutputs[i].sCompression;
+		vTargets.push_back( pTarget );
 	}
+
+	if ( vTargets.empty() )
+		return;
+
+	// The writer takes a snapshot of the cell states and returns, leaving
+	// the rasters to be written in the background
+	if ( this->pOutputWriter == NULL )
+		this->pOutputWriter = new COutputWriter( this );
+	this->pOutputWriter->queueOutputs( vTargets );
+}
+
+/*
+ *  Write a checkpoint of the domain to the output directory. Only the
+ *  device readback holds up the simulation; the file is written in the
+ *  background.
+ */
+void	CDomainCartesian::writeCheckpoint( double dLastOutputTime )
+{
+	sCheckpointHeader	pHeader;
+
+	CCheckpointDataset::prepareHeader(
+		&pHeader,
+		this->uiID,
+		this->ulCellCount,
+		this->ucFloatSize,
+		( this->bStructureOfArrays ? model::cellStateLayout::kStructureOfArrays : model::cellStateLayout::kArrayOfStructures )
+	);
+	pScheme->readCheckpointState( &pHeader );
+	pHeader.dLastOutputTime = dLastOutputTime;
+
+	if ( this->pOutputWriter == NULL )
+		this->pOutputWriter = new COutputWriter( this );
+	this->pOutputWriter->queueCheckpoint(
+		CCheckpointDataset::getFilename( ( this->cTargetDir != NULL ? std::string( this->cTargetDir ) : "" ), this->uiID ),
+		pHeader
+	);
+}
+
+/*
+ *  Wait for any output files still being written in the background
+ */
+void	CDomainCartesian::waitForOutputs()
+{
+	if ( this->pOutputWriter != NULL )
+		this->pOutputWriter->waitForCompletion();
 }
 
 /*
@@ -21,6 +21,10 @@
 
 #include "../CDomain.h"
 
+class COutputWriter;
+class CGaugeWriter;
+class CRasterDataset;
+
 /*
  *  DOMAIN CLASS
  *  CDomainCartesian
@@ -50,6 +54,12 @@ class CDomainCartesian : public CDomain
 		void			prepareDomain();										// Create memory structures etc.
 		void			logDetails();											// Log details about the domain
 		void			writeOutputs();											// Write output files to disk
+		void			writeFinalOutputs();									// Write the accumulator outputs at the end of a simulation
+		void			waitForOutputs();										// Wait for output files still being written
+		void			writeGauges();											// Append new gauge samples to the time series files
+		double			getGaugeReadbackInterval();								// Longest time between syncs before gauge samples are lost
+		void			resumeGauges( double );									// Keep the time series rows up to a resume time
+		void			writeCheckpoint( double );								// Write a checkpoint of the domain state to disk
 		void			syncWithDomain( CDomain* );								// Synchronise with another domain
 		unsigned int	getOverlapSize( CDomain* );								// Get the size of the overlap zone
 		// - Specific to cartesian grids
@@ -70,6 +80,9 @@ class CDomainCartesian : public CDomain
 		unsigned long	getCols();												// Get the number of columns in the domain
 		virtual unsigned long	getCellID( unsigned long, unsigned long );		// Get the cell ID using an X and Y index
 		unsigned long	getCellFromCoordinates( double, double );				// Get the cell ID using real coords
+		void			setRasterWindow( unsigned long, unsigned long, unsigned long, unsigned long );	// Restrict source rasters to a window (X, Y, cols, rows)
+		bool			getRasterWindow( unsigned long*, unsigned long*, unsigned long*, unsigned long* );	// Fetch the source raster window, if there is one
+		void			setOwnedWindow( unsigned long, unsigned long, unsigned long, unsigned long );	// Set the part of the window not overlapping other domains
 		double			getVolume();											// Calculate the amount of volume in all the cells
 		#ifdef _WINDLL
 		virtual void	sendAllToRenderer();									// Allows the renderer to read off the bed elevations
@@ -109,6 +122,7 @@ class CDomainCartesian : public CDomain
 			char*			cFormat;
 			unsigned char	ucValue;
 			std::string		sTarget;
+			std::string		sCompression;
 		};
 
 		// Private variables
@@ -120,11 +134,19 @@ class CDomainCartesian : public CDomain
 		unsigned long	ulCols;
 		unsigned long	ulProjectionCode;
 		char			cUnits[2];
+		bool			bRasterWindow;												// Is the domain only part of its source rasters?
+		unsigned long	ulRasterWindow[4];											// Window within the source rasters (X, Y, cols, rows) from the lower-left
+		unsigned long	ulOwnedWindow[4];											// Part of the window this domain alone writes outputs for
 		std::vector<sDataTargetInfo>	pOutputs;									// Structure of details about the outputs
+		COutputWriter*	pOutputWriter;												// Background writer for the outputs
+		CGaugeWriter*	pGaugeWriter;												// Writer for the time series outputs
 
 		// Private functions
 		void			addOutput( sDataTargetInfo );								// Adds a new output 
-		bool			loadInitialConditionSource( sDataSourceInfo, char* );		// Load a constant/raster condition to the domain
+		void			queueOutputs( bool );										// Pass either the periodic or accumulator outputs to the writer
+		bool			loadInitialConditionSource( sDataSourceInfo, char*, CRasterDataset* = NULL, std::vector<double>* = NULL );	// Load a constant/raster condition to the domain
+		bool			loadGaugeDefinitions( XMLElement*, std::string, unsigned char );	// Load the gauges for a time series output
+		cl_ulong		getInputKey( std::vector<sDataSourceInfo>*, char* );		// Hash the initial condition sources to identify a cached domain
 		void			updateCellStatistics();										// Update the number of rows, cols, etc.
 
 };
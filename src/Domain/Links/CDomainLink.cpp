@@ -23,6 +23,8 @@
 
 #include "../../common.h"
 #include "../../MPI/CMPIManager.h"
+#include "../../OpenCL/Executors/COCLDevice.h"
+#include "../../Schemes/CScheme.h"
 #include "CDomainLink.h"
 #include "../Cartesian/CDomainCartesian.h"	// TEMP: Remove me!
 #include "../CDomainManager.h"				// TEMP: Remove me!
@@ -48,11 +50,21 @@ CDomainLink::CDomainLink( CDomainBase* pTarget, CDomainBase *pSource )
 	this->dValidityTime = -1.0;
 	this->bSent 		= true;
 	this->uiSmallestOverlap = 999999999;
+	this->pHostStaging		= NULL;
+	this->pDeviceStaging	= NULL;
+	this->ulStagingSize		= 0;
+	this->dStagedTime		= -1.0;
+	this->bStagePending		= false;
+	this->pMPIBuffer		= NULL;
+	this->uiMPIBufferSize	= 0;
+	this->bPackedStateData	= false;
 
 	pManager->log->writeLine("Generating link definitions between domains #" + toString(this->uiTargetDomainID + 1) 
 		+ " and #" + toString(this->uiSourceDomainID + 1));
 
 	this->generateDefinitions( pTarget, pSource );
+	this->createStaging( pTarget, pSource );
+	this->createMPIExchange( pTarget, pSource );
 }
 
 /*
@@ -60,10 +72,27 @@ CDomainLink::CDomainLink( CDomainBase* pTarget, CDomainBase *pSource )
  */
 CDomainLink::~CDomainLink(void)
 {
-	for (unsigned int i = 0; i < linkDefs.size(); i++)
+#ifdef MPI_ON
+	if ( this->pMPIBuffer != NULL )
+		pManager->getMPIManager()->releaseLinkRequests( this );
+#endif
+
+	if ( this->pDeviceStaging != NULL )
+		delete this->pDeviceStaging;
+
+	if ( !this->bPackedStateData )
 	{
-		delete[] linkDefs[i].vStateData;
+		for (unsigned int i = 0; i < linkDefs.size(); i++)
+		{
+			delete[] linkDefs[i].vStateData;
+		}
 	}
+
+	if ( this->pHostStaging != NULL )
+		delete this->pHostStaging;
+
+	if ( this->pMPIBuffer != NULL )
+		delete[] this->pMPIBuffer;
 }
 
 /*
@@ -92,8 +121,8 @@ bool CDomainLink::canLink(CDomainBase* pA, CDomainBase* pB)
         }
 
 	// E/W axis
-	if ( pSumA.dEdgeWest >= pSumB.dEdgeEast &&
-		 pSumA.dEdgeEast <= pSumB.dEdgeWest )
+	if ( ( pSumA.dEdgeEast >= pSumB.dEdgeEast && pSumA.dEdgeWest >= pSumB.dEdgeEast ) ||
+		 ( pSumA.dEdgeEast <= pSumB.dEdgeWest && pSumA.dEdgeWest <= pSumB.dEdgeWest ) )
 	{
                 //pManager->log->writeLine("[DEBUG] Cannot link non-overlapping E/W.");
                 return false;
@@ -179,15 +208,34 @@ void	CDomainLink::pullFromBuffer(double dCurrentTime, COCLBuffer* pBuffer)
 #ifdef DEBUG_MPI
 				pManager->log->writeLine("[DEBUG] Should now be downloading data from buffer at time " + Util::secondsToTime(dCurrentTime));
 #endif
-				pBuffer->queueReadPartial(
-					this->linkDefs[i].ulOffsetSource,
-					this->linkDefs[i].ulSize,
-					this->linkDefs[i].vStateData
-				);
+				if ( pManager->getCellStateLayout() == model::cellStateLayout::kStructureOfArrays )
+				{
+					// One read per state variable plane
+					unsigned long ulPlaneSize = this->linkDefs[i].ulSize / 4;
+					for ( unsigned char ucPlane = 0; ucPlane < 4; ucPlane++ )
+					{
+						this->queueRead(
+							pBuffer,
+							&this->linkDefs[i],
+							this->linkDefs[i].ulOffsetSource + ucPlane * this->linkDefs[i].ulPlaneSource,
+							ulPlaneSize,
+							static_cast<char*>( this->linkDefs[i].vStateData ) + ucPlane * ulPlaneSize
+						);
+					}
+				} else {
+					this->queueRead(
+						pBuffer,
+						&this->linkDefs[i],
+						this->linkDefs[i].ulOffsetSource,
+						this->linkDefs[i].ulSize,
+						this->linkDefs[i].vStateData
+					);
+				}
 		}
 		
 		this->dValidityTime = dCurrentTime;
 		this->bSent = false;
+		this->bStagePending = true;
 		
 	} else {
 #ifdef DEBUG_MPI
@@ -205,7 +253,7 @@ bool	CDomainLink::sendOverMPI()
 		return true;
 
 #ifdef MPI_ON
-	if ( this->iTargetNodeID >= 0 )
+	if ( this->pMPIBuffer != NULL )
 	{
 		mpiSignalDataDomain pHeader;
 		
@@ -213,31 +261,12 @@ bool	CDomainLink::sendOverMPI()
 		pHeader.uiTargetDomainID = this->uiTargetDomainID;
 		pHeader.uiSourceDomainID = this->uiSourceDomainID;
 		pHeader.dValidityTime = this->dValidityTime;
-		pHeader.uiDataSize = 0;
+		pHeader.uiDataSize = this->uiMPIBufferSize - sizeof( mpiSignalDataDomain );
 		
-		for( unsigned int i = 0; i < this->linkDefs.size(); i++ )
-		{
-			pHeader.uiDataSize += this->linkDefs[i].ulSize;
-		}
-		
-		unsigned int uiSize = sizeof( mpiSignalDataDomain ) + pHeader.uiDataSize;
-		unsigned int uiOffset = sizeof( mpiSignalDataDomain ); 
-	
-		char* cSendBuffer = new char[ uiSize ];
-	
-		memcpy( &cSendBuffer[ 0 ], &pHeader, sizeof( mpiSignalDataDomain ) );
-		
-		for( unsigned int i = 0; i < this->linkDefs.size(); i++ )
-		{
-			memcpy(
-				&cSendBuffer[ uiOffset ],
-				this->linkDefs[i].vStateData,
-				this->linkDefs[i].ulSize
-			);
-			uiOffset += this->linkDefs[i].ulSize;
-		}
+		// The data was downloaded straight into the buffer behind the header
+		memcpy( this->pMPIBuffer, &pHeader, sizeof( mpiSignalDataDomain ) );
 	
-		pManager->getMPIManager()->sendDataDomainLink( this->iTargetNodeID, cSendBuffer, uiSize );
+		pManager->getMPIManager()->startLinkSend( this );
 	}
 #endif
 	
@@ -246,6 +275,17 @@ bool	CDomainLink::sendOverMPI()
 	return false;
 }
 
+/*
+ *	Data has arrived from another node in our MPI buffer
+ */
+void	CDomainLink::receiveFromMPI()
+{
+	mpiSignalDataDomain pHeader;
+	memcpy( &pHeader, this->pMPIBuffer, sizeof( mpiSignalDataDomain ) );
+
+	this->pullFromMPI( pHeader.dValidityTime, &this->pMPIBuffer[ sizeof( mpiSignalDataDomain ) ] );
+}
+
 /*
  *	Push data to a memory buffer
  */
@@ -256,17 +296,237 @@ void	CDomainLink::pushToBuffer(COCLBuffer* pBuffer)
 	// TODO: Remove this later...
 	if (this->dValidityTime < 0.0) return;
 
+	// Data already waiting on the device only needs copying into place
+	bool bStaged = ( this->pDeviceStaging != NULL && this->dStagedTime == this->dValidityTime );
+
 	for (unsigned int i = 0; i < this->linkDefs.size(); i++)
 	{
 #ifdef DEBUG_MPI
 		pManager->log->writeLine("[DEBUG] Should now be pushing data to buffer at time " + Util::secondsToTime(dValidityTime) + " (" + toString(this->linkDefs[i].ulSize) + " bytes)");
 #endif
-		pBuffer->queueWritePartial(
-			this->linkDefs[i].ulOffsetTarget,
-			this->linkDefs[i].ulSize,
-			this->linkDefs[i].vStateData
-		);
+		if ( pManager->getCellStateLayout() == model::cellStateLayout::kStructureOfArrays )
+		{
+			// One write per state variable plane
+			unsigned long ulPlaneSize = this->linkDefs[i].ulSize / 4;
+			for ( unsigned char ucPlane = 0; ucPlane < 4; ucPlane++ )
+			{
+				if ( bStaged )
+				{
+					this->queueCopy(
+						pBuffer,
+						&this->linkDefs[i],
+						this->linkDefs[i].ulStagingOffset + ucPlane * ulPlaneSize,
+						this->linkDefs[i].ulOffsetTarget + ucPlane * this->linkDefs[i].ulPlaneTarget,
+						ulPlaneSize
+					);
+					continue;
+				}
+				this->queueWrite(
+					pBuffer,
+					&this->linkDefs[i],
+					this->linkDefs[i].ulOffsetTarget + ucPlane * this->linkDefs[i].ulPlaneTarget,
+					ulPlaneSize,
+					static_cast<char*>( this->linkDefs[i].vStateData ) + ucPlane * ulPlaneSize
+				);
+			}
+		} else if ( bStaged ) {
+			this->queueCopy(
+				pBuffer,
+				&this->linkDefs[i],
+				this->linkDefs[i].ulStagingOffset,
+				this->linkDefs[i].ulOffsetTarget,
+				this->linkDefs[i].ulSize
+			);
+		} else {
+			this->queueWrite(
+				pBuffer,
+				&this->linkDefs[i],
+				this->linkDefs[i].ulOffsetTarget,
+				this->linkDefs[i].ulSize,
+				this->linkDefs[i].vStateData
+			);
+		}
+	}
+}
+
+/*
+ *	Read one plane of a definition from the source buffer, using a strided
+ *	read unless the rows are adjacent in memory
+ */
+void	CDomainLink::queueRead(COCLBuffer* pBuffer, LinkDefinition* pDefinition, unsigned long ulOffset, unsigned long ulSize, void* pData)
+{
+	if ( pDefinition->bContiguous )
+	{
+		pBuffer->queueReadPartial( ulOffset, ulSize, pData );
+	} else {
+		pBuffer->queueReadRect( ulOffset, pDefinition->ulRowSize, pDefinition->ulRows, pDefinition->ulPitchSource, pData );
+	}
+}
+
+/*
+ *	Write one plane of a definition to the target buffer, using a strided
+ *	write unless the rows are adjacent in memory
+ */
+void	CDomainLink::queueWrite(COCLBuffer* pBuffer, LinkDefinition* pDefinition, unsigned long ulOffset, unsigned long ulSize, void* pData)
+{
+	if ( pDefinition->bContiguous )
+	{
+		pBuffer->queueWritePartial( ulOffset, ulSize, pData );
+	} else {
+		pBuffer->queueWriteRect( ulOffset, pDefinition->ulRowSize, pDefinition->ulRows, pDefinition->ulPitchTarget, pData );
+	}
+}
+
+/*
+ *	Copy one plane of a definition from the device staging into the target
+ *	buffer, spreading the rows out to the target's pitch if need be
+ */
+void	CDomainLink::queueCopy(COCLBuffer* pBuffer, LinkDefinition* pDefinition, unsigned long ulStagingOffset, unsigned long ulOffset, unsigned long ulSize)
+{
+	if ( pDefinition->bContiguous )
+	{
+		this->pDeviceStaging->queueCopyTo( pBuffer, ulStagingOffset, ulOffset, ulSize );
+	} else {
+		this->pDeviceStaging->queueCopyRectTo( pBuffer, ulStagingOffset, ulOffset, pDefinition->ulRowSize, pDefinition->ulRows, pDefinition->ulPitchTarget );
+	}
+}
+
+/*
+ *	Once downloaded data has arrived in host memory, pass it straight on to
+ *	the target's device if the target is on this node. The upload then runs
+ *	while the target finishes its own batch, and at the sync point the data
+ *	only needs copying within the device. Called by the source domain's thread.
+ */
+void	CDomainLink::stageOnTarget()
+{
+	if ( !this->bStagePending || this->pDeviceStaging == NULL )
+		return;
+
+	this->pDeviceStaging->queueWritePartial( 0, this->ulStagingSize, this->pHostStaging->getHostBlock<void*>() );
+
+	// Copies queued by the target at the sync point must follow the upload
+	// even on an out-of-order queue
+	pManager->getDomainSet()->getDomain( this->uiTargetDomainID )->getDevice()->queueBarrier();
+	pManager->getDomainSet()->getDomain( this->uiTargetDomainID )->getDevice()->flush();
+
+	this->dStagedTime	= this->dValidityTime;
+	this->bStagePending	= false;
+}
+
+/*
+ *	Links between domains on the same node keep their data in one block of pinned
+ *	memory, so transfers in and out avoid an extra copy by the driver, and mirror
+ *	it in a buffer on the target's device. Devices each have their own context
+ *	so the data can't be copied between them directly.
+ */
+void	CDomainLink::createStaging(CDomainBase* pTarget, CDomainBase* pSource)
+{
+	if ( pTarget->isRemote() || pSource->isRemote() || this->linkDefs.empty() )
+		return;
+
+	CDomain* pDomainSrc = static_cast<CDomain*>( pSource );
+	CDomain* pDomainTgt = static_cast<CDomain*>( pTarget );
+
+	this->ulStagingSize = 0;
+	for (unsigned int i = 0; i < this->linkDefs.size(); i++)
+	{
+		this->linkDefs[i].ulStagingOffset = this->ulStagingSize;
+		this->ulStagingSize += this->linkDefs[i].ulSize;
+	}
+
+	std::string sName = "Link #" + toString( this->uiSourceDomainID + 1 ) + " to #" + toString( this->uiTargetDomainID + 1 );
+
+	this->pHostStaging = new COCLBuffer(
+		sName + " host",
+		pDomainSrc->getScheme()->getProgram(),
+		false,
+		false,
+		this->ulStagingSize,
+		false
+	);
+
+	if ( !this->pHostStaging->createPinnedBuffer() ||
+		 this->pHostStaging->getHostBlock<void*>() == NULL )
+	{
+		// Carry on with the separate blocks for each definition
+		delete this->pHostStaging;
+		this->pHostStaging = NULL;
+		return;
+	}
+
+	for (unsigned int i = 0; i < this->linkDefs.size(); i++)
+	{
+		delete[] this->linkDefs[i].vStateData;
+		this->linkDefs[i].vStateData = this->pHostStaging->getHostBlock<char*>() + this->linkDefs[i].ulStagingOffset;
+	}
+	this->bPackedStateData = true;
+
+	this->pDeviceStaging = new COCLBuffer(
+		sName,
+		pDomainTgt->getScheme()->getProgram(),
+		true,
+		false,
+		this->ulStagingSize,
+		false
+	);
+	this->pDeviceStaging->setProfiled( true );
+
+	if ( !this->pDeviceStaging->createBuffer() )
+	{
+		delete this->pDeviceStaging;
+		this->pDeviceStaging = NULL;
+	}
+}
+
+/*
+ *	Links between a domain on this node and one on another node exchange their data
+ *	through a fixed buffer with a persistent MPI request, so each sync only needs the
+ *	request starting. When sending, the definitions download straight into the buffer.
+ *	Both nodes generate the same definitions, so the sizes match.
+ */
+void	CDomainLink::createMPIExchange(CDomainBase* pTarget, CDomainBase* pSource)
+{
+#ifdef MPI_ON
+	bool bSend = ( pTarget->isRemote() && !pSource->isRemote() );
+	bool bRecv = ( !pTarget->isRemote() && pSource->isRemote() );
+
+	if ( ( !bSend && !bRecv ) || this->linkDefs.empty() )
+		return;
+
+	unsigned long ulDataSize = 0;
+	for (unsigned int i = 0; i < this->linkDefs.size(); i++)
+		ulDataSize += this->linkDefs[i].ulSize;
+
+	this->uiMPIBufferSize	= sizeof( mpiSignalDataDomain ) + ulDataSize;
+	this->pMPIBuffer		= new char[ this->uiMPIBufferSize ];
+
+	if ( bSend )
+	{
+		unsigned long ulOffset = sizeof( mpiSignalDataDomain );
+		for (unsigned int i = 0; i < this->linkDefs.size(); i++)
+		{
+			delete[] this->linkDefs[i].vStateData;
+			this->linkDefs[i].vStateData = &this->pMPIBuffer[ ulOffset ];
+			ulOffset += this->linkDefs[i].ulSize;
+		}
+		this->bPackedStateData = true;
 	}
+
+	// Each link between a pair of nodes needs its own tag
+	int iTag = static_cast<int>( this->uiSourceDomainID * pManager->getDomainSet()->getDomainCount() + this->uiTargetDomainID );
+
+	pManager->getMPIManager()->createLinkRequest(
+		this,
+		bSend,
+		( bSend ? pTarget->getSummary().uiNodeID : pSource->getSummary().uiNodeID ),
+		this->pMPIBuffer,
+		this->uiMPIBufferSize,
+		iTag
+	);
+#else
+	(void)pTarget;
+	(void)pSource;
+#endif
 }
 
 /*
@@ -281,102 +541,240 @@ bool	CDomainLink::isAtTime( double dCheckTime )
 }
 
 /*
- *	Identify all the areas of contiguous memory which overlap so we know what needs exchanging
+ *	Does a domain hold the cell at the given position on the target's grid?
+ */
+bool	CDomainLink::containsCell(LinkExtent* pExtent, long lX, long lY)
+{
+	return ( lX >= pExtent->lOffsetX && lX < pExtent->lOffsetX + pExtent->lCols &&
+			 lY >= pExtent->lOffsetY && lY < pExtent->lOffsetY + pExtent->lRows );
+}
+
+/*
+ *	How many cells lie between a cell and the nearest edge of a domain which
+ *	adjoins another domain. Cells further in are computed more reliably.
+ */
+long	CDomainLink::getCellDepth(LinkExtent* pExtent, long lX, long lY)
+{
+	long lDepth = pExtent->lCols + pExtent->lRows;
+	long lLocalX = lX - pExtent->lOffsetX;
+	long lLocalY = lY - pExtent->lOffsetY;
+
+	if ( pExtent->bInternal[0] ) lDepth = min( lDepth, pExtent->lRows - 1 - lLocalY );
+	if ( pExtent->bInternal[1] ) lDepth = min( lDepth, pExtent->lCols - 1 - lLocalX );
+	if ( pExtent->bInternal[2] ) lDepth = min( lDepth, lLocalY );
+	if ( pExtent->bInternal[3] ) lDepth = min( lDepth, lLocalX );
+
+	return lDepth;
+}
+
+/*
+ *	Identify the rectangular areas of memory which overlap so we know what needs exchanging.
+ *	Each cell in the overlap is owned by whichever domain holds it furthest from an internal
+ *	edge, and the target receives a cell from the source if the source owns it and holds it
+ *	more than two cells further in. Domains may be offset on either axis, and corner cells
+ *	are taken from the diagonal neighbour where it owns them.
  */
 void	CDomainLink::generateDefinitions(CDomainBase* pTarget, CDomainBase *pSource)
 {
 	CDomainBase::DomainSummary pSumTgt = pTarget->getSummary();
 	CDomainBase::DomainSummary pSumSrc = pSource->getSummary();
+	CDomainManager* pDomains = pManager->getDomainSet();
 
 	// Get the size of our cell state vector
 	unsigned char ucStateVectorSize = (pSumTgt.ucFloatPrecision == model::floatPrecision::kSingle ?
 		sizeof(cl_float4) : sizeof(cl_double4)
 	);
 
-	// Fetch the high and low for the overlap
-	double dSyncZoneSouth = max( pSumTgt.dEdgeSouth, pSumSrc.dEdgeSouth );
-	double dSyncZoneNorth = min( pSumTgt.dEdgeNorth, pSumSrc.dEdgeNorth );
+	// Place every domain on the target's grid, with the target's south-west cell at the origin
+	std::vector<LinkExtent> vExtents;
+	unsigned int uiExtentTgt = 0, uiExtentSrc = 0;
 
-	// Calculate how large in rows the overlap is
-	unsigned int uiOverlapRowCount = static_cast<unsigned int>(
-		floor( ( dSyncZoneNorth - dSyncZoneSouth )/2.0 / pSumTgt.dResolution ) - 1.0 
-	);
-	unsigned int uiOverlapRowOffset = static_cast<unsigned int>(
-		ceil( (dSyncZoneNorth - dSyncZoneSouth) / pSumTgt.dResolution)
-	);
+	for (unsigned int i = 0; i < pDomains->getDomainCount(); i++)
+	{
+		CDomainBase::DomainSummary pSum = pDomains->getDomainBase(i)->getSummary();
+		LinkExtent pExtent;
+
+		pExtent.lOffsetX	= static_cast<long>( floor( ( pSum.dEdgeWest - pSumTgt.dEdgeWest ) / pSumTgt.dResolution + 0.5 ) );
+		pExtent.lOffsetY	= static_cast<long>( floor( ( pSum.dEdgeSouth - pSumTgt.dEdgeSouth ) / pSumTgt.dResolution + 0.5 ) );
+		pExtent.lCols		= static_cast<long>( pSum.ulColCount );
+		pExtent.lRows		= static_cast<long>( pSum.ulRowCount );
+		pExtent.uiDomainID	= pSum.uiDomainID;
 
-	// Smallest overlap is the size of our overlap, which is used to constrain
-	// how many iterations can be run before sync.
-	uiSmallestOverlap = uiOverlapRowCount;
+		if ( pSum.uiDomainID == pSumTgt.uiDomainID ) uiExtentTgt = i;
+		if ( pSum.uiDomainID == pSumSrc.uiDomainID ) uiExtentSrc = i;
+
+		vExtents.push_back( pExtent );
+	}
 
-	// Calculate the start and end rows in the source and targets
-	unsigned long ulRowBaseTgt, ulRowHighTgt;
-	unsigned long ulRowBaseSrc, ulRowHighSrc;
-	if ( dSyncZoneSouth == pSumSrc.dEdgeSouth )
+	// An edge is internal if another domain continues beyond it
+	for (unsigned int i = 0; i < vExtents.size(); i++)
 	{
-		// The source domain is above this domain
-		ulRowHighTgt = pSumTgt.ulRowCount - 1;
-		ulRowBaseTgt = ulRowHighTgt - uiOverlapRowCount + 1;
-		ulRowBaseSrc = uiOverlapRowOffset - uiOverlapRowCount;
-		ulRowHighSrc = ulRowBaseSrc + uiOverlapRowCount - 1;
-	} else {
-		// The source domain is below this one
-		ulRowBaseTgt = 0;
-		ulRowHighTgt = uiOverlapRowCount - 1;
-		ulRowHighSrc = pSumSrc.ulRowCount - 1 - uiOverlapRowOffset + uiOverlapRowCount;
-		ulRowBaseSrc = ulRowHighSrc - uiOverlapRowCount + 1;
+		LinkExtent* pA = &vExtents[i];
+		pA->bInternal[0] = pA->bInternal[1] = pA->bInternal[2] = pA->bInternal[3] = false;
+
+		for (unsigned int j = 0; j < vExtents.size(); j++)
+		{
+			if ( i == j ) continue;
+			LinkExtent* pB = &vExtents[j];
+
+			bool bSpanX = ( pB->lOffsetX < pA->lOffsetX + pA->lCols && pB->lOffsetX + pB->lCols > pA->lOffsetX );
+			bool bSpanY = ( pB->lOffsetY < pA->lOffsetY + pA->lRows && pB->lOffsetY + pB->lRows > pA->lOffsetY );
+
+			if ( bSpanX && pB->lOffsetY + pB->lRows > pA->lOffsetY + pA->lRows && pB->lOffsetY < pA->lOffsetY + pA->lRows )
+				pA->bInternal[0] = true;
+			if ( bSpanY && pB->lOffsetX + pB->lCols > pA->lOffsetX + pA->lCols && pB->lOffsetX < pA->lOffsetX + pA->lCols )
+				pA->bInternal[1] = true;
+			if ( bSpanX && pB->lOffsetY < pA->lOffsetY && pB->lOffsetY + pB->lRows > pA->lOffsetY )
+				pA->bInternal[2] = true;
+			if ( bSpanY && pB->lOffsetX < pA->lOffsetX && pB->lOffsetX + pB->lCols > pA->lOffsetX )
+				pA->bInternal[3] = true;
+		}
 	}
 
+	LinkExtent* pExtTgt = &vExtents[ uiExtentTgt ];
+	LinkExtent* pExtSrc = &vExtents[ uiExtentSrc ];
+
+	// Fetch the cells which overlap, on the target's grid
+	long lOverlapX0 = max( 0L, pExtSrc->lOffsetX );
+	long lOverlapX1 = min( pExtTgt->lCols, pExtSrc->lOffsetX + pExtSrc->lCols );
+	long lOverlapY0 = max( 0L, pExtSrc->lOffsetY );
+	long lOverlapY1 = min( pExtTgt->lRows, pExtSrc->lOffsetY + pExtSrc->lRows );
+
 	// Do not proceed if there is no overlap identified that we can work with
-	if (ulRowHighTgt - ulRowBaseTgt < 1)
+	if ( lOverlapX1 <= lOverlapX0 || lOverlapY1 <= lOverlapY0 )
 		return;
 
-	// Calculate the low and high columns to use in sync
-	// TODO: For now assuming perfect overlaps...
+	// Smallest overlap is half the width of the overlap on the axes where the domains
+	// are offset, which is used to constrain how many iterations can be run before sync.
+	long lOverlapCols = lOverlapX1 - lOverlapX0;
+	long lOverlapRows = lOverlapY1 - lOverlapY0;
+	bool bOffsetX = ( lOverlapCols < min( pExtTgt->lCols, pExtSrc->lCols ) );
+	bool bOffsetY = ( lOverlapRows < min( pExtTgt->lRows, pExtSrc->lRows ) );
+	long lSmallestOverlap = min( lOverlapCols, lOverlapRows ) / 2 - 1;
+
+	if ( bOffsetX && !bOffsetY ) lSmallestOverlap = lOverlapCols / 2 - 1;
+	if ( bOffsetY && !bOffsetX ) lSmallestOverlap = lOverlapRows / 2 - 1;
 
-	// Create definitions; preferably contiguous...
-	LinkDefinition pDefinition;
-	pDefinition.ulSize = 0;
+	uiSmallestOverlap = static_cast<unsigned int>( max( 0L, lSmallestOverlap ) );
 
-	for (unsigned int i = 0; i <= ulRowHighTgt - ulRowBaseTgt; i++)
+	// Find runs of cells to receive in each row, and extend the blocks from the row
+	// below where the columns match so we end up with as few rectangles as possible
+	struct LinkBlock
 	{
-		// Can we extend the last?
-		if ( pDefinition.ulSize > 0 && pTarget->getCellID(0, ulRowBaseTgt + i) == pDefinition.ulTargetEndCellID + 1 )
+		long lX0, lX1, lY0, lY1;
+	};
+	std::vector<LinkBlock> vBlocks, vOpen;
+
+	for (long lY = lOverlapY0; lY < lOverlapY1; lY++)
+	{
+		std::vector<LinkBlock> vRow, vStillOpen;
+		long lRunStart = -1;
+
+		for (long lX = lOverlapX0; lX <= lOverlapX1; lX++)
 		{
-			pDefinition.ulSourceEndCellID = pSource->getCellID(pSumSrc.ulColCount - 1, ulRowBaseSrc + i);
-			pDefinition.ulTargetEndCellID = pTarget->getCellID(pSumTgt.ulColCount - 1, ulRowBaseTgt + i);
-			
-		} else {
-			// Need a new definition... deal with the last one
-			if (pDefinition.ulSize > 0)
-				linkDefs.push_back(pDefinition);
+			bool bReceive = false;
+
+			if ( lX < lOverlapX1 )
+			{
+				long lDepthTgt = getCellDepth( pExtTgt, lX, lY );
+				long lDepthSrc = getCellDepth( pExtSrc, lX, lY );
+
+				bReceive = ( lDepthSrc - lDepthTgt > 2 );
+
+				// The source must also be the owner of the cell
+				for (unsigned int i = 0; i < vExtents.size() && bReceive; i++)
+				{
+					if ( i == uiExtentSrc || !containsCell( &vExtents[i], lX, lY ) )
+						continue;
+
+					long lDepth = getCellDepth( &vExtents[i], lX, lY );
+					if ( lDepth > lDepthSrc ||
+						 ( lDepth == lDepthSrc && vExtents[i].uiDomainID < pExtSrc->uiDomainID ) )
+						bReceive = false;
+				}
+			}
+
+			if ( bReceive && lRunStart < 0 )
+				lRunStart = lX;
+
+			if ( !bReceive && lRunStart >= 0 )
+			{
+				LinkBlock pRun = { lRunStart, lX - 1, lY, lY };
+				vRow.push_back( pRun );
+				lRunStart = -1;
+			}
+		}
 
-			pDefinition.ulSourceStartCellID  = pSource->getCellID( 0, ulRowBaseSrc + i );
-			pDefinition.ulSourceEndCellID	 = pSource->getCellID( pSumSrc.ulColCount - 1, ulRowBaseSrc + i );
-			pDefinition.ulTargetStartCellID  = pTarget->getCellID( 0, ulRowBaseTgt + i );
-			pDefinition.ulTargetEndCellID	 = pTarget->getCellID( pSumTgt.ulColCount - 1, ulRowBaseTgt + i );
+		for (unsigned int i = 0; i < vRow.size(); i++)
+		{
+			bool bExtended = false;
+
+			for (unsigned int j = 0; j < vOpen.size() && !bExtended; j++)
+			{
+				if ( vOpen[j].lY0 >= 0 && vOpen[j].lX0 == vRow[i].lX0 && vOpen[j].lX1 == vRow[i].lX1 )
+				{
+					vOpen[j].lY1 = lY;
+					vStillOpen.push_back( vOpen[j] );
+					vOpen[j].lY0 = -1;
+					bExtended = true;
+				}
+			}
+
+			if ( !bExtended )
+				vStillOpen.push_back( vRow[i] );
+		}
 
-			pDefinition.vStateData = NULL;
+		for (unsigned int j = 0; j < vOpen.size(); j++)
+		{
+			if ( vOpen[j].lY0 >= 0 )
+				vBlocks.push_back( vOpen[j] );
 		}
 
-		pDefinition.ulSize = (pDefinition.ulSourceEndCellID - pDefinition.ulSourceStartCellID + 1) * ucStateVectorSize;
+		vOpen = vStillOpen;
 	}
 
-	// Store and allocate
-	if ( pDefinition.ulSize > 0 )
-		linkDefs.push_back( pDefinition );
+	vBlocks.insert( vBlocks.end(), vOpen.begin(), vOpen.end() );
+
+	// With separate planes for each state variable, offsets are to the first
+	// plane and the others follow at intervals of the domain's cell count
+	bool bPlanar = ( pManager->getCellStateLayout() == model::cellStateLayout::kStructureOfArrays );
+	bool bSingle = ( pSumTgt.ucFloatPrecision == model::floatPrecision::kSingle );
+	unsigned long ulElementSize = ( bSingle ?
+		( bPlanar ? sizeof(cl_float) : sizeof(cl_float4) ) :
+		( bPlanar ? sizeof(cl_double) : sizeof(cl_double4) ) );
 
-	for (unsigned int i = 0; i < linkDefs.size(); i++)
+	for (unsigned int i = 0; i < vBlocks.size(); i++)
 	{
-		if ( pSumTgt.ucFloatPrecision == model::floatPrecision::kSingle )
+		LinkDefinition pDefinition;
+		unsigned long ulCols = vBlocks[i].lX1 - vBlocks[i].lX0 + 1;
+		unsigned long ulRows = vBlocks[i].lY1 - vBlocks[i].lY0 + 1;
+
+		pDefinition.ulTargetStartCellID	= pTarget->getCellID( vBlocks[i].lX0, vBlocks[i].lY0 );
+		pDefinition.ulTargetEndCellID	= pTarget->getCellID( vBlocks[i].lX1, vBlocks[i].lY1 );
+		pDefinition.ulSourceStartCellID	= pSource->getCellID( vBlocks[i].lX0 - pExtSrc->lOffsetX, vBlocks[i].lY0 - pExtSrc->lOffsetY );
+		pDefinition.ulSourceEndCellID	= pSource->getCellID( vBlocks[i].lX1 - pExtSrc->lOffsetX, vBlocks[i].lY1 - pExtSrc->lOffsetY );
+
+		pDefinition.ulSize			= ulCols * ulRows * ucStateVectorSize;
+		pDefinition.ulRows			= ulRows;
+		pDefinition.ulRowSize		= ulCols * ulElementSize;
+		pDefinition.ulPitchSource	= pSumSrc.ulColCount * ulElementSize;
+		pDefinition.ulPitchTarget	= pSumTgt.ulColCount * ulElementSize;
+		pDefinition.ulOffsetSource	= pDefinition.ulSourceStartCellID * ulElementSize;
+		pDefinition.ulOffsetTarget	= pDefinition.ulTargetStartCellID * ulElementSize;
+		pDefinition.ulPlaneSource	= pSumSrc.ulRowCount * pSumSrc.ulColCount * ( bSingle ? sizeof(cl_float) : sizeof(cl_double) );
+		pDefinition.ulPlaneTarget	= pSumTgt.ulRowCount * pSumTgt.ulColCount * ( bSingle ? sizeof(cl_float) : sizeof(cl_double) );
+		pDefinition.ulStagingOffset	= 0;
+
+		// Rows are adjacent in memory on both sides if the block spans both domains
+		pDefinition.bContiguous		= ( ulRows == 1 || ( ulCols == pSumSrc.ulColCount && ulCols == pSumTgt.ulColCount ) );
+
+		if ( bSingle )
 		{
-			linkDefs[i].vStateData  = new cl_float4[ linkDefs[i].ulSourceEndCellID - linkDefs[i].ulSourceStartCellID + 1 ];
-			linkDefs[i].ulOffsetSource = linkDefs[i].ulSourceStartCellID * sizeof(cl_float4);
-			linkDefs[i].ulOffsetTarget = linkDefs[i].ulTargetStartCellID * sizeof(cl_float4);
+			pDefinition.vStateData = new cl_float4[ ulCols * ulRows ];
 		} else {
-			linkDefs[i].vStateData = new cl_double4[linkDefs[i].ulSourceEndCellID - linkDefs[i].ulSourceStartCellID + 1 ];
-			linkDefs[i].ulOffsetSource = linkDefs[i].ulSourceStartCellID * sizeof(cl_double4);
-			linkDefs[i].ulOffsetTarget = linkDefs[i].ulTargetStartCellID * sizeof(cl_double4);
+			pDefinition.vStateData = new cl_double4[ ulCols * ulRows ];
 		}
+
+		linkDefs.push_back( pDefinition );
 	}
 }
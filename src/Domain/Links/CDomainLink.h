@@ -56,12 +56,15 @@ class CDomainLink
 		void				pullFromBuffer(double, COCLBuffer*);									// Download data from a memory buffer
 		void				pushToBuffer(COCLBuffer*);												// Push data to memory buffer
 		unsigned int		getSmallestOverlap()					{ return uiSmallestOverlap;  }	// Get the smallest overlap size
+		bool				hasDefinitions()						{ return !linkDefs.empty(); }	// Is there any data to exchange?
 		void				markInvalid()							{ dValidityTime = -1.0;  }		// Mark the data as invalid
 		bool				isAtTime( double );														// Is this link at the given time?
 		unsigned int		getSourceDomainID()						{ return uiSourceDomainID; }	// Fetch the source domain ID number
 		unsigned int		getTargetDomainID()						{ return uiTargetDomainID; }	// Fetch the target domain ID number
 		void				pullFromMPI(double, char*);												// Fetch data received via MPI
 		bool				sendOverMPI();															// Send this domain data over MPI if needed
+		void				receiveFromMPI();														// Handle data arriving in the MPI buffer
+		void				stageOnTarget();														// Upload downloaded data to a target on this node
 
 	protected:
 
@@ -79,9 +82,27 @@ class CDomainLink
 			unsigned long ulSize;
 			unsigned long ulOffsetSource;
 			unsigned long ulOffsetTarget;
+			unsigned long ulPlaneSource;
+			unsigned long ulPlaneTarget;
+			unsigned long ulRows;
+			unsigned long ulRowSize;
+			unsigned long ulPitchSource;
+			unsigned long ulPitchTarget;
+			unsigned long ulStagingOffset;
+			bool		  bContiguous;
 			void*		  vStateData;
 		};
 
+		struct LinkExtent
+		{
+			long			lOffsetX;																// Column of the west edge relative to the target
+			long			lOffsetY;																// Row of the south edge relative to the target
+			long			lCols;
+			long			lRows;
+			unsigned int	uiDomainID;
+			bool			bInternal[4];															// Do the N, E, S, W edges adjoin another domain?
+		};
+
 		// Private variables
 		std::vector<LinkDefinition>		linkDefs;
 		unsigned int					uiSourceDomainID;
@@ -90,9 +111,24 @@ class CDomainLink
 		unsigned int					uiSmallestOverlap;
 		double							dValidityTime;
 		bool							bSent;
+		COCLBuffer*						pHostStaging;												// Pinned host memory holding every definition
+		COCLBuffer*						pDeviceStaging;												// Copy of the host staging on the target's device
+		unsigned long					ulStagingSize;												// Bytes of data across every definition
+		double							dStagedTime;												// Time of the data held on the target's device
+		bool							bStagePending;												// Has data been downloaded but not yet staged?
+		char*							pMPIBuffer;													// Header and data exchanged with another node
+		unsigned int					uiMPIBufferSize;											// Size of the MPI buffer in bytes
+		bool							bPackedStateData;											// Do the definitions share one block of memory?
 
 		// Private functions
-		void				generateDefinitions(CDomainBase*, CDomainBase*);						// Identify contiguous memory areas for exchange
+		void				generateDefinitions(CDomainBase*, CDomainBase*);						// Identify rectangular memory areas for exchange
+		void				createStaging(CDomainBase*, CDomainBase*);								// Allocate pinned and device staging for same-node links
+		void				createMPIExchange(CDomainBase*, CDomainBase*);							// Set up persistent MPI requests for links between nodes
+		void				queueRead(COCLBuffer*, LinkDefinition*, unsigned long, unsigned long, void*);	// Read one plane of a definition
+		void				queueWrite(COCLBuffer*, LinkDefinition*, unsigned long, unsigned long, void*);	// Write one plane of a definition
+		void				queueCopy(COCLBuffer*, LinkDefinition*, unsigned long, unsigned long, unsigned long);	// Copy one plane of a definition from the staging
+		static bool			containsCell(LinkExtent*, long, long);									// Does a domain hold a cell?
+		static long			getCellDepth(LinkExtent*, long, long);									// Distance from a cell to the nearest internal edge
 };
 
 #endif
@@ -56,6 +56,11 @@ CMPIManager::CMPIManager()
 	this->dCollective_ReductionInput = 0.0;
 	this->dCollective_ReductionLastTime = -1.0;
 
+	// Link data travels on its own communicator so it can never be picked up
+	// by the probe for other messages
+	this->uiLinkSendsActive = 0;
+	MPI_Comm_dup( MPI_COMM_WORLD, &this->commLinks );
+
 #ifdef PLATFORM_WIN
 	HANDLE hThread = CreateThread(
 		NULL,
@@ -81,10 +86,24 @@ CMPIManager::CMPIManager()
 CMPIManager::~CMPIManager()
 {
 	this->bCollectiveThreadRun = false;
+	this->releaseLinkCommunicator();
 	delete [] this->pNodes;
 	delete [] this->pRecvBuffer;
 }
 
+/*
+ *  Free the communicator duplicated for link data. The link requests must
+ *  be released first, so this is called once the domains are gone.
+ */
+void CMPIManager::releaseLinkCommunicator()
+{
+	int iFinalised = 0;
+	MPI_Finalized( &iFinalised );
+
+	if ( !iFinalised && this->commLinks != MPI_COMM_NULL )
+		MPI_Comm_free( &this->commLinks );
+}
+
 /*
  *  Spit out some details
  */
@@ -550,49 +569,157 @@ void CMPIManager::receiveDataSimulation( char* cData )
 }
 
 /*
- *  Send domain link data
+ *  Set up a persistent send or receive for a link to or from a domain on another
+ *  node. The buffer is owned by the link and holds the header and the data, so
+ *  nothing is allocated or copied by the manager for each exchange. Receives are
+ *  started straight away and restarted each time one completes.
  */
-bool CMPIManager::sendDataDomainLink( int iTargetNodeID, char* pData, unsigned int uiSize )
+void CMPIManager::createLinkRequest( CDomainLink* pLink, bool bSend, int iNodeID, char* pBuffer, unsigned int uiSize, int iTag )
 {
 	MPI_Request pRequest;
-	
-	wrapError(
-		MPI_Isend(
-			pData,
-			uiSize,
-			MPI_BYTE,
-			iTargetNodeID,
-			model::mpiSignalCodes::kSignalDomainData,
-			MPI_COMM_WORLD,
-			&pRequest
-		)
-	);
-	
-	this->sendOps.push_back( mpiSendOp( pRequest, iTargetNodeID, pData ) );
-	
-	return true;
+
+	if ( bSend )
+	{
+		wrapError(
+			MPI_Send_init(
+				pBuffer,
+				uiSize,
+				MPI_BYTE,
+				iNodeID,
+				iTag,
+				this->commLinks,
+				&pRequest
+			)
+		);
+
+		this->vLinkSendRequests.push_back( pRequest );
+		this->vLinkSendLinks.push_back( pLink );
+	} else {
+		wrapError(
+			MPI_Recv_init(
+				pBuffer,
+				uiSize,
+				MPI_BYTE,
+				iNodeID,
+				iTag,
+				this->commLinks,
+				&pRequest
+			)
+		);
+
+		this->vLinkRecvRequests.push_back( pRequest );
+		this->vLinkRecvLinks.push_back( pLink );
+		this->vLinkRecvCompleted.resize( this->vLinkRecvRequests.size() );
+
+		wrapError( MPI_Start( &this->vLinkRecvRequests.back() ) );
+	}
 }
 
 /*
- *  Receive domain link data
+ *  Start the persistent send for a link, once its buffer holds the latest data
  */
-void CMPIManager::receiveDataDomainLink( char* cData )
+void CMPIManager::startLinkSend( CDomainLink* pLink )
 {
-	CDomainLink::mpiSignalDataDomain pHeader;
-	std::memcpy( &pHeader, &cData[0], sizeof( CDomainLink::mpiSignalDataDomain ) );
+	for( unsigned int i = 0; i < this->vLinkSendLinks.size(); i++ )
+	{
+		if ( this->vLinkSendLinks[i] != pLink )
+			continue;
 
-	CDomainLink*	pTargetLink = pManager->getDomainSet()->getDomainBase( pHeader.uiTargetDomainID )->getLinkFrom( pHeader.uiSourceDomainID );
-	
-	if ( pTargetLink == NULL )
+		wrapError( MPI_Start( &this->vLinkSendRequests[i] ) );
+		this->uiLinkSendsActive++;
+		return;
+	}
+}
+
+/*
+ *  Free the persistent requests for a link which is being deleted
+ */
+void CMPIManager::releaseLinkRequests( CDomainLink* pLink )
+{
+	int iFinalised = 0;
+	MPI_Finalized( &iFinalised );
+
+	for( int i = this->vLinkSendLinks.size() - 1; i >= 0; i-- )
 	{
-		model::doError(
-			"Received domain data for a link doesn't seem to exist.",
-			model::errorCodes::kLevelModelStop
+		if ( this->vLinkSendLinks[i] != pLink )
+			continue;
+
+		if ( !iFinalised )
+		{
+			MPI_Wait( &this->vLinkSendRequests[i], MPI_STATUS_IGNORE );
+			MPI_Request_free( &this->vLinkSendRequests[i] );
+		}
+		this->vLinkSendRequests.erase( this->vLinkSendRequests.begin() + i );
+		this->vLinkSendLinks.erase( this->vLinkSendLinks.begin() + i );
+	}
+
+	for( int i = this->vLinkRecvLinks.size() - 1; i >= 0; i-- )
+	{
+		if ( this->vLinkRecvLinks[i] != pLink )
+			continue;
+
+		if ( !iFinalised )
+		{
+			MPI_Cancel( &this->vLinkRecvRequests[i] );
+			MPI_Wait( &this->vLinkRecvRequests[i], MPI_STATUS_IGNORE );
+			MPI_Request_free( &this->vLinkRecvRequests[i] );
+		}
+		this->vLinkRecvRequests.erase( this->vLinkRecvRequests.begin() + i );
+		this->vLinkRecvLinks.erase( this->vLinkRecvLinks.begin() + i );
+	}
+
+	this->vLinkRecvCompleted.resize( this->vLinkRecvRequests.size() );
+}
+
+/*
+ *  Complete the link sends together, and hand any link data received
+ *  over to the links before listening for the next
+ */
+void CMPIManager::processLinkRequests()
+{
+	int iFlag = 0;
+
+	// Inactive requests count as complete, so every send can be tested at once
+	if ( this->uiLinkSendsActive > 0 )
+	{
+		wrapError( 
+			MPI_Testall(
+				this->vLinkSendRequests.size(),
+				&this->vLinkSendRequests[0],
+				&iFlag,
+				MPI_STATUSES_IGNORE
+			)
 		);
+
+		if ( iFlag )
+			this->uiLinkSendsActive = 0;
+	}
+
+	if ( this->vLinkRecvRequests.empty() )
+		return;
+
+	int iCompleted = 0;
+
+	wrapError( 
+		MPI_Testsome(
+			this->vLinkRecvRequests.size(),
+			&this->vLinkRecvRequests[0],
+			&iCompleted,
+			&this->vLinkRecvCompleted[0],
+			MPI_STATUSES_IGNORE
+		)
+	);
+
+	if ( iCompleted == MPI_UNDEFINED )
 		return;
+
+	for( int i = 0; i < iCompleted; i++ )
+	{
+		unsigned int uiIndex = this->vLinkRecvCompleted[i];
+
+		this->vLinkRecvLinks[ uiIndex ]->receiveFromMPI();
+		wrapError( MPI_Start( &this->vLinkRecvRequests[ uiIndex ] ) );
 	}
-	
-	pTargetLink->pullFromMPI( pHeader.dValidityTime, &cData[ sizeof( CDomainLink::mpiSignalDataDomain ) ] );
 }
 
 /*
@@ -607,6 +734,8 @@ void CMPIManager::processQueue()
 	
 	if ( this->iNodeCount <= 1 )
 		return;
+
+	this->processLinkRequests();
 		
 	// Pending send operation has completed?
 	if ( this->sendOps.size() > 0 )
@@ -727,9 +856,6 @@ void CMPIManager::processIncoming( int iTag )
 		case model::mpiSignalCodes::kSignalProgress:
 			this->receiveDataSimulation( this->pRecvBuffer );
 			break;
-		case model::mpiSignalCodes::kSignalDomainData:
-			this->receiveDataDomainLink( this->pRecvBuffer );
-			break;
 		default:
 			pManager->log->writeLine("[DEBUG] Received a new MPI signal (="+toString( iMessageCode )+") which hasn't been processed...");
 			break;
@@ -37,6 +37,7 @@ namespace model {
 
 class CMPINode;
 class CXMLDataset;
+class CDomainLink;
 class CMPIManager
 {
 public:
@@ -50,14 +51,16 @@ public:
 	CMPINode*				getNode()								{ return pNodes[iNodeID]; };
 	CMPINode*				getNode(int i)							{ return pNodes[i]; };
 	bool					isMaster()								{ return ( iNodeID == 0 ); };
-	bool					isWaitingOnTransmission()				{ return ( sendOps.size() > 0 ); };
+	bool					isWaitingOnTransmission()				{ return ( sendOps.size() > 0 || uiLinkSendsActive > 0 ); };
 	bool					exchangeConfiguration( CXMLDataset*& );
 	bool					exchangeDevices();
 	bool					exchangeDomains();
 	bool					sendDataSimulation();
 	void					receiveDataSimulation( char* );
-	bool					sendDataDomainLink( int, char*, unsigned int );
-	void					receiveDataDomainLink( char* );
+	void					createLinkRequest( CDomainLink*, bool, int, char*, unsigned int, int );
+	void					startLinkSend( CDomainLink* );
+	void					releaseLinkRequests( CDomainLink* );
+	void					releaseLinkCommunicator();
 	bool					sendStatus();
 	bool					reduceTimeData( double, double*, double, bool = false );
 	bool					isWaitingOnBlock()						{ return iNodeCount > 1 && ( bCollective_Hold | bCollective_Barrier | bCollective_Reduction ); };
@@ -99,12 +102,20 @@ private:
 	};
 
 	void					wrapError( int );
+	void					processLinkRequests();
 	int						iNodeID;
 	int						iNodeCount;
 	CMPINode**				pNodes;
 	MPI_Request				pRecvReq;
 	bool					bReceiving;
 	std::vector<mpiSendOp>	sendOps;
+	MPI_Comm				commLinks;										// Communicator reserved for domain link data
+	std::vector<MPI_Request>	vLinkSendRequests;							// Persistent sends for each link to another node
+	std::vector<CDomainLink*>	vLinkSendLinks;								// Links matching each persistent send
+	std::vector<MPI_Request>	vLinkRecvRequests;							// Persistent receives for each link from another node
+	std::vector<CDomainLink*>	vLinkRecvLinks;								// Links matching each persistent receive
+	std::vector<int>			vLinkRecvCompleted;							// Indices of receives completed in a single test
+	unsigned int			uiLinkSendsActive;								// Persistent sends started but not yet completed
 	char*					pRecvBuffer;
 	unsigned int			uiRecvBufferSize;
 	bool					bCollectiveThreadRun;
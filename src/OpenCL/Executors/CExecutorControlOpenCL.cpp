@@ -25,6 +25,7 @@
 #include "../../Datasets/CXMLDataset.h"
 #include <vector>
 #include <boost/lexical_cast.hpp>
+#include <boost/filesystem.hpp>
 
 /*
  *  Constructor
@@ -33,6 +34,9 @@ CExecutorControlOpenCL::CExecutorControlOpenCL(void)
 {
 	this->clDeviceTotal = 0;
 	this->uiSelectedDeviceID = NULL;
+	this->sBinaryCacheDir = "";
+	this->bProfilingEnabled = false;
+	this->uiSubDevices = 1;
 
 	if ( !this->getPlatforms() ) return;
 
@@ -66,6 +70,37 @@ void CExecutorControlOpenCL::setupFromConfig( XMLElement* pXNode )
 			if ( strstr( cParameterValue, "apu" ) != NULL )	
 				uiDeviceFilter |= model::filters::devices::devicesAPU;
 		}
+		else if ( strcmp( cParameterName, "binarycache" ) == 0 )
+		{
+			// Directory names may be case sensitive, so use the raw attribute
+			if ( strcmp( cParameterValue, "off" ) == 0 ||
+				 strcmp( cParameterValue, "no" ) == 0 ||
+				 strcmp( cParameterValue, "" ) == 0 )
+			{
+				this->sBinaryCacheDir = "";
+			} else {
+				this->sBinaryCacheDir = std::string( pParameter->Attribute( "value" ) );
+				if ( this->sBinaryCacheDir.back() != '/' && this->sBinaryCacheDir.back() != '\\' )
+					this->sBinaryCacheDir += "/";
+			}
+		}
+		else if ( strcmp( cParameterName, "profiling" ) == 0 )
+		{
+			this->bProfilingEnabled = ( strcmp( cParameterValue, "yes" ) == 0 );
+		}
+		else if ( strcmp( cParameterName, "subdevices" ) == 0 )
+		{
+			if ( CXMLDataset::isValidUnsignedInt( std::string( cParameterValue ) ) &&
+				 boost::lexical_cast<unsigned int>( cParameterValue ) >= 1 )
+			{
+				this->uiSubDevices = boost::lexical_cast<unsigned int>( cParameterValue );
+			} else {
+				model::doError(
+					"Invalid number of sub-devices given.",
+					model::errorCodes::kLevelWarning
+				);
+			}
+		}
 		else 
 		{
 			model::doError(
@@ -77,6 +112,22 @@ void CExecutorControlOpenCL::setupFromConfig( XMLElement* pXNode )
 		pParameter = pParameter->NextSiblingElement();
 	}
 
+	if ( this->isBinaryCacheEnabled() )
+	{
+		try {
+			boost::filesystem::create_directories( boost::filesystem::path( this->sBinaryCacheDir ) );
+			pManager->log->writeLine( "Compiled programs will be cached in " + this->sBinaryCacheDir );
+		}
+		catch ( boost::filesystem::filesystem_error )
+		{
+			model::doError(
+				"Could not create the program binary cache directory. Caching is disabled.",
+				model::errorCodes::kLevelWarning
+			);
+			this->sBinaryCacheDir = "";
+		}
+	}
+
 	this->setDeviceFilter( uiDeviceFilter );
 	if ( !this->createDevices() ) return;
 }
@@ -243,7 +294,8 @@ bool CExecutorControlOpenCL::createDevices(void)
 			pDevice = new COCLDevice(
 				clDevice[ iDeviceID ],
 				iPlatformID,
-				uiDeviceCount
+				uiDeviceCount,
+				this->bProfilingEnabled
 			);
 
 			if ( pDevice->isReady() )		
@@ -255,6 +307,14 @@ bool CExecutorControlOpenCL::createDevices(void)
 					pDevice->clDeviceType == CL_DEVICE_TYPE_ACCELERATOR && ( ( this->deviceFilter & model::filters::devices::devicesAPU ) == model::filters::devices::devicesAPU )
 				   )
 				{
+					// CPUs can be split into several devices, each taking its share of the cores
+					if ( pDevice->clDeviceType == CL_DEVICE_TYPE_CPU && this->uiSubDevices > 1 &&
+						 this->createSubDevices( pDevice, iPlatformID, &pDevices, &uiDeviceCount ) )
+					{
+						delete pDevice;
+						continue;
+					}
+
 					pDevices.push_back( pDevice );
 					uiDeviceCount++;
 					pDevice->logDevice();
@@ -280,6 +340,76 @@ bool CExecutorControlOpenCL::createDevices(void)
 	return true;
 }
 
+/*
+ *  Split a CPU into the requested number of sub-devices using device fission,
+ *  sharing the compute units between them as evenly as possible. Each one is
+ *  added in place of the CPU, so domains can be given a sub-device each.
+ */
+bool CExecutorControlOpenCL::createSubDevices( COCLDevice* pParent, unsigned int uiPlatformID, std::vector<COCLDevice*>* pDevices, unsigned int* uiDeviceCount )
+{
+#ifdef CL_VERSION_1_2
+	cl_uint									uiUnits = pParent->clDeviceComputeUnits;
+	std::vector<cl_device_partition_property>	vProperties;
+	std::vector<cl_device_id>				vSubDevices( this->uiSubDevices );
+	cl_uint									uiCreated = 0;
+
+	if ( uiUnits < this->uiSubDevices )
+	{
+		model::doError(
+			"The CPU has too few compute units to create " + toString( this->uiSubDevices ) + " sub-devices.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	vProperties.push_back( CL_DEVICE_PARTITION_BY_COUNTS );
+	for ( unsigned int i = 0; i < this->uiSubDevices; i++ )
+		vProperties.push_back( uiUnits / this->uiSubDevices + ( i < uiUnits % this->uiSubDevices ? 1 : 0 ) );
+	vProperties.push_back( CL_DEVICE_PARTITION_BY_COUNTS_LIST_END );
+	vProperties.push_back( 0 );
+
+	if ( clCreateSubDevices( pParent->getDevice(), &vProperties[0], this->uiSubDevices, &vSubDevices[0], &uiCreated ) != CL_SUCCESS )
+	{
+		model::doError(
+			"Could not split the CPU into sub-devices, so it will be used whole.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	pManager->log->writeLine( "The CPU has been split into " + toString( uiCreated ) + " sub-devices." );
+
+	for ( cl_uint i = 0; i < uiCreated; i++ )
+	{
+		COCLDevice* pDevice = new COCLDevice(
+			vSubDevices[ i ],
+			uiPlatformID,
+			*uiDeviceCount,
+			this->bProfilingEnabled
+		);
+
+		if ( !pDevice->isReady() )
+		{
+			pManager->log->writeLine( "Sub-device is not ready." );
+			delete pDevice;
+			continue;
+		}
+
+		pDevices->push_back( pDevice );
+		( *uiDeviceCount )++;
+		pDevice->logDevice();
+	}
+
+	return true;
+#else
+	model::doError(
+		"Sub-devices need OpenCL 1.2 headers, so the CPU will be used whole.",
+		model::errorCodes::kLevelWarning
+	);
+	return false;
+#endif
+}
+
 /*
  *  Obtain the size and value for a platform info field
  */
@@ -400,3 +530,24 @@ void	CExecutorControlOpenCL::selectDevice( unsigned int uiDeviceNo )
 
 	this->uiSelectedDeviceID = uiDeviceNo;
 }
+
+/*
+ *  Write the kernel timing summary for each device to the log, and
+ *  to a CSV file alongside the log for later analysis
+ */
+void	CExecutorControlOpenCL::writeProfilingReport()
+{
+	if ( !this->bProfilingEnabled )
+		return;
+
+	for ( unsigned int i = 0; i < this->pDevices.size(); ++i )
+	{
+		if ( this->pDevices[i] == NULL || !this->pDevices[i]->isProfiling() )
+			continue;
+
+		this->pDevices[i]->logProfilingSummary();
+		this->pDevices[i]->writeProfilingSummary(
+			pManager->log->getDir() + "_profile" + toString( this->pDevices[i]->getDeviceID() ) + ".csv"
+		);
+	}
+}
@@ -21,6 +21,7 @@
 #define HIPIMS_OPENCL_EXECUTORS_CEXECUTORCONTROLOPENCL_H_
 
 #include <vector>
+#include <string>
 #include "../../Base/CExecutorControl.h"
 #include "../opencl.h"
 
@@ -61,6 +62,10 @@ class CExecutorControlOpenCL: public CExecutorControl
 		bool					createDevices( void );				// Creates new classes for each device
 		unsigned int			getDeviceCount( void )		{ return clDeviceTotal; }		// Returns the number of devices in the system
 		unsigned int			getDeviceCurrent( void )	{ return uiSelectedDeviceID; }	// Returns the active device
+		bool					isBinaryCacheEnabled( void ) { return !sBinaryCacheDir.empty(); }	// Should compiled programs be cached on disk?
+		std::string				getBinaryCacheDir( void )	{ return sBinaryCacheDir; }		// Directory for the program binary cache
+		bool					isProfilingEnabled( void )	{ return bProfilingEnabled; }	// Should kernel execution be profiled?
+		void					writeProfilingReport( void );	// Summarise kernel timings for all devices
 
 	private:
 
@@ -83,11 +88,15 @@ class CExecutorControlOpenCL: public CExecutorControl
 		std::vector<COCLDevice*>							// Dynamic array of device controller classes
 								pDevices;				
 		unsigned int			uiSelectedDeviceID;				// The selected device for use in execution
+		std::string				sBinaryCacheDir;				// Directory holding cached program binaries (empty if disabled)
+		bool					bProfilingEnabled;				// Create queues with profiling and collect kernel timings
+		unsigned int			uiSubDevices;					// Number of sub-devices to split each CPU into
 
 		// Private functions
 		char*					getPlatformInfo( unsigned int, cl_platform_info );	// Fetches information about the platform
 		bool					getPlatforms( void );						// Discovers the platforms available
 		void					logPlatforms( void );						// Write platform details to the log
+		bool					createSubDevices( COCLDevice*, unsigned int, std::vector<COCLDevice*>*, unsigned int* );	// Split a CPU using device fission
 };
 
 #endif
@@ -41,6 +41,8 @@ COCLBuffer::COCLBuffer(
 	this->sName				= sName;
 	this->bReady			= false;
 	this->bInternalBlock	= bExistsOnHost;
+	this->bPinned			= false;
+	this->bProfiled			= false;
 	this->pHostBlock		= NULL;
 	this->bExistsOnHost		= bExistsOnHost;
 	this->bReadOnly			= bReadOnly;
@@ -72,6 +74,13 @@ COCLBuffer::COCLBuffer(
  */
 COCLBuffer::~COCLBuffer()
 {
+	if ( this->bPinned && this->pHostBlock != NULL )
+	{
+		clEnqueueUnmapMemObject( this->clQueue, this->clBuffer, this->pHostBlock, 0, NULL, NULL );
+		clFinish( this->clQueue );
+		this->pHostBlock = NULL;
+	}
+
 	if ( this->clBuffer != NULL )
 		clReleaseMemObject( this->clBuffer );
 
@@ -147,6 +156,50 @@ bool COCLBuffer::createBufferAndInitialise()
 	return createBuffer();
 }
 
+/*
+ *  Create the OpenCL buffer in page-locked host memory and map it, so the
+ *  host block can be used as the target for fast transfers from other buffers
+ */
+bool COCLBuffer::createPinnedBuffer()
+{
+	cl_int	iErrorID;
+
+	this->clFlags		   |= CL_MEM_ALLOC_HOST_PTR;
+	this->clFlags		   &= ~CL_MEM_COPY_HOST_PTR;
+	this->bInternalBlock	= false;
+	this->pHostBlock		= NULL;
+
+	if ( !createBuffer() )
+		return false;
+
+	this->pHostBlock = clEnqueueMapBuffer(
+		this->clQueue,
+		this->clBuffer,
+		CL_TRUE,
+		CL_MAP_READ | CL_MAP_WRITE,
+		0,
+		static_cast<size_t>( this->ulSize ),
+		0,
+		NULL,
+		NULL,
+		&iErrorID
+	);
+
+	if ( iErrorID != CL_SUCCESS )
+	{
+		model::doError(
+			"Could not map pinned memory for '" + this->sName + "'. Error " + toString( iErrorID ) + ".",
+			model::errorCodes::kLevelWarning
+		);
+		this->pHostBlock = NULL;
+		return false;
+	}
+
+	this->bPinned = true;
+
+	return true;
+}
+
 /*
  *  Set the location of the host-copy of the buffer if it's not within this class instance
  */
@@ -186,9 +239,9 @@ void COCLBuffer::allocateHostBlock(
 /*
 *  Attempt to write all of the buffer to the device
 */
-void COCLBuffer::queueReadAll()
+void COCLBuffer::queueReadAll( void* pMemBlock )
 {
-	queueReadPartial(0, static_cast<size_t>(this->ulSize));
+	queueReadPartial(0, static_cast<size_t>(this->ulSize), pMemBlock);
 }
 
 /*
@@ -264,6 +317,8 @@ void COCLBuffer::queueWritePartial(cl_ulong ulOffset, size_t ulSize, void* pMemB
 	// Store the event returned, so the calling function
 	// can use it to block etc.
 	cl_event	clEvent = NULL;
+	bool		bCallback = ( fCallbackWrite != NULL && fCallbackWrite != COCLDevice::defaultCallback );
+	bool		bProfiling = ( this->bProfiled && pDevice->isProfiling() );
 
 	// Use the data held in this buffer object unless told otherwise
 	if (pMemBlock == NULL)
@@ -282,7 +337,7 @@ void COCLBuffer::queueWritePartial(cl_ulong ulOffset, size_t ulSize, void* pMemB
 		pMemBlock,					// Source pointer
 		NULL,						// No. of events in wait list
 		NULL,						// Wait list
-		( fCallbackWrite != NULL && fCallbackWrite != COCLDevice::defaultCallback ? &clEvent : NULL )					// Event pointer
+		( bCallback || bProfiling ? &clEvent : NULL )					// Event pointer
 	);
 
 	// Did any errors occur?
@@ -299,7 +354,161 @@ void COCLBuffer::queueWritePartial(cl_ulong ulOffset, size_t ulSize, void* pMemB
 		);
 	}
 
+	if ( bProfiling && iReturn == CL_SUCCESS )
+	{
+		if ( bCallback )
+			clRetainEvent( clEvent );
+		this->profileTransfer( "Write", clEvent );
+	}
+
 	// Attach a callback
+	if ( bCallback )
+	{
+		iReturn = clSetEventCallback(
+			clEvent,
+			CL_COMPLETE,
+			fCallbackWrite,
+			&this->uiDeviceID
+		);
+
+		if ( iReturn != CL_SUCCESS )
+		{
+			model::doError(
+				"Attaching thread callback failed for device #" + toString( this->uiDeviceID ) + ".",
+				model::errorCodes::kLevelModelStop
+			);
+			return;
+		}
+	}
+}
+/*
+ *  Read a rectangular region of the buffer back from the device, where
+ *  each row is separated by a pitch in bytes. Rows are packed together
+ *  in the target pointer, or kept at the same pitch if using the host block.
+ */
+void COCLBuffer::queueReadRect( cl_ulong ulOffset, size_t ulRowSize, size_t ulRows, size_t ulRowPitch, void* pMemBlock )
+{
+	cl_event	clEvent = NULL;
+
+	size_t		szBufferOrigin[3]	= { static_cast<size_t>( ulOffset % ulRowPitch ), static_cast<size_t>( ulOffset / ulRowPitch ), 0 };
+	size_t		szHostOrigin[3]		= { 0, 0, 0 };
+	size_t		szRegion[3]			= { ulRowSize, ulRows, 1 };
+	size_t		szHostPitch			= ulRowSize;
+
+	if ( pMemBlock == NULL )
+	{
+		pMemBlock		= this->pHostBlock;
+		szHostOrigin[0]	= szBufferOrigin[0];
+		szHostOrigin[1]	= szBufferOrigin[1];
+		szHostPitch		= ulRowPitch;
+	}
+
+	pDevice->markBusy();
+
+	// Add a read buffer to the queue (non-blocking)
+	// Calling functions are expected to handle barriers etc.
+	cl_int	iReturn = clEnqueueReadBufferRect(
+		this->clQueue,				// Device queue
+		clBuffer,					// Buffer object
+		CL_FALSE,					// Blocking?
+		szBufferOrigin,				// Buffer origin
+		szHostOrigin,				// Host origin
+		szRegion,					// Region
+		ulRowPitch,					// Buffer row pitch
+		0,							// Buffer slice pitch
+		szHostPitch,				// Host row pitch
+		0,							// Host slice pitch
+		pMemBlock,					// Target pointer
+		NULL,						// No. of events in wait list
+		NULL,						// Wait list
+		( fCallbackRead != NULL && fCallbackRead != COCLDevice::defaultCallback ? &clEvent : NULL )					// Event pointer
+	);
+
+	if ( iReturn != CL_SUCCESS )
+	{
+		model::doError(
+			"Unable to read memory region from device back to host  " 
+			+ this->sName + " (" + toString( iReturn ) + ")",
+			model::errorCodes::kLevelModelStop
+		);
+	}
+
+	if ( fCallbackRead != NULL && fCallbackRead != COCLDevice::defaultCallback )
+	{
+		iReturn = clSetEventCallback(
+			clEvent,
+			CL_COMPLETE,
+			fCallbackRead,
+			&this->uiDeviceID
+		);
+
+		if ( iReturn != CL_SUCCESS )
+		{
+			model::doError(
+				"Attaching thread callback failed for device #" + toString( this->uiDeviceID ) + ".",
+				model::errorCodes::kLevelModelStop
+			);
+			return;
+		}
+	}
+}
+
+/*
+ *  Write a rectangular region of the buffer, where each row is separated
+ *  by a pitch in bytes. Rows are expected to be packed together in the
+ *  source pointer, or at the same pitch if using the host block.
+ */
+void COCLBuffer::queueWriteRect( cl_ulong ulOffset, size_t ulRowSize, size_t ulRows, size_t ulRowPitch, void* pMemBlock )
+{
+	cl_event	clEvent = NULL;
+
+	size_t		szBufferOrigin[3]	= { static_cast<size_t>( ulOffset % ulRowPitch ), static_cast<size_t>( ulOffset / ulRowPitch ), 0 };
+	size_t		szHostOrigin[3]		= { 0, 0, 0 };
+	size_t		szRegion[3]			= { ulRowSize, ulRows, 1 };
+	size_t		szHostPitch			= ulRowSize;
+
+	if ( pMemBlock == NULL )
+	{
+		pMemBlock		= this->pHostBlock;
+		szHostOrigin[0]	= szBufferOrigin[0];
+		szHostOrigin[1]	= szBufferOrigin[1];
+		szHostPitch		= ulRowPitch;
+	}
+
+	pDevice->markBusy();
+
+	// Add a write buffer to the queue (non-blocking)
+	// Calling functions are expected to handle barriers etc.
+	cl_int	iReturn = clEnqueueWriteBufferRect(
+		this->clQueue,				// Device queue
+		clBuffer,					// Buffer object
+		CL_FALSE,					// Blocking?
+		szBufferOrigin,				// Buffer origin
+		szHostOrigin,				// Host origin
+		szRegion,					// Region
+		ulRowPitch,					// Buffer row pitch
+		0,							// Buffer slice pitch
+		szHostPitch,				// Host row pitch
+		0,							// Host slice pitch
+		pMemBlock,					// Source pointer
+		NULL,						// No. of events in wait list
+		NULL,						// Wait list
+		( fCallbackWrite != NULL && fCallbackWrite != COCLDevice::defaultCallback ? &clEvent : NULL )					// Event pointer
+	);
+
+	if ( iReturn != CL_SUCCESS )
+	{
+		model::doError(
+			"Unable to write memory region to device\n  " 
+			+ this->sName + " (" + toString( iReturn ) + ")\n"
+			+ "  Offset: " + toString( ulOffset ) 
+			+ "  Rows: " + toString( ulRows ) 
+			+ "  Row size: " + toString( ulRowSize ) 
+			+ "  Pitch: " + toString( ulRowPitch ),
+			model::errorCodes::kLevelModelStop
+		);
+	}
+
 	if ( fCallbackWrite != NULL && fCallbackWrite != COCLDevice::defaultCallback )
 	{
 		iReturn = clSetEventCallback(
@@ -318,4 +527,104 @@ void COCLBuffer::queueWritePartial(cl_ulong ulOffset, size_t ulSize, void* pMemB
 			return;
 		}
 	}
-}
\ No newline at end of file
+}
+
+/*
+ *  Copy part of this buffer into another buffer on the same device, without
+ *  a trip through host memory
+ */
+void COCLBuffer::queueCopyTo( COCLBuffer* pTarget, cl_ulong ulOffset, cl_ulong ulTargetOffset, size_t ulSize )
+{
+	cl_event	clEvent = NULL;
+	bool		bProfiling = ( this->bProfiled && pDevice->isProfiling() );
+
+	pDevice->markBusy();
+
+	// Calling functions are expected to handle barriers etc.
+	cl_int	iReturn = clEnqueueCopyBuffer(
+		this->clQueue,				// Device queue
+		clBuffer,					// Source buffer
+		pTarget->getBuffer(),		// Target buffer
+		ulOffset,					// Source offset
+		ulTargetOffset,				// Target offset
+		ulSize,						// Size
+		NULL,						// No. of events in wait list
+		NULL,						// Wait list
+		( bProfiling ? &clEvent : NULL )	// Event pointer
+	);
+
+	if ( iReturn != CL_SUCCESS )
+	{
+		model::doError(
+			"Unable to copy memory buffer\n  " 
+			+ this->sName + " to " + pTarget->getName() + " (" + toString( iReturn ) + ")\n"
+			+ "  Offset: " + toString( ulOffset ) 
+			+ "  Target offset: " + toString( ulTargetOffset ) 
+			+ "  Size: " + toString( ulSize ),
+			model::errorCodes::kLevelModelStop
+		);
+		return;
+	}
+
+	if ( bProfiling )
+		this->profileTransfer( "Copy", clEvent );
+}
+
+/*
+ *  Copy rows packed together in this buffer into a rectangular region of
+ *  another buffer on the same device, where each row is separated by a pitch
+ */
+void COCLBuffer::queueCopyRectTo( COCLBuffer* pTarget, cl_ulong ulOffset, cl_ulong ulTargetOffset, size_t ulRowSize, size_t ulRows, size_t ulTargetPitch )
+{
+	cl_event	clEvent = NULL;
+	bool		bProfiling = ( this->bProfiled && pDevice->isProfiling() );
+
+	size_t		szSourceOrigin[3]	= { static_cast<size_t>( ulOffset % ulRowSize ), static_cast<size_t>( ulOffset / ulRowSize ), 0 };
+	size_t		szTargetOrigin[3]	= { static_cast<size_t>( ulTargetOffset % ulTargetPitch ), static_cast<size_t>( ulTargetOffset / ulTargetPitch ), 0 };
+	size_t		szRegion[3]			= { ulRowSize, ulRows, 1 };
+
+	pDevice->markBusy();
+
+	// Calling functions are expected to handle barriers etc.
+	cl_int	iReturn = clEnqueueCopyBufferRect(
+		this->clQueue,				// Device queue
+		clBuffer,					// Source buffer
+		pTarget->getBuffer(),		// Target buffer
+		szSourceOrigin,				// Source origin
+		szTargetOrigin,				// Target origin
+		szRegion,					// Region
+		ulRowSize,					// Source row pitch
+		0,							// Source slice pitch
+		ulTargetPitch,				// Target row pitch
+		0,							// Target slice pitch
+		NULL,						// No. of events in wait list
+		NULL,						// Wait list
+		( bProfiling ? &clEvent : NULL )	// Event pointer
+	);
+
+	if ( iReturn != CL_SUCCESS )
+	{
+		model::doError(
+			"Unable to copy memory region\n  " 
+			+ this->sName + " to " + pTarget->getName() + " (" + toString( iReturn ) + ")\n"
+			+ "  Offset: " + toString( ulTargetOffset ) 
+			+ "  Rows: " + toString( ulRows ) 
+			+ "  Row size: " + toString( ulRowSize ) 
+			+ "  Pitch: " + toString( ulTargetPitch ),
+			model::errorCodes::kLevelModelStop
+		);
+		return;
+	}
+
+	if ( bProfiling )
+		this->profileTransfer( "Copy", clEvent );
+}
+
+/*
+ *  Hand a transfer event to the device so its timing appears alongside
+ *  the kernels in the profiling summary
+ */
+void COCLBuffer::profileTransfer( std::string sOperation, cl_event clEvent )
+{
+	pDevice->addProfilingEvent( sOperation + ": " + this->sName, clEvent );
+}
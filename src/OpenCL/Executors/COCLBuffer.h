@@ -41,12 +41,18 @@ public:
 	blockType		getHostBlock()						{ return static_cast<blockType>( this->pHostBlock ); }
 	bool			createBuffer();
 	bool			createBufferAndInitialise();
+	bool			createPinnedBuffer();
 	void			setPointer( void*, cl_ulong );
 	void			allocateHostBlock( cl_ulong );
-	void			queueReadAll();
+	void			queueReadAll( void* = NULL );
 	void			queueReadPartial( cl_ulong, size_t, void* = NULL );
+	void			queueReadRect( cl_ulong, size_t, size_t, size_t, void* = NULL );
 	void			queueWriteAll();
 	void			queueWritePartial( cl_ulong, size_t, void* = NULL );
+	void			queueWriteRect( cl_ulong, size_t, size_t, size_t, void* = NULL );
+	void			queueCopyTo( COCLBuffer*, cl_ulong, cl_ulong, size_t );
+	void			queueCopyRectTo( COCLBuffer*, cl_ulong, cl_ulong, size_t, size_t, size_t );
+	void			setProfiled( bool bProfile )		{ bProfiled = bProfile; }
 
 protected:
 	cl_uint			uiDeviceID;
@@ -60,10 +66,14 @@ protected:
 	cl_ulong		ulSize;
 	bool			bReady;
 	bool			bInternalBlock;
+	bool			bPinned;
 	bool			bReadOnly;
 	bool			bExistsOnHost;
+	bool			bProfiled;
 	void (__stdcall *fCallbackRead)( cl_event, cl_int, void* );
 	void (__stdcall *fCallbackWrite)( cl_event, cl_int, void* );
+
+	void			profileTransfer( std::string, cl_event );
 };
 
 #endif
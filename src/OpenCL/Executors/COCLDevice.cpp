@@ -20,6 +20,9 @@
 // Includes
 #include "../../common.h"
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
 #include "../opencl.h"
 #include "../../CModel.h"
 #include "../../Base/CExecutorControl.h"
@@ -29,7 +32,7 @@
 /*
  *  Constructor
  */
-COCLDevice::COCLDevice( cl_device_id clDevice, unsigned int iPlatformID, unsigned int iDeviceNo )
+COCLDevice::COCLDevice( cl_device_id clDevice, unsigned int iPlatformID, unsigned int iDeviceNo, bool bProfiling )
 {
 	// Store the device and platform ID
 	this->uiPlatformID			= iPlatformID;
@@ -40,6 +43,8 @@ COCLDevice::COCLDevice( cl_device_id clDevice, unsigned int iPlatformID, unsigne
 	this->bErrored				= false;
 	this->bBusy					= false;
 	this->clMarkerEvent			= NULL;
+	this->bProfiling			= bProfiling;
+	this->bOutOfOrder			= false;
 
 	pManager->log->writeLine( "Querying the suitability of a discovered device." );
 
@@ -53,8 +58,17 @@ COCLDevice::COCLDevice( cl_device_id clDevice, unsigned int iPlatformID, unsigne
 COCLDevice::~COCLDevice(void)
 {
 	clFinish( this->clQueue );
+
+	for ( unsigned int i = 0; i < this->pProfilingEvents.size(); ++i )
+		clReleaseEvent( this->pProfilingEvents[i].second );
+	this->pProfilingEvents.clear();
+
 	clReleaseCommandQueue( this->clQueue );
 	clReleaseContext( this->clContext );
+#ifdef CL_VERSION_1_2
+	// Only has any effect for sub-devices
+	clReleaseDevice( this->clDevice );
+#endif
 
 	delete[] this->clDeviceMaxWorkItemSizes;
 	delete[] this->clDeviceName;
@@ -280,10 +294,37 @@ void COCLDevice::createQueue()
 		return;
 	}
 
+	cl_command_queue_properties clQueueProperties = 0;
+
+	// Dependencies between kernels are expressed with events, so an out-of-order
+	// queue lets independent work overlap. Otherwise fall back to in-order.
+	if ( this->clDeviceQueueProperties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE )
+	{
+		clQueueProperties |= CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+		this->bOutOfOrder  = true;
+	} else {
+		pManager->log->writeLine( "Device does not support out-of-order execution. Using an in-order queue." );
+	}
+
+	// Kernel timings are only available if the queue is created for profiling
+	if ( this->bProfiling )
+	{
+		if ( this->clDeviceQueueProperties & CL_QUEUE_PROFILING_ENABLE )
+		{
+			clQueueProperties |= CL_QUEUE_PROFILING_ENABLE;
+		} else {
+			model::doError(
+				"Device does not support queue profiling. Kernel timings will not be collected.",
+				model::errorCodes::kLevelWarning
+			);
+			this->bProfiling = false;
+		}
+	}
+
 	this->clQueue = clCreateCommandQueue(
 		this->clContext,
 		this->clDevice,
-		CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE,
+		clQueueProperties,
 		&iErrorID
 	);
 
@@ -389,6 +430,8 @@ void	COCLDevice::blockUntilFinished()
 	this->bBusy = true;
 	clFlush( this->clQueue );
 	clFinish( this->clQueue );
+	if ( this->bProfiling )
+		this->collectProfilingData();
 	/*
 	if (clMarkerEvent != NULL) {
 		clReleaseEvent(clMarkerEvent);
@@ -548,3 +591,181 @@ void COCLDevice::getSummary(  COCLDevice::sDeviceSummary & pSummary )
 	pSummary.uiDeviceID = this->uiDeviceNo;
 	pSummary.uiDeviceNumber = this->uiDeviceNo + 1;
 }
+
+/*
+ *  Keep an event so the kernel timings can be read once it has completed
+ */
+void COCLDevice::addProfilingEvent( std::string sKernelName, cl_event clEvent )
+{
+	std::lock_guard<std::mutex> lockProfiling( this->mtxProfiling );
+	this->pProfilingEvents.push_back( std::make_pair( sKernelName, clEvent ) );
+}
+
+/*
+ *  Read the timings from any completed profiling events, and release them
+ */
+void COCLDevice::collectProfilingData()
+{
+	std::lock_guard<std::mutex> lockProfiling( this->mtxProfiling );
+
+	// Bounds the memory used for percentiles, samples beyond this are reservoir sampled
+	const unsigned long	ulMaxSamples	= 100000;
+	unsigned int		uiRemaining		= 0;
+
+	for ( unsigned int i = 0; i < this->pProfilingEvents.size(); ++i )
+	{
+		cl_event	clEvent		= this->pProfilingEvents[i].second;
+		cl_int		iStatus		= CL_QUEUED;
+		cl_ulong	ulQueued	= 0, ulSubmit = 0, ulStart = 0, ulEnd = 0;
+
+		clGetEventInfo( clEvent, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof( cl_int ), &iStatus, NULL );
+
+		// Not finished yet, so keep hold of it until next time
+		if ( iStatus > CL_COMPLETE )
+		{
+			this->pProfilingEvents[ uiRemaining++ ] = this->pProfilingEvents[i];
+			continue;
+		}
+
+		if ( iStatus == CL_COMPLETE &&
+			 clGetEventProfilingInfo( clEvent, CL_PROFILING_COMMAND_QUEUED, sizeof( cl_ulong ), &ulQueued, NULL ) == CL_SUCCESS &&
+			 clGetEventProfilingInfo( clEvent, CL_PROFILING_COMMAND_SUBMIT, sizeof( cl_ulong ), &ulSubmit, NULL ) == CL_SUCCESS &&
+			 clGetEventProfilingInfo( clEvent, CL_PROFILING_COMMAND_START,  sizeof( cl_ulong ), &ulStart,  NULL ) == CL_SUCCESS &&
+			 clGetEventProfilingInfo( clEvent, CL_PROFILING_COMMAND_END,    sizeof( cl_ulong ), &ulEnd,    NULL ) == CL_SUCCESS )
+		{
+			sKernelProfile*	pProfile	= &this->pKernelProfiles[ this->pProfilingEvents[i].first ];
+			double			dExecution	= static_cast<double>( ulEnd - ulStart ) / 1E6;
+
+			// Some CPU runtimes report a submit time ahead of queued, so guard against wrapping
+			pProfile->ulCount++;
+			pProfile->dTotalQueued		+= ( ulSubmit > ulQueued ? static_cast<double>( ulSubmit - ulQueued ) / 1E6 : 0.0 );
+			pProfile->dTotalSubmitted	+= ( ulStart > ulSubmit ? static_cast<double>( ulStart - ulSubmit ) / 1E6 : 0.0 );
+			pProfile->dTotalExecution	+= dExecution;
+			if ( dExecution > pProfile->dMaxExecution )
+				pProfile->dMaxExecution = dExecution;
+
+			if ( pProfile->fExecutionSamples.size() < ulMaxSamples )
+			{
+				pProfile->fExecutionSamples.push_back( static_cast<float>( dExecution ) );
+			} else {
+				pProfile->ulSampled = pProfile->ulSampled * 6364136223846793005ULL + 1442695040888963407ULL;
+				unsigned long long ulSlot = ( pProfile->ulSampled >> 17 ) % pProfile->ulCount;
+				if ( ulSlot < ulMaxSamples )
+					pProfile->fExecutionSamples[ ulSlot ] = static_cast<float>( dExecution );
+			}
+		}
+
+		clReleaseEvent( clEvent );
+	}
+
+	this->pProfilingEvents.resize( uiRemaining );
+}
+
+/*
+ *  Calculate a percentile (0-100) from a set of samples
+ */
+double COCLDevice::getPercentile( std::vector<float> fSamples, double dPercentile )
+{
+	if ( fSamples.size() < 1 )
+		return 0.0;
+
+	unsigned long ulIndex = static_cast<unsigned long>( 
+		ceil( dPercentile / 100.0 * static_cast<double>( fSamples.size() ) ) 
+	);
+	if ( ulIndex > 0 ) ulIndex--;
+	if ( ulIndex >= fSamples.size() ) ulIndex = fSamples.size() - 1;
+
+	std::nth_element( fSamples.begin(), fSamples.begin() + ulIndex, fSamples.end() );
+	return static_cast<double>( fSamples[ ulIndex ] );
+}
+
+/*
+ *  Write a summary of the kernel timings to the log
+ */
+void COCLDevice::logProfilingSummary()
+{
+	if ( !this->bProfiling )
+		return;
+
+	this->collectProfilingData();
+
+	std::lock_guard<std::mutex> lockProfiling( this->mtxProfiling );
+
+	CLog*			pLog			= pManager->log;
+	unsigned short	wColour			= model::cli::colourInfoBlock;
+	double			dTotalAll		= 0.0;
+
+	for ( std::map< std::string, sKernelProfile >::iterator it = this->pKernelProfiles.begin(); it != this->pKernelProfiles.end(); ++it )
+		dTotalAll += it->second.dTotalExecution;
+
+	pLog->writeDivide();
+	pLog->writeLine( "KERNEL PROFILE FOR DEVICE #" + toString( this->uiDeviceNo ), true, wColour );
+	pLog->writeLine( "  Kernel                    Count      Total (ms)   Mean (ms)  P95 (ms)   Share", true, wColour );
+
+	for ( std::map< std::string, sKernelProfile >::iterator it = this->pKernelProfiles.begin(); it != this->pKernelProfiles.end(); ++it )
+	{
+		sKernelProfile*		pProfile = &it->second;
+		std::stringstream	ssLine;
+
+		ssLine << "  " << std::left << std::setw( 24 ) << it->first << "  "
+			   << std::setw( 9 ) << pProfile->ulCount << "  "
+			   << std::fixed << std::setprecision( 3 )
+			   << std::setw( 11 ) << pProfile->dTotalExecution << "  "
+			   << std::setw( 9 ) << ( pProfile->ulCount > 0 ? pProfile->dTotalExecution / pProfile->ulCount : 0.0 ) << "  "
+			   << std::setw( 9 ) << getPercentile( pProfile->fExecutionSamples, 95.0 ) << "  "
+			   << std::setprecision( 1 ) << ( dTotalAll > 0.0 ? pProfile->dTotalExecution / dTotalAll * 100.0 : 0.0 ) << "%";
+
+		pLog->writeLine( ssLine.str(), true, wColour );
+	}
+
+	pLog->writeDivide();
+}
+
+/*
+ *  Write the kernel timings to a CSV file
+ */
+bool COCLDevice::writeProfilingSummary( std::string sFilename )
+{
+	if ( !this->bProfiling )
+		return false;
+
+	this->collectProfilingData();
+
+	std::lock_guard<std::mutex> lockProfiling( this->mtxProfiling );
+	std::ofstream ofsProfile( sFilename.c_str(), std::ios::out | std::ios::trunc );
+
+	if ( !ofsProfile.is_open() )
+	{
+		model::doError(
+			"Could not write the kernel profile to " + sFilename,
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	ofsProfile << "device,kernel,count,total_ms,mean_ms,p50_ms,p95_ms,max_ms,mean_queued_ms,mean_submitted_ms" << std::endl;
+	ofsProfile << std::setprecision( 9 );
+
+	for ( std::map< std::string, sKernelProfile >::iterator it = this->pKernelProfiles.begin(); it != this->pKernelProfiles.end(); ++it )
+	{
+		sKernelProfile*	pProfile	= &it->second;
+		double			dCount		= static_cast<double>( pProfile->ulCount > 0 ? pProfile->ulCount : 1 );
+
+		ofsProfile << this->uiDeviceNo << ","
+				   << it->first << ","
+				   << pProfile->ulCount << ","
+				   << pProfile->dTotalExecution << ","
+				   << pProfile->dTotalExecution / dCount << ","
+				   << getPercentile( pProfile->fExecutionSamples, 50.0 ) << ","
+				   << getPercentile( pProfile->fExecutionSamples, 95.0 ) << ","
+				   << pProfile->dMaxExecution << ","
+				   << pProfile->dTotalQueued / dCount << ","
+				   << pProfile->dTotalSubmitted / dCount << std::endl;
+	}
+
+	ofsProfile.close();
+
+	pManager->log->writeLine( "Kernel profile for device #" + toString( this->uiDeviceNo ) + " written to " + sFilename );
+
+	return true;
+}
@@ -19,6 +19,10 @@
 #ifndef HIPIMS_OPENCL_EXECUTORS_COCLDEVICE_H_
 #define HIPIMS_OPENCL_EXECUTORS_COCLDEVICE_H_
 
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "CExecutorControlOpenCL.h"
 
 /*
@@ -34,7 +38,7 @@ class COCLDevice
 
 	public:
 
-		COCLDevice( cl_device_id, unsigned int, unsigned int );				// Constructor
+		COCLDevice( cl_device_id, unsigned int, unsigned int, bool = false );	// Constructor
 		~COCLDevice( void );												// Destructor
 
 		// Public structures
@@ -47,6 +51,18 @@ class COCLDevice
 			unsigned int	uiDeviceNumber;
 		};
 
+		// Timing data for a single kernel when profiling is enabled
+		struct sKernelProfile
+		{
+			unsigned long long	ulCount;
+			unsigned long long	ulSampled;
+			double				dTotalQueued;
+			double				dTotalSubmitted;
+			double				dTotalExecution;
+			double				dMaxExecution;
+			std::vector<float>	fExecutionSamples;
+		};
+
 		// Public variables
 		// Device property variables
 		// See www.khronos.org/registry/cl/sdk/1.1/docs/man/xhtml/clGetDeviceInfo.html
@@ -109,6 +125,12 @@ class COCLDevice
 		void						markerCompletion();														// Handle once the marker callback has been triggered (non-static)
 		static void CL_CALLBACK		
 									markerCallback( cl_event, cl_int, void * );								// Triggered when the marker is reached (but static...)
+		bool						isProfiling( void )					{ return bProfiling; }				// Are kernel events being profiled?
+		bool						isOutOfOrder( void )				{ return bOutOfOrder; }				// Can commands in the queue execute out-of-order?
+		void						addProfilingEvent( std::string, cl_event );								// Keep an event for profiling once complete
+		void						collectProfilingData();													// Read timings from completed profiling events
+		void						logProfilingSummary();													// Write the per-kernel timing summary to the log
+		bool						writeProfilingSummary( std::string );									// Write the per-kernel timing summary to a CSV file
 
 	private:
 
@@ -123,11 +145,19 @@ class COCLDevice
 		bool						bErrored;																// Serious error triggered
 		bool						bForceSinglePrecision;													// Force single precision only?
 		bool						bBusy;																	// Is this device busy?
+		bool						bProfiling;																// Is the queue created with profiling enabled?
+		bool						bOutOfOrder;															// Is the queue created with out-of-order execution?
+		std::mutex					mtxProfiling;															// Guards the profiling event list
+		std::vector< std::pair< std::string, cl_event > >
+									pProfilingEvents;														// Kernel events awaiting profiling data
+		std::map< std::string, sKernelProfile >
+									pKernelProfiles;														// Accumulated timings for each kernel
 
 		// Private functions
 		void						getAllInfo();															// Fetches all the info we'll need on the device
 		void*						getDeviceInfo( cl_device_info );										// Fetch a device info field
 		void						createQueue( void );													// Create the device context and queue
+		static double				getPercentile( std::vector<float>, double );							// Calculate a percentile from samples
 
 		// Friendships (for access to data structure pointers mainly)
 		friend class				CDomain;
@@ -71,10 +71,25 @@ COCLKernel::~COCLKernel()
  */
 void COCLKernel::scheduleExecution()
 {
+	this->scheduleExecution( 0, NULL, NULL );
+}
+
+/*
+ *  Schedule the kernel for execution once the events in the wait list
+ *  have completed, optionally returning an event for this kernel
+ */
+void COCLKernel::scheduleExecution( cl_uint uiWaitCount, const cl_event* clWaitList, cl_event* clEventOut )
+{
+	if ( clEventOut != NULL ) 
+		*clEventOut = NULL;
+
 	if ( !this->bReady ) return;
 
 	cl_event		clEvent		= NULL;
 	cl_int			iErrorID	= CL_SUCCESS;
+	bool			bCallback	= ( fCallback != NULL && fCallback != COCLDevice::defaultCallback );
+	bool			bProfiling	= pDevice->isProfiling();
+	unsigned int	uiOwners	= ( bCallback ? 1 : 0 ) + ( bProfiling ? 1 : 0 ) + ( clEventOut != NULL ? 1 : 0 );
 
 	pDevice->markBusy();
 	
@@ -85,9 +100,9 @@ void COCLKernel::scheduleExecution()
 		szGlobalOffset,
 		szGlobalSize,
 		szGroupSize,
-		NULL,
-		NULL,
-		( fCallback != NULL && fCallback != COCLDevice::defaultCallback ? &clEvent : NULL )
+		( clWaitList != NULL ? uiWaitCount : 0 ),
+		( uiWaitCount > 0 ? clWaitList : NULL ),
+		( uiOwners > 0 ? &clEvent : NULL )
 	);
 
 	if ( iErrorID != CL_SUCCESS )
@@ -101,7 +116,18 @@ void COCLKernel::scheduleExecution()
 		return;
 	}
 
-	if ( fCallback != NULL && fCallback != COCLDevice::defaultCallback )
+	// The caller, the profiler and the callback each release the event
+	// independently, so each needs its own reference
+	for ( unsigned int i = 1; i < uiOwners; ++i )
+		clRetainEvent( clEvent );
+
+	if ( clEventOut != NULL )
+		*clEventOut = clEvent;
+
+	if ( bProfiling )
+		pDevice->addProfilingEvent( sName, clEvent );
+
+	if ( bCallback )
 	{
 		iErrorID = clSetEventCallback(
 			clEvent,
@@ -41,6 +41,7 @@ public:
 																	{ fCallback = cb; }
 
 	void			scheduleExecution();
+	void			scheduleExecution( cl_uint, const cl_event*, cl_event* );
 	void			scheduleExecutionAndFlush();
 	bool			assignArguments( COCLBuffer* Buffer_Arguments[] );
 	bool			assignArgument( unsigned char Index, COCLBuffer* Buffer_Argument );
@@ -21,6 +21,9 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/algorithm/string.hpp>
+#include <fstream>
+#include <iomanip>
+#include <cstdio>
 #include "../../common.h"
 #include "COCLProgram.h"
 #include "COCLKernel.h"
@@ -94,45 +97,68 @@ bool COCLProgram::compileProgram(
 	for ( unsigned int i = 0; i < uiStackLength; i++ )
 		orcCode[ i ] = oclCodeStack[ i ];
 
-	clProgram = clCreateProgramWithSource(
-		this->clContext,
-		uiStackLength,
-		const_cast<const char**>(orcCode),
-		NULL,							// All char* must be null terminated because we don't pass any lengths!
-		&iErrorID
-	);
+	CBenchmark		pBenchmark( true );
+	bool			bFromCache		= false;
+	std::string		sCacheKey		= "";
 
-	if ( iErrorID != CL_SUCCESS )
+	// Try the binary cache first, which avoids the full compile on later runs
+	if ( this->execController->isBinaryCacheEnabled() )
 	{
-		model::doError(
-			"Could not create a program to run on device #" + toString( this->device->getDeviceID() ) + ".",
-			model::errorCodes::kLevelModelStop
-		);
-		return false;
+		sCacheKey	= this->getBinaryCacheKey( orcCode, uiStackLength );
+		bFromCache	= this->loadBinaryFromCache( sCacheKey );
 	}
 
-	iErrorID = clBuildProgram(
-		clProgram,																		// Program
-		NULL,																			// Num. devices
-		NULL,																			// Device list
-		sCompileParameters.c_str(),														// Options (no  -cl-finite-math-only  -cl-denorms-are-zero)
-		NULL,																			// Callback
-		NULL																			// Callback data
-	);
-
-	if ( iErrorID != CL_SUCCESS )
+	if ( !bFromCache )
 	{
-		model::doError(
-			"Could not build the program to run on device #" + toString( this->device->getDeviceID() ) + ".",
-			model::errorCodes::kLevelModelStop
+		clProgram = clCreateProgramWithSource(
+			this->clContext,
+			uiStackLength,
+			const_cast<const char**>(orcCode),
+			NULL,							// All char* must be null terminated because we don't pass any lengths!
+			&iErrorID
 		);
-		pManager->log->writeDivide();
-		pManager->log->writeLine( this->getCompileLog(), false );
-		pManager->log->writeDivide();
-		pManager->log->writeDebugFile( orcCode, uiStackLength );
-		return false;
+
+		if ( iErrorID != CL_SUCCESS )
+		{
+			model::doError(
+				"Could not create a program to run on device #" + toString( this->device->getDeviceID() ) + ".",
+				model::errorCodes::kLevelModelStop
+			);
+			return false;
+		}
+
+		iErrorID = clBuildProgram(
+			clProgram,																		// Program
+			NULL,																			// Num. devices
+			NULL,																			// Device list
+			sCompileParameters.c_str(),														// Options (no  -cl-finite-math-only  -cl-denorms-are-zero)
+			NULL,																			// Callback
+			NULL																			// Callback data
+		);
+
+		if ( iErrorID != CL_SUCCESS )
+		{
+			model::doError(
+				"Could not build the program to run on device #" + toString( this->device->getDeviceID() ) + ".",
+				model::errorCodes::kLevelModelStop
+			);
+			pManager->log->writeDivide();
+			pManager->log->writeLine( this->getCompileLog(), false );
+			pManager->log->writeDivide();
+			pManager->log->writeDebugFile( orcCode, uiStackLength );
+			return false;
+		}
 	}
 
+	pBenchmark.finish();
+	pManager->log->writeLine( 
+		std::string( bFromCache ? "Program binary loaded from cache" : "Program built from source" ) + 
+		" in " + toString( pBenchmark.getMetrics()->dMilliseconds ) + "ms." 
+	);
+
+	if ( !bFromCache && this->execController->isBinaryCacheEnabled() )
+		this->saveBinaryToCache( sCacheKey );
+
 	pManager->log->writeLine( "Program successfully compiled for device #" + toString( this->device->getDeviceID() ) + "." );
 
 	std::string sBuildLog = this->getCompileLog();
@@ -329,6 +355,235 @@ void COCLProgram::clearConstants()
 	this->uomConstants.clear();
 }
 
+/*
+ *  Build a key which uniquely identifies this program for the binary cache,
+ *  covering the device and driver, the build options and the full source
+ *  (which already includes the registered constants)
+ */
+std::string COCLProgram::getBinaryCacheKey(
+		OCL_RAW_CODE*	orcCode,
+		cl_uint			uiStackLength
+	)
+{
+	std::stringstream ssKey;
+
+	ssKey << "HIPIMS-OCL-BINARY-CACHE" << std::endl;
+	ssKey << this->device->clDeviceName << std::endl;
+	ssKey << this->device->clDeviceVendor << std::endl;
+	ssKey << this->device->clDeviceOpenCLVersion << std::endl;
+	ssKey << this->device->clDeviceOpenCLDriver << std::endl;
+	ssKey << this->sCompileParameters << std::endl;
+
+	for ( unsigned int i = 0; i < uiStackLength; i++ )
+		ssKey << orcCode[ i ];
+
+	return ssKey.str();
+}
+
+/*
+ *  Get the filename used for a cache key, using an FNV-1a hash
+ */
+std::string COCLProgram::getBinaryCacheFilename(
+		std::string		sKey
+	)
+{
+	unsigned long long	ullHash		= 14695981039346656037ULL;
+	std::stringstream	ssFilename;
+
+	for ( unsigned long i = 0; i < sKey.length(); i++ )
+	{
+		ullHash ^= static_cast<unsigned char>( sKey[ i ] );
+		ullHash *= 1099511628211ULL;
+	}
+
+	ssFilename << this->execController->getBinaryCacheDir() << "program_" 
+			   << std::hex << std::setw( 16 ) << std::setfill( '0' ) << ullHash << ".bin";
+
+	return ssFilename.str();
+}
+
+/*
+ *  Attempt to create the program from a previously cached binary
+ */
+bool COCLProgram::loadBinaryFromCache(
+		std::string		sKey
+	)
+{
+	std::string		sFilename		= this->getBinaryCacheFilename( sKey );
+	std::ifstream	ifsCache( sFilename.c_str(), std::ios::in | std::ios::binary );
+	cl_int			iErrorID, iBinaryStatus;
+	size_t			szKeyLength		= 0;
+	size_t			szBinaryLength	= 0;
+
+	if ( !ifsCache.is_open() )
+	{
+		pManager->log->writeLine( "Program binary cache miss for device #" + toString( this->device->getDeviceID() ) + "." );
+		return false;
+	}
+
+	// The full key is stored in the file so collisions and stale files are caught
+	ifsCache.read( reinterpret_cast<char*>( &szKeyLength ), sizeof( size_t ) );
+	if ( !ifsCache.good() || szKeyLength != sKey.length() )
+	{
+		pManager->log->writeLine( "Program binary cache mismatch for device #" + toString( this->device->getDeviceID() ) + "." );
+		return false;
+	}
+
+	std::string sStoredKey( szKeyLength, '\0' );
+	ifsCache.read( &sStoredKey[0], szKeyLength );
+	ifsCache.read( reinterpret_cast<char*>( &szBinaryLength ), sizeof( size_t ) );
+	if ( !ifsCache.good() || sStoredKey != sKey || szBinaryLength == 0 )
+	{
+		pManager->log->writeLine( "Program binary cache mismatch for device #" + toString( this->device->getDeviceID() ) + "." );
+		return false;
+	}
+
+	unsigned char* ucBinary = new unsigned char[ szBinaryLength ];
+	ifsCache.read( reinterpret_cast<char*>( ucBinary ), szBinaryLength );
+	if ( static_cast<size_t>( ifsCache.gcount() ) != szBinaryLength )
+	{
+		delete [] ucBinary;
+		pManager->log->writeLine( "Program binary cache file is truncated for device #" + toString( this->device->getDeviceID() ) + "." );
+		return false;
+	}
+	ifsCache.close();
+
+	cl_device_id	clDevice	= this->device->getDevice();
+	const unsigned char* ucBinaryPtr = ucBinary;
+
+	clProgram = clCreateProgramWithBinary(
+		this->clContext,
+		1,
+		&clDevice,
+		&szBinaryLength,
+		&ucBinaryPtr,
+		&iBinaryStatus,
+		&iErrorID
+	);
+
+	delete [] ucBinary;
+
+	if ( iErrorID != CL_SUCCESS || iBinaryStatus != CL_SUCCESS )
+	{
+		if ( clProgram != NULL )
+			clReleaseProgram( clProgram );
+		clProgram = NULL;
+		model::doError(
+			"Cached program binary was rejected by device #" + toString( this->device->getDeviceID() ) + ". Building from source.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	iErrorID = clBuildProgram(
+		clProgram,
+		NULL,
+		NULL,
+		sCompileParameters.c_str(),
+		NULL,
+		NULL
+	);
+
+	if ( iErrorID != CL_SUCCESS )
+	{
+		clReleaseProgram( clProgram );
+		clProgram = NULL;
+		model::doError(
+			"Cached program binary could not be built on device #" + toString( this->device->getDeviceID() ) + ". Building from source.",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	pManager->log->writeLine( "Program binary cache hit for device #" + toString( this->device->getDeviceID() ) + "." );
+
+	return true;
+}
+
+/*
+ *  Store the binary for a program compiled from source in the cache
+ */
+bool COCLProgram::saveBinaryToCache(
+		std::string		sKey
+	)
+{
+	std::string		sFilename		= this->getBinaryCacheFilename( sKey );
+	cl_int			iErrorID;
+	size_t			szBinaryLength	= 0;
+	size_t			szKeyLength		= sKey.length();
+
+	// Program is only built for a single device
+	iErrorID = clGetProgramInfo(
+		clProgram,
+		CL_PROGRAM_BINARY_SIZES,
+		sizeof( size_t ),
+		&szBinaryLength,
+		NULL
+	);
+
+	if ( iErrorID != CL_SUCCESS || szBinaryLength == 0 )
+	{
+		model::doError(
+			"Could not obtain the program binary for device #" + toString( this->device->getDeviceID() ) + ".",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	unsigned char* ucBinary = new unsigned char[ szBinaryLength ];
+
+	iErrorID = clGetProgramInfo(
+		clProgram,
+		CL_PROGRAM_BINARIES,
+		sizeof( unsigned char* ),
+		&ucBinary,
+		NULL
+	);
+
+	if ( iErrorID != CL_SUCCESS )
+	{
+		delete [] ucBinary;
+		model::doError(
+			"Could not obtain the program binary for device #" + toString( this->device->getDeviceID() ) + ".",
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	// Write to a temporary file first so other processes never see a partial binary
+	std::string		sTempFilename	= sFilename + "." + toString( this->device->getDeviceID() ) + ".tmp";
+	std::ofstream	ofsCache( sTempFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+
+	if ( !ofsCache.is_open() )
+	{
+		delete [] ucBinary;
+		model::doError(
+			"Could not write to the program binary cache in " + this->execController->getBinaryCacheDir(),
+			model::errorCodes::kLevelWarning
+		);
+		return false;
+	}
+
+	ofsCache.write( reinterpret_cast<const char*>( &szKeyLength ), sizeof( size_t ) );
+	ofsCache.write( sKey.c_str(), szKeyLength );
+	ofsCache.write( reinterpret_cast<const char*>( &szBinaryLength ), sizeof( size_t ) );
+	ofsCache.write( reinterpret_cast<const char*>( ucBinary ), szBinaryLength );
+	ofsCache.close();
+
+	delete [] ucBinary;
+
+	std::remove( sFilename.c_str() );
+	if ( std::rename( sTempFilename.c_str(), sFilename.c_str() ) != 0 )
+	{
+		std::remove( sTempFilename.c_str() );
+		return false;
+	}
+
+	pManager->log->writeLine( "Program binary stored in cache for device #" + toString( this->device->getDeviceID() ) + "." );
+
+	return true;
+}
+
 /*
  *  Get OpenCL code representing the constants defined
  */
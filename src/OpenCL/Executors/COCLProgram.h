@@ -56,6 +56,10 @@ public:
 protected:
 	OCL_RAW_CODE				getConstantsHeader( void );		
 	OCL_RAW_CODE				getExtensionsHeader( void );			
+	std::string					getBinaryCacheKey( OCL_RAW_CODE*, cl_uint );
+	std::string					getBinaryCacheFilename( std::string );
+	bool						loadBinaryFromCache( std::string );
+	bool						saveBinaryToCache( std::string );
 
 	CExecutorControlOpenCL*		execController;
 	COCLDevice*					device;
@@ -41,7 +41,6 @@ CScheme::CScheme()
 	this->bReady				= false;
 	this->bRunning				= false;
 	this->bThreadRunning		= false;
-	this->bThreadTerminated		= false;
 
 	this->bAutomaticQueue		= true;
 	this->uiQueueAdditionSize	= 1;
@@ -53,6 +52,9 @@ CScheme::CScheme()
 	this->uiBatchSkipped		= 0;
 	this->uiBatchSuccessful		= 0;
 	this->dBatchTimesteps		= 0.0;
+	this->dComputeSeconds		= 0.0;
+	this->bAccumulators			= false;
+	this->bGauges				= false;
 }
 
 /*
@@ -19,6 +19,10 @@
 #ifndef HIPIMS_SCHEMES_CSCHEME_H_
 #define HIPIMS_SCHEMES_CSCHEME_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "../General/CBenchmark.h"
 #include "../Domain/CDomain.h"
 #include "../OpenCL/Executors/CExecutorControlOpenCL.h"
@@ -27,6 +31,8 @@
 #include "../OpenCL/Executors/COCLKernel.h"
 #include "../OpenCL/Executors/COCLBuffer.h"
 
+struct sCheckpointHeader;
+
 namespace model {
 
 // Model scheme types
@@ -113,8 +119,10 @@ class CScheme
 		unsigned int		getBatchSize()					{ return uiQueueAdditionSize; }			// Get the batch size
 		unsigned int		getIterationsSuccessful()		{ return uiBatchSuccessful; }			// Get the successful iterations
 		unsigned int		getIterationsSkipped()			{ return uiBatchSkipped; }				// Get the number of iterations skipped
+		double				getComputeSeconds()				{ return dComputeSeconds; }				// Get the time spent running batches
+		void				resetComputeSeconds()			{ dComputeSeconds = 0.0; }				// Restart the count of time spent running batches
 
-		virtual void		readDomainAll() = 0;													// Read back all domain data
+		virtual void		readDomainAll( void* = NULL ) = 0;										// Read back all domain data
 		virtual void		importLinkZoneData() = 0;												// Read back synchronisation zone data
 		virtual void		prepareSimulation() = 0;												// Set everything up to start running for this domain
 		virtual void		readKeyStatistics() = 0;												// Fetch the key statistics back to the right places in memory
@@ -122,11 +130,22 @@ class CScheme
 		virtual void		cleanupSimulation() = 0;												// Dispose of transient data and clean-up this domain
 		virtual void		rollbackSimulation( double, double ) = 0;								// Roll back cell states to the last successful round
 		virtual void		saveCurrentState() = 0;													// Save current cell states
+		virtual void		readCheckpointState( sCheckpointHeader* ) = 0;							// Fetch the time and timestep data for a checkpoint
+		virtual void		restoreCheckpointState( sCheckpointHeader* ) = 0;						// Restore time, timestep and cell state data from a checkpoint
 		virtual void		forceTimeAdvance() = 0;													// Force time advance (when synced will stall)
 		virtual bool		isSimulationFailure( double ) = 0;										// Check whether we successfully reached a specific time
 		virtual bool		isSimulationSyncReady( double ) = 0;									// Are we ready to synchronise? i.e. have we reached the set sync time?
 		virtual COCLBuffer*	getLastCellSourceBuffer() = 0;											// Get the last source cell state buffer
 		virtual COCLBuffer*	getNextCellSourceBuffer() = 0;											// Get the next source cell state buffer
+		virtual COCLProgram*	getProgram() = 0;														// Get the program the scheme's kernels belong to
+		virtual void		enableAccumulators() = 0;												// Track flood maxima, arrival times and durations on the device
+		bool				getAccumulatorsEnabled()		{ return bAccumulators; }				// Are the accumulators being updated?
+		virtual void		readAccumulators( void* = NULL ) = 0;									// Read back the accumulator data
+		virtual void		writeAccumulators( void* ) = 0;											// Replace the accumulator data
+		virtual void		enableGauges( std::vector<unsigned long>*, double, unsigned int ) = 0;	// Sample gauge cells into a device-side ring buffer
+		bool				getGaugesEnabled()				{ return bGauges; }						// Are the gauges being sampled?
+		virtual void		readGauges( unsigned int, unsigned int, void* ) = 0;					// Read back a range of gauge sample slots
+		virtual void		readOutputFields( std::vector<unsigned char>*, void* ) = 0;				// Derive output values on the device and read them back
 
 	protected:
 
@@ -134,9 +153,11 @@ class CScheme
 		// ...
 
 		// Private variables
-		bool				bRunning;																// Is this simulation currently running?
-		bool				bThreadRunning;															// Is the worker thread running?
-		bool				bThreadTerminated;														// Has the worker thread been terminated?
+		std::atomic<bool>	bRunning;																// Is this simulation currently running?
+		std::atomic<bool>	bThreadRunning;															// Is the worker thread running?
+		std::thread			thrBatch;																// Worker thread which runs each batch
+		std::mutex			mtxBatch;																// Guards the running state for the worker thread
+		std::condition_variable	cvBatch;															// Signalled when the worker thread has work or must stop
 		bool				bReady;																	// Is the scheme ready?
 		bool				bBatchComplete;															// Is the batch done?
 		bool				bBatchError;															// Have we run out of room?
@@ -157,6 +178,9 @@ class CScheme
 		cl_uint				uiBatchSkipped;															// Number of skipped batch iterations
 		cl_uint				uiBatchSuccessful;														// Number of successful batch iterations
 		cl_uint				uiBatchRate;															// Number of successful iterations per second
+		double				dComputeSeconds;														// Time spent running batches since last reset
+		bool				bAccumulators;															// Are the per-cell accumulators in use?
+		bool				bGauges;																// Are gauge cells being sampled?
 		CDomain*			pDomain;																// Domain which this scheme is attached to
 		
 };
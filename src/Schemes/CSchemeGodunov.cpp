@@ -20,6 +20,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string_regex.hpp>
 #include <algorithm>
+#include <chrono>
 
 #include "../common.h"
 #include "../main.h"
@@ -30,6 +31,8 @@
 #include "../Domain/Links/CDomainLink.h"
 #include "../Domain/Cartesian/CDomainCartesian.h"
 #include "../Datasets/CXMLDataset.h"
+#include "../Datasets/CCheckpointDataset.h"
+#include "../Datasets/CRasterDataset.h"
 #include "CSchemeGodunov.h"
 #include "CSchemeMUSCLHancock.h"
 #include "CSchemeInertial.h"
@@ -47,7 +50,6 @@ CSchemeGodunov::CSchemeGodunov()
 	// Default setup values
 	this->bRunning						= false;
 	this->bThreadRunning				= false;
-	this->bThreadTerminated				= false;
 	this->bDebugOutput					= false;
 	this->uiDebugCellX					= 9999;
 	this->uiDebugCellY					= 9999;
@@ -55,9 +57,15 @@ CSchemeGodunov::CSchemeGodunov()
 	this->dCurrentTime					= 0.0;
 	this->dThresholdVerySmall			= 1E-10;
 	this->dThresholdQuiteSmall			= this->dThresholdVerySmall * 10;
+	this->dInundationThreshold			= 0.1;
 	this->bFrictionInFluxKernel			= true;
 	this->bIncludeBoundaries			= false;
 	this->uiTimestepReductionWavefronts = 200;
+	this->uiGaugeCount					= 0;
+	this->uiGaugeSamples				= 0;
+	this->uiOutputFieldCapacity			= 0;
+	this->bParallelFinalReduction		= true;
+	this->bActiveTiles					= false;
 
 	this->ucSolverType					= model::solverTypes::kHLLC;
 	this->ucConfiguration				= model::schemeConfigurations::godunovType::kCacheNone;
@@ -67,12 +75,15 @@ CSchemeGodunov::CSchemeGodunov()
 	this->ulCachedWorkgroupSizeY		= 0;
 	this->ulNonCachedWorkgroupSizeX		= 0;
 	this->ulNonCachedWorkgroupSizeY		= 0;
+	this->ulActiveTilesX				= 0;
+	this->ulActiveTilesY				= 0;
 
 	this->dBoundaryTimeSeries			= NULL;
 	this->fBoundaryTimeSeries			= NULL;
 	this->uiBoundaryParameters			= NULL;
 	this->ulBoundaryRelationCells		= NULL;
 	this->uiBoundaryRelationSeries		= NULL;
+	this->clEventIterationTail			= NULL;
 
 	// Default null values for OpenCL objects
 	oclModel							= NULL;
@@ -82,6 +93,12 @@ CSchemeGodunov::CSchemeGodunov()
 	oclKernelTimeAdvance				= NULL;
 	oclKernelResetCounters				= NULL;
 	oclKernelTimestepUpdate				= NULL;
+	oclKernelActiveMark					= NULL;
+	oclKernelActiveList					= NULL;
+	oclKernelAccumulate					= NULL;
+	oclKernelGaugeSample				= NULL;
+	oclKernelOutputFields				= NULL;
+	oclKernelOutputAccumulators			= NULL;
 	oclBufferCellStates					= NULL;
 	oclBufferCellStatesAlt				= NULL;
 	oclBufferCellManning				= NULL;
@@ -91,6 +108,17 @@ CSchemeGodunov::CSchemeGodunov()
 	oclBufferTime						= NULL;
 	oclBufferTimeTarget					= NULL;
 	oclBufferTimeHydrological			= NULL;
+	oclBufferActiveFlags				= NULL;
+	oclBufferActiveList					= NULL;
+	oclBufferActiveCount				= NULL;
+	oclBufferAccumulators				= NULL;
+	oclBufferAccumulatorsSaved			= NULL;
+	oclBufferGaugeSettings				= NULL;
+	oclBufferGaugeInterval				= NULL;
+	oclBufferGaugeCells					= NULL;
+	oclBufferGaugeSamples				= NULL;
+	oclBufferOutputFieldCodes			= NULL;
+	oclBufferOutputFields				= NULL;
 
 	if ( this->bDebugOutput )
 		model::doError( "Debug mode is enabled!", model::errorCodes::kLevelWarning );
@@ -103,6 +131,8 @@ CSchemeGodunov::CSchemeGodunov()
  */
 CSchemeGodunov::~CSchemeGodunov(void)
 {
+	// The worker thread mustn't outlive the scheme
+	this->cleanupSimulation();
 	this->releaseResources();
 	pManager->log->writeLine( "The Godunov scheme class was unloaded from memory." );
 }
@@ -149,6 +179,18 @@ void	CSchemeGodunov::setupFromConfig( XMLElement* pXScheme, bool bInheritanceCha
 				this->setDryThreshold( boost::lexical_cast<double>( cParameterValue ) );
 			}
 		}
+		else if ( strcmp( cParameterName, "inundationthreshold" ) == 0 )
+		{ 
+			if ( !CXMLDataset::isValidFloat( cParameterValue ) )
+			{
+				model::doError(
+					"Invalid inundation threshold depth given.",
+					model::errorCodes::kLevelWarning
+				);
+			} else {
+				this->setInundationThreshold( boost::lexical_cast<double>( cParameterValue ) );
+			}
+		}
 		else if ( strcmp( cParameterName, "timestepmode" ) == 0 )
 		{ 
 			unsigned char ucTimestepMode = 255;
@@ -192,6 +234,40 @@ void	CSchemeGodunov::setupFromConfig( XMLElement* pXScheme, bool bInheritanceCha
 				this->setReductionWavefronts( boost::lexical_cast<unsigned int>( cParameterValue ) );
 			}
 		}
+		else if ( strcmp( cParameterName, "timestepreductionparallel" ) == 0 )
+		{ 
+			unsigned char ucParallel = 255;
+			if ( strcmp( cParameterValue, "yes" ) == 0 )
+				ucParallel = 1;
+			if ( strcmp( cParameterValue, "no" ) == 0 )
+				ucParallel = 0;
+			if ( ucParallel == 255 )
+			{
+				model::doError(
+					"Invalid final reduction state given.",
+					model::errorCodes::kLevelWarning
+				);
+			} else {
+				this->setParallelFinalReduction( ucParallel == 1 );
+			}
+		}
+		else if ( strcmp( cParameterName, "activetiles" ) == 0 )
+		{ 
+			unsigned char ucActive = 255;
+			if ( strcmp( cParameterValue, "yes" ) == 0 )
+				ucActive = 1;
+			if ( strcmp( cParameterValue, "no" ) == 0 )
+				ucActive = 0;
+			if ( ucActive == 255 )
+			{
+				model::doError(
+					"Invalid active tiles state given.",
+					model::errorCodes::kLevelWarning
+				);
+			} else {
+				this->setActiveTiles( ucActive == 1 );
+			}
+		}
 		else if ( strcmp( cParameterName, "frictioneffects" ) == 0 )
 		{ 
 			unsigned char ucFriction = 255;
@@ -369,9 +445,11 @@ void CSchemeGodunov::logDetails()
 	pManager->log->writeLine( "  Courant number:     " + (std::string)( this->bDynamicTimestep ? toString( this->dCourantNumber ) : "N/A" ), true, wColour );
 	pManager->log->writeLine( "  Initial timestep:   " + Util::secondsToTime( this->dTimestep ), true, wColour );
 	pManager->log->writeLine( "  Data reduction:     " + toString(this->uiTimestepReductionWavefronts) + " divisions", true, wColour);
+	pManager->log->writeLine( "  Final reduction:    " + (std::string)( this->bParallelFinalReduction ? "Parallel" : "Serial" ), true, wColour);
 	pManager->log->writeLine( "  Boundaries:         " + toString(this->pDomain->getBoundaries()->getBoundaryCount()), true, wColour);
 	pManager->log->writeLine( "  Riemann solver:     " + sSolver, true, wColour );
 	pManager->log->writeLine( "  Configuration:      " + sConfiguration, true, wColour );
+	pManager->log->writeLine( "  Active tiles:       " + (std::string)( this->bActiveTiles ? "Enabled" : "Disabled" ), true, wColour );
 	pManager->log->writeLine( "  Friction effects:   " + (std::string)( this->bFrictionEffects ? "Enabled" : "Disabled" ), true, wColour );
 	pManager->log->writeLine( "  Kernel queue mode:  " + (std::string)( this->bAutomaticQueue ? "Automatic" : "Fixed size" ), true, wColour );
 	pManager->log->writeLine( (std::string)( this->bAutomaticQueue ? "  Initial queue:      " : "  Fixed queue:        " ) + toString( this->uiQueueAdditionSize ) + " iteration(s)", true, wColour );
@@ -488,6 +566,9 @@ bool CSchemeGodunov::prepareCode()
 	oclModel->appendCodeFromResource( "CLFriction_H" );
 	oclModel->appendCodeFromResource( "CLSolverHLLC_H" );
 	oclModel->appendCodeFromResource( "CLDynamicTimestep_H" );
+	oclModel->appendCodeFromResource( "CLAccumulators_H" );
+	oclModel->appendCodeFromResource( "CLGauges_H" );
+	oclModel->appendCodeFromResource( "CLOutputFields_H" );
 	oclModel->appendCodeFromResource( "CLSchemeGodunov_H" );
 	oclModel->appendCodeFromResource( "CLBoundaries_H" );
 
@@ -495,6 +576,9 @@ bool CSchemeGodunov::prepareCode()
 	oclModel->appendCodeFromResource( "CLFriction_C" );
 	oclModel->appendCodeFromResource( "CLSolverHLLC_C" );
 	oclModel->appendCodeFromResource( "CLDynamicTimestep_C" );
+	oclModel->appendCodeFromResource( "CLAccumulators_C" );
+	oclModel->appendCodeFromResource( "CLGauges_C" );
+	oclModel->appendCodeFromResource( "CLOutputFields_C" );
 	oclModel->appendCodeFromResource( "CLSchemeGodunov_C" );
 	oclModel->appendCodeFromResource( "CLBoundaries_C" );
 
@@ -531,6 +615,22 @@ double	CSchemeGodunov::getDryThreshold()
 	return this->dThresholdVerySmall;
 }
 
+/*
+ *  Set the depth counted as inundated by the accumulators
+ */
+void	CSchemeGodunov::setInundationThreshold( double dThresholdDepth )
+{
+	this->dInundationThreshold = dThresholdDepth;
+}
+
+/*
+ *  Get the depth counted as inundated by the accumulators
+ */
+double	CSchemeGodunov::getInundationThreshold()
+{
+	return this->dInundationThreshold;
+}
+
 /*
  *  Set number of wavefronts used in reductions
  */
@@ -547,6 +647,38 @@ unsigned int	CSchemeGodunov::getReductionWavefronts()
 	return this->uiTimestepReductionWavefronts;
 }
 
+/*
+ *  Set whether the final reduction stage is parallel
+ */
+void	CSchemeGodunov::setParallelFinalReduction( bool bParallel )
+{
+	this->bParallelFinalReduction = bParallel;
+}
+
+/*
+ *  Get whether the final reduction stage is parallel
+ */
+bool	CSchemeGodunov::getParallelFinalReduction()
+{
+	return this->bParallelFinalReduction;
+}
+
+/*
+ *  Set whether the scheme kernel is only launched over active tiles
+ */
+void	CSchemeGodunov::setActiveTiles( bool bActive )
+{
+	this->bActiveTiles = bActive;
+}
+
+/*
+ *  Get whether the scheme kernel is only launched over active tiles
+ */
+bool	CSchemeGodunov::getActiveTiles()
+{
+	return this->bActiveTiles;
+}
+
 /*
  *  Set the Riemann solver to use
  */
@@ -657,6 +789,24 @@ bool CSchemeGodunov::prepare1OExecDimensions()
 	//ulReductionWorkgroupSize = pDevice->clDeviceMaxWorkGroupSize / 2;
 	ulReductionGlobalSize = static_cast<unsigned long>( ceil( ( static_cast<double>(pDomain->getCellCount()) / this->uiTimestepReductionWavefronts ) / ulReductionWorkgroupSize ) * ulReductionWorkgroupSize );
 
+	// --
+	// Active tiles (2D)
+	// --
+
+	// Tiles match the non-cached workgroups, so the cached kernels and
+	// the second-order schemes can't use them
+	if ( this->bActiveTiles && this->ucConfiguration != model::schemeConfigurations::godunovType::kCacheNone )
+	{
+		model::doError(
+			"Active tiles require a configuration without caching. Disabled.",
+			model::errorCodes::kLevelWarning
+		);
+		this->bActiveTiles = false;
+	}
+
+	ulActiveTilesX = static_cast<cl_ulong>( ceil( static_cast<double>( pDomain->getCols() ) / ulNonCachedWorkgroupSizeX ) );
+	ulActiveTilesY = static_cast<cl_ulong>( ceil( static_cast<double>( pDomain->getRows() ) / ulNonCachedWorkgroupSizeY ) );
+
 	return bReturnState;
 }
 
@@ -673,6 +823,30 @@ bool CSchemeGodunov::prepare1OConstants()
 	oclModel->registerConstant( "VERY_SMALL",			toString( this->dThresholdVerySmall ) );
 	oclModel->registerConstant( "QUITE_SMALL",			toString( this->dThresholdQuiteSmall ) );
 
+	// --
+	// Depth counted as inundated for arrival times and durations
+	// --
+	oclModel->registerConstant( "INUNDATION_THRESHOLD",	toString( this->dInundationThreshold ) );
+
+	// --
+	// Output fields derived on the device, coded as the raster values
+	// --
+	oclModel->registerConstant( "FIELD_DEPTH",			toString( model::rasterDatasets::dataValues::kDepth ) );
+	oclModel->registerConstant( "FIELD_FSL",			toString( model::rasterDatasets::dataValues::kFreeSurfaceLevel ) );
+	oclModel->registerConstant( "FIELD_MAXDEPTH",		toString( model::rasterDatasets::dataValues::kMaxDepth ) );
+	oclModel->registerConstant( "FIELD_MAXFSL",			toString( model::rasterDatasets::dataValues::kMaxFSL ) );
+	oclModel->registerConstant( "FIELD_VELOCITYX",		toString( model::rasterDatasets::dataValues::kVelocityX ) );
+	oclModel->registerConstant( "FIELD_VELOCITYY",		toString( model::rasterDatasets::dataValues::kVelocityY ) );
+	oclModel->registerConstant( "FIELD_DISCHARGEX",		toString( model::rasterDatasets::dataValues::kDischargeX ) );
+	oclModel->registerConstant( "FIELD_DISCHARGEY",		toString( model::rasterDatasets::dataValues::kDischargeY ) );
+	oclModel->registerConstant( "FIELD_FROUDE",			toString( model::rasterDatasets::dataValues::kFroudeNumber ) );
+	oclModel->registerConstant( "FIELD_SPEED",			toString( model::rasterDatasets::dataValues::kSpeed ) );
+	oclModel->registerConstant( "FIELD_UNITDISCHARGE",	toString( model::rasterDatasets::dataValues::kUnitDischarge ) );
+	oclModel->registerConstant( "FIELD_MAXVELOCITY",	toString( model::rasterDatasets::dataValues::kMaxVelocity ) );
+	oclModel->registerConstant( "FIELD_MAXHAZARD",		toString( model::rasterDatasets::dataValues::kMaxHazard ) );
+	oclModel->registerConstant( "FIELD_ARRIVALTIME",	toString( model::rasterDatasets::dataValues::kArrivalTime ) );
+	oclModel->registerConstant( "FIELD_DURATION",		toString( model::rasterDatasets::dataValues::kDuration ) );
+
 	// --
 	// Debug mode 
 	// --
@@ -712,6 +886,33 @@ bool CSchemeGodunov::prepare1OConstants()
 		"__attribute__((reqd_work_group_size(" + toString( this->ulReductionWorkgroupSize )  + ", 1, 1)))"
 	);
 
+	// Only launch the scheme kernel over tiles which aren't dry
+	if ( this->bActiveTiles )
+	{
+		oclModel->registerConstant( "USE_ACTIVE_TILES", "1" );
+		oclModel->registerConstant( "ACTIVE_TILES_X", toString( this->ulActiveTilesX ) );
+		oclModel->registerConstant( "ACTIVE_TILES_Y", toString( this->ulActiveTilesY ) );
+	} else {
+		oclModel->removeConstant( "USE_ACTIVE_TILES" );
+	}
+
+	// The time advancing kernels run as a single workgroup when they also
+	// carry out the final stage of the timestep reduction
+	if ( this->bDynamicTimestep && this->bParallelFinalReduction )
+	{
+		oclModel->registerConstant( "TIMESTEP_REDUCE_PARALLEL", "1" );
+		oclModel->registerConstant( 
+			"REQD_WG_SIZE_ADVANCE", 
+			"__attribute__((reqd_work_group_size(" + toString( this->ulReductionWorkgroupSize )  + ", 1, 1)))"
+		);
+	} else {
+		oclModel->removeConstant( "TIMESTEP_REDUCE_PARALLEL" );
+		oclModel->registerConstant( 
+			"REQD_WG_SIZE_ADVANCE", 
+			"__attribute__((reqd_work_group_size(1, 1, 1)))"
+		);
+	}
+
 	// --
 	// Size of local cache arrays
 	// --
@@ -780,6 +981,13 @@ bool CSchemeGodunov::prepare1OConstants()
 	oclModel->registerConstant( "DOMAIN_DELTAX",		toString( dResolution ) );
 	oclModel->registerConstant( "DOMAIN_DELTAY",		toString( dResolution ) );
 
+	if ( pManager->getCellStateLayout() == model::cellStateLayout::kStructureOfArrays )
+	{
+		oclModel->registerConstant( "USE_SOA_STATE", "1" );
+	} else {
+		oclModel->removeConstant( "USE_SOA_STATE" );
+	}
+
 	return true;
 }
 
@@ -879,6 +1087,21 @@ bool CSchemeGodunov::prepare1OMemory()
 	oclBufferTimestepReduction = new COCLBuffer( "Timestep reduction scratch", oclModel, false, true, this->ulReductionGlobalSize * ucFloatSize, true );
 	oclBufferTimestepReduction->createBuffer();
 
+	// --
+	// Active tile flags and list
+	// --
+
+	if ( this->bActiveTiles )
+	{
+		oclBufferActiveFlags = new COCLBuffer( "Active tile flags", oclModel, false, true, this->ulActiveTilesX * this->ulActiveTilesY * sizeof( cl_uchar ), true );
+		oclBufferActiveList	 = new COCLBuffer( "Active tile list", oclModel, false, true, this->ulActiveTilesX * this->ulActiveTilesY * sizeof( cl_uint ), true );
+		oclBufferActiveCount = new COCLBuffer( "Active tile count", oclModel, false, true, sizeof( cl_uint ), true );
+		*( oclBufferActiveCount->getHostBlock<cl_uint*>() )	= 0;
+		oclBufferActiveFlags->createBuffer();
+		oclBufferActiveList->createBuffer();
+		oclBufferActiveCount->createBuffer();
+	}
+
 	// TODO: Check buffers were created successfully before returning a positive response
 
 	// VISUALISER STUFF
@@ -908,10 +1131,18 @@ bool CSchemeGodunov::prepareGeneralKernels()
 	oclKernelTimestepReduction	= oclModel->getKernel( "tst_Reduce" );
 	oclKernelTimestepUpdate		= oclModel->getKernel( "tst_UpdateTimestep" );
 
-	oclKernelTimeAdvance->setGroupSize(1, 1, 1);
-	oclKernelTimeAdvance->setGlobalSize(1, 1, 1);
-	oclKernelTimestepUpdate->setGroupSize(1, 1, 1);
-	oclKernelTimestepUpdate->setGlobalSize(1, 1, 1);
+	if ( this->bDynamicTimestep && this->bParallelFinalReduction )
+	{
+		oclKernelTimeAdvance->setGroupSize( this->ulReductionWorkgroupSize );
+		oclKernelTimeAdvance->setGlobalSize( this->ulReductionWorkgroupSize );
+		oclKernelTimestepUpdate->setGroupSize( this->ulReductionWorkgroupSize );
+		oclKernelTimestepUpdate->setGlobalSize( this->ulReductionWorkgroupSize );
+	} else {
+		oclKernelTimeAdvance->setGroupSize(1, 1, 1);
+		oclKernelTimeAdvance->setGlobalSize(1, 1, 1);
+		oclKernelTimestepUpdate->setGroupSize(1, 1, 1);
+		oclKernelTimestepUpdate->setGlobalSize(1, 1, 1);
+	}
 	oclKernelResetCounters->setGroupSize(1, 1, 1);
 	oclKernelResetCounters->setGlobalSize(1, 1, 1);
 	oclKernelTimestepReduction->setGroupSize( this->ulReductionWorkgroupSize );
@@ -927,6 +1158,27 @@ bool CSchemeGodunov::prepareGeneralKernels()
 	oclKernelTimestepReduction->assignArguments( aryArgsTimeReduction );
 	oclKernelTimestepUpdate->assignArguments( aryArgsTimestepUpdate );
 
+	// --
+	// Active tile tracking
+	// --
+
+	if ( this->bActiveTiles )
+	{
+		oclKernelActiveMark		= oclModel->getKernel( "act_MarkTiles" );
+		oclKernelActiveList		= oclModel->getKernel( "act_BuildList" );
+
+		oclKernelActiveMark->setGroupSize( this->ulNonCachedWorkgroupSizeX, this->ulNonCachedWorkgroupSizeY );
+		oclKernelActiveMark->setGlobalSize( this->ulActiveTilesX * this->ulNonCachedWorkgroupSizeX, this->ulActiveTilesY * this->ulNonCachedWorkgroupSizeY );
+		oclKernelActiveList->setGroupSize( 64 );
+		oclKernelActiveList->setGlobalSize( this->ulActiveTilesX * this->ulActiveTilesY );
+
+		COCLBuffer* aryArgsActiveMark[]		= { oclBufferTimestep, oclBufferCellBed, oclBufferCellStates, oclBufferActiveFlags, oclBufferActiveCount };
+		COCLBuffer* aryArgsActiveList[]		= { oclBufferActiveFlags, oclBufferActiveList, oclBufferActiveCount };
+
+		oclKernelActiveMark->assignArguments( aryArgsActiveMark );
+		oclKernelActiveList->assignArguments( aryArgsActiveList );
+	}
+
 	// --
 	// Boundaries and friction etc.
 	// --
@@ -959,8 +1211,14 @@ bool CSchemeGodunov::prepare1OKernels()
 	{
 		oclKernelFullTimestep = oclModel->getKernel( "gts_cacheDisabled" );
 		oclKernelFullTimestep->setGroupSize( this->ulNonCachedWorkgroupSizeX, this->ulNonCachedWorkgroupSizeY );
-		oclKernelFullTimestep->setGlobalSize( this->ulNonCachedGlobalSizeX, this->ulNonCachedGlobalSizeY );
-		COCLBuffer* aryArgsFullTimestep[] = { oclBufferTimestep, oclBufferCellBed, oclBufferCellStates, oclBufferCellStatesAlt, oclBufferCellManning };	
+		if ( this->bActiveTiles )
+		{
+			// One workgroup for every tile, in case they're all active
+			oclKernelFullTimestep->setGlobalSize( this->ulActiveTilesX * this->ulActiveTilesY * this->ulNonCachedWorkgroupSizeX, this->ulNonCachedWorkgroupSizeY );
+		} else {
+			oclKernelFullTimestep->setGlobalSize( this->ulNonCachedGlobalSizeX, this->ulNonCachedGlobalSizeY );
+		}
+		COCLBuffer* aryArgsFullTimestep[] = { oclBufferTimestep, oclBufferCellBed, oclBufferCellStates, oclBufferCellStatesAlt, oclBufferCellManning, oclBufferActiveList, oclBufferActiveCount };	
 		oclKernelFullTimestep->assignArguments( aryArgsFullTimestep );
 	}
 	if ( this->ucConfiguration == model::schemeConfigurations::godunovType::kCacheEnabled )
@@ -975,6 +1233,86 @@ bool CSchemeGodunov::prepare1OKernels()
 	return bReturnState;
 }
 
+/*
+ *  Create the buffers and kernel which track the maximum velocity and hazard,
+ *  arrival time and duration of flooding in every cell. These are only needed
+ *  if an output asks for them, so are created once the outputs are known.
+ */
+void CSchemeGodunov::enableAccumulators()
+{
+	if ( this->bAccumulators )
+		return;
+
+	unsigned char ucFloatSize =  ( pManager->getFloatPrecision() == model::floatPrecision::kSingle ? sizeof( cl_float ) : sizeof( cl_double ) );
+	cl_ulong ulSize = ucFloatSize * 4 * this->pDomain->getCellCount();
+
+	oclBufferAccumulators		= new COCLBuffer( "Accumulators", oclModel, false, true, ulSize, true );
+	oclBufferAccumulatorsSaved	= new COCLBuffer( "Accumulators (saved)", oclModel, false, false, ulSize, false );
+
+	oclBufferAccumulators->createBuffer();
+	oclBufferAccumulatorsSaved->createBuffer();
+
+	oclKernelAccumulate = oclModel->getKernel( "acc_Update" );
+	oclKernelAccumulate->setGroupSize( this->ulNonCachedWorkgroupSizeX, this->ulNonCachedWorkgroupSizeY );
+	oclKernelAccumulate->setGlobalSize( this->ulNonCachedGlobalSizeX, this->ulNonCachedGlobalSizeY );
+
+	COCLBuffer* aryArgsAccumulate[] = { oclBufferTime, oclBufferTimestep, oclBufferCellBed, oclBufferCellStates, oclBufferAccumulators };
+	oclKernelAccumulate->assignArguments( aryArgsAccumulate );
+
+	this->bAccumulators = true;
+
+	pManager->log->writeLine( "Device-side accumulators enabled with an inundation threshold of " + toString( this->dInundationThreshold ) + "m." );
+}
+
+/*
+ *  Create the buffers and kernel which sample the cell states at a list of
+ *  gauge cells into a ring buffer on the device, every time the simulation
+ *  passes a multiple of the interval. Only the slots filled since the last
+ *  readback need to be fetched.
+ */
+void CSchemeGodunov::enableGauges( std::vector<unsigned long>* vCells, double dInterval, unsigned int uiSamples )
+{
+	if ( this->bGauges || vCells->empty() )
+		return;
+
+	unsigned char ucFloatSize =  ( pManager->getFloatPrecision() == model::floatPrecision::kSingle ? sizeof( cl_float ) : sizeof( cl_double ) );
+
+	this->uiGaugeCount		= vCells->size();
+	this->uiGaugeSamples	= uiSamples;
+
+	oclBufferGaugeSettings	= new COCLBuffer( "Gauge settings", oclModel, true, true, sizeof( cl_ulong ) * 2, true );
+	oclBufferGaugeInterval	= new COCLBuffer( "Gauge interval", oclModel, true, true, ucFloatSize, true );
+	oclBufferGaugeCells		= new COCLBuffer( "Gauge cells", oclModel, true, true, sizeof( cl_ulong ) * this->uiGaugeCount, true );
+	oclBufferGaugeSamples	= new COCLBuffer( "Gauge samples", oclModel, false, true, ucFloatSize * 4 * this->uiGaugeCount * this->uiGaugeSamples, true );
+
+	oclBufferGaugeSettings->getHostBlock<cl_ulong*>()[0] = this->uiGaugeCount;
+	oclBufferGaugeSettings->getHostBlock<cl_ulong*>()[1] = this->uiGaugeSamples;
+	if ( pManager->getFloatPrecision() == model::floatPrecision::kSingle )
+	{
+		*( oclBufferGaugeInterval->getHostBlock<float*>() )	= static_cast<cl_float>( dInterval );
+	} else {
+		*( oclBufferGaugeInterval->getHostBlock<double*>() )	= dInterval;
+	}
+	for ( unsigned int i = 0; i < this->uiGaugeCount; i++ )
+		oclBufferGaugeCells->getHostBlock<cl_ulong*>()[ i ] = ( *vCells )[ i ];
+
+	oclBufferGaugeSettings->createBuffer();
+	oclBufferGaugeInterval->createBuffer();
+	oclBufferGaugeCells->createBuffer();
+	oclBufferGaugeSamples->createBuffer();
+
+	oclKernelGaugeSample = oclModel->getKernel( "gau_Sample" );
+	oclKernelGaugeSample->setGroupSize( 64 );
+	oclKernelGaugeSample->setGlobalSize( (cl_ulong)ceil( this->uiGaugeCount / 64.0 ) * 64 );
+
+	COCLBuffer* aryArgsGaugeSample[] = { oclBufferTime, oclBufferTimestep, oclBufferCellStates, oclBufferGaugeSettings, oclBufferGaugeInterval, oclBufferGaugeCells, oclBufferGaugeSamples };
+	oclKernelGaugeSample->assignArguments( aryArgsGaugeSample );
+
+	this->bGauges = true;
+
+	pManager->log->writeLine( "Sampling " + toString( this->uiGaugeCount ) + " gauge(s) every " + Util::secondsToTime( dInterval ) + " on the device." );
+}
+
 /*
  *  Release all OpenCL resources consumed using the OpenCL methods
  */
@@ -1003,6 +1341,12 @@ void CSchemeGodunov::release1OResources()
 	if ( this->oclKernelTimeAdvance != NULL )				delete oclKernelTimeAdvance;
 	if ( this->oclKernelTimestepUpdate != NULL )			delete oclKernelTimestepUpdate;
 	if ( this->oclKernelResetCounters != NULL )				delete oclKernelResetCounters;
+	if ( this->oclKernelActiveMark != NULL )				delete oclKernelActiveMark;
+	if ( this->oclKernelActiveList != NULL )				delete oclKernelActiveList;
+	if ( this->oclKernelAccumulate != NULL )				delete oclKernelAccumulate;
+	if ( this->oclKernelGaugeSample != NULL )				delete oclKernelGaugeSample;
+	if ( this->oclKernelOutputFields != NULL )				delete oclKernelOutputFields;
+	if ( this->oclKernelOutputAccumulators != NULL )		delete oclKernelOutputAccumulators;
 	if ( this->oclBufferCellStates != NULL )				delete oclBufferCellStates;
 	if ( this->oclBufferCellStatesAlt != NULL )				delete oclBufferCellStatesAlt;
 	if ( this->oclBufferCellManning != NULL )				delete oclBufferCellManning;
@@ -1012,6 +1356,17 @@ void CSchemeGodunov::release1OResources()
 	if ( this->oclBufferTime != NULL )						delete oclBufferTime;
 	if ( this->oclBufferTimeTarget != NULL )				delete oclBufferTimeTarget;
 	if ( this->oclBufferTimeHydrological != NULL )			delete oclBufferTimeHydrological;
+	if ( this->oclBufferActiveFlags != NULL )				delete oclBufferActiveFlags;
+	if ( this->oclBufferActiveList != NULL )				delete oclBufferActiveList;
+	if ( this->oclBufferActiveCount != NULL )				delete oclBufferActiveCount;
+	if ( this->oclBufferAccumulators != NULL )				delete oclBufferAccumulators;
+	if ( this->oclBufferAccumulatorsSaved != NULL )			delete oclBufferAccumulatorsSaved;
+	if ( this->oclBufferGaugeSettings != NULL )				delete oclBufferGaugeSettings;
+	if ( this->oclBufferGaugeInterval != NULL )				delete oclBufferGaugeInterval;
+	if ( this->oclBufferGaugeCells != NULL )				delete oclBufferGaugeCells;
+	if ( this->oclBufferGaugeSamples != NULL )				delete oclBufferGaugeSamples;
+	if ( this->oclBufferOutputFieldCodes != NULL )			delete oclBufferOutputFieldCodes;
+	if ( this->oclBufferOutputFields != NULL )				delete oclBufferOutputFields;
 
 	oclModel						= NULL;
 	oclKernelFullTimestep			= NULL;
@@ -1020,6 +1375,12 @@ void CSchemeGodunov::release1OResources()
 	oclKernelTimeAdvance			= NULL;
 	oclKernelResetCounters			= NULL;
 	oclKernelTimestepUpdate			= NULL;
+	oclKernelActiveMark				= NULL;
+	oclKernelActiveList				= NULL;
+	oclKernelAccumulate				= NULL;
+	oclKernelGaugeSample			= NULL;
+	oclKernelOutputFields			= NULL;
+	oclKernelOutputAccumulators		= NULL;
 	oclBufferCellStates				= NULL;
 	oclBufferCellStatesAlt			= NULL;
 	oclBufferCellManning			= NULL;
@@ -1029,6 +1390,20 @@ void CSchemeGodunov::release1OResources()
 	oclBufferTime					= NULL;
 	oclBufferTimeTarget				= NULL;
 	oclBufferTimeHydrological		= NULL;
+	oclBufferActiveFlags			= NULL;
+	oclBufferActiveList				= NULL;
+	oclBufferActiveCount			= NULL;
+	oclBufferAccumulators			= NULL;
+	oclBufferAccumulatorsSaved		= NULL;
+	oclBufferGaugeSettings			= NULL;
+	oclBufferGaugeInterval			= NULL;
+	oclBufferGaugeCells				= NULL;
+	oclBufferGaugeSamples			= NULL;
+	oclBufferOutputFieldCodes		= NULL;
+	oclBufferOutputFields			= NULL;
+	this->uiOutputFieldCapacity		= 0;
+	this->bAccumulators				= false;
+	this->bGauges					= false;
 
 	if ( this->bIncludeBoundaries )
 	{
@@ -1070,6 +1445,47 @@ void	CSchemeGodunov::prepareSimulation()
 	oclBufferTimeHydrological->queueWriteAll();
 	this->pDomain->getDevice()->blockUntilFinished();
 
+	// Nothing has flooded yet, and there's no arrival time
+	if ( this->bAccumulators )
+	{
+		for ( unsigned long ulCellID = 0; ulCellID < this->pDomain->getCellCount(); ++ulCellID )
+		{
+			for ( unsigned char ucIndex = 0; ucIndex < 4; ++ucIndex )
+			{
+				double dInitial = ( ucIndex == model::accumulatorIndices::kAccumulatorArrivalTime ? -9999.0 : 0.0 );
+				if ( pManager->getFloatPrecision() == model::floatPrecision::kSingle )
+				{
+					oclBufferAccumulators->getHostBlock<cl_float*>()[ ulCellID * 4 + ucIndex ] = static_cast<cl_float>( dInitial );
+				} else {
+					oclBufferAccumulators->getHostBlock<cl_double*>()[ ulCellID * 4 + ucIndex ] = dInitial;
+				}
+			}
+		}
+		oclBufferAccumulators->queueWriteAll();
+		this->pDomain->getDevice()->blockUntilFinished();
+		oclBufferAccumulators->queueCopyTo( oclBufferAccumulatorsSaved, 0, 0, oclBufferAccumulators->getSize() );
+		this->pDomain->getDevice()->blockUntilFinished();
+	}
+
+	// Gauge sample slots are marked empty with a negative time
+	if ( this->bGauges )
+	{
+		for ( unsigned long ulSlot = 0; ulSlot < static_cast<unsigned long>( this->uiGaugeSamples ) * this->uiGaugeCount; ++ulSlot )
+		{
+			for ( unsigned char ucIndex = 0; ucIndex < 4; ++ucIndex )
+			{
+				if ( pManager->getFloatPrecision() == model::floatPrecision::kSingle )
+				{
+					oclBufferGaugeSamples->getHostBlock<cl_float*>()[ ulSlot * 4 + ucIndex ] = -9999.0f;
+				} else {
+					oclBufferGaugeSamples->getHostBlock<cl_double*>()[ ulSlot * 4 + ucIndex ] = -9999.0;
+				}
+			}
+		}
+		oclBufferGaugeSamples->queueWriteAll();
+		this->pDomain->getDevice()->blockUntilFinished();
+	}
+
 	// Sort out memory alternation
 	bUseAlternateKernel		= false;
 	bOverrideTimestep		= false;
@@ -1090,54 +1506,27 @@ void	CSchemeGodunov::prepareSimulation()
 	// States
 	bRunning = false;
 	bThreadRunning = false;
-	bThreadTerminated = false;
-}
-
-#ifdef PLATFORM_WIN
-DWORD CSchemeGodunov::Threaded_runBatchLaunch(LPVOID param)
-{
-	CSchemeGodunov* pScheme = static_cast<CSchemeGodunov*>(param);
-	pScheme->Threaded_runBatch();
-	return 0;
-}
-#endif
-#ifdef PLATFORM_UNIX
-void* CSchemeGodunov::Threaded_runBatchLaunch(void* param)
-{
-	CSchemeGodunov* pScheme = static_cast<CSchemeGodunov*>(param);
-	pScheme->Threaded_runBatch();
-	return 0;
 }
-#endif
 
 /*
  *	Create a new thread to run this batch using
  */
 void CSchemeGodunov::runBatchThread()
 {
-	if (this->bThreadRunning)
+	if (this->thrBatch.joinable())
+	{
+		// Wake the existing thread
+		this->cvBatch.notify_one();
 		return;
+	}
 
-	this->bThreadRunning = true;
-	this->bThreadTerminated = false;
-
-#ifdef PLATFORM_WIN
-	HANDLE hThread = CreateThread(
-		NULL,
-		0,
-		(LPTHREAD_START_ROUTINE)CSchemeGodunov::Threaded_runBatchLaunch,
-		this,
-		0,
-		NULL
-		);
-	CloseHandle(hThread);
-#endif
-#ifdef PLATFORM_UNIX
-	pthread_t tid;
-	int result = pthread_create(&tid, 0, CSchemeGodunov::Threaded_runBatchLaunch, this);
-	if (result == 0)
-		pthread_detach(tid);
-#endif
+	{
+		std::lock_guard<std::mutex> lockBatch( this->mtxBatch );
+		this->bThreadRunning = true;
+	}
+
+	// Joined in cleanupSimulation(), so the scheme outlives the thread
+	this->thrBatch = std::thread( &CSchemeGodunov::Threaded_runBatch, this );
 }
 
 /*
@@ -1148,18 +1537,26 @@ void CSchemeGodunov::Threaded_runBatch()
 {
 	// Keep the thread in existence because of the overhead
 	// associated with creating a thread.
-	while (this->bThreadRunning)
+	while (true)
 	{
-		// Are we expected to run?
-		if  (!this->bRunning || this->pDomain->getDevice()->isBusy())
+		// Sleep until we're expected to run
 		{
-			if ( this->pDomain->getDevice()->isBusy() )
-			{
-				this->pDomain->getDevice()->blockUntilFinished();
-			}
-			continue;
+			std::unique_lock<std::mutex> lockBatch( this->mtxBatch );
+			this->cvBatch.wait( 
+				lockBatch, 
+				[this]{ return this->bRunning || !this->bThreadRunning; } 
+			);
+			if (!this->bThreadRunning)
+				break;
 		}
 
+		// Time spent on each batch is used to balance work between domains
+		std::chrono::steady_clock::time_point tBatchStart = std::chrono::steady_clock::now();
+
+		// Anything still queued outside of a batch must finish first
+		if ( this->pDomain->getDevice()->isBusy() )
+			this->pDomain->getDevice()->blockUntilFinished();
+
 		// Have we been asked to update the target time?
 		if (this->bUpdateTargetTime)
 		{
@@ -1284,6 +1681,9 @@ void CSchemeGodunov::Threaded_runBatch()
 		if ( uiIterationsSinceSync < this->pDomain->getRollbackLimit() &&
 			 this->dCurrentTime < dTargetTime )
 		{
+			// Boundaries streamed from disk need data up to the target time
+			pDomain->getBoundaries()->streamBoundaries( this->dCurrentTime );
+
 			for (unsigned int i = 0; i < uiQueueAmount; i++)
 			{
 #ifdef DEBUG_MPI
@@ -1300,6 +1700,15 @@ void CSchemeGodunov::Threaded_runBatch()
 				bUseAlternateKernel = !bUseAlternateKernel;
 			}
 
+			// Reads and writes don't carry wait lists, so everything
+			// else must still wait for the whole batch
+			this->pDomain->getDevice()->queueBarrier();
+			if ( this->clEventIterationTail != NULL )
+			{
+				clReleaseEvent( this->clEventIterationTail );
+				this->clEventIterationTail = NULL;
+			}
+
 			// A further download will be required...
 			this->bCellStatesSynced = false;
 		}
@@ -1343,6 +1752,12 @@ void CSchemeGodunov::Threaded_runBatch()
 		// Are cell states now synced?
 		if (bDownloadLinks)
 		{
+			// Pass the link data on to domains on this node while they finish
+			for (unsigned int i = 0; i < this->pDomain->getDependentLinkCount(); i++)
+			{
+				this->pDomain->getDependentLink(i)->stageOnTarget();
+			}
+
 			bDownloadLinks = false;
 			bCellStatesSynced = true;
 		}
@@ -1361,11 +1776,15 @@ void CSchemeGodunov::Threaded_runBatch()
 		}
 #endif
 		
+		this->dComputeSeconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - tBatchStart ).count();
+
 		// Wait until further work is scheduled
-		this->bRunning = false;
+		{
+			std::lock_guard<std::mutex> lockBatch( this->mtxBatch );
+			this->bRunning = false;
+		}
+		pManager->notifyBatchComplete();
 	}
-
-	this->bThreadTerminated = true;
 }
 
 /*
@@ -1448,7 +1867,10 @@ void	CSchemeGodunov::runSimulation( double dTargetTime, double dRealTime )
 	}
 
 	dBatchStartedTime = dRealTime;
-	this->bRunning = true;
+	{
+		std::lock_guard<std::mutex> lockBatch( this->mtxBatch );
+		this->bRunning = true;
+	}
 	this->runBatchThread();
 }
 
@@ -1461,11 +1883,16 @@ void	CSchemeGodunov::cleanupSimulation()
 	dBatchStartedTime = 0.0;
 
 	// Kill the worker thread
-	bRunning = false;
-	bThreadRunning = false;
+	{
+		std::lock_guard<std::mutex> lockBatch( this->mtxBatch );
+		bRunning = false;
+		bThreadRunning = false;
+	}
+	this->cvBatch.notify_all();
 
 	// Wait for the thread to terminate before returning
-	while (!bThreadTerminated && bThreadRunning) {}
+	if (this->thrBatch.joinable())
+		this->thrBatch.join();
 }
 
 /*
@@ -1497,6 +1924,10 @@ void	CSchemeGodunov::rollbackSimulation( double dCurrentTime, double dTargetTime
 	oclBufferCellStatesAlt->queueWriteAll();
 	oclBufferCellStates->queueWriteAll();
 
+	// Accumulators go back to the same point as the cell states
+	if ( this->bAccumulators )
+		oclBufferAccumulatorsSaved->queueCopyTo( oclBufferAccumulators, 0, 0, oclBufferAccumulators->getSize() );
+
 	// Schedule timestep calculation again
 	// Timestep reduction
 	if ( this->bDynamicTimestep )
@@ -1627,55 +2058,271 @@ void	CSchemeGodunov::scheduleIteration(
 		oclKernelFullTimestep->assignArgument( 3, oclBufferCellStates );
 		oclKernelFriction->assignArgument( 1, oclBufferCellStates );
 		oclKernelTimestepReduction->assignArgument( 3, oclBufferCellStates );
+		if ( this->bActiveTiles )
+			oclKernelActiveMark->assignArgument( 2, oclBufferCellStatesAlt );
 	} else {
 		oclKernelFullTimestep->assignArgument( 2, oclBufferCellStates );
 		oclKernelFullTimestep->assignArgument( 3, oclBufferCellStatesAlt );
 		oclKernelFriction->assignArgument( 1, oclBufferCellStatesAlt );
 		oclKernelTimestepReduction->assignArgument( 3, oclBufferCellStatesAlt );
+		if ( this->bActiveTiles )
+			oclKernelActiveMark->assignArgument( 2, oclBufferCellStates );
 	}
 
-	// Run the boundary kernels (each bndy has its own kernel now)
-	pDomain->getBoundaries()->applyBoundaries(bUseAlternateKernel ? oclBufferCellStatesAlt : oclBufferCellStates);
-	pDevice->queueBarrier();
+	// Run the boundary kernels (each bndy has its own kernel now) once the
+	// previous iteration has finished
+	std::vector<cl_event>	clBoundaryEvents;
+	cl_event				clEventLast = NULL;
 
-	// Main scheme kernel
-	oclKernelFullTimestep->scheduleExecution();
-	pDevice->queueBarrier();
+	pDomain->getBoundaries()->applyBoundaries(
+		bUseAlternateKernel ? oclBufferCellStatesAlt : oclBufferCellStates,
+		this->clEventIterationTail,
+		&clBoundaryEvents
+	);
 
-	// Friction
-	if ( this->bFrictionEffects && !this->bFrictionInFluxKernel )
+	// Main scheme kernel (or the active tile marking before it) waits on
+	// every boundary, or the previous iteration if there aren't any
+	if ( clBoundaryEvents.empty() && this->clEventIterationTail != NULL )
+		clBoundaryEvents.push_back( this->clEventIterationTail );
+	( this->bActiveTiles ? oclKernelActiveMark : oclKernelFullTimestep )->scheduleExecution(
+		clBoundaryEvents.size(),
+		( clBoundaryEvents.empty() ? NULL : &clBoundaryEvents[0] ),
+		&clEventLast
+	);
+	for ( unsigned int i = 0; i < clBoundaryEvents.size(); i++ )
 	{
-		oclKernelFriction->scheduleExecution();
-		pDevice->queueBarrier();
+		if ( clBoundaryEvents[i] != this->clEventIterationTail )
+			clReleaseEvent( clBoundaryEvents[i] );
 	}
+	if ( this->clEventIterationTail != NULL )
+		clReleaseEvent( this->clEventIterationTail );
 
-	// Timestep reduction
-	if ( this->bDynamicTimestep )
+	// Compact the list of wet tiles to process
+	if ( this->bActiveTiles )
 	{
-		oclKernelTimestepReduction->scheduleExecution();
-		pDevice->queueBarrier();
+		this->scheduleAfter( oclKernelActiveList, &clEventLast );
+		this->scheduleAfter( oclKernelFullTimestep, &clEventLast );
 	}
 
+	// Friction
+	if ( this->bFrictionEffects && !this->bFrictionInFluxKernel )
+		this->scheduleAfter( oclKernelFriction, &clEventLast );
+
+	// Timestep reduction
+	if ( this->bDynamicTimestep )
+		this->scheduleAfter( oclKernelTimestepReduction, &clEventLast );
+
+	// Accumulators and gauges see the final states, before the time moves on
+	this->scheduleAccumulation( bUseAlternateKernel ? oclBufferCellStates : oclBufferCellStatesAlt, &clEventLast );
+	this->scheduleGaugeSampling( bUseAlternateKernel ? oclBufferCellStates : oclBufferCellStatesAlt, &clEventLast );
+
 	// Time advancing
-	oclKernelTimeAdvance->scheduleExecution();
-	pDevice->queueBarrier();
+	this->scheduleAfter( oclKernelTimeAdvance, &clEventLast );
+	this->clEventIterationTail = clEventLast;
 
 	// Only block after every iteration when testing things that need it...
 	// Big performance hit...
 	//pDevice->blockUntilFinished();
 }
 
+/*
+ *  Schedule a kernel to run once the given event has completed, and
+ *  replace the event with the one for the new kernel
+ */
+void	CSchemeGodunov::scheduleAfter( COCLKernel* pKernel, cl_event* clEvent )
+{
+	cl_event	clEventNew = NULL;
+
+	pKernel->scheduleExecution(
+		( *clEvent != NULL ? 1 : 0 ),
+		( *clEvent != NULL ? clEvent : NULL ),
+		&clEventNew
+	);
+
+	if ( *clEvent != NULL )
+		clReleaseEvent( *clEvent );
+	*clEvent = clEventNew;
+}
+
+/*
+ *  Schedule the accumulator update over the cell states an iteration has
+ *  just written, if any outputs need the accumulators
+ */
+void	CSchemeGodunov::scheduleAccumulation( COCLBuffer* pCellStates, cl_event* clEvent )
+{
+	if ( !this->bAccumulators )
+		return;
+
+	oclKernelAccumulate->assignArgument( 3, pCellStates );
+	this->scheduleAfter( oclKernelAccumulate, clEvent );
+}
+
+/*
+ *  Schedule the gauge sampling over the cell states an iteration has just
+ *  written, if there are any gauges
+ */
+void	CSchemeGodunov::scheduleGaugeSampling( COCLBuffer* pCellStates, cl_event* clEvent )
+{
+	if ( !this->bGauges )
+		return;
+
+	oclKernelGaugeSample->assignArgument( 2, pCellStates );
+	this->scheduleAfter( oclKernelGaugeSample, clEvent );
+}
+
 /*
  *  Read back all of the domain data
  */
-void CSchemeGodunov::readDomainAll()
+void CSchemeGodunov::readDomainAll( void* pTarget )
 {
 	if ( bUseAlternateKernel )
 	{
-		oclBufferCellStatesAlt->queueReadAll();
+		oclBufferCellStatesAlt->queueReadAll( pTarget );
 	} else {
-		oclBufferCellStates->queueReadAll();
+		oclBufferCellStates->queueReadAll( pTarget );
+	}
+}
+
+/*
+ *  Read back the accumulator data, which is held as four values per cell
+ *  regardless of the cell state layout
+ */
+void CSchemeGodunov::readAccumulators( void* pTarget )
+{
+	if ( !this->bAccumulators )
+		return;
+
+	oclBufferAccumulators->queueReadAll( pTarget );
+}
+
+/*
+ *  Replace the accumulator data on the device, and the saved copy used
+ *  for rollbacks, such as when the domain has been recreated
+ */
+void CSchemeGodunov::writeAccumulators( void* pSource )
+{
+	if ( !this->bAccumulators )
+		return;
+
+	memcpy( oclBufferAccumulators->getHostBlock<void*>(), pSource, static_cast<size_t>( oclBufferAccumulators->getSize() ) );
+	oclBufferAccumulators->queueWriteAll();
+	pDomain->getDevice()->blockUntilFinished();
+	oclBufferAccumulators->queueCopyTo( oclBufferAccumulatorsSaved, 0, 0, oclBufferAccumulators->getSize() );
+	pDomain->getDevice()->blockUntilFinished();
+}
+
+/*
+ *  Read back a contiguous range of slots from the gauge ring buffer, into
+ *  the same position within a host copy of the whole ring
+ */
+void CSchemeGodunov::readGauges( unsigned int uiFirstSlot, unsigned int uiSlots, void* pTarget )
+{
+	if ( !this->bGauges || uiSlots == 0 )
+		return;
+
+	cl_ulong ulSlotSize = oclBufferGaugeSamples->getSize() / this->uiGaugeSamples;
+
+	oclBufferGaugeSamples->queueReadPartial(
+		ulSlotSize * uiFirstSlot,
+		static_cast<size_t>( ulSlotSize * uiSlots ),
+		static_cast<char*>( pTarget ) + ulSlotSize * uiFirstSlot
+	);
+}
+
+/*
+ *  Calculate the requested output values for every cell on the device and
+ *  read them back as consecutive single-precision planes, one per field,
+ *  in place of the full cell states. Accumulator planes are filled by a
+ *  second kernel once the others are done. Must be called when the domain
+ *  is idle.
+ */
+void CSchemeGodunov::readOutputFields( std::vector<unsigned char>* vFields, void* pTarget )
+{
+	if ( vFields->empty() )
+		return;
+
+	if ( vFields->size() > uiMaxOutputFields )
+	{
+		model::doError(
+			"Too many output fields requested at once.",
+			model::errorCodes::kLevelWarning
+		);
+		return;
 	}
+
+	if ( oclKernelOutputFields == NULL )
+	{
+		oclBufferOutputFieldCodes = new COCLBuffer( "Output field codes", oclModel, true, true, sizeof( cl_uint ) * ( uiMaxOutputFields + 1 ), true );
+		oclBufferOutputFieldCodes->createBuffer();
+
+		oclKernelOutputFields = oclModel->getKernel( "out_Derive" );
+		oclKernelOutputFields->setGroupSize( this->ulNonCachedWorkgroupSizeX, this->ulNonCachedWorkgroupSizeY );
+		oclKernelOutputFields->setGlobalSize( this->ulNonCachedGlobalSizeX, this->ulNonCachedGlobalSizeY );
+	}
+
+	// Only grows, so the buffer suits the largest set of outputs seen
+	if ( vFields->size() > this->uiOutputFieldCapacity )
+	{
+		if ( oclBufferOutputFields != NULL )
+			delete oclBufferOutputFields;
+
+		this->uiOutputFieldCapacity	= vFields->size();
+		oclBufferOutputFields		= new COCLBuffer( "Output fields", oclModel, false, false, sizeof( cl_float ) * this->pDomain->getCellCount() * this->uiOutputFieldCapacity, false );
+		oclBufferOutputFields->createBuffer();
+	}
+
+	cl_uint* uiCodes = oclBufferOutputFieldCodes->getHostBlock<cl_uint*>();
+	uiCodes[0] = vFields->size();
+	for ( unsigned int i = 0; i < vFields->size(); i++ )
+		uiCodes[ i + 1 ] = ( *vFields )[ i ];
+
+	bool bStateFields		= false;
+	bool bAccumulatorFields	= false;
+	for ( unsigned int i = 0; i < vFields->size(); i++ )
+	{
+		if ( CRasterDataset::isAccumulatorValue( ( *vFields )[ i ] ) )
+		{
+			bAccumulatorFields = true;
+		} else {
+			bStateFields = true;
+		}
+	}
+
+	if ( bAccumulatorFields && !this->bAccumulators )
+	{
+		model::doError(
+			"Accumulator outputs were requested without the accumulators enabled.",
+			model::errorCodes::kLevelWarning
+		);
+		return;
+	}
+
+	COCLBuffer* aryArgsOutputFields[] = { oclBufferCellBed, ( bUseAlternateKernel ? oclBufferCellStatesAlt : oclBufferCellStates ), oclBufferOutputFieldCodes, oclBufferOutputFields };
+	oclKernelOutputFields->assignArguments( aryArgsOutputFields );
+
+	oclBufferOutputFieldCodes->queueWriteAll();
+	this->pDomain->getDevice()->queueBarrier();
+	if ( bStateFields )
+	{
+		oclKernelOutputFields->scheduleExecution();
+		this->pDomain->getDevice()->queueBarrier();
+	}
+
+	if ( bAccumulatorFields )
+	{
+		if ( oclKernelOutputAccumulators == NULL )
+		{
+			oclKernelOutputAccumulators = oclModel->getKernel( "out_DeriveAccumulators" );
+			oclKernelOutputAccumulators->setGroupSize( this->ulNonCachedWorkgroupSizeX, this->ulNonCachedWorkgroupSizeY );
+			oclKernelOutputAccumulators->setGlobalSize( this->ulNonCachedGlobalSizeX, this->ulNonCachedGlobalSizeY );
+		}
+
+		COCLBuffer* aryArgsOutputAccumulators[] = { ( bUseAlternateKernel ? oclBufferCellStatesAlt : oclBufferCellStates ), oclBufferAccumulators, oclBufferOutputFieldCodes, oclBufferOutputFields };
+		oclKernelOutputAccumulators->assignArguments( aryArgsOutputAccumulators );
+		oclKernelOutputAccumulators->scheduleExecution();
+		this->pDomain->getDevice()->queueBarrier();
+	}
+	oclBufferOutputFields->queueReadPartial( 0, sizeof( cl_float ) * this->pDomain->getCellCount() * vFields->size(), pTarget );
 }
 
 /*
@@ -1723,6 +2370,10 @@ void CSchemeGodunov::saveCurrentState()
 	// the last one saved to the normal cell state buffer...
 	getNextCellSourceBuffer()->queueReadAll();
 
+	// Accumulators are kept on the device alongside
+	if ( this->bAccumulators )
+		oclBufferAccumulators->queueCopyTo( oclBufferAccumulatorsSaved, 0, 0, oclBufferAccumulators->getSize() );
+
 	// Reset iteration tracking
 	// TODO: Should this be moved into the sync function?
 	uiIterationsSinceSync = 0;
@@ -1735,6 +2386,62 @@ void CSchemeGodunov::saveCurrentState()
 	//pDomain->getDevice()->blockUntilFinished();
 }
 
+/*
+ *  Fetch the time and timestep data to be stored in a checkpoint, which
+ *  must be taken while the domain is idle at a sync point
+ */
+void CSchemeGodunov::readCheckpointState( sCheckpointHeader* pHeader )
+{
+	oclBufferTime->queueReadAll();
+	oclBufferTimestep->queueReadAll();
+	oclBufferTimeHydrological->queueReadAll();
+	pDomain->getDevice()->blockUntilFinished();
+
+	if ( pManager->getFloatPrecision() == model::floatPrecision::kSingle )
+	{
+		pHeader->dTime				= static_cast<cl_double>( *( oclBufferTime->getHostBlock<float*>() ) );
+		pHeader->dTimestep			= static_cast<cl_double>( *( oclBufferTimestep->getHostBlock<float*>() ) );
+		pHeader->dTimeHydrological	= static_cast<cl_double>( *( oclBufferTimeHydrological->getHostBlock<float*>() ) );
+	} else {
+		pHeader->dTime				= *( oclBufferTime->getHostBlock<double*>() );
+		pHeader->dTimestep			= *( oclBufferTimestep->getHostBlock<double*>() );
+		pHeader->dTimeHydrological	= *( oclBufferTimeHydrological->getHostBlock<double*>() );
+	}
+	pHeader->dBatchTimesteps		= dBatchTimesteps;
+	pHeader->uiBatchSuccessful		= uiBatchSuccessful;
+}
+
+/*
+ *  Restore the state held in a checkpoint, once its cell states have been
+ *  loaded into the domain's memory
+ */
+void CSchemeGodunov::restoreCheckpointState( sCheckpointHeader* pHeader )
+{
+	this->dCurrentTime		= pHeader->dTime;
+	this->dCurrentTimestep	= pHeader->dTimestep;
+	this->dBatchTimesteps	= pHeader->dBatchTimesteps;
+	this->uiBatchSuccessful	= pHeader->uiBatchSuccessful;
+	this->dLastSyncTime		= pHeader->dTime;
+
+	if ( pManager->getFloatPrecision() == model::floatPrecision::kSingle )
+	{
+		*( oclBufferTime->getHostBlock<float*>() )				= static_cast<cl_float>( pHeader->dTime );
+		*( oclBufferTimestep->getHostBlock<float*>() )			= static_cast<cl_float>( pHeader->dTimestep );
+		*( oclBufferTimeHydrological->getHostBlock<float*>() )	= static_cast<cl_float>( pHeader->dTimeHydrological );
+	} else {
+		*( oclBufferTime->getHostBlock<double*>() )				= pHeader->dTime;
+		*( oclBufferTimestep->getHostBlock<double*>() )			= pHeader->dTimestep;
+		*( oclBufferTimeHydrological->getHostBlock<double*>() )	= pHeader->dTimeHydrological;
+	}
+
+	oclBufferCellStates->queueWriteAll();
+	oclBufferCellStatesAlt->queueWriteAll();
+	oclBufferTime->queueWriteAll();
+	oclBufferTimestep->queueWriteAll();
+	oclBufferTimeHydrological->queueWriteAll();
+	pDomain->getDevice()->blockUntilFinished();
+}
+
 /*
  *  Set the target sync time
  */
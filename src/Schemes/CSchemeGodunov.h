@@ -66,8 +66,14 @@ class CSchemeGodunov : public CScheme
 		void				forceTimestep( double );								// Force a specific timestep
 		void				setDryThreshold( double );								// Set the dry cell threshold depth
 		double				getDryThreshold();										// Get the dry cell threshold depth
+		void				setInundationThreshold( double );						// Set the depth counted as inundated by the accumulators
+		double				getInundationThreshold();								// Get the depth counted as inundated by the accumulators
 		void				setReductionWavefronts( unsigned int );					// Set number of wavefronts used in reductions
 		unsigned int		getReductionWavefronts();								// Get number of wavefronts used in reductions
+		void				setParallelFinalReduction( bool );						// Set whether the final reduction stage is parallel
+		bool				getParallelFinalReduction();							// Get whether the final reduction stage is parallel
+		void				setActiveTiles( bool );									// Set whether only active tiles are launched
+		bool				getActiveTiles();										// Get whether only active tiles are launched
 		void				setRiemannSolver( unsigned char );						// Set the Riemann solver to use
 		unsigned char		getRiemannSolver();										// Get the Riemann solver in use
 		void				setCacheMode( unsigned char );							// Set the cache configuration
@@ -82,23 +88,26 @@ class CSchemeGodunov : public CScheme
 		double				getAverageTimestep();									// Get batch average timestep
 		virtual COCLBuffer*	getLastCellSourceBuffer();								// Get the last source cell state buffer
 		virtual COCLBuffer*	getNextCellSourceBuffer();								// Get the next source cell state buffer
+		COCLProgram*		getProgram()				{ return oclModel; }		// Get the program the scheme's kernels belong to
+		virtual void		enableAccumulators();									// Track flood maxima, arrival times and durations on the device
+		virtual void		readAccumulators( void* = NULL );						// Read back the accumulator data
+		virtual void		writeAccumulators( void* );								// Replace the accumulator data
+		virtual void		enableGauges( std::vector<unsigned long>*, double, unsigned int );	// Sample gauge cells into a device-side ring buffer
+		virtual void		readGauges( unsigned int, unsigned int, void* );		// Read back a range of gauge sample slots
+		virtual void		readOutputFields( std::vector<unsigned char>*, void* );	// Derive output values on the device and read them back
 
-#ifdef PLATFORM_WIN
-		static DWORD		Threaded_runBatchLaunch(LPVOID param);
-#endif
-#ifdef PLATFORM_UNIX
-		static void*		Threaded_runBatchLaunch(void* param);
-#endif
 		void				runBatchThread();
 		void				Threaded_runBatch();
 
-		virtual void		readDomainAll();										// Read back all domain data
+		virtual void		readDomainAll( void* = NULL );							// Read back all domain data
 		virtual void		importLinkZoneData();									// Load in data
 		virtual void		prepareSimulation();									// Set everything up to start running for this domain
 		virtual void		readKeyStatistics();									// Fetch the key details back to the right places in memory
 		virtual void		runSimulation( double, double );						// Run this simulation until the specified time
 		virtual void		cleanupSimulation();									// Dispose of transient data and clean-up this domain
 		virtual void		saveCurrentState();										// Save current cell states
+		virtual void		readCheckpointState( sCheckpointHeader* );				// Fetch the time and timestep data for a checkpoint
+		virtual void		restoreCheckpointState( sCheckpointHeader* );			// Restore time, timestep and cell state data from a checkpoint
 		virtual void		forceTimeAdvance();										// Force time advance (when synced will stall)
 		virtual void		rollbackSimulation( double, double );					// Roll back cell states to the last successful round
 		virtual bool		isSimulationFailure( double );							// Check whether we successfully reached a specific time
@@ -115,6 +124,7 @@ class CSchemeGodunov : public CScheme
 		cl_ulong			ulBoundaryCellGlobalSize;
 		cl_ulong			ulReductionWorkgroupSize;
 		cl_ulong			ulReductionGlobalSize;
+		cl_ulong			ulActiveTilesX, ulActiveTilesY;
 
 		unsigned char		ucConfiguration;										// Kernel configuration in-use
 		unsigned char		ucCacheConstraints;										// Kernel LDS cache constraints
@@ -122,6 +132,7 @@ class CSchemeGodunov : public CScheme
 		unsigned char		ucSyncMethod;											// Synchronisation method employed
 		double				dThresholdVerySmall;									// Threshold value for 'very small'
 		double				dThresholdQuiteSmall;									// Threshold value for 'quite small'
+		double				dInundationThreshold;									// Depth counted as inundated for arrival times and durations
 		double				dLastSyncTime;											// What was the last synchronisation time?
 		bool				bDebugOutput;											// Debug output enabled in the scheme?
 		bool				bFrictionInFluxKernel;									// Process friction in the flux kernel?
@@ -133,14 +144,20 @@ class CSchemeGodunov : public CScheme
 		bool				bDownloadLinks;											// Download dependent links?
 		bool				bIncludeBoundaries;										// Boundary condition kernel is required?
 		bool				bCellStatesSynced;										// Are the host cell states synchronised with the compute device?
+		bool				bParallelFinalReduction;								// Reduce the workgroup results in parallel when advancing time?
+		bool				bActiveTiles;											// Launch the scheme kernel over wet tiles only?
 		unsigned int		uiDebugCellX;											// Debug info cell X
 		unsigned int		uiDebugCellY;											// Debug info cell Y
 		unsigned int		uiTimestepReductionWavefronts;							// Number of wavefronts used in reduction
+		unsigned int		uiGaugeCount;											// Number of gauge cells sampled
+		unsigned int		uiGaugeSamples;											// Number of samples held in the gauge ring buffer
+		unsigned int		uiOutputFieldCapacity;									// Number of output fields the buffer can hold
 		cl_double4*			dBoundaryTimeSeries;									// Boundary time series data
 		cl_float4*			fBoundaryTimeSeries;									// Boundary time series data
 		cl_ulong*			ulBoundaryRelationCells;								// Boundary to cell relations
 		cl_uint*			uiBoundaryRelationSeries;								// Target series for the boundary to cell relations
 		cl_uint*			uiBoundaryParameters;									// Boundary parameters bitmask
+		cl_event			clEventIterationTail;									// Event for the last kernel of the previous iteration
 		
 		// Private functions
 		virtual bool		prepareCode();											// Prepare the code required
@@ -152,6 +169,11 @@ class CSchemeGodunov : public CScheme
 		bool				prepare1OMemory();										// Prepare memory buffers required
 		bool				prepare1OExecDimensions();								// Size the problem for execution
 		void				release1OResources();									// Release 1st-order OpenCL resources consumed
+		void				scheduleAfter( COCLKernel*, cl_event* );				// Schedule a kernel after an event, replacing the event
+		void				scheduleAccumulation( COCLBuffer*, cl_event* );			// Schedule the accumulator update for an iteration's new states
+		void				scheduleGaugeSampling( COCLBuffer*, cl_event* );		// Schedule the gauge sampling for an iteration's new states
+
+		static const unsigned int	uiMaxOutputFields = 16;							// Most fields derived by one output kernel launch
 
 		// OpenCL elements
 		COCLProgram*		oclModel;
@@ -161,6 +183,12 @@ class CSchemeGodunov : public CScheme
 		COCLKernel*			oclKernelTimeAdvance;
 		COCLKernel*			oclKernelResetCounters;
 		COCLKernel*			oclKernelTimestepUpdate;
+		COCLKernel*			oclKernelActiveMark;
+		COCLKernel*			oclKernelActiveList;
+		COCLKernel*			oclKernelAccumulate;
+		COCLKernel*			oclKernelGaugeSample;
+		COCLKernel*			oclKernelOutputFields;
+		COCLKernel*			oclKernelOutputAccumulators;
 		COCLBuffer*			oclBufferCellStates;
 		COCLBuffer*			oclBufferCellStatesAlt;
 		COCLBuffer*			oclBufferCellManning;
@@ -173,6 +201,17 @@ class CSchemeGodunov : public CScheme
 		COCLBuffer*			oclBufferBatchTimesteps;
 		COCLBuffer*			oclBufferBatchSuccessful;
 		COCLBuffer*			oclBufferBatchSkipped;
+		COCLBuffer*			oclBufferActiveFlags;
+		COCLBuffer*			oclBufferActiveList;
+		COCLBuffer*			oclBufferActiveCount;
+		COCLBuffer*			oclBufferAccumulators;
+		COCLBuffer*			oclBufferAccumulatorsSaved;
+		COCLBuffer*			oclBufferGaugeSettings;
+		COCLBuffer*			oclBufferGaugeInterval;
+		COCLBuffer*			oclBufferGaugeCells;
+		COCLBuffer*			oclBufferGaugeSamples;
+		COCLBuffer*			oclBufferOutputFieldCodes;
+		COCLBuffer*			oclBufferOutputFields;
 
 };
 
@@ -188,6 +188,7 @@ void CSchemeInertial::logDetails()
 	pManager->log->writeLine( "  Data reduction:     " + toString( this->uiTimestepReductionWavefronts ) + " divisions", true, wColour );
 	pManager->log->writeLine( "  Boundaries:         " + toString( this->pDomain->getBoundaries()->getBoundaryCount() ), true, wColour );
 	pManager->log->writeLine( "  Configuration:      " + sConfiguration, true, wColour );
+	pManager->log->writeLine( "  Active tiles:       " + (std::string)( this->bActiveTiles ? "Enabled" : "Disabled" ), true, wColour );
 	pManager->log->writeLine( "  Friction effects:   " + (std::string)( this->bFrictionEffects ? "Enabled" : "Disabled" ), true, wColour );
 	pManager->log->writeLine( "  Kernel queue mode:  " + (std::string)( this->bAutomaticQueue ? "Automatic" : "Fixed size" ), true, wColour );
 	pManager->log->writeLine( (std::string)( this->bAutomaticQueue ? "  Initial queue:      " : "  Fixed queue:        " ) + toString( this->uiQueueAdditionSize ) + " iteration(s)", true, wColour );
@@ -206,12 +207,18 @@ bool CSchemeInertial::prepareCode()
 	oclModel->appendCodeFromResource( "CLDomainCartesian_H" );
 	oclModel->appendCodeFromResource( "CLFriction_H" );
 	oclModel->appendCodeFromResource( "CLDynamicTimestep_H" );
+	oclModel->appendCodeFromResource( "CLAccumulators_H" );
+	oclModel->appendCodeFromResource( "CLGauges_H" );
+	oclModel->appendCodeFromResource( "CLOutputFields_H" );
 	oclModel->appendCodeFromResource( "CLSchemeInertial_H" );
 	oclModel->appendCodeFromResource( "CLBoundaries_H" );
 
 	oclModel->appendCodeFromResource( "CLDomainCartesian_C" );
 	oclModel->appendCodeFromResource( "CLFriction_C" );
 	oclModel->appendCodeFromResource( "CLDynamicTimestep_C" );
+	oclModel->appendCodeFromResource( "CLAccumulators_C" );
+	oclModel->appendCodeFromResource( "CLGauges_C" );
+	oclModel->appendCodeFromResource( "CLOutputFields_C" );
 	oclModel->appendCodeFromResource( "CLSchemeInertial_C" );
 	oclModel->appendCodeFromResource( "CLBoundaries_C" );
 
@@ -268,8 +275,14 @@ bool CSchemeInertial::prepareInertialKernels()
 	{
 		oclKernelFullTimestep = oclModel->getKernel( "ine_cacheDisabled" );
 		oclKernelFullTimestep->setGroupSize( this->ulNonCachedWorkgroupSizeX, this->ulNonCachedWorkgroupSizeY );
-		oclKernelFullTimestep->setGlobalSize( this->ulNonCachedGlobalSizeX, this->ulNonCachedGlobalSizeY );
-		COCLBuffer* aryArgsFullTimestep[] = { oclBufferTimestep, oclBufferCellBed, oclBufferCellStates, oclBufferCellStatesAlt, oclBufferCellManning };	
+		if ( this->bActiveTiles )
+		{
+			// One workgroup for every tile, in case they're all active
+			oclKernelFullTimestep->setGlobalSize( this->ulActiveTilesX * this->ulActiveTilesY * this->ulNonCachedWorkgroupSizeX, this->ulNonCachedWorkgroupSizeY );
+		} else {
+			oclKernelFullTimestep->setGlobalSize( this->ulNonCachedGlobalSizeX, this->ulNonCachedGlobalSizeY );
+		}
+		COCLBuffer* aryArgsFullTimestep[] = { oclBufferTimestep, oclBufferCellBed, oclBufferCellStates, oclBufferCellStatesAlt, oclBufferCellManning, oclBufferActiveList, oclBufferActiveCount };	
 		oclKernelFullTimestep->assignArguments( aryArgsFullTimestep );
 	}
 	if ( this->ucConfiguration == model::schemeConfigurations::inertialFormula::kCacheEnabled )
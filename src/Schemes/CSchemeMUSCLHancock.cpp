@@ -328,6 +328,9 @@ bool CSchemeMUSCLHancock::prepareCode()
 	oclModel->appendCodeFromResource( "CLSlopeLimiterMINMOD_H" );
 	oclModel->appendCodeFromResource( "CLSolverHLLC_H" );
 	oclModel->appendCodeFromResource( "CLDynamicTimestep_H" );
+	oclModel->appendCodeFromResource( "CLAccumulators_H" );
+	oclModel->appendCodeFromResource( "CLGauges_H" );
+	oclModel->appendCodeFromResource( "CLOutputFields_H" );
 	oclModel->appendCodeFromResource( "CLSchemeMUSCLHancock_H" );
 	oclModel->appendCodeFromResource( "CLBoundaries_H" );
 
@@ -336,6 +339,9 @@ bool CSchemeMUSCLHancock::prepareCode()
 	oclModel->appendCodeFromResource( "CLSlopeLimiterMINMOD_C" );
 	oclModel->appendCodeFromResource( "CLSolverHLLC_C" );
 	oclModel->appendCodeFromResource( "CLDynamicTimestep_C" );
+	oclModel->appendCodeFromResource( "CLAccumulators_C" );
+	oclModel->appendCodeFromResource( "CLGauges_C" );
+	oclModel->appendCodeFromResource( "CLOutputFields_C" );
 	oclModel->appendCodeFromResource( "CLSchemeMUSCLHancock_C" );
 	oclModel->appendCodeFromResource( "CLBoundaries_C" );
 
@@ -649,34 +655,30 @@ void	CSchemeMUSCLHancock::scheduleIteration(
 					CDomain*					pDomain
 		)
 {
+	// Each kernel waits on the one before, starting from the end of the
+	// previous iteration
+	cl_event	clEventLast = this->clEventIterationTail;
+
 	// Half-timestep and full-timestep kernels
 	if ( this->ucConfiguration != model::schemeConfigurations::musclHancock::kCacheMaximum )
-	{
-		oclKernelHalfTimestep->scheduleExecution();
-		pDevice->queueBarrier();
-		oclKernelFullTimestep->scheduleExecution();	
-	} else {
-		oclKernelFullTimestep->scheduleExecution();	
-	}
-	pDevice->queueBarrier();
+		this->scheduleAfter( oclKernelHalfTimestep, &clEventLast );
+	this->scheduleAfter( oclKernelFullTimestep, &clEventLast );
 
 	// Friction
 	if ( this->bFrictionEffects && !this->bFrictionInFluxKernel )
-	{
-		oclKernelFriction->scheduleExecution();
-		pDevice->queueBarrier();
-	}
+		this->scheduleAfter( oclKernelFriction, &clEventLast );
 
 	// Timestep reduction
 	if ( this->bDynamicTimestep )
-	{
-		oclKernelTimestepReduction->scheduleExecution();
-		pDevice->queueBarrier();
-	}
+		this->scheduleAfter( oclKernelTimestepReduction, &clEventLast );
+
+	// Accumulators and gauges see the final states, before the time moves on
+	this->scheduleAccumulation( oclBufferCellStates, &clEventLast );
+	this->scheduleGaugeSampling( oclBufferCellStates, &clEventLast );
 
 	// Time advancing
-	oclKernelTimeAdvance->scheduleExecution();
-	pDevice->queueBarrier();
+	this->scheduleAfter( oclKernelTimeAdvance, &clEventLast );
+	this->clEventIterationTail = clEventLast;
 }
 
 
@@ -719,22 +721,22 @@ COCLBuffer* CSchemeMUSCLHancock::getNextCellSourceBuffer()
 /*
 *  Read back all of the domain data
 */
-void CSchemeMUSCLHancock::readDomainAll()
+void CSchemeMUSCLHancock::readDomainAll( void* pTarget )
 {
 	// There's only one cell state buffer in the MUSCL-Hancock scheme
 	// unless we're using the maximum caching version
 	switch (this->ucConfiguration)
 	{
 		default:
-			oclBufferCellStates->queueReadAll();
+			oclBufferCellStates->queueReadAll( pTarget );
 		break;
 		case model::schemeConfigurations::musclHancock::kCacheMaximum:
 			if (bUseAlternateKernel)
 			{
-				oclBufferCellStatesAlt->queueReadAll();
+				oclBufferCellStatesAlt->queueReadAll( pTarget );
 			}
 			else {
-				oclBufferCellStates->queueReadAll();
+				oclBufferCellStates->queueReadAll( pTarget );
 			}
 		break;
 	}
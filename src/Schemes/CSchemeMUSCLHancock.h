@@ -69,7 +69,7 @@ class CSchemeMUSCLHancock : public CSchemeGodunov
 		unsigned char		getCacheConstraints();							// Get LDS cache size constraints
 		void				setExtrapolatedContiguity( bool );				// Store extrapolated data contiguously?
 		bool				getExtrapolatedContiguity();					// Is extrapolated data stored contiguously?
-		void				readDomainAll();								// Fetch back all the domain data
+		void				readDomainAll( void* = NULL );					// Fetch back all the domain data
 		COCLBuffer*			getLastCellSourceBuffer();						// Get the last source cell state buffer
 		COCLBuffer*			getNextCellSourceBuffer();						// Get the next source cell state buffer
 
@@ -75,6 +75,14 @@ namespace floatPrecision{
 	};
 }
 
+// Cell state memory layout
+namespace cellStateLayout{
+	enum cellStateLayout {
+		kArrayOfStructures	= 0,	// Z, Zmax, Qx, Qy interleaved for each cell
+		kStructureOfArrays	= 1		// Separate planes for Z, Zmax, Qx and Qy
+	};
+}
+
 extern	CModel*			pManager;
 extern  char*			configFile;
 extern  char*			codeDir;
@@ -26,6 +26,7 @@
 #include "MPI/CMPIManager.h"
 #include "Datasets/CXMLDataset.h"
 #include "Datasets/CRasterDataset.h"
+#include "Datasets/CBinaryTableDataset.h"
 #include "OpenCL/Executors/COCLDevice.h"
 #include "Domain/CDomainManager.h"
 #include "Domain/CDomain.h"
@@ -38,6 +39,8 @@ char*					model::workingDir;
 char*					model::logFile;
 char*					model::configFile;
 char*					model::codeDir;
+char*					model::resumeDir;
+char*					model::convertFile;
 bool					model::quietMode;
 bool					model::forceAbort;
 bool					model::gdalInitiated;
@@ -63,6 +66,8 @@ int _tmain(int argc, char* argv[])
 	model::configFile	= new char[50];
 	model::logFile		= new char[50];
 	model::codeDir		= NULL;
+	model::resumeDir	= NULL;
+	model::convertFile	= NULL;
 	model::quietMode	= false;
 	model::forceAbort	= false;
 	model::gdalInitiated = true;
@@ -78,6 +83,7 @@ int _tmain(int argc, char* argv[])
 
 	model::storeWorkingEnv();
 	model::parseArguments( argc, argv );
+	if ( model::convertFile != NULL ) return model::convertTable();
 	CRasterDataset::registerAll();
 
 	int iReturnCode = model::loadConfiguration();
@@ -101,10 +107,13 @@ int main(int argc, char* argv[])
 	model::logFile		= new char[50];
 	std::strcpy( model::configFile, "configuration.xml" );
 	std::strcpy( model::logFile,    "_model.log" );
+	model::resumeDir	= NULL;
+	model::convertFile	= NULL;
 	model::quietMode	= false;
 	model::forceAbort	= false;
 	model::disableScreen = false;
 	model::disableConsole = false;
+	int iReturnCode;
 
 #ifdef MPI_ON
 	int iProvidedThreadSupport;
@@ -114,6 +123,16 @@ int main(int argc, char* argv[])
 	model::storeWorkingEnv();
 	model::parseArguments( argc, argv );
 
+	// Converting a table doesn't need the model
+	if ( model::convertFile != NULL )
+	{
+		iReturnCode = model::convertTable();
+#ifdef MPI_ON
+		MPI_Finalize();
+#endif
+		return iReturnCode;
+	}
+
 	// Seg fault handler
 	//signal(SIGSEGV, segFaultHandler);  
 
@@ -139,7 +158,7 @@ int main(int argc, char* argv[])
 
 	CRasterDataset::registerAll();
 
-	int iReturnCode = model::loadConfiguration();
+	iReturnCode = model::loadConfiguration();
 	if ( iReturnCode != model::appReturnCodes::kAppSuccess ) 
 		return iReturnCode;
 	iReturnCode = model::commenceSimulation();
@@ -464,7 +483,7 @@ int model::closeConfiguration()
 void model::parseArguments( int iArgCount, char* cArgEntities[] )
 {
 	// Arguments to check for
-	unsigned int	argOptionCount = 6;
+	unsigned int	argOptionCount = 8;
 	modelArgument	argOptions[]   = {
 		{	
 			"-c",
@@ -495,6 +514,16 @@ void model::parseArguments( int iArgCount, char* cArgEntities[] )
 			"-x",
 			"--code-dir\0",
 			"Directory containing the OpenCL code structure\0"
+		},
+		{
+			"-r",
+			"--resume\0",
+			"Resume from the checkpoints in a directory\0"
+		},
+		{
+			"-t",
+			"--convert-table\0",
+			"Convert a boundary CSV file to a binary table and exit\0"
 		}
 	};
 
@@ -548,6 +577,18 @@ void model::handleArgument( const char * cLongName, char * cValue )
 		strcpy( codeDir, cValue );
 	}
 
+	else if ( strcmp( cLongName, "--resume" ) == 0 )
+	{
+		resumeDir = new char[ strlen( cValue ) + 1 ];
+		strcpy( resumeDir, cValue );
+	}
+
+	else if ( strcmp( cLongName, "--convert-table" ) == 0 )
+	{
+		convertFile = new char[ strlen( cValue ) + 1 ];
+		strcpy( convertFile, cValue );
+	}
+
 	else if ( strcmp( cLongName, "--quiet-mode" ) == 0 )
 	{
 		model::quietMode = true;
@@ -578,6 +619,28 @@ void model::handleArgument( const char * cLongName, char * cValue )
 	}
 }
 
+/*
+ *  Convert a boundary CSV file to a binary table alongside it, without
+ *  loading a model
+ */
+int model::convertTable()
+{
+	boost::filesystem::path pTablePath( model::convertFile );
+	pTablePath.replace_extension( ".hbt" );
+
+	bool bConverted = CBinaryTableDataset::convertCSV( 
+		std::string( model::convertFile ), 
+		pTablePath.string() 
+	);
+
+	delete [] model::convertFile;
+	model::convertFile = NULL;
+
+	return bConverted ? 
+		model::appReturnCodes::kAppSuccess : 
+		model::appReturnCodes::kAppFatal;
+}
+
 /*
  *  Model is complete.
  */
@@ -590,6 +653,7 @@ int model::doClose( int iCode )
 	delete [] model::logFile;			// TODO: Fix me...
 	delete [] model::configFile;
 	delete [] model::codeDir;
+	delete [] model::resumeDir;
 	model::doPause();
 
 	pManager			= NULL;
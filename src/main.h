@@ -79,6 +79,7 @@ int						doClose( int );
 void					storeWorkingEnv();
 void					parseArguments( int, char*[] );
 void					handleArgument( const char *, char* );
+int						convertTable();
 
 // Data structures used in interop
 struct DomainData
@@ -160,6 +161,8 @@ extern	bool			disableScreen;
 extern	bool			disableConsole;
 extern	char*			workingDir;
 extern  char*			codeDir;
+extern  char*			resumeDir;
+extern  char*			convertFile;
 extern  char*			configFile;
 extern  char*			logFile;
 extern	CModel*			pManager;
@@ -79,7 +79,17 @@ namespace Util
 	double	round( double dValue, unsigned char ucPlaces )
 	{
 		unsigned int	uiMultiplier		= (unsigned int)std::pow( 10.0, ucPlaces );
-		double			dMultipliedValue	= dValue * uiMultiplier;
+
+		return roundScaled( dValue, static_cast<double>( uiMultiplier ) );
+	}
+
+	/*
+	 *  Round a number using a multiplier already calculated for the number
+	 *  of decimal places, for rounding many values at once
+	 */
+	double	roundScaled( double dValue, double dMultiplier )
+	{
+		double			dMultipliedValue	= dValue * dMultiplier;
 		double			dRemainder			= std::fmod( dMultipliedValue, 1 );
 
 		if ( dRemainder >= 0.5 )
@@ -89,7 +99,7 @@ namespace Util
 			dMultipliedValue = std::floor( dMultipliedValue );
 		}
 
-		return dMultipliedValue / uiMultiplier;
+		return dMultipliedValue / dMultiplier;
 	}
 
 	/*
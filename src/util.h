@@ -42,6 +42,7 @@ namespace Util
 	void			getHostname(char*);
 	void			setCursorPosition( cursorCoords );
 	double			round( double, unsigned char );
+	double			roundScaled( double, double );
 	char*			toLowercase( const char * );
 	void			toLowercase( char**, const char * );
 	void			toNewString( char**, const char * );